@@ -6,10 +6,12 @@ EXTENSIONS = {
     "envoy.clusters.dynamic_forward_proxy":                "//source/extensions/clusters/dynamic_forward_proxy:cluster",
     "envoy.clusters.logical_dns":                          "//source/extensions/clusters/logical_dns:logical_dns_cluster_lib",
     "envoy.clusters.static":                               "//source/extensions/clusters/static:static_cluster_lib",
+    "envoy.extensions.http.cache.mobile":                  "@envoy_mobile//library/common/extensions/http/cache/mobile:config",
     "envoy.filters.connection_pools.http.generic":         "//source/extensions/upstreams/http/generic:config",
     "envoy.filters.http.alternate_protocols_cache":        "//source/extensions/filters/http/alternate_protocols_cache:config",
     "envoy.filters.http.assertion":                        "@envoy_mobile//library/common/extensions/filters/http/assertion:config",
     "envoy.filters.http.buffer":                           "//source/extensions/filters/http/buffer:config",
+    "envoy.filters.http.cache":                            "//source/extensions/filters/http/cache:config",
     "envoy.filters.http.decompressor":                     "//source/extensions/filters/http/decompressor:config",
     "envoy.filters.http.dynamic_forward_proxy":            "//source/extensions/filters/http/dynamic_forward_proxy:config",
     "envoy.filters.http.local_error":                      "@envoy_mobile//library/common/extensions/filters/http/local_error:config",
@@ -17,6 +19,7 @@ EXTENSIONS = {
     "envoy.filters.http.network_configuration":            "@envoy_mobile//library/common/extensions/filters/http/network_configuration:config",
     "envoy.filters.http.route_cache_reset":                "@envoy_mobile//library/common/extensions/filters/http/route_cache_reset:config",
     "envoy.filters.http.router":                           "//source/extensions/filters/http/router:config",
+    "envoy.filters.http.single_flight":                    "@envoy_mobile//library/common/extensions/filters/http/single_flight:config",
     "envoy.filters.network.http_connection_manager":       "//source/extensions/filters/network/http_connection_manager:config",
     "envoy.http.original_ip_detection.xff":                "//source/extensions/http/original_ip_detection/xff:config",
     "envoy.key_value.platform":                            "@envoy_mobile//library/common/extensions/key_value/platform:config",
@@ -29,6 +32,7 @@ EXTENSIONS = {
     "envoy.transport_sockets.tls":                         "//source/extensions/transport_sockets/tls:config",
     "envoy.http.stateful_header_formatters.preserve_case": "//source/extensions/http/header_formatters/preserve_case:config",
     "envoy_mobile.cert_validator.platform_bridge_cert_validator": "@envoy_mobile//library/common/extensions/cert_validator/platform_bridge:config",
+    "envoy_mobile.cert_validator.root_certificates_cert_validator": "@envoy_mobile//library/common/extensions/cert_validator/root_certificates:config",
 }
 WINDOWS_EXTENSIONS = {}
 LEGACY_ALWAYSLINK = 1
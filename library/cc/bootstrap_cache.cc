@@ -0,0 +1,51 @@
+#include "bootstrap_cache.h"
+
+#include "source/common/common/hash.h"
+#include "source/common/common/hex.h"
+#include "source/common/version/version.h"
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "library/common/config/internal.h"
+
+namespace Envoy {
+namespace Platform {
+
+namespace {
+
+constexpr char StoreKey[] = "envoy_mobile.bootstrap";
+
+// Bumped whenever the format in which bootstraps are cached changes. Bootstraps generated by other
+// builds of the library are never read back, since the key also covers the build's version.
+constexpr uint32_t FormatVersion = 1;
+
+} // namespace
+
+std::string BootstrapCache::key(absl::string_view config) {
+  // The config header holds the defaults and root certificates which the config refers to. The
+  // build's version stands in for the code generating the bootstrap from them.
+  const uint64_t hash = HashUtil::xxHash64(
+      config, HashUtil::xxHash64(config_header, HashUtil::xxHash64(VersionInfo::version())));
+  return absl::StrCat("v", FormatVersion, ".", Hex::uint64ToHex(hash), "\n");
+}
+
+std::unique_ptr<envoy::config::bootstrap::v3::Bootstrap>
+BootstrapCache::read(const std::string& key) const {
+  // The bootstrap is stored after its key, so that one read finds out whether it's current.
+  absl::optional<std::string> value = store_->read(StoreKey);
+  if (!value.has_value() || !absl::StartsWith(*value, key)) {
+    return nullptr;
+  }
+  auto bootstrap = std::make_unique<envoy::config::bootstrap::v3::Bootstrap>();
+  if (!bootstrap->ParseFromArray(value->data() + key.size(), value->size() - key.size())) {
+    return nullptr;
+  }
+  return bootstrap;
+}
+
+void BootstrapCache::save(const std::string& key, const std::string& serialized_bootstrap) {
+  store_->save(StoreKey, absl::StrCat(key, serialized_bootstrap));
+}
+
+} // namespace Platform
+} // namespace Envoy
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "envoy/config/bootstrap/v3/bootstrap.pb.h"
+
+#include "absl/strings/string_view.h"
+#include "key_value_store.h"
+
+namespace Envoy {
+namespace Platform {
+
+/**
+ * Persists the bootstrap an EngineBuilder generates in a key value store, so that engines built
+ * later with the same options run with it rather than generating it again.
+ *
+ * The bootstrap is cached under a key hashed from the config it was generated from and the
+ * library's build version, which changes with any of the builder's options, with the library's
+ * config and with the library itself, so that a bootstrap generated from other inputs is never
+ * read back. Only the latest bootstrap is kept.
+ */
+class BootstrapCache {
+public:
+  explicit BootstrapCache(KeyValueStoreSharedPtr store) : store_(std::move(store)) {}
+
+  /**
+   * @param config, the YAML config which the bootstrap is generated to match.
+   * @return std::string, the key to cache the bootstrap under.
+   */
+  static std::string key(absl::string_view config);
+
+  /**
+   * @param key, the key the bootstrap was cached under.
+   * @return the cached bootstrap, or nullptr if none was cached under the key or it can't be
+   *         parsed.
+   */
+  std::unique_ptr<envoy::config::bootstrap::v3::Bootstrap> read(const std::string& key) const;
+
+  /**
+   * Caches a bootstrap, replacing any cached before.
+   * @param key, the key to cache the bootstrap under.
+   * @param serialized_bootstrap, the bootstrap in the protobuf wire format.
+   */
+  void save(const std::string& key, const std::string& serialized_bootstrap);
+
+private:
+  KeyValueStoreSharedPtr store_;
+};
+
+} // namespace Platform
+} // namespace Envoy
@@ -2,35 +2,30 @@
 
 #include <sstream>
 
+#include "library/common/data/bridge_map_builder.h"
 #include "library/common/data/utility.h"
 
 namespace Envoy {
 namespace Platform {
 
 envoy_headers rawHeaderMapAsEnvoyHeaders(const RawHeaderMap& headers) {
-  size_t header_count = 0;
+  // Size the block holding the entries and all of their bytes, so that it is allocated only once.
+  Data::BridgeMapBuilder builder;
   for (const auto& pair : headers) {
-    header_count += pair.second.size();
+    size_t bytes = pair.first.size() * pair.second.size();
+    for (const auto& value : pair.second) {
+      bytes += value.size();
+    }
+    builder.reserve(pair.second.size(), bytes);
   }
 
-  envoy_map_entry* headers_list =
-      static_cast<envoy_map_entry*>(safe_malloc(sizeof(envoy_map_entry) * header_count));
-
-  size_t i = 0;
   for (const auto& pair : headers) {
     const auto& key = pair.first;
     for (const auto& value : pair.second) {
-      envoy_map_entry& header = headers_list[i++];
-      header.key = Data::Utility::copyToBridgeData(key);
-      header.value = Data::Utility::copyToBridgeData(value);
+      builder.add(key, value);
     }
   }
-
-  envoy_headers raw_headers{
-      static_cast<envoy_map_size_t>(header_count),
-      headers_list,
-  };
-  return raw_headers;
+  return builder.finish();
 }
 
 RawHeaderMap envoyHeadersAsRawHeaderMap(envoy_headers raw_headers) {
@@ -0,0 +1,58 @@
+#include "callback_workers.h"
+
+namespace Envoy {
+namespace Platform {
+
+CallbackWorkers::CallbackWorkers(uint32_t threads) {
+  for (uint32_t i = 0; i < threads; i++) {
+    auto worker = std::make_shared<Worker>();
+    worker->thread_ = std::thread([worker]() { worker->run(); });
+    workers_.push_back(std::move(worker));
+  }
+}
+
+CallbackWorkers::~CallbackWorkers() {
+  for (auto& worker : workers_) {
+    absl::MutexLock lock(&worker->mutex_);
+    worker->stopping_ = true;
+  }
+  for (auto& worker : workers_) {
+    // A thread can't join itself, so a worker destroying its workers is left to finish alone.
+    if (worker->thread_.get_id() == std::this_thread::get_id()) {
+      worker->thread_.detach();
+    } else {
+      worker->thread_.join();
+    }
+  }
+}
+
+void CallbackWorkers::post(envoy_stream_t stream, std::function<void()> callback) {
+  // Stream handles are allocated sequentially, so streams are spread evenly across the workers.
+  Worker& worker = *workers_[static_cast<uint64_t>(stream) % workers_.size()];
+  absl::MutexLock lock(&worker.mutex_);
+  worker.callbacks_.push_back(std::move(callback));
+}
+
+void CallbackWorkers::Worker::run() {
+  while (true) {
+    std::deque<std::function<void()>> callbacks;
+    {
+      absl::MutexLock lock(&mutex_);
+      const auto has_work = [this]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+        return stopping_ || !callbacks_.empty();
+      };
+      mutex_.Await(absl::Condition(&has_work));
+      if (callbacks_.empty()) {
+        return;
+      }
+      // Callbacks posted while these run are picked up on the next pass.
+      callbacks.swap(callbacks_);
+    }
+    for (auto& callback : callbacks) {
+      callback();
+    }
+  }
+}
+
+} // namespace Platform
+} // namespace Envoy
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "library/common/types/c_types.h"
+
+namespace Envoy {
+namespace Platform {
+
+// Runs stream callbacks on a fixed set of worker threads rather than on the engine's thread, so
+// that work done in callbacks by one stream does not hold up the others. Each stream's callbacks
+// run on the worker its handle maps to, in the order they were posted.
+class CallbackWorkers {
+public:
+  CallbackWorkers(uint32_t threads);
+  // Runs the callbacks already posted, then stops the workers. May be called from a callback, in
+  // which case the worker running it stops once it returns and the callbacks posted before the
+  // call have run, rather than being waited for.
+  ~CallbackWorkers();
+
+  void post(envoy_stream_t stream, std::function<void()> callback);
+  size_t size() const { return workers_.size(); }
+
+private:
+  struct Worker {
+    void run();
+
+    absl::Mutex mutex_;
+    std::deque<std::function<void()>> callbacks_ ABSL_GUARDED_BY(mutex_);
+    bool stopping_ ABSL_GUARDED_BY(mutex_){};
+    std::thread thread_;
+  };
+
+  // Shared with the workers' threads, which may outlive this when destroyed from a callback.
+  std::vector<std::shared_ptr<Worker>> workers_;
+};
+
+using CallbackWorkersSharedPtr = std::shared_ptr<CallbackWorkers>;
+using CallbackWorkersWeakPtr = std::weak_ptr<CallbackWorkers>;
+
+} // namespace Platform
+} // namespace Envoy
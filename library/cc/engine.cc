@@ -6,7 +6,8 @@
 namespace Envoy {
 namespace Platform {
 
-Engine::Engine(envoy_engine_t engine) : engine_(engine), terminated_(false) {}
+Engine::Engine(envoy_engine_t engine, CallbackWorkersSharedPtr callback_workers)
+    : engine_(engine), callback_workers_(std::move(callback_workers)), terminated_(false) {}
 
 // we lazily construct the stream and pulse clients
 // because they either require or will require a weak ptr
@@ -24,7 +25,15 @@ void Engine::terminate() {
   }
   terminate_engine(engine_, /* release */ false);
   terminated_ = true;
+  // No more callbacks are posted once the engine has terminated, so the workers can be stopped
+  // once they have run those already posted. When terminating from a callback, the worker running
+  // it stops once it returns.
+  callback_workers_.reset();
 }
 
+void Engine::suspend() { suspend_engine(engine_); }
+
+void Engine::resume() { resume_engine(engine_); }
+
 } // namespace Platform
 } // namespace Envoy
@@ -2,6 +2,7 @@
 
 #include <functional>
 
+#include "callback_workers.h"
 #include "library/common/types/c_types.h"
 #include "log_level.h"
 #include "pulse_client.h"
@@ -22,8 +23,13 @@ public:
 
   void terminate();
 
+  // Releases the memory the engine doesn't need while the app is in the background, and resumes
+  // it. See suspend_engine() and resume_engine().
+  void suspend();
+  void resume();
+
 private:
-  Engine(envoy_engine_t engine);
+  Engine(envoy_engine_t engine, CallbackWorkersSharedPtr callback_workers = nullptr);
 
   // required to access private constructor
   friend class EngineBuilder;
@@ -35,6 +41,8 @@ private:
   envoy_engine_t engine_;
   StreamClientSharedPtr stream_client_;
   PulseClientSharedPtr pulse_client_;
+  // Present if stream callbacks run on worker threads rather than on the engine's thread.
+  CallbackWorkersSharedPtr callback_workers_;
   bool terminated_;
 };
 
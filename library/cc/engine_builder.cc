@@ -1,23 +1,135 @@
 #include "engine_builder.h"
 
+#include <limits>
 #include <sstream>
 
+#include "envoy/config/cluster/v3/cluster.pb.h"
+#include "envoy/config/listener/v3/listener.pb.h"
+#include "envoy/config/metrics/v3/metrics_service.pb.h"
+#include "envoy/config/metrics/v3/stats.pb.h"
+#include "envoy/config/route/v3/route.pb.h"
+#include "envoy/extensions/clusters/dynamic_forward_proxy/v3/cluster.pb.h"
+#include "envoy/extensions/common/dynamic_forward_proxy/v3/dns_cache.pb.h"
+#include "envoy/extensions/compression/brotli/decompressor/v3/brotli.pb.h"
+#include "envoy/extensions/compression/gzip/decompressor/v3/gzip.pb.h"
+#include "envoy/extensions/filters/http/alternate_protocols_cache/v3/alternate_protocols_cache.pb.h"
+#include "envoy/extensions/filters/http/cache/v3/cache.pb.h"
+#include "envoy/extensions/filters/http/decompressor/v3/decompressor.pb.h"
+#include "envoy/extensions/filters/http/dynamic_forward_proxy/v3/dynamic_forward_proxy.pb.h"
+#include "envoy/extensions/filters/http/router/v3/router.pb.h"
+#include "envoy/extensions/filters/network/http_connection_manager/v3/http_connection_manager.pb.h"
+#include "envoy/extensions/http/header_formatters/preserve_case/v3/preserve_case.pb.h"
+#include "envoy/extensions/network/dns_resolver/apple/v3/apple_dns_resolver.pb.h"
+#include "envoy/extensions/network/dns_resolver/getaddrinfo/v3/getaddrinfo_dns_resolver.pb.h"
+#include "envoy/extensions/transport_sockets/http_11_proxy/v3/upstream_http_11_connect.pb.h"
+#include "envoy/extensions/transport_sockets/quic/v3/quic_transport.pb.h"
+#include "envoy/extensions/transport_sockets/raw_buffer/v3/raw_buffer.pb.h"
+#include "envoy/extensions/transport_sockets/tls/v3/tls.pb.h"
+#include "envoy/extensions/upstreams/http/v3/http_protocol_options.pb.h"
+
 #include "source/common/common/assert.h"
+#include "source/common/protobuf/message_validator_impl.h"
+#include "source/common/protobuf/utility.h"
 
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_replace.h"
 #include "fmt/core.h"
+#include "library/common/extensions/cert_validator/platform_bridge/platform_bridge.pb.h"
+#include "library/common/extensions/cert_validator/root_certificates/root_certificates.pb.h"
+#include "library/common/extensions/filters/http/local_error/filter.pb.h"
+#include "library/common/extensions/filters/http/network_configuration/filter.pb.h"
+#include "library/common/extensions/filters/http/platform_bridge/filter.pb.h"
+#include "library/common/extensions/filters/http/single_flight/filter.pb.h"
+#include "library/common/extensions/filters/http/socket_tag/filter.pb.h"
+#include "library/common/extensions/http/cache/mobile/cache.pb.h"
+#include "library/common/extensions/key_value/platform/platform.pb.h"
 #include "library/common/main_interface.h"
 
 namespace Envoy {
 namespace Platform {
 
 namespace {
+
+using HttpFilter = envoy::extensions::filters::network::http_connection_manager::v3::HttpFilter;
+using HttpProtocolOptions = envoy::extensions::upstreams::http::v3::HttpProtocolOptions;
+
 // Inserts `filter_config` into the "custom_filters" target in `config_template`.
 void insertCustomFilter(const std::string& filter_config, std::string& config_template) {
   absl::StrReplaceAll({{"#{custom_filters}", absl::StrCat("#{custom_filters}\n", filter_config)}},
                       &config_template);
 }
+
+// The stats which are emitted. Others are rejected.
+constexpr const char* StatsInclusionPatterns[] = {
+    R"(^cluster\.[\w]+?\.upstream_cx_[\w]+)",
+    R"(^cluster\.[\w]+?\.upstream_rq_[\w]+)",
+    R"(^cluster\.[\w]+?\.update_(attempt|success|failure))",
+    R"(^cluster\.[\w]+?\.http2.keepalive_timeout)",
+    R"(^dns.apple.*)",
+    R"(^http.client.*)",
+    R"(^http.dispatcher.*)",
+    R"(^http.hcm.decompressor.*)",
+    R"(^http.hcm.downstream_rq_[\w]+)",
+    R"(^pbf_filter.*)",
+    R"(^pulse.*)",
+    R"(^startup\..*)",
+    R"(^vhost\.[\w]+\.vcluster\.[\w]+?\.upstream_rq_)"
+    R"((?:[12345]xx|[3-5][0-9][0-9]|retry.*|timeout|total))",
+};
+
+// Builder options given as YAML are parsed on their own, into the message which holds them.
+template <class Message> Message parseYaml(const std::string& yaml) {
+  Message message;
+  MessageUtil::loadFromYaml(yaml, message, ProtobufMessage::getStrictValidationVisitor());
+  return message;
+}
+
+template <class Message> Message parseYamlField(absl::string_view field, const std::string& yaml) {
+  return parseYaml<Message>(absl::StrCat(field, ": ", yaml));
+}
+
+HttpFilter httpFilter(std::string name, const Protobuf::Message& typed_config) {
+  HttpFilter filter;
+  filter.set_name(std::move(name));
+  filter.mutable_typed_config()->PackFrom(typed_config);
+  return filter;
+}
+
+// A response decompressor, which decompresses requests only if enabled at runtime.
+HttpFilter decompressorFilter(std::string library_name, const Protobuf::Message& library_config) {
+  envoy::extensions::filters::http::decompressor::v3::Decompressor decompressor;
+  decompressor.mutable_decompressor_library()->set_name(std::move(library_name));
+  decompressor.mutable_decompressor_library()->mutable_typed_config()->PackFrom(library_config);
+  envoy::config::core::v3::RuntimeFeatureFlag* request_enabled =
+      decompressor.mutable_request_direction_config()->mutable_common_config()->mutable_enabled();
+  request_enabled->mutable_default_value()->set_value(false);
+  request_enabled->set_runtime_key("request_decompressor_enabled");
+  decompressor.mutable_response_direction_config()
+      ->mutable_common_config()
+      ->set_ignore_no_transform_header(true);
+  return httpFilter("envoy.filters.http.decompressor", decompressor);
+}
+
+// Wraps a transport socket in the HTTP/1.1 proxy socket, which tunnels through proxies when
+// they're configured.
+envoy::config::core::v3::TransportSocket http11ProxySocket(std::string name,
+                                                           const Protobuf::Message& typed_config) {
+  envoy::extensions::transport_sockets::http_11_proxy::v3::Http11ProxyUpstreamTransport proxy;
+  proxy.mutable_transport_socket()->set_name(std::move(name));
+  proxy.mutable_transport_socket()->mutable_typed_config()->PackFrom(typed_config);
+  envoy::config::core::v3::TransportSocket socket;
+  socket.set_name("envoy.transport_sockets.http_11_proxy");
+  socket.mutable_typed_config()->PackFrom(proxy);
+  return socket;
+}
+
+void setProtocolOptions(envoy::config::cluster::v3::Cluster& cluster,
+                        const HttpProtocolOptions& options) {
+  (*cluster.mutable_typed_extension_protocol_options())
+      ["envoy.extensions.upstreams.http.v3.HttpProtocolOptions"]
+          .PackFrom(options);
+}
+
 } // namespace
 
 EngineBuilder::EngineBuilder(std::string config_template)
@@ -80,6 +192,15 @@ EngineBuilder& EngineBuilder::addMaxConnectionsPerHost(int max_connections_per_h
   return *this;
 }
 
+EngineBuilder& EngineBuilder::addPreconnectHosts(std::vector<std::string> authorities,
+                                                 uint32_t connections_per_host,
+                                                 envoy_preconnect_protocol_t protocol) {
+  for (std::string& authority : authorities) {
+    this->preconnect_hosts_.push_back({std::move(authority), connections_per_host, protocol});
+  }
+  return *this;
+}
+
 EngineBuilder& EngineBuilder::useDnsSystemResolver(bool use_system_resolver) {
   this->use_system_resolver_ = use_system_resolver;
   return *this;
@@ -139,6 +260,38 @@ EngineBuilder& EngineBuilder::setPerTryIdleTimeoutSeconds(int per_try_idle_timeo
   return *this;
 }
 
+EngineBuilder& EngineBuilder::setStreamBufferLimitBytes(uint32_t stream_buffer_limit_bytes) {
+  this->stream_buffer_limit_bytes_ = stream_buffer_limit_bytes;
+  return *this;
+}
+
+EngineBuilder&
+EngineBuilder::setStreamBufferMemoryBudgetBytes(uint64_t stream_buffer_memory_budget_bytes) {
+  this->stream_buffer_memory_budget_bytes_ = stream_buffer_memory_budget_bytes;
+  return *this;
+}
+
+EngineBuilder&
+EngineBuilder::setPerConnectionBufferLimitBytes(uint32_t per_connection_buffer_limit_bytes) {
+  this->per_connection_buffer_limit_bytes_ = per_connection_buffer_limit_bytes;
+  return *this;
+}
+
+EngineBuilder& EngineBuilder::setCallbackLatencySampleRate(uint32_t callback_latency_sample_rate) {
+  this->callback_latency_sample_rate_ = callback_latency_sample_rate;
+  return *this;
+}
+
+EngineBuilder& EngineBuilder::setCallbackThreads(uint32_t callback_threads) {
+  this->callback_threads_ = callback_threads;
+  return *this;
+}
+
+EngineBuilder& EngineBuilder::setBootstrapCache(KeyValueStoreSharedPtr store) {
+  this->bootstrap_cache_ = std::make_shared<BootstrapCache>(std::move(store));
+  return *this;
+}
+
 EngineBuilder& EngineBuilder::enableGzip(bool gzip_on) {
   this->gzip_filter_ = gzip_on;
   return *this;
@@ -154,6 +307,19 @@ EngineBuilder& EngineBuilder::enableSocketTagging(bool socket_tagging_on) {
   return *this;
 }
 
+EngineBuilder& EngineBuilder::enableRequestCoalescing(bool request_coalescing_on) {
+  this->single_flight_filter_ = request_coalescing_on;
+  return *this;
+}
+
+EngineBuilder& EngineBuilder::enableResponseCache(bool response_cache_on,
+                                                  uint64_t max_memory_bytes, bool persistent) {
+  this->response_cache_filter_ = response_cache_on;
+  this->response_cache_max_memory_bytes_ = max_memory_bytes;
+  this->response_cache_persistent_ = persistent;
+  return *this;
+}
+
 EngineBuilder& EngineBuilder::enableAdminInterface(bool admin_interface_on) {
   this->admin_interface_enabled_ = admin_interface_on;
   return *this;
@@ -179,6 +345,11 @@ EngineBuilder& EngineBuilder::enableDrainPostDnsRefresh(bool drain_post_dns_refr
   return *this;
 }
 
+EngineBuilder& EngineBuilder::enableEarlyDrain(bool early_drain_on) {
+  this->enable_early_drain_ = early_drain_on;
+  return *this;
+}
+
 EngineBuilder& EngineBuilder::enforceTrustChainVerification(bool trust_chain_verification_on) {
   this->enforce_trust_chain_verification_ = trust_chain_verification_on;
   return *this;
@@ -218,7 +389,8 @@ EngineBuilder& EngineBuilder::addPlatformFilter(std::string name) {
 
 std::string EngineBuilder::generateConfigStr() const {
   std::vector<std::pair<std::string, std::string>> replacements {
-    {"connect_timeout", fmt::format("{}s", this->connect_timeout_seconds_)},
+    {"callback_latency_sample_rate", fmt::format("{}", this->callback_latency_sample_rate_)},
+        {"connect_timeout", fmt::format("{}s", this->connect_timeout_seconds_)},
         {"dns_fail_base_interval", fmt::format("{}s", this->dns_failure_refresh_seconds_base_)},
         {"dns_fail_max_interval", fmt::format("{}s", this->dns_failure_refresh_seconds_max_)},
         {"dns_lookup_family", enable_happy_eyeballs_ ? "ALL" : "V4_PREFERRED"},
@@ -228,6 +400,7 @@ std::string EngineBuilder::generateConfigStr() const {
         {"dns_refresh_rate", fmt::format("{}s", this->dns_refresh_seconds_)},
         {"dns_query_timeout", fmt::format("{}s", this->dns_query_timeout_seconds_)},
         {"enable_drain_post_dns_refresh", enable_drain_post_dns_refresh_ ? "true" : "false"},
+        {"enable_early_drain", enable_early_drain_ ? "true" : "false"},
         {"enable_interface_binding", enable_interface_binding_ ? "true" : "false"},
         {"h2_connection_keepalive_idle_interval",
          fmt::format("{}s", this->h2_connection_keepalive_idle_interval_milliseconds_ / 1000.0)},
@@ -240,8 +413,14 @@ std::string EngineBuilder::generateConfigStr() const {
                         this->app_version_, this->app_id_),
         },
         {"max_connections_per_host", fmt::format("{}", this->max_connections_per_host_)},
+        {"per_connection_buffer_limit",
+         fmt::format("{}", this->per_connection_buffer_limit_bytes_)},
+        {"response_cache_max_memory_bytes",
+         fmt::format("{}", this->response_cache_max_memory_bytes_)},
         {"stats_domain", this->stats_domain_},
         {"stats_flush_interval", fmt::format("{}s", this->stats_flush_seconds_)},
+        {"stream_buffer_budget", fmt::format("{}", this->stream_buffer_memory_budget_bytes_)},
+        {"stream_buffer_limit", fmt::format("{}", this->stream_buffer_limit_bytes_)},
         {"stream_idle_timeout", fmt::format("{}s", this->stream_idle_timeout_seconds_)},
         {"trust_chain_verification",
          enforce_trust_chain_verification_ ? "VERIFY_TRUST_CHAIN" : "ACCEPT_UNTRUSTED"},
@@ -284,6 +463,14 @@ std::string EngineBuilder::generateConfigStr() const {
   if (this->socket_tagging_filter_) {
     insertCustomFilter(socket_tag_config_insert, config_template);
   }
+  if (this->single_flight_filter_) {
+    insertCustomFilter(single_flight_config_insert, config_template);
+  }
+  if (this->response_cache_filter_) {
+    insertCustomFilter(this->response_cache_persistent_ ? persistent_response_cache_config_insert
+                                                        : response_cache_config_insert,
+                       config_template);
+  }
   if (this->enable_http3_) {
     insertCustomFilter(alternate_protocols_cache_filter_insert, config_template);
   }
@@ -314,6 +501,436 @@ std::string EngineBuilder::generateConfigStr() const {
   return config_str;
 }
 
+std::unique_ptr<envoy::config::bootstrap::v3::Bootstrap> EngineBuilder::generateBootstrap() const {
+  auto bootstrap = std::make_unique<envoy::config::bootstrap::v3::Bootstrap>();
+
+  // DNS resolution, shared by the dynamic forward proxy filter and clusters.
+  envoy::config::core::v3::TypedExtensionConfig* dns_resolver_config =
+      bootstrap->mutable_typed_dns_resolver_config();
+#if defined(__APPLE__)
+  dns_resolver_config->set_name("envoy.network.dns_resolver.apple");
+  dns_resolver_config->mutable_typed_config()->PackFrom(
+      envoy::extensions::network::dns_resolver::apple::v3::AppleDnsResolverConfig());
+#else
+  dns_resolver_config->set_name("envoy.network.dns_resolver.getaddrinfo");
+  dns_resolver_config->mutable_typed_config()->PackFrom(
+      envoy::extensions::network::dns_resolver::getaddrinfo::v3::GetAddrInfoDnsResolverConfig());
+#endif
+
+  envoy::extensions::common::dynamic_forward_proxy::v3::DnsCacheConfig dns_cache_config;
+  dns_cache_config.set_name("base_dns_cache");
+  if (dns_preresolve_hostnames_ != "[]") {
+    *dns_cache_config.mutable_preresolve_hostnames() =
+        parseYamlField<envoy::extensions::common::dynamic_forward_proxy::v3::DnsCacheConfig>(
+            "preresolve_hostnames", dns_preresolve_hostnames_)
+            .preresolve_hostnames();
+  }
+  dns_cache_config.set_dns_lookup_family(enable_happy_eyeballs_
+                                             ? envoy::config::cluster::v3::Cluster::ALL
+                                             : envoy::config::cluster::v3::Cluster::V4_PREFERRED);
+  *dns_cache_config.mutable_host_ttl() = ProtobufUtil::TimeUtil::SecondsToDuration(86400);
+  *dns_cache_config.mutable_dns_min_refresh_rate() =
+      ProtobufUtil::TimeUtil::SecondsToDuration(dns_min_refresh_seconds_);
+  *dns_cache_config.mutable_dns_refresh_rate() =
+      ProtobufUtil::TimeUtil::SecondsToDuration(dns_refresh_seconds_);
+  *dns_cache_config.mutable_dns_failure_refresh_rate()->mutable_base_interval() =
+      ProtobufUtil::TimeUtil::SecondsToDuration(dns_failure_refresh_seconds_base_);
+  *dns_cache_config.mutable_dns_failure_refresh_rate()->mutable_max_interval() =
+      ProtobufUtil::TimeUtil::SecondsToDuration(dns_failure_refresh_seconds_max_);
+  *dns_cache_config.mutable_dns_query_timeout() =
+      ProtobufUtil::TimeUtil::SecondsToDuration(dns_query_timeout_seconds_);
+  *dns_cache_config.mutable_typed_dns_resolver_config() = *dns_resolver_config;
+
+  // The HTTP filter chain. Custom filters are added ahead of those added before them, as they are
+  // inserted into the YAML template.
+  std::vector<HttpFilter> custom_filters;
+  if (gzip_filter_) {
+    envoy::extensions::compression::gzip::decompressor::v3::Gzip gzip;
+    gzip.mutable_window_bits()->set_value(15);
+    custom_filters.push_back(decompressorFilter("gzip", gzip));
+  }
+  if (brotli_filter_) {
+    custom_filters.push_back(decompressorFilter(
+        "text_optimized", envoy::extensions::compression::brotli::decompressor::v3::Brotli()));
+  }
+  if (socket_tagging_filter_) {
+    custom_filters.push_back(
+        httpFilter("envoy.filters.http.socket_tag",
+                   envoymobile::extensions::filters::http::socket_tag::SocketTag()));
+  }
+  if (single_flight_filter_) {
+    envoymobile::extensions::filters::http::single_flight::SingleFlight single_flight;
+    for (const char* header :
+         {"accept", "accept-encoding", "accept-language", "authorization", "cookie", "range"}) {
+      single_flight.add_key_headers(header);
+    }
+    custom_filters.push_back(httpFilter("envoy.filters.http.single_flight", single_flight));
+  }
+  if (response_cache_filter_) {
+    envoymobile::extensions::http::cache::mobile::MobileHttpCacheConfig mobile_cache;
+    mobile_cache.set_max_memory_bytes(response_cache_max_memory_bytes_);
+    if (response_cache_persistent_) {
+      envoymobile::extensions::key_value::platform::PlatformKeyValueStoreConfig store;
+      store.set_key("envoy_mobile.response_cache");
+      *store.mutable_save_interval() = ProtobufUtil::TimeUtil::SecondsToDuration(10);
+      // The store is left unbounded in entries, as the cache bounds it in bytes and must be the
+      // only one evicting from it for its accounting to hold.
+      envoy::config::core::v3::TypedExtensionConfig* store_config =
+          mobile_cache.mutable_persistent_store_config()->mutable_config();
+      store_config->set_name("envoy.key_value.platform");
+      store_config->mutable_typed_config()->PackFrom(store);
+    }
+    envoy::extensions::filters::http::cache::v3::CacheConfig cache;
+    cache.mutable_typed_config()->PackFrom(mobile_cache);
+    custom_filters.push_back(httpFilter("envoy.filters.http.cache", cache));
+  }
+  if (enable_http3_) {
+    envoy::extensions::filters::http::alternate_protocols_cache::v3::FilterConfig alt_svc_cache;
+    alt_svc_cache.mutable_alternate_protocols_cache_options()->set_name(
+        "default_alternate_protocols_cache");
+    custom_filters.push_back(httpFilter("alternate_protocols_cache", alt_svc_cache));
+  }
+  for (const NativeFilterConfig& filter : native_filter_chain_) {
+    HttpFilter native_filter = parseYamlField<HttpFilter>("typed_config", filter.typed_config_);
+    native_filter.set_name(filter.name_);
+    custom_filters.push_back(std::move(native_filter));
+  }
+  for (const std::string& name : platform_filters_) {
+    envoymobile::extensions::filters::http::platform_bridge::PlatformBridge platform_bridge;
+    platform_bridge.set_platform_filter_name(name);
+    custom_filters.push_back(httpFilter("envoy.filters.http.platform_bridge", platform_bridge));
+  }
+
+  envoymobile::extensions::filters::http::network_configuration::NetworkConfiguration
+      network_configuration;
+  network_configuration.set_enable_drain_post_dns_refresh(enable_drain_post_dns_refresh_);
+  network_configuration.set_enable_interface_binding(enable_interface_binding_);
+  envoy::extensions::filters::http::dynamic_forward_proxy::v3::FilterConfig dfp;
+  *dfp.mutable_dns_cache_config() = dns_cache_config;
+
+  envoy::extensions::filters::network::http_connection_manager::v3::HttpConnectionManager hcm;
+  hcm.set_stat_prefix("hcm");
+  hcm.set_server_header_transformation(envoy::extensions::filters::network::
+                                           http_connection_manager::v3::HttpConnectionManager::
+                                               PASS_THROUGH);
+  *hcm.mutable_stream_idle_timeout() =
+      ProtobufUtil::TimeUtil::SecondsToDuration(stream_idle_timeout_seconds_);
+  for (auto filter = custom_filters.rbegin(); filter != custom_filters.rend(); ++filter) {
+    *hcm.add_http_filters() = std::move(*filter);
+  }
+  *hcm.add_http_filters() =
+      httpFilter("envoy.filters.http.network_configuration", network_configuration);
+  *hcm.add_http_filters() =
+      httpFilter("envoy.filters.http.local_error",
+                 envoymobile::extensions::filters::http::local_error::LocalError());
+  *hcm.add_http_filters() = httpFilter("envoy.filters.http.dynamic_forward_proxy", dfp);
+  *hcm.add_http_filters() =
+      httpFilter("envoy.router", envoy::extensions::filters::http::router::v3::Router());
+
+  // The list of virtual hosts impacts directly the number of virtual cluster stats, as a separate
+  // set of stats is created for every "virtual cluster" <> "virtual host" pair.
+  envoy::config::route::v3::RouteConfiguration* route_config = hcm.mutable_route_config();
+  route_config->set_name("api_router");
+  envoy::config::route::v3::VirtualHost* api_host = route_config->add_virtual_hosts();
+  api_host->set_name("api");
+  api_host->set_include_attempt_count_in_response(true);
+  if (virtual_clusters_ != "[]") {
+    *api_host->mutable_virtual_clusters() =
+        parseYamlField<envoy::config::route::v3::VirtualHost>("virtual_clusters",
+                                                              virtual_clusters_)
+            .virtual_clusters();
+  }
+  api_host->add_domains("*");
+  envoy::config::route::v3::Route* route = api_host->add_routes();
+  route->mutable_match()->set_prefix("/");
+  route->add_request_headers_to_remove("x-forwarded-proto");
+  route->add_request_headers_to_remove("x-envoy-mobile-cluster");
+  envoy::config::route::v3::RouteAction* route_action = route->mutable_route();
+  route_action->set_cluster_header("x-envoy-mobile-cluster");
+  *route_action->mutable_timeout() = ProtobufUtil::TimeUtil::SecondsToDuration(0);
+  envoy::config::route::v3::RetryPolicy* retry_policy = route_action->mutable_retry_policy();
+  *retry_policy->mutable_per_try_idle_timeout() =
+      ProtobufUtil::TimeUtil::SecondsToDuration(per_try_idle_timeout_seconds_);
+  *retry_policy->mutable_retry_back_off()->mutable_base_interval() =
+      ProtobufUtil::TimeUtil::MillisecondsToDuration(250);
+  *retry_policy->mutable_retry_back_off()->mutable_max_interval() =
+      ProtobufUtil::TimeUtil::SecondsToDuration(60);
+
+  envoy::config::listener::v3::Listener* api_listener =
+      bootstrap->mutable_static_resources()->add_listeners();
+  api_listener->set_name("base_api_listener");
+  envoy::config::core::v3::SocketAddress* api_address =
+      api_listener->mutable_address()->mutable_socket_address();
+  api_address->set_protocol(envoy::config::core::v3::SocketAddress::TCP);
+  api_address->set_address("0.0.0.0");
+  api_address->set_port_value(10000);
+  api_listener->mutable_per_connection_buffer_limit_bytes()->set_value(
+      per_connection_buffer_limit_bytes_);
+  envoy::extensions::filters::network::http_connection_manager::v3::
+      EnvoyMobileHttpConnectionManager api_listener_config;
+  *api_listener_config.mutable_config() = std::move(hcm);
+  api_listener->mutable_api_listener()->mutable_api_listener()->PackFrom(api_listener_config);
+
+  // Upstream TLS, validated against the bundled root certificates or by the platform.
+  envoy::extensions::transport_sockets::tls::v3::CertificateValidationContext validation_context;
+  envoy::config::core::v3::TypedExtensionConfig* validator =
+      validation_context.mutable_custom_validator_config();
+  if (platform_certificates_validation_on_) {
+    validator->set_name("envoy_mobile.cert_validator.platform_bridge_cert_validator");
+    validator->mutable_typed_config()->PackFrom(
+        envoy_mobile::extensions::cert_validator::platform_bridge::PlatformBridgeCertValidator());
+  } else {
+    validator->set_name("envoy_mobile.cert_validator.root_certificates_cert_validator");
+    validator->mutable_typed_config()->PackFrom(
+        envoy_mobile::extensions::cert_validator::root_certificates::
+            RootCertificatesCertValidator());
+  }
+  validation_context.set_trust_chain_verification(
+      enforce_trust_chain_verification_
+          ? envoy::extensions::transport_sockets::tls::v3::CertificateValidationContext::
+                VERIFY_TRUST_CHAIN
+          : envoy::extensions::transport_sockets::tls::v3::CertificateValidationContext::
+                ACCEPT_UNTRUSTED);
+
+  envoy::extensions::transport_sockets::tls::v3::CommonTlsContext common_tls_context;
+  common_tls_context.mutable_tls_params()->set_tls_maximum_protocol_version(
+      envoy::extensions::transport_sockets::tls::v3::TlsParameters::TLSv1_3);
+  *common_tls_context.mutable_validation_context() = std::move(validation_context);
+
+  envoy::extensions::transport_sockets::tls::v3::UpstreamTlsContext tls_context;
+  *tls_context.mutable_common_tls_context() = common_tls_context;
+  const envoy::config::core::v3::TransportSocket tls_socket =
+      http11ProxySocket("envoy.transport_sockets.tls", tls_context);
+
+  envoy::extensions::transport_sockets::tls::v3::UpstreamTlsContext h2_tls_context;
+  *h2_tls_context.mutable_common_tls_context() = common_tls_context;
+  h2_tls_context.mutable_common_tls_context()->add_alpn_protocols("h2");
+  const envoy::config::core::v3::TransportSocket h2_socket =
+      http11ProxySocket("envoy.transport_sockets.tls", h2_tls_context);
+
+  envoy::extensions::transport_sockets::quic::v3::QuicUpstreamTransport h3_transport;
+  *h3_transport.mutable_upstream_tls_context()->mutable_common_tls_context() =
+      std::move(common_tls_context);
+  const envoy::config::core::v3::TransportSocket h3_socket =
+      http11ProxySocket("envoy.transport_sockets.quic", h3_transport);
+
+  const envoy::config::core::v3::TransportSocket clear_socket = http11ProxySocket(
+      "envoy.transport_sockets.raw_buffer",
+      envoy::extensions::transport_sockets::raw_buffer::v3::RawBuffer());
+
+  // Upstream protocols.
+  envoy::config::core::v3::Http1ProtocolOptions h1_options;
+  envoy::config::core::v3::TypedExtensionConfig* formatter =
+      h1_options.mutable_header_key_format()->mutable_stateful_formatter();
+  formatter->set_name("preserve_case");
+  envoy::extensions::http::header_formatters::preserve_case::v3::PreserveCaseFormatterConfig
+      preserve_case;
+  preserve_case.set_forward_reason_phrase(false);
+  preserve_case.set_formatter_type_on_envoy_headers(
+      envoy::extensions::http::header_formatters::preserve_case::v3::PreserveCaseFormatterConfig::
+          DEFAULT);
+  formatter->mutable_typed_config()->PackFrom(preserve_case);
+
+  envoy::config::core::v3::Http2ProtocolOptions h2_options;
+  *h2_options.mutable_connection_keepalive()->mutable_connection_idle_interval() =
+      ProtobufUtil::TimeUtil::MillisecondsToDuration(
+          h2_connection_keepalive_idle_interval_milliseconds_);
+  *h2_options.mutable_connection_keepalive()->mutable_timeout() =
+      ProtobufUtil::TimeUtil::SecondsToDuration(h2_connection_keepalive_timeout_seconds_);
+  h2_options.mutable_max_concurrent_streams()->set_value(100);
+
+  HttpProtocolOptions base_protocol_options;
+  base_protocol_options.mutable_upstream_http_protocol_options()->set_auto_sni(true);
+  base_protocol_options.mutable_upstream_http_protocol_options()->set_auto_san_validation(true);
+
+  HttpProtocolOptions h1_protocol_options = base_protocol_options;
+  *h1_protocol_options.mutable_explicit_http_config()->mutable_http_protocol_options() =
+      h1_options;
+
+  HttpProtocolOptions h2_protocol_options = base_protocol_options;
+  *h2_protocol_options.mutable_explicit_http_config()->mutable_http2_protocol_options() =
+      h2_options;
+
+  HttpProtocolOptions alpn_protocol_options = base_protocol_options;
+  *alpn_protocol_options.mutable_auto_config()->mutable_http2_protocol_options() = h2_options;
+  *alpn_protocol_options.mutable_auto_config()->mutable_http_protocol_options() = h1_options;
+
+  HttpProtocolOptions h3_protocol_options = alpn_protocol_options;
+  h3_protocol_options.mutable_auto_config()->mutable_alternate_protocols_cache_options()->set_name(
+      "default_alternate_protocols_cache");
+  h3_protocol_options.mutable_auto_config()->mutable_http3_protocol_options();
+
+  // Clusters.
+  envoy::config::cluster::v3::Cluster* stats_cluster =
+      bootstrap->mutable_static_resources()->add_clusters();
+  stats_cluster->set_name("stats");
+  stats_cluster->set_type(envoy::config::cluster::v3::Cluster::LOGICAL_DNS);
+  stats_cluster->mutable_wait_for_warm_on_init()->set_value(false);
+  *stats_cluster->mutable_connect_timeout() =
+      ProtobufUtil::TimeUtil::SecondsToDuration(connect_timeout_seconds_);
+  *stats_cluster->mutable_dns_refresh_rate() =
+      ProtobufUtil::TimeUtil::SecondsToDuration(dns_refresh_seconds_);
+  HttpProtocolOptions stats_protocol_options;
+  stats_protocol_options.mutable_explicit_http_config()->mutable_http2_protocol_options();
+  setProtocolOptions(*stats_cluster, stats_protocol_options);
+  stats_cluster->set_lb_policy(envoy::config::cluster::v3::Cluster::ROUND_ROBIN);
+  stats_cluster->mutable_load_assignment()->set_cluster_name("stats");
+  envoy::config::core::v3::SocketAddress* stats_address =
+      stats_cluster->mutable_load_assignment()
+          ->add_endpoints()
+          ->add_lb_endpoints()
+          ->mutable_endpoint()
+          ->mutable_address()
+          ->mutable_socket_address();
+  stats_address->set_address(stats_domain_);
+  stats_address->set_port_value(443);
+  *stats_cluster->mutable_transport_socket() = tls_socket;
+
+  envoy::config::cluster::v3::Cluster base_cluster;
+  *base_cluster.mutable_connect_timeout() =
+      ProtobufUtil::TimeUtil::SecondsToDuration(connect_timeout_seconds_);
+  base_cluster.set_lb_policy(envoy::config::cluster::v3::Cluster::CLUSTER_PROVIDED);
+  base_cluster.mutable_cluster_type()->set_name("envoy.clusters.dynamic_forward_proxy");
+  envoy::extensions::clusters::dynamic_forward_proxy::v3::ClusterConfig dfp_cluster;
+  *dfp_cluster.mutable_dns_cache_config() = dns_cache_config;
+  base_cluster.mutable_cluster_type()->mutable_typed_config()->PackFrom(dfp_cluster);
+  envoy::config::cluster::v3::UpstreamConnectionOptions* upstream_options =
+      base_cluster.mutable_upstream_connection_options();
+  upstream_options->set_set_local_interface_name_on_upstream_connections(true);
+  upstream_options->mutable_tcp_keepalive()->mutable_keepalive_interval()->set_value(5);
+  upstream_options->mutable_tcp_keepalive()->mutable_keepalive_probes()->set_value(1);
+  upstream_options->mutable_tcp_keepalive()->mutable_keepalive_time()->set_value(10);
+  envoy::config::cluster::v3::CircuitBreakers* circuit_breakers =
+      base_cluster.mutable_circuit_breakers();
+  // Don't impose limits on concurrent retries.
+  envoy::config::cluster::v3::CircuitBreakers::Thresholds* thresholds =
+      circuit_breakers->add_thresholds();
+  thresholds->set_priority(envoy::config::core::v3::RoutingPriority::DEFAULT);
+  thresholds->mutable_retry_budget()->mutable_budget_percent()->set_value(100);
+  thresholds->mutable_retry_budget()->mutable_min_retry_concurrency()->set_value(0xffffffff);
+  envoy::config::cluster::v3::CircuitBreakers::Thresholds* per_host_thresholds =
+      circuit_breakers->add_per_host_thresholds();
+  per_host_thresholds->set_priority(envoy::config::core::v3::RoutingPriority::DEFAULT);
+  per_host_thresholds->mutable_max_connections()->set_value(max_connections_per_host_);
+
+  envoy::config::cluster::v3::Cluster* cluster =
+      bootstrap->mutable_static_resources()->add_clusters();
+  *cluster = base_cluster;
+  cluster->set_name("base");
+  *cluster->mutable_transport_socket() = tls_socket;
+  setProtocolOptions(*cluster, alpn_protocol_options);
+
+  cluster = bootstrap->mutable_static_resources()->add_clusters();
+  *cluster = base_cluster;
+  cluster->set_name("base_clear");
+  *cluster->mutable_transport_socket() = clear_socket;
+  setProtocolOptions(*cluster, h1_protocol_options);
+
+  cluster = bootstrap->mutable_static_resources()->add_clusters();
+  *cluster = base_cluster;
+  cluster->set_name("base_h2");
+  *cluster->mutable_transport_socket() = h2_socket;
+  setProtocolOptions(*cluster, h2_protocol_options);
+
+  cluster = bootstrap->mutable_static_resources()->add_clusters();
+  *cluster = std::move(base_cluster);
+  cluster->set_name("base_h3");
+  *cluster->mutable_transport_socket() = h3_socket;
+  setProtocolOptions(*cluster, h3_protocol_options);
+
+  // Stats.
+  *bootstrap->mutable_stats_flush_interval() =
+      ProtobufUtil::TimeUtil::SecondsToDuration(stats_flush_seconds_);
+  for (const std::string& stat_sink : stat_sinks_) {
+    *bootstrap->add_stats_sinks() = parseYaml<envoy::config::metrics::v3::StatsSink>(stat_sink);
+  }
+  if (!stats_domain_.empty()) {
+    envoy::config::metrics::v3::MetricsServiceConfig metrics_service;
+    metrics_service.set_transport_api_version(envoy::config::core::v3::ApiVersion::V3);
+    metrics_service.mutable_report_counters_as_deltas()->set_value(true);
+    metrics_service.set_emit_tags_as_labels(true);
+    metrics_service.mutable_grpc_service()->mutable_envoy_grpc()->set_cluster_name("stats");
+    envoy::config::metrics::v3::StatsSink* sink = bootstrap->add_stats_sinks();
+    sink->set_name("envoy.metrics_service");
+    sink->mutable_typed_config()->PackFrom(metrics_service);
+  }
+  envoy::config::metrics::v3::StatsConfig* stats_config = bootstrap->mutable_stats_config();
+  for (const char* regex : StatsInclusionPatterns) {
+    stats_config->mutable_stats_matcher()
+        ->mutable_inclusion_list()
+        ->add_patterns()
+        ->mutable_safe_regex()
+        ->set_regex(regex);
+  }
+  stats_config->mutable_use_all_default_tags()->set_value(false);
+
+  envoy::config::bootstrap::v3::Watchdog* watchdog =
+      bootstrap->mutable_watchdogs()->mutable_main_thread_watchdog();
+  *watchdog->mutable_megamiss_timeout() = ProtobufUtil::TimeUtil::SecondsToDuration(60);
+  *watchdog->mutable_miss_timeout() = ProtobufUtil::TimeUtil::SecondsToDuration(60);
+  *bootstrap->mutable_watchdogs()->mutable_worker_watchdog() = *watchdog;
+
+  envoy::config::core::v3::Node* node = bootstrap->mutable_node();
+  node->set_id("envoy-mobile");
+  node->set_cluster("envoy-mobile");
+  auto& metadata = *node->mutable_metadata()->mutable_fields();
+  metadata["device_os"] = ValueUtil::stringValue(device_os_);
+  metadata["app_version"] = ValueUtil::stringValue(app_version_);
+  metadata["app_id"] = ValueUtil::stringValue(app_id_);
+
+  // Runtime.
+  ProtobufWkt::Struct reloadable_features;
+  auto& features = *reloadable_features.mutable_fields();
+  features["allow_multiple_dns_addresses"] = ValueUtil::boolValue(enable_happy_eyeballs_);
+#if defined(__ANDROID_API__)
+  features["always_use_v6"] = ValueUtil::boolValue(true);
+#else
+  features["always_use_v6"] = ValueUtil::boolValue(false);
+#endif
+  features["http2_delay_keepalive_timeout"] = ValueUtil::boolValue(h2_extend_keepalive_timeout_);
+  features["skip_dns_lookup_for_proxied_requests"] = ValueUtil::boolValue(false);
+
+  ProtobufWkt::Struct envoy_layer;
+  // This disables envoy bug stats, which are filtered out of our stats inclusion list anyway.
+  // Global stats do not play well with engines with limited lifetimes.
+  (*envoy_layer.mutable_fields())["disallow_global_stats"] = ValueUtil::boolValue(true);
+  (*envoy_layer.mutable_fields())["reloadable_features"] =
+      ValueUtil::structValue(reloadable_features);
+
+  ProtobufWkt::Struct envoy_mobile_layer;
+  auto& envoy_mobile_fields = *envoy_mobile_layer.mutable_fields();
+  envoy_mobile_fields["callback_latency_sample_rate"] =
+      ValueUtil::numberValue(callback_latency_sample_rate_);
+  envoy_mobile_fields["early_drain"] = ValueUtil::boolValue(enable_early_drain_);
+  envoy_mobile_fields["stream_buffer_budget_bytes"] =
+      ValueUtil::numberValue(stream_buffer_memory_budget_bytes_);
+  envoy_mobile_fields["stream_buffer_limit_bytes"] =
+      ValueUtil::numberValue(stream_buffer_limit_bytes_);
+
+  // Needed due to warning in
+  // https://github.com/envoyproxy/envoy/blob/6eb7e642d33f5a55b63c367188f09819925fca34/source/server/server.cc#L546
+  ProtobufWkt::Struct overload_layer;
+  (*overload_layer.mutable_fields())["global_downstream_max_connections"] =
+      ValueUtil::numberValue(std::numeric_limits<uint32_t>::max());
+
+  envoy::config::bootstrap::v3::RuntimeLayer* static_layer =
+      bootstrap->mutable_layered_runtime()->add_layers();
+  static_layer->set_name("static_layer_0");
+  auto& static_fields = *static_layer->mutable_static_layer()->mutable_fields();
+  static_fields["envoy"] = ValueUtil::structValue(envoy_layer);
+  static_fields["envoy_mobile"] = ValueUtil::structValue(envoy_mobile_layer);
+  static_fields["overload"] = ValueUtil::structValue(overload_layer);
+
+  if (admin_interface_enabled_) {
+    envoy::config::core::v3::SocketAddress* admin_address =
+        bootstrap->mutable_admin()->mutable_address()->mutable_socket_address();
+    admin_address->set_address("::1");
+    admin_address->set_port_value(9901);
+  }
+
+  return bootstrap;
+}
+
 EngineSharedPtr EngineBuilder::build() {
   envoy_logger null_logger;
   null_logger.log = nullptr;
@@ -322,14 +939,39 @@ EngineSharedPtr EngineBuilder::build() {
 
   envoy_event_tracker null_tracker{};
 
+  EngineCallbacksSharedPtr callbacks = this->callbacks_;
+  std::unique_ptr<envoy::config::bootstrap::v3::Bootstrap> bootstrap;
   std::string config_str;
-  if (config_override_for_tests_.empty()) {
-    config_str = this->generateConfigStr();
-  } else {
+  if (!config_override_for_tests_.empty()) {
     config_str = config_override_for_tests_;
+  } else if (config_template_ == config_template) {
+    // The default config is built as a bootstrap, so that no YAML is parsed at startup.
+    std::string cache_key;
+    if (this->bootstrap_cache_ != nullptr) {
+      cache_key = BootstrapCache::key(this->generateConfigStr());
+      bootstrap = this->bootstrap_cache_->read(cache_key);
+    }
+    if (bootstrap == nullptr) {
+      bootstrap = this->generateBootstrap();
+      if (this->bootstrap_cache_ != nullptr) {
+        // The bootstrap is cached once the engine is running with it, so that one the server
+        // rejects isn't read back.
+        callbacks = std::make_shared<EngineCallbacks>();
+        callbacks->on_engine_running = [cache = this->bootstrap_cache_,
+                                        on_engine_running = this->callbacks_->on_engine_running,
+                                        cache_key, serialized = bootstrap->SerializeAsString()]() {
+          cache->save(cache_key, serialized);
+          if (on_engine_running) {
+            on_engine_running();
+          }
+        };
+      }
+    }
+  } else {
+    config_str = this->generateConfigStr();
   }
   envoy_engine_t envoy_engine =
-      init_engine(this->callbacks_->asEnvoyEngineCallbacks(), null_logger, null_tracker);
+      init_engine(callbacks->asEnvoyEngineCallbacks(), null_logger, null_tracker);
 
   for (const auto& [name, store] : key_value_stores_) {
     // TODO(goaway): This leaks, but it's tied to the life of the engine.
@@ -345,12 +987,26 @@ EngineSharedPtr EngineBuilder::build() {
     register_platform_api(name.c_str(), api);
   }
 
-  run_engine(envoy_engine, config_str.c_str(), logLevelToString(this->log_level_).c_str(),
-             this->admin_address_path_for_tests_.c_str());
+  if (bootstrap != nullptr) {
+    run_engine(envoy_engine, std::move(bootstrap), logLevelToString(this->log_level_).c_str(),
+               this->admin_address_path_for_tests_.c_str());
+  } else {
+    run_engine(envoy_engine, config_str.c_str(), logLevelToString(this->log_level_).c_str(),
+               this->admin_address_path_for_tests_.c_str());
+  }
+
+  // Preconnects are queued until the engine is running.
+  for (const PreconnectHost& host : preconnect_hosts_) {
+    preconnect(envoy_engine, host.authority_.c_str(), host.protocol_, host.connections_);
+  }
 
   // we can't construct via std::make_shared
   // because Engine is only constructible as a friend
-  Engine* engine = new Engine(envoy_engine);
+  CallbackWorkersSharedPtr callback_workers;
+  if (this->callback_threads_ > 0) {
+    callback_workers = std::make_shared<CallbackWorkers>(this->callback_threads_);
+  }
+  Engine* engine = new Engine(envoy_engine, std::move(callback_workers));
   auto engine_ptr = EngineSharedPtr(engine);
   return engine_ptr;
 }
@@ -5,7 +5,10 @@
 #include <string>
 #include <vector>
 
+#include "envoy/config/bootstrap/v3/bootstrap.pb.h"
+
 #include "absl/container/flat_hash_map.h"
+#include "bootstrap_cache.h"
 #include "engine.h"
 #include "engine_callbacks.h"
 #include "key_value_store.h"
@@ -32,6 +35,12 @@ public:
   EngineBuilder& addDnsMinRefreshSeconds(int dns_min_refresh_seconds);
   EngineBuilder& addDnsPreresolveHostnames(std::string dns_preresolve_hostnames);
   EngineBuilder& addMaxConnectionsPerHost(int max_connections_per_host);
+  // Establishes connections to each host, given as host or host:port, once the engine is running,
+  // and again when the preferred network changes, so that the first requests to them need not
+  // wait for handshakes.
+  EngineBuilder& addPreconnectHosts(std::vector<std::string> authorities,
+                                    uint32_t connections_per_host = 1,
+                                    envoy_preconnect_protocol_t protocol = ENVOY_PRECONNECT_ALPN);
   EngineBuilder& useDnsSystemResolver(bool use_system_resolver);
   EngineBuilder& addH2ConnectionKeepaliveIdleIntervalMilliseconds(
       int h2_connection_keepalive_idle_interval_milliseconds);
@@ -50,20 +59,59 @@ public:
   EngineBuilder& setDeviceOs(std::string app_id);
   EngineBuilder& setStreamIdleTimeoutSeconds(int stream_idle_timeout_seconds);
   EngineBuilder& setPerTryIdleTimeoutSeconds(int per_try_idle_timeout_seconds);
+  // The default number of bytes buffered per stream. Streams may override it when started.
+  EngineBuilder& setStreamBufferLimitBytes(uint32_t stream_buffer_limit_bytes);
+  // The number of response bytes which may be buffered across all streams in explicit flow
+  // control mode. As buffered bytes approach the budget, the buffer limits of those streams, and
+  // of streams started from then on, are lowered proportionally. 0 disables the budget.
+  EngineBuilder& setStreamBufferMemoryBudgetBytes(uint64_t stream_buffer_memory_budget_bytes);
+  EngineBuilder& setPerConnectionBufferLimitBytes(uint32_t per_connection_buffer_limit_bytes);
+  // Records the latency of one in every callback_latency_sample_rate platform callbacks in the
+  // on_*_callback_latency histograms. 0 disables recording. Slow callbacks are always logged.
+  EngineBuilder& setCallbackLatencySampleRate(uint32_t callback_latency_sample_rate);
+  // Runs stream callbacks on callback_threads threads rather than on the engine's thread, so that
+  // they run in parallel with each other and with the engine. Streams are spread across the
+  // threads by handle, and each stream's callbacks run in order. 0 runs them on the engine's
+  // thread. Only the callbacks move: connections, TLS and filters all still run on the engine's
+  // single event loop, so this does not raise the throughput that loop can sustain.
+  EngineBuilder& setCallbackThreads(uint32_t callback_threads);
+  // Caches the bootstrap which build() generates in `store` once an engine is running with it.
+  // Engines built later with the same options, by the same version of the library, run with the
+  // cached bootstrap rather than generating it. It's replaced when any option changes.
+  EngineBuilder& setBootstrapCache(KeyValueStoreSharedPtr store);
   EngineBuilder& enableGzip(bool gzip_on);
   EngineBuilder& enableBrotli(bool brotli_on);
   EngineBuilder& enableSocketTagging(bool socket_tagging_on);
+  // Coalesces identical GET requests in flight at the same time into a single upstream request,
+  // whose response is delivered to each of them.
+  EngineBuilder& enableRequestCoalescing(bool request_coalescing_on);
+  // Caches responses according to their Cache-Control headers, revalidating stale responses with
+  // their validators. Up to max_memory_bytes of responses are held in memory. If persistent,
+  // responses are also saved to the key value store added as "reserved.platform_store", up to
+  // 1MiB of responses of up to 64KiB each; larger responses are held only in memory.
+  EngineBuilder& enableResponseCache(bool response_cache_on,
+                                     uint64_t max_memory_bytes = 4 * 1024 * 1024,
+                                     bool persistent = false);
   EngineBuilder& enableAdminInterface(bool admin_interface_on);
   EngineBuilder& enableHappyEyeballs(bool happy_eyeballs_on);
   EngineBuilder& enableHttp3(bool http3_on);
   EngineBuilder& enableInterfaceBinding(bool interface_binding_on);
   EngineBuilder& enableDrainPostDnsRefresh(bool drain_post_dns_refresh_on);
+  // Starts accepting streams as soon as the engine's dispatcher is running, rather than once all
+  // clusters have warmed. Streams to a host wait only on that host's DNS resolution, but those
+  // routed to custom clusters which are still warming fail.
+  EngineBuilder& enableEarlyDrain(bool early_drain_on);
   EngineBuilder& enableH2ExtendKeepaliveTimeout(bool h2_extend_keepalive_timeout_on);
   EngineBuilder& enforceTrustChainVerification(bool trust_chain_verification_on);
   EngineBuilder& enablePlatformCertificatesValidation(bool platform_certificates_validation_on);
 
   // this is separated from build() for the sake of testability
   std::string generateConfigStr() const;
+  // Generates the config generateConfigStr() does from the default template, as a bootstrap which
+  // the engine runs with as is, so that no YAML is parsed at startup. Options given as YAML, e.g.
+  // stats sinks and native filter configs, are parsed on their own. build() uses it unless the
+  // builder was given a config template.
+  std::unique_ptr<envoy::config::bootstrap::v3::Bootstrap> generateBootstrap() const;
 
   EngineSharedPtr build();
 
@@ -80,6 +128,12 @@ private:
     std::string typed_config_;
   };
 
+  struct PreconnectHost {
+    std::string authority_;
+    uint32_t connections_;
+    envoy_preconnect_protocol_t protocol_;
+  };
+
   LogLevel log_level_ = LogLevel::info;
   EngineCallbacksSharedPtr callbacks_;
 
@@ -103,9 +157,19 @@ private:
   std::string admin_address_path_for_tests_ = "";
   int stream_idle_timeout_seconds_ = 15;
   int per_try_idle_timeout_seconds_ = 15;
+  uint32_t stream_buffer_limit_bytes_ = 1024000;
+  uint64_t stream_buffer_memory_budget_bytes_ = 0;
+  uint32_t per_connection_buffer_limit_bytes_ = 10485760;
+  uint32_t callback_latency_sample_rate_ = 1;
+  uint32_t callback_threads_ = 0;
+  std::shared_ptr<BootstrapCache> bootstrap_cache_;
   bool gzip_filter_ = true;
   bool brotli_filter_ = false;
   bool socket_tagging_filter_ = false;
+  bool single_flight_filter_ = false;
+  bool response_cache_filter_ = false;
+  uint64_t response_cache_max_memory_bytes_ = 4 * 1024 * 1024;
+  bool response_cache_persistent_ = false;
   bool platform_certificates_validation_on_ = false;
 
   absl::flat_hash_map<std::string, KeyValueStoreSharedPtr> key_value_stores_{};
@@ -114,6 +178,7 @@ private:
   bool enable_happy_eyeballs_ = true;
   bool enable_interface_binding_ = false;
   bool enable_drain_post_dns_refresh_ = false;
+  bool enable_early_drain_ = false;
   bool enforce_trust_chain_verification_ = true;
   bool h2_extend_keepalive_timeout_ = false;
   bool enable_http3_ = false;
@@ -123,6 +188,7 @@ private:
 
   std::vector<NativeFilterConfig> native_filter_chain_;
   std::vector<std::string> platform_filters_;
+  std::vector<PreconnectHost> preconnect_hosts_;
   absl::flat_hash_map<std::string, StringAccessorSharedPtr> string_accessors_;
 };
 
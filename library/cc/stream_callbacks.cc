@@ -10,50 +10,67 @@ namespace Platform {
 
 namespace {
 
+// Runs the callback on the stream's callback worker if the engine has workers, and otherwise on
+// the calling thread.
+template <class Callback>
+void runCallback(const StreamCallbacksSharedPtr& stream_callbacks, Callback callback) {
+  if (CallbackWorkersSharedPtr workers = stream_callbacks->workers.lock()) {
+    workers->post(stream_callbacks->stream, std::move(callback));
+    return;
+  }
+  callback();
+}
+
 void* c_on_headers(envoy_headers headers, bool end_stream, envoy_stream_intel intel,
                    void* context) {
   auto stream_callbacks = *static_cast<StreamCallbacksSharedPtr*>(context);
-  if (stream_callbacks->on_headers.has_value()) {
-    auto raw_headers = envoyHeadersAsRawHeaderMap(headers);
-    ResponseHeadersBuilder builder;
-    for (const auto& pair : raw_headers) {
-      if (pair.first == ":status") {
-        builder.addHttpStatus(std::stoi(pair.second[0]));
+  runCallback(stream_callbacks, [stream_callbacks, headers, end_stream, intel]() {
+    if (stream_callbacks->on_headers.has_value()) {
+      auto raw_headers = envoyHeadersAsRawHeaderMap(headers);
+      ResponseHeadersBuilder builder;
+      for (const auto& pair : raw_headers) {
+        if (pair.first == ":status") {
+          builder.addHttpStatus(std::stoi(pair.second[0]));
+        }
+        builder.set(pair.first, pair.second);
       }
-      builder.set(pair.first, pair.second);
+      auto on_headers = stream_callbacks->on_headers.value();
+      on_headers(builder.build(), end_stream, intel);
+    } else {
+      release_envoy_headers(headers);
     }
-    auto on_headers = stream_callbacks->on_headers.value();
-    on_headers(builder.build(), end_stream, intel);
-  } else {
-    release_envoy_headers(headers);
-  }
+  });
   return context;
 }
 
 void* c_on_data(envoy_data data, bool end_stream, envoy_stream_intel, void* context) {
   auto stream_callbacks = *static_cast<StreamCallbacksSharedPtr*>(context);
-  if (stream_callbacks->on_data.has_value()) {
-    auto on_data = stream_callbacks->on_data.value();
-    on_data(data, end_stream);
-  } else {
-    release_envoy_data(data);
-  }
+  runCallback(stream_callbacks, [stream_callbacks, data, end_stream]() {
+    if (stream_callbacks->on_data.has_value()) {
+      auto on_data = stream_callbacks->on_data.value();
+      on_data(data, end_stream);
+    } else {
+      release_envoy_data(data);
+    }
+  });
   return context;
 }
 
 void* c_on_trailers(envoy_headers metadata, envoy_stream_intel intel, void* context) {
   auto stream_callbacks = *static_cast<StreamCallbacksSharedPtr*>(context);
-  if (stream_callbacks->on_trailers.has_value()) {
-    auto raw_headers = envoyHeadersAsRawHeaderMap(metadata);
-    ResponseTrailersBuilder builder;
-    for (const auto& pair : raw_headers) {
-      builder.set(pair.first, pair.second);
+  runCallback(stream_callbacks, [stream_callbacks, metadata, intel]() {
+    if (stream_callbacks->on_trailers.has_value()) {
+      auto raw_headers = envoyHeadersAsRawHeaderMap(metadata);
+      ResponseTrailersBuilder builder;
+      for (const auto& pair : raw_headers) {
+        builder.set(pair.first, pair.second);
+      }
+      auto on_trailers = stream_callbacks->on_trailers.value();
+      on_trailers(builder.build(), intel);
+    } else {
+      release_envoy_headers(metadata);
     }
-    auto on_trailers = stream_callbacks->on_trailers.value();
-    on_trailers(builder.build(), intel);
-  } else {
-    release_envoy_headers(metadata);
-  }
+  });
   return context;
 }
 
@@ -61,15 +78,17 @@ void* c_on_error(envoy_error raw_error, envoy_stream_intel intel,
                  envoy_final_stream_intel final_intel, void* context) {
   auto stream_callbacks_ptr = static_cast<StreamCallbacksSharedPtr*>(context);
   auto stream_callbacks = *stream_callbacks_ptr;
-  if (stream_callbacks->on_error.has_value()) {
-    EnvoyErrorSharedPtr error = std::make_shared<EnvoyError>();
-    error->error_code = raw_error.error_code;
-    error->message = Data::Utility::copyToString(raw_error.message);
-    error->attempt_count = absl::optional<int>(raw_error.attempt_count);
-    auto on_error = stream_callbacks->on_error.value();
-    on_error(error, intel, final_intel);
-  }
-  release_envoy_error(raw_error);
+  runCallback(stream_callbacks, [stream_callbacks, raw_error, intel, final_intel]() {
+    if (stream_callbacks->on_error.has_value()) {
+      EnvoyErrorSharedPtr error = std::make_shared<EnvoyError>();
+      error->error_code = raw_error.error_code;
+      error->message = Data::Utility::copyToString(raw_error.message);
+      error->attempt_count = absl::optional<int>(raw_error.attempt_count);
+      auto on_error = stream_callbacks->on_error.value();
+      on_error(error, intel, final_intel);
+    }
+    release_envoy_error(raw_error);
+  });
   delete stream_callbacks_ptr;
   return nullptr;
 }
@@ -77,10 +96,12 @@ void* c_on_error(envoy_error raw_error, envoy_stream_intel intel,
 void* c_on_complete(envoy_stream_intel intel, envoy_final_stream_intel final_intel, void* context) {
   auto stream_callbacks_ptr = static_cast<StreamCallbacksSharedPtr*>(context);
   auto stream_callbacks = *stream_callbacks_ptr;
-  if (stream_callbacks->on_complete.has_value()) {
-    auto on_complete = stream_callbacks->on_complete.value();
-    on_complete(intel, final_intel);
-  }
+  runCallback(stream_callbacks, [stream_callbacks, intel, final_intel]() {
+    if (stream_callbacks->on_complete.has_value()) {
+      auto on_complete = stream_callbacks->on_complete.value();
+      on_complete(intel, final_intel);
+    }
+  });
   delete stream_callbacks_ptr;
   return nullptr;
 }
@@ -88,10 +109,12 @@ void* c_on_complete(envoy_stream_intel intel, envoy_final_stream_intel final_int
 void* c_on_cancel(envoy_stream_intel intel, envoy_final_stream_intel final_intel, void* context) {
   auto stream_callbacks_ptr = static_cast<StreamCallbacksSharedPtr*>(context);
   auto stream_callbacks = *stream_callbacks_ptr;
-  if (stream_callbacks->on_cancel.has_value()) {
-    auto on_cancel = stream_callbacks->on_cancel.value();
-    on_cancel(intel, final_intel);
-  }
+  runCallback(stream_callbacks, [stream_callbacks, intel, final_intel]() {
+    if (stream_callbacks->on_cancel.has_value()) {
+      auto on_cancel = stream_callbacks->on_cancel.value();
+      on_cancel(intel, final_intel);
+    }
+  });
   delete stream_callbacks_ptr;
   return nullptr;
 }
@@ -99,14 +122,29 @@ void* c_on_cancel(envoy_stream_intel intel, envoy_final_stream_intel final_intel
 void* c_on_send_window_available(envoy_stream_intel intel, void* context) {
   auto stream_callbacks_ptr = static_cast<StreamCallbacksSharedPtr*>(context);
   auto stream_callbacks = *stream_callbacks_ptr;
-  if (stream_callbacks->on_send_window_available.has_value()) {
-    auto on_send_window_available = stream_callbacks->on_send_window_available.value();
-    on_send_window_available(intel);
-  }
+  runCallback(stream_callbacks, [stream_callbacks, intel]() {
+    if (stream_callbacks->on_send_window_available.has_value()) {
+      auto on_send_window_available = stream_callbacks->on_send_window_available.value();
+      on_send_window_available(intel);
+    }
+  });
   delete stream_callbacks_ptr;
   return nullptr;
 }
 
+void* c_on_response_body_progress(uint64_t bytes_written, envoy_stream_intel intel,
+                                  void* context) {
+  auto stream_callbacks_ptr = static_cast<StreamCallbacksSharedPtr*>(context);
+  auto stream_callbacks = *stream_callbacks_ptr;
+  runCallback(stream_callbacks, [stream_callbacks, bytes_written, intel]() {
+    if (stream_callbacks->on_response_body_progress.has_value()) {
+      auto on_response_body_progress = stream_callbacks->on_response_body_progress.value();
+      on_response_body_progress(bytes_written, intel);
+    }
+  });
+  return context;
+}
+
 } // namespace
 
 envoy_http_callbacks StreamCallbacks::asEnvoyHttpCallbacks() {
@@ -120,6 +158,9 @@ envoy_http_callbacks StreamCallbacks::asEnvoyHttpCallbacks() {
       &c_on_cancel,
       &c_on_send_window_available,
       new StreamCallbacksSharedPtr(shared_from_this()),
+      nullptr,
+      nullptr,
+      &c_on_response_body_progress,
   };
 }
 
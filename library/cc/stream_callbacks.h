@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "absl/types/optional.h"
+#include "callback_workers.h"
 #include "envoy_error.h"
 #include "library/common/types/c_types.h"
 #include "response_headers.h"
@@ -29,6 +30,8 @@ using OnCompleteCallback =
 using OnCancelCallback =
     std::function<void(envoy_stream_intel intel, envoy_final_stream_intel final_intel)>;
 using OnSendWindowAvailableCallback = std::function<void(envoy_stream_intel intel)>;
+using OnResponseBodyProgressCallback =
+    std::function<void(uint64_t bytes_written, envoy_stream_intel intel)>;
 
 // See library/common/types/c_types.h for what these callbacks should do.
 struct StreamCallbacks : public std::enable_shared_from_this<StreamCallbacks> {
@@ -39,6 +42,12 @@ struct StreamCallbacks : public std::enable_shared_from_this<StreamCallbacks> {
   absl::optional<OnCompleteCallback> on_complete;
   absl::optional<OnCancelCallback> on_cancel;
   absl::optional<OnSendWindowAvailableCallback> on_send_window_available;
+  absl::optional<OnResponseBodyProgressCallback> on_response_body_progress;
+
+  // If the engine has callback workers, the stream these callbacks are for and the workers they
+  // run on. The workers are owned by the engine, so that they are never stopped by a callback.
+  envoy_stream_t stream{};
+  CallbackWorkersWeakPtr workers;
 
   envoy_http_callbacks asEnvoyHttpCallbacks();
 };
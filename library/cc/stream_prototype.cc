@@ -11,8 +11,17 @@ StreamPrototype::StreamPrototype(EngineSharedPtr engine) : engine_(engine) {
 
 StreamSharedPtr StreamPrototype::start(bool explicit_flow_control) {
   auto envoy_stream = init_stream(this->engine_->engine_);
-  start_stream(this->engine_->engine_, envoy_stream, this->callbacks_->asEnvoyHttpCallbacks(),
-               explicit_flow_control);
+  envoy_stream_options options = this->options_;
+  options.explicit_flow_control = explicit_flow_control;
+  StreamCallbacksSharedPtr callbacks = this->callbacks_;
+  if (this->engine_->callback_workers_ != nullptr) {
+    // Each stream's callbacks run on the worker its handle maps to.
+    callbacks = std::make_shared<StreamCallbacks>(*this->callbacks_);
+    callbacks->stream = envoy_stream;
+    callbacks->workers = this->engine_->callback_workers_;
+  }
+  start_stream_with_options(this->engine_->engine_, envoy_stream,
+                            callbacks->asEnvoyHttpCallbacks(), options);
   return std::make_shared<Stream>(this->engine_->engine_, envoy_stream);
 }
 
@@ -51,5 +60,30 @@ StreamPrototype& StreamPrototype::setOnSendWindowAvailable(OnSendWindowAvailable
   return *this;
 }
 
+StreamPrototype& StreamPrototype::setBufferLimitBytes(uint32_t buffer_limit_bytes) {
+  this->options_.buffer_limit_bytes = buffer_limit_bytes;
+  return *this;
+}
+
+StreamPrototype& StreamPrototype::setPriority(envoy_stream_priority_t priority) {
+  this->options_.priority = priority;
+  return *this;
+}
+
+StreamPrototype& StreamPrototype::setResponseBodyFile(int fd) {
+  this->options_.write_response_body_to_file = true;
+  this->options_.response_body_fd = fd;
+  return *this;
+}
+
+StreamPrototype&
+StreamPrototype::setOnResponseBodyProgress(OnResponseBodyProgressCallback closure,
+                                           uint32_t progress_bytes, uint32_t progress_interval_ms) {
+  this->callbacks_->on_response_body_progress = closure;
+  this->options_.response_body_progress_bytes = progress_bytes;
+  this->options_.response_body_progress_interval_ms = progress_interval_ms;
+  return *this;
+}
+
 } // namespace Platform
 } // namespace Envoy
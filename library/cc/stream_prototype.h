@@ -29,10 +29,23 @@ public:
   StreamPrototype& setOnComplete(OnCompleteCallback closure);
   StreamPrototype& setOnCancel(OnCancelCallback closure);
   StreamPrototype& setOnSendWindowAvailable(OnSendWindowAvailableCallback closure);
+  // Overrides the engine's default buffer limit for streams started from this prototype.
+  StreamPrototype& setBufferLimitBytes(uint32_t buffer_limit_bytes);
+  // Sets the priority class of streams started from this prototype.
+  StreamPrototype& setPriority(envoy_stream_priority_t priority);
+  // Writes the response bodies of streams started from this prototype to the file rather than
+  // delivering them via on_data. The file must be kept open until the streams complete.
+  StreamPrototype& setResponseBodyFile(int fd);
+  // Reports the progress of response bodies written to file once progress_bytes have been
+  // written or progress_interval_ms have passed. @see envoy_stream_options.
+  StreamPrototype& setOnResponseBodyProgress(OnResponseBodyProgressCallback closure,
+                                             uint32_t progress_bytes = 0,
+                                             uint32_t progress_interval_ms = 0);
 
 private:
   EngineSharedPtr engine_;
   StreamCallbacksSharedPtr callbacks_;
+  envoy_stream_options options_{};
 };
 
 using StreamPrototypeSharedPtr = std::shared_ptr<StreamPrototype>;
@@ -0,0 +1,95 @@
+#include "library/common/buffer/file_reader.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+
+#include "source/common/buffer/buffer_impl.h"
+
+namespace Envoy {
+namespace Buffer {
+
+namespace {
+
+uint64_t pageSize() {
+  static const uint64_t page_size = sysconf(_SC_PAGESIZE);
+  return page_size;
+}
+
+} // namespace
+
+FileReader::FileReader(int fd, uint64_t offset, uint64_t length)
+    : fd_(fd), offset_(offset), remaining_(length) {
+  struct stat file_stat;
+  mappable_ = fstat(fd_, &file_stat) == 0 && S_ISREG(file_stat.st_mode);
+  seekable_ = mappable_;
+  file_size_ = mappable_ ? file_stat.st_size : 0;
+}
+
+FileReader::~FileReader() { close(fd_); }
+
+bool FileReader::read(Instance& buffer, uint64_t max_bytes) {
+  const uint64_t bytes = std::min(remaining_, max_bytes);
+  if (bytes == 0) {
+    return true;
+  }
+  if (mappable_) {
+    // Mapped pages past the end of the file can't be read, so a range which overruns it fails
+    // here rather than when the chunk is sent.
+    if (offset_ + bytes > file_size_) {
+      return false;
+    }
+    if (map(buffer, bytes)) {
+      return true;
+    }
+    // Mapping may fail for files on some filesystems, or for lack of address space, in which
+    // case the file is read, as are files which are not regular files.
+    mappable_ = false;
+  }
+  return copy(buffer, bytes);
+}
+
+bool FileReader::map(Instance& buffer, uint64_t bytes) {
+  // Mappings must start on a page boundary.
+  const uint64_t map_offset = offset_ - offset_ % pageSize();
+  const uint64_t map_length = offset_ - map_offset + bytes;
+  void* mapping =
+      mmap(nullptr, map_length, PROT_READ, MAP_PRIVATE, fd_, static_cast<off_t>(map_offset));
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+
+  auto* fragment = new BufferFragmentImpl(
+      static_cast<const uint8_t*>(mapping) + (offset_ - map_offset), bytes,
+      [mapping, map_length](const void*, size_t, const BufferFragmentImpl* fragment) {
+        munmap(mapping, map_length);
+        delete fragment;
+      });
+  buffer.addBufferFragment(*fragment);
+  offset_ += bytes;
+  remaining_ -= bytes;
+  return true;
+}
+
+bool FileReader::copy(Instance& buffer, uint64_t bytes) {
+  auto reservation = buffer.reserveSingleSlice(bytes);
+  ssize_t rc;
+  do {
+    rc = seekable_ ? pread(fd_, reservation.slice().mem_, bytes, static_cast<off_t>(offset_))
+                   : ::read(fd_, reservation.slice().mem_, bytes);
+  } while (rc < 0 && errno == EINTR);
+  // The file ending before the range does is an error too.
+  if (rc <= 0) {
+    return false;
+  }
+  reservation.commit(rc);
+  offset_ += rc;
+  remaining_ -= rc;
+  return true;
+}
+
+} // namespace Buffer
+} // namespace Envoy
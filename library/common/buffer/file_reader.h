@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "envoy/buffer/buffer.h"
+
+#include "source/common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Buffer {
+
+/**
+ * Reads a range of a file into buffers a chunk at a time, so that only the chunks not yet sent
+ * are resident.
+ *
+ * Regular files are mapped into memory, and each mapped chunk is added to the buffer as a
+ * fragment which is unmapped once drained, so that the file's contents are not copied. Files
+ * which can't be mapped, e.g. pipes, are read instead. Mapped files must not be truncated while
+ * their chunks are buffered.
+ */
+class FileReader : NonCopyable {
+public:
+  /**
+   * @param fd, the file to read, which the reader takes ownership of and closes.
+   * @param offset, the position in the file to start reading at. Ignored for files which are not
+   *        regular files, which are read from their current position.
+   * @param length, the bytes to read.
+   */
+  FileReader(int fd, uint64_t offset, uint64_t length);
+  ~FileReader();
+
+  /**
+   * Adds the next chunk of the range to the buffer.
+   * @param buffer, the buffer to add the chunk to.
+   * @param max_bytes, the largest chunk to add.
+   * @return bool, false if the file could not be read, in which case no more may be read.
+   */
+  bool read(Instance& buffer, uint64_t max_bytes);
+
+  /**
+   * @return uint64_t, the bytes of the range not yet read.
+   */
+  uint64_t remaining() const { return remaining_; }
+
+private:
+  bool map(Instance& buffer, uint64_t bytes);
+  bool copy(Instance& buffer, uint64_t bytes);
+
+  const int fd_;
+  uint64_t offset_;
+  uint64_t remaining_;
+  // Cleared once mapping the file has failed, after which it is read.
+  bool mappable_;
+  // Regular files are read at offset_, others from their current position.
+  bool seekable_;
+  uint64_t file_size_;
+};
+
+using FileReaderPtr = std::unique_ptr<FileReader>;
+
+} // namespace Buffer
+} // namespace Envoy
@@ -0,0 +1,198 @@
+#include "library/common/buffer/file_writer.h"
+
+#include <limits.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <vector>
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/common/assert.h"
+
+namespace Envoy {
+namespace Buffer {
+
+namespace {
+
+// Writes all of the data's slices to the file, returning 0 on success or the errno of the failed
+// write.
+int writeAll(int fd, const Instance& data) {
+  std::vector<iovec> iov;
+  for (const RawSlice& slice : data.getRawSlices()) {
+    if (slice.len_ > 0) {
+      iov.push_back({slice.mem_, slice.len_});
+    }
+  }
+
+  size_t next = 0;
+  while (next < iov.size()) {
+    const int count = static_cast<int>(std::min<size_t>(iov.size() - next, IOV_MAX));
+    const ssize_t rc = ::writev(fd, &iov[next], count);
+    if (rc < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errno;
+    }
+    // Skip the slices written, and advance into a slice written in part.
+    size_t written = rc;
+    while (next < iov.size() && written >= iov[next].iov_len) {
+      written -= iov[next].iov_len;
+      ++next;
+    }
+    if (written > 0) {
+      iov[next].iov_base = static_cast<uint8_t*>(iov[next].iov_base) + written;
+      iov[next].iov_len -= written;
+    }
+  }
+  return 0;
+}
+
+} // namespace
+
+FileWriterThread::Target::Target(int fd, Event::ProvisionalDispatcher& dispatcher,
+                                 FileWriterCallbacks& callbacks,
+                                 std::weak_ptr<bool> alive_indicator)
+    : fd_(::dup(fd)), dup_error_(fd_ < 0 ? errno : 0), dispatcher_(dispatcher),
+      callbacks_(callbacks), alive_indicator_(std::move(alive_indicator)) {}
+
+FileWriterThread::Target::~Target() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+}
+
+FileWriterThread::~FileWriterThread() {
+  std::thread thread;
+  {
+    absl::MutexLock lock(&mutex_);
+    ASSERT(pending_.empty());
+    stopping_ = true;
+    thread = std::move(thread_);
+  }
+  if (thread.joinable()) {
+    thread.join();
+  }
+  // Completions are only left if their posts were dropped. Their targets' writers are gone, so
+  // nothing is reported.
+  std::deque<Completion> completions;
+  {
+    absl::MutexLock lock(&completions_->mutex_);
+    completions.swap(completions_->queue_);
+  }
+}
+
+void FileWriterThread::enqueue(TargetSharedPtr target, std::shared_ptr<Instance> data) {
+  absl::MutexLock lock(&mutex_);
+  if (target->failed_) {
+    return;
+  }
+  pending_.push_back(Write{std::move(target), std::move(data)});
+  if (!thread_.joinable()) {
+    thread_ = std::thread(&FileWriterThread::run, this);
+  }
+}
+
+std::deque<FileWriterThread::Write> FileWriterThread::dequeue(const Target& target) {
+  absl::MutexLock lock(&mutex_);
+  return removeWrites(target);
+}
+
+std::deque<FileWriterThread::Write> FileWriterThread::removeWrites(const Target& target) {
+  std::deque<Write> removed;
+  for (auto it = pending_.begin(); it != pending_.end();) {
+    if (it->target_.get() == &target) {
+      removed.push_back(std::move(*it));
+      it = pending_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  return removed;
+}
+
+void FileWriterThread::run() {
+  while (true) {
+    Write write;
+    {
+      absl::MutexLock lock(&mutex_);
+      mutex_.Await(absl::Condition(this, &FileWriterThread::hasWork));
+      if (stopping_) {
+        return;
+      }
+      write = std::move(pending_.front());
+      pending_.pop_front();
+    }
+
+    // The write is only read here, and is queued for the dispatcher's thread from then on, so that
+    // its data is released there.
+    Target& target = *write.target_;
+    const int error = target.fd_ < 0 ? target.dup_error_ : writeAll(target.fd_, *write.data_);
+    // Nothing more is written for the target once a write has failed. The writes queued for it
+    // are released with the failed one.
+    std::deque<Write> discarded;
+    if (error != 0) {
+      absl::MutexLock lock(&mutex_);
+      target.failed_ = true;
+      discarded = removeWrites(target);
+    }
+    Event::ProvisionalDispatcher& dispatcher = target.dispatcher_;
+    {
+      absl::MutexLock lock(&completions_->mutex_);
+      completions_->queue_.push_back(Completion{std::move(write), std::move(discarded), error});
+    }
+    // The callback only holds a weak reference, so nothing is released here if the post is
+    // dropped. Each callback runs all of the completions queued by then, in order.
+    dispatcher.post([weak_completions = std::weak_ptr<Completions>(completions_)]() {
+      CompletionsSharedPtr completions = weak_completions.lock();
+      if (completions != nullptr) {
+        runCompletions(*completions);
+      }
+    });
+  }
+}
+
+void FileWriterThread::runCompletions(Completions& completions) {
+  std::deque<Completion> completed;
+  {
+    absl::MutexLock lock(&completions.mutex_);
+    completed.swap(completions.queue_);
+  }
+  for (const Completion& completion : completed) {
+    Target& target = *completion.write_.target_;
+    // A callback may destroy the writer of a later completion, whose write is then not reported.
+    if (target.alive_indicator_.expired()) {
+      continue;
+    }
+    if (completion.error_ != 0) {
+      target.callbacks_.onWriteError(completion.error_);
+    } else {
+      target.callbacks_.onWritten(completion.write_.data_->length());
+    }
+  }
+}
+
+FileWriter::FileWriter(int fd, FileWriterThreadSharedPtr thread,
+                       Event::ProvisionalDispatcher& dispatcher, FileWriterCallbacks& callbacks)
+    : thread_(std::move(thread)), target_(std::make_shared<FileWriterThread::Target>(
+                                      fd, dispatcher, callbacks, alive_indicator_)) {}
+
+FileWriter::~FileWriter() {
+  // The data not yet written is released here, on the dispatcher's thread. A write in progress
+  // holds its own reference to the target, and so to the file.
+  thread_->dequeue(*target_);
+}
+
+void FileWriter::write(Instance& data) {
+  if (data.length() == 0) {
+    return;
+  }
+  auto batch = std::make_shared<OwnedImpl>();
+  batch->move(data);
+  thread_->enqueue(target_, std::move(batch));
+}
+
+} // namespace Buffer
+} // namespace Envoy
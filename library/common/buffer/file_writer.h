@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <thread>
+
+#include "envoy/buffer/buffer.h"
+#include "envoy/common/pure.h"
+
+#include "source/common/common/non_copyable.h"
+
+#include "absl/synchronization/mutex.h"
+#include "library/common/event/provisional_dispatcher.h"
+
+namespace Envoy {
+namespace Buffer {
+
+/**
+ * Notified of the progress of a FileWriter, on the dispatcher's thread.
+ */
+class FileWriterCallbacks {
+public:
+  virtual ~FileWriterCallbacks() = default;
+
+  /**
+   * Called when data passed to FileWriter::write() has been written, in the order it was passed.
+   * @param bytes, the bytes written.
+   */
+  virtual void onWritten(uint64_t bytes) PURE;
+
+  /**
+   * Called when writing failed. No more data is written.
+   * @param error, the errno of the failed write.
+   */
+  virtual void onWriteError(int error) PURE;
+};
+
+/**
+ * A background thread shared by FileWriters, which writes their data in the order it was queued.
+ * The thread is started by the first write queued. The writers sharing it must share a dispatcher,
+ * and it must be destroyed on the dispatcher's thread.
+ */
+class FileWriterThread : NonCopyable {
+public:
+  FileWriterThread() = default;
+
+  /**
+   * Stops the thread, waiting for a write in progress to finish. Writers share ownership of the
+   * thread, so this happens once the last of them has been destroyed. Writes whose completion
+   * could not be posted, e.g. once the dispatcher has terminated, are released here.
+   */
+  ~FileWriterThread();
+
+private:
+  friend class FileWriter;
+
+  // The state of a writer which its writes in progress need, shared so that the writer can be
+  // destroyed without waiting for them.
+  struct Target {
+    Target(int fd, Event::ProvisionalDispatcher& dispatcher, FileWriterCallbacks& callbacks,
+           std::weak_ptr<bool> alive_indicator);
+    ~Target();
+
+    // The writer's own duplicate of the file, or -1 if it could not be duplicated, in which case
+    // the errno of the failed dup().
+    const int fd_;
+    const int dup_error_;
+    Event::ProvisionalDispatcher& dispatcher_;
+    FileWriterCallbacks& callbacks_;
+    // Expires with the writer, so that writes completing after it is destroyed are not reported.
+    const std::weak_ptr<bool> alive_indicator_;
+    // Set once a write has failed, after which nothing more is written. Guarded by the thread's
+    // mutex_.
+    bool failed_{};
+  };
+  using TargetSharedPtr = std::shared_ptr<Target>;
+
+  struct Write {
+    TargetSharedPtr target_;
+    std::shared_ptr<Instance> data_;
+  };
+
+  // A finished write, along with the writes discarded if it failed, waiting to be reported and
+  // released on the dispatcher's thread.
+  struct Completion {
+    Write write_;
+    std::deque<Write> discarded_;
+    int error_{};
+  };
+
+  // Owned by the thread, and only referenced weakly by the posted callbacks, so that if a post is
+  // dropped no data is released off the dispatcher's thread.
+  struct Completions {
+    absl::Mutex mutex_;
+    std::deque<Completion> queue_ ABSL_GUARDED_BY(mutex_);
+  };
+  using CompletionsSharedPtr = std::shared_ptr<Completions>;
+
+  void enqueue(TargetSharedPtr target, std::shared_ptr<Instance> data);
+  // Removes the writes queued for the target, which are returned so that they can be released
+  // outside of the lock.
+  std::deque<Write> dequeue(const Target& target);
+  std::deque<Write> removeWrites(const Target& target) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void run();
+  // Reports the completed writes, and releases them, on the dispatcher's thread.
+  static void runCompletions(Completions& completions);
+  bool hasWork() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return stopping_ || !pending_.empty();
+  }
+
+  absl::Mutex mutex_;
+  std::deque<Write> pending_ ABSL_GUARDED_BY(mutex_);
+  bool stopping_ ABSL_GUARDED_BY(mutex_){};
+  std::thread thread_ ABSL_GUARDED_BY(mutex_);
+  const CompletionsSharedPtr completions_{std::make_shared<Completions>()};
+};
+
+using FileWriterThreadSharedPtr = std::shared_ptr<FileWriterThread>;
+
+/**
+ * Writes data to a file on a background thread, so that slow storage does not stall the
+ * dispatcher.
+ *
+ * Each write() hands the data's slices to the writer thread as they are, which writes them with
+ * writev(). The slices are released on the dispatcher's thread once written, as are any drain
+ * trackers attached to them: in the callback posted to report the write or, if the post is
+ * dropped, when the FileWriterThread is destroyed.
+ */
+class FileWriter : NonCopyable {
+public:
+  /**
+   * @param fd, the file to write to, which must be blocking. The writer writes to its own
+   *        duplicate of it, so the caller may close it once the writer has been destroyed.
+   * @param thread, the thread which writes the data.
+   * @param dispatcher, the dispatcher the callbacks are called on.
+   * @param callbacks, notified as writes complete.
+   */
+  FileWriter(int fd, FileWriterThreadSharedPtr thread, Event::ProvisionalDispatcher& dispatcher,
+             FileWriterCallbacks& callbacks);
+
+  /**
+   * Discards the data not yet written, without waiting for a write in progress to finish. No more
+   * callbacks are called.
+   */
+  ~FileWriter();
+
+  /**
+   * Queues data to be written after that already queued, draining it from the buffer.
+   */
+  void write(Instance& data);
+
+private:
+  const FileWriterThreadSharedPtr thread_;
+  std::shared_ptr<bool> alive_indicator_{std::make_shared<bool>(true)};
+  const FileWriterThread::TargetSharedPtr target_;
+};
+
+using FileWriterPtr = std::unique_ptr<FileWriter>;
+
+} // namespace Buffer
+} // namespace Envoy
@@ -0,0 +1,112 @@
+#include "library/common/common/slab_pool.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <utility>
+
+#include "source/common/common/assert.h"
+
+namespace Envoy {
+
+namespace {
+
+size_t alignUp(size_t size, size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+SlabPool::Ptr SlabPool::create(size_t block_size, size_t blocks_per_slab) {
+  return Ptr{new SlabPool(block_size, blocks_per_slab)};
+}
+
+SlabPool::SlabPool(size_t block_size, size_t blocks_per_slab)
+    : stride_(sizeof(BlockHeader) + alignUp(block_size, alignof(BlockHeader))),
+      blocks_per_slab_(blocks_per_slab) {
+  ASSERT(blocks_per_slab_ > 0);
+}
+
+void* SlabPool::allocate() {
+  if (free_list_ == nullptr) {
+    addSlab();
+  }
+  BlockHeader* header = free_list_;
+  free_list_ = header->next_free_;
+  header->pool_ = this;
+  ++outstanding_;
+  return header + 1;
+}
+
+void SlabPool::deallocate(void* block) {
+  BlockHeader* header = static_cast<BlockHeader*>(block) - 1;
+  SlabPool* pool = header->pool_;
+  ASSERT(pool->outstanding_ > 0);
+  header->next_free_ = pool->free_list_;
+  pool->free_list_ = header;
+  if (--pool->outstanding_ == 0 && pool->released_) {
+    delete pool;
+  }
+}
+
+void SlabPool::release() {
+  ASSERT(!released_);
+  released_ = true;
+  if (outstanding_ == 0) {
+    delete this;
+  }
+}
+
+void SlabPool::trim() {
+  // Blocks are freed in any order, so the free blocks of each slab are counted by looking up the
+  // slab each free block lies in.
+  std::vector<std::pair<const char*, size_t>> starts;
+  starts.reserve(slabs_.size());
+  for (size_t i = 0; i < slabs_.size(); ++i) {
+    starts.emplace_back(slabs_[i].get(), i);
+  }
+  std::sort(starts.begin(), starts.end());
+  const auto slab_of = [&starts](const BlockHeader* header) {
+    const char* block = reinterpret_cast<const char*>(header);
+    auto it = std::upper_bound(starts.begin(), starts.end(),
+                               std::make_pair(block, std::numeric_limits<size_t>::max()));
+    ASSERT(it != starts.begin());
+    return std::prev(it)->second;
+  };
+
+  std::vector<size_t> free_blocks(slabs_.size());
+  for (const BlockHeader* header = free_list_; header != nullptr; header = header->next_free_) {
+    ++free_blocks[slab_of(header)];
+  }
+
+  // Drop the free blocks of the slabs being freed from the free list, keeping the others' order.
+  BlockHeader** next = &free_list_;
+  while (*next != nullptr) {
+    if (free_blocks[slab_of(*next)] == blocks_per_slab_) {
+      *next = (*next)->next_free_;
+    } else {
+      next = &(*next)->next_free_;
+    }
+  }
+  size_t kept = 0;
+  for (size_t i = 0; i < slabs_.size(); ++i) {
+    if (free_blocks[i] != blocks_per_slab_) {
+      slabs_[kept++] = std::move(slabs_[i]);
+    }
+  }
+  slabs_.resize(kept);
+}
+
+void SlabPool::addSlab() {
+  // operator new[] returns storage aligned for any fundamental type, and stride_ is a multiple of
+  // that alignment, so every block in the slab is suitably aligned.
+  slabs_.emplace_back(new char[stride_ * blocks_per_slab_]);
+  char* slab = slabs_.back().get();
+  for (size_t i = blocks_per_slab_; i > 0; --i) {
+    BlockHeader* header = reinterpret_cast<BlockHeader*>(slab + (i - 1) * stride_);
+    header->next_free_ = free_list_;
+    free_list_ = header;
+  }
+}
+
+} // namespace Envoy
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace Envoy {
+
+/**
+ * Fixed-size block allocator which carves blocks out of slabs of contiguous memory, recycling
+ * freed blocks via an intrusive free list. Intended for objects which are created and destroyed
+ * at a high rate, such as per-request state, to avoid a round trip through the global allocator
+ * for each one.
+ *
+ * Each block is prefixed with a pointer to its pool, so that a block can be returned via the
+ * static deallocate() without the caller knowing which pool it came from. This allows the pool to
+ * back a class-specific operator delete.
+ *
+ * The owner of the pool releases it rather than deleting it: blocks may outlive their owner (for
+ * example when they are pending deferred deletion), and the pool frees itself once the last
+ * outstanding block has been returned.
+ *
+ * Not thread-safe: all allocation and deallocation must happen on one thread at a time.
+ */
+class SlabPool {
+public:
+  struct Releaser {
+    void operator()(SlabPool* pool) const { pool->release(); }
+  };
+  using Ptr = std::unique_ptr<SlabPool, Releaser>;
+
+  /**
+   * @param block_size, the size in bytes of each block handed out by allocate().
+   * @param blocks_per_slab, the number of blocks allocated at once when the free list is empty.
+   */
+  static Ptr create(size_t block_size, size_t blocks_per_slab);
+
+  /**
+   * @return void*, storage for block_size bytes, aligned to alignof(std::max_align_t).
+   */
+  void* allocate();
+
+  /**
+   * Returns a block to the pool it was allocated from.
+   * @param block, a pointer previously returned by allocate() on any pool.
+   */
+  static void deallocate(void* block);
+
+  /**
+   * Frees the slabs all of whose blocks are free, e.g. once a burst of allocations has passed.
+   */
+  void trim();
+
+  /**
+   * @return size_t, the number of blocks which have been allocated but not yet deallocated.
+   */
+  size_t outstanding() const { return outstanding_; }
+
+  /**
+   * @return size_t, the number of blocks held by the pool, whether outstanding or free.
+   */
+  size_t capacity() const { return slabs_.size() * blocks_per_slab_; }
+
+private:
+  union BlockHeader {
+    // Set while the block is outstanding.
+    SlabPool* pool_;
+    // Set while the block is on the free list.
+    BlockHeader* next_free_;
+    std::max_align_t align_;
+  };
+
+  SlabPool(size_t block_size, size_t blocks_per_slab);
+  ~SlabPool() = default;
+
+  void release();
+  void addSlab();
+
+  // The size of each block including its header, rounded up to preserve alignment.
+  const size_t stride_;
+  const size_t blocks_per_slab_;
+  std::vector<std::unique_ptr<char[]>> slabs_;
+  BlockHeader* free_list_{};
+  size_t outstanding_{};
+  bool released_{};
+};
+
+} // namespace Envoy
@@ -77,8 +77,10 @@ const char* brotli_config_insert = R"(
 
 const char* default_cert_validation_context_template = R"(
 - &validation_context
-  trusted_ca:
-    inline_string: *tls_root_certs
+  custom_validator_config:
+    name: "envoy_mobile.cert_validator.root_certificates_cert_validator"
+    typed_config:
+      "@type": type.googleapis.com/envoy_mobile.extensions.cert_validator.root_certificates.RootCertificatesCertValidator
   trust_chain_verification: *trust_chain_verification
 )";
 
@@ -97,6 +99,38 @@ const char* socket_tag_config_insert = R"(
       "@type": type.googleapis.com/envoymobile.extensions.filters.http.socket_tag.SocketTag
 )";
 
+const char* single_flight_config_insert = R"(
+  - name: envoy.filters.http.single_flight
+    typed_config:
+      "@type": type.googleapis.com/envoymobile.extensions.filters.http.single_flight.SingleFlight
+      key_headers: [accept, accept-encoding, accept-language, authorization, cookie, range]
+)";
+
+const char* response_cache_config_insert = R"(
+  - name: envoy.filters.http.cache
+    typed_config:
+      "@type": type.googleapis.com/envoy.extensions.filters.http.cache.v3.CacheConfig
+      typed_config:
+        "@type": type.googleapis.com/envoymobile.extensions.http.cache.mobile.MobileHttpCacheConfig
+        max_memory_bytes: *response_cache_max_memory_bytes
+)";
+
+const char* persistent_response_cache_config_insert = R"(
+  - name: envoy.filters.http.cache
+    typed_config:
+      "@type": type.googleapis.com/envoy.extensions.filters.http.cache.v3.CacheConfig
+      typed_config:
+        "@type": type.googleapis.com/envoymobile.extensions.http.cache.mobile.MobileHttpCacheConfig
+        max_memory_bytes: *response_cache_max_memory_bytes
+        persistent_store_config:
+          config:
+            name: envoy.key_value.platform
+            typed_config:
+              "@type": type.googleapis.com/envoymobile.extensions.key_value.platform.PlatformKeyValueStoreConfig
+              key: envoy_mobile.response_cache
+              save_interval: 10s
+)";
+
 // clang-format off
 const std::string config_header = R"(
 !ignore default_defs:
@@ -120,16 +154,22 @@ R"(- &dns_resolver_name envoy.network.dns_resolver.getaddrinfo
 - &dns_resolver_config {"@type":"type.googleapis.com/envoy.extensions.network.dns_resolver.getaddrinfo.v3.GetAddrInfoDnsResolverConfig"}
 )"
 #endif
-R"(- &enable_drain_post_dns_refresh false
+R"(- &callback_latency_sample_rate 1
+- &enable_drain_post_dns_refresh false
+- &enable_early_drain false
 - &enable_interface_binding false
 - &h2_connection_keepalive_idle_interval 100000s
 - &h2_connection_keepalive_timeout 10s
 - &h2_delay_keepalive_timeout false
 - &max_connections_per_host 7
 - &metadata {}
+- &per_connection_buffer_limit 10485760
+- &response_cache_max_memory_bytes 4194304
 - &stats_domain 127.0.0.1
 - &stats_flush_interval 60s
 - &stats_sinks []
+- &stream_buffer_budget 0
+- &stream_buffer_limit 1024000
 - &stream_idle_timeout 15s
 - &per_try_idle_timeout 15s
 - &trust_chain_verification VERIFY_TRUST_CHAIN
@@ -154,15 +194,12 @@ R"(- &enable_drain_post_dns_refresh false
         address: ::1
         port_value: 9901
 
-!ignore tls_root_ca_defs: &tls_root_certs |
-)"
-#include "certificates.inc"
-R"(
-
 !ignore validation_context_defs:
 - &validation_context
-  trusted_ca:
-    inline_string: *tls_root_certs
+  custom_validator_config:
+    name: "envoy_mobile.cert_validator.root_certificates_cert_validator"
+    typed_config:
+      "@type": type.googleapis.com/envoy_mobile.extensions.cert_validator.root_certificates.RootCertificatesCertValidator
   trust_chain_verification: *trust_chain_verification
 )";
 
@@ -364,7 +401,7 @@ static_resources:
         protocol: TCP
         address: 0.0.0.0
         port_value: 10000
-    per_connection_buffer_limit_bytes: 10485760 # 10MB
+    per_connection_buffer_limit_bytes: *per_connection_buffer_limit
     api_listener:
       api_listener:
         "@type": type.googleapis.com/envoy.extensions.filters.network.http_connection_manager.v3.EnvoyMobileHttpConnectionManager
@@ -494,6 +531,8 @@ stats_config:
             regex: '^pbf_filter.*'
         - safe_regex:
             regex: '^pulse.*'
+        - safe_regex:
+            regex: '^startup\..*'
         - safe_regex:
             regex: '^vhost\.[\w]+\.vcluster\.[\w]+?\.upstream_rq_(?:[12345]xx|[3-5][0-9][0-9]|retry.*|timeout|total)'
   use_all_default_tags:
@@ -522,6 +561,11 @@ layered_runtime:
             always_use_v6: *force_ipv6
             http2_delay_keepalive_timeout: *h2_delay_keepalive_timeout
             skip_dns_lookup_for_proxied_requests: *skip_dns_lookup_for_proxied_requests
+        envoy_mobile:
+          callback_latency_sample_rate: *callback_latency_sample_rate
+          early_drain: *enable_early_drain
+          stream_buffer_budget_bytes: *stream_buffer_budget
+          stream_buffer_limit_bytes: *stream_buffer_limit
 )"
 // Needed due to warning in
 // https://github.com/envoyproxy/envoy/blob/6eb7e642d33f5a55b63c367188f09819925fca34/source/server/server.cc#L546
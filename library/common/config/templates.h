@@ -77,6 +77,25 @@ extern const char* brotli_config_insert;
  */
 extern const char* socket_tag_config_insert;
 
+/**
+ * Insert that enables the single flight filter in the filter chain, which coalesces identical
+ * GET requests in flight at the same time into a single upstream request. Requests are only
+ * coalesced when their key headers match, in addition to their method, authority and path.
+ */
+extern const char* single_flight_config_insert;
+
+/**
+ * Insert that enables the response cache filter in the filter chain, holding cached responses in
+ * memory only.
+ */
+extern const char* response_cache_config_insert;
+
+/**
+ * Insert that enables the response cache filter in the filter chain, holding cached responses in
+ * memory and saving them to the platform key value store registered as "reserved.platform_store".
+ */
+extern const char* persistent_response_cache_config_insert;
+
 /**
  * Insert that enables the route cache reset filter in the filter chain.
  * Should only be added when the route cache should be cleared on every request
@@ -87,8 +106,8 @@ extern const char* socket_tag_config_insert;
 extern const char* route_cache_reset_filter_insert;
 
 /**
- * Config template which uses Envoy's built-in certificates validator to verify
- * certificate chain.
+ * Config template which verifies certificate chains against the root certificates
+ * compiled into the library.
  */
 extern const char* default_cert_validation_context_template;
 
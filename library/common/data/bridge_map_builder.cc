@@ -0,0 +1,51 @@
+#include "library/common/data/bridge_map_builder.h"
+
+#include <cstring>
+
+#include "source/common/common/assert.h"
+
+namespace Envoy {
+namespace Data {
+
+void BridgeMapBuilder::allocate() {
+  ASSERT(!allocated_);
+  allocated_ = true;
+  const size_t entries_size = sizeof(envoy_map_entry) * capacity_;
+  uint8_t* block = static_cast<uint8_t*>(safe_malloc(entries_size + bytes_));
+  map_.entries = reinterpret_cast<envoy_map_entry*>(block);
+  next_byte_ = block + entries_size;
+}
+
+void BridgeMapBuilder::add(absl::string_view key, absl::string_view value) {
+  if (!allocated_) {
+    allocate();
+  }
+  RELEASE_ASSERT(static_cast<size_t>(map_.length) < capacity_,
+                 "BridgeMapBuilder: more entries added than reserved");
+  envoy_data bridge_key = copy(key);
+  envoy_data bridge_value = copy(value);
+  map_.entries[map_.length++] = {bridge_key, bridge_value};
+}
+
+envoy_data BridgeMapBuilder::copy(absl::string_view str) {
+  RELEASE_ASSERT(str.size() <= bytes_, "BridgeMapBuilder: more bytes added than reserved");
+  uint8_t* bytes = next_byte_;
+  if (!str.empty()) {
+    memcpy(bytes, str.data(), str.size()); // NOLINT(safe-memcpy)
+  }
+  next_byte_ += str.size();
+  bytes_ -= str.size();
+  return {str.size(), bytes, envoy_noop_release, nullptr};
+}
+
+envoy_map BridgeMapBuilder::finish() {
+  if (!allocated_) {
+    allocate();
+  }
+  envoy_map map = map_;
+  map_ = {0, nullptr};
+  return map;
+}
+
+} // namespace Data
+} // namespace Envoy
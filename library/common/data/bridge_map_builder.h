@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+
+#include "absl/strings/string_view.h"
+#include "library/common/types/c_types.h"
+
+namespace Envoy {
+namespace Data {
+
+/**
+ * Builds an envoy_map (or envoy_headers) in a single allocation, which holds the entry array
+ * followed by the bytes of every key and value. Each entry's envoy_data has a no-op release, so
+ * the whole block is freed by the usual release_envoy_map/release_envoy_headers.
+ *
+ * Space for every entry must be reserved before the first call to add(). The entries added must
+ * not need more bytes than were reserved in total.
+ */
+class BridgeMapBuilder {
+public:
+  /**
+   * Accounts for entries which will be added.
+   * @param entries, the number of entries.
+   * @param bytes, the combined length of the entries' keys and values.
+   */
+  void reserve(size_t entries, size_t bytes) {
+    capacity_ += entries;
+    bytes_ += bytes;
+  }
+
+  /**
+   * Copies an entry into the block, allocating the block on first use.
+   * @param key, the entry's key.
+   * @param value, the entry's value.
+   */
+  void add(absl::string_view key, absl::string_view value);
+
+  /**
+   * @return envoy_map, the map built so far. Ownership of the block is transferred to the caller.
+   */
+  envoy_map finish();
+
+private:
+  void allocate();
+  envoy_data copy(absl::string_view str);
+
+  size_t capacity_{};
+  size_t bytes_{};
+  envoy_map map_{0, nullptr};
+  uint8_t* next_byte_{};
+  bool allocated_{};
+};
+
+} // namespace Data
+} // namespace Envoy
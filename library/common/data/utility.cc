@@ -28,13 +28,55 @@ Buffer::InstancePtr toInternalData(envoy_data data) {
   return buf;
 }
 
+namespace {
+
+void releaseSlice(void* context) { delete static_cast<Buffer::SliceData*>(context); }
+
+void releaseString(void* context) { delete static_cast<std::string*>(context); }
+
+// Moves the first slice out of data, transferring ownership of its storage to the envoy_data.
+envoy_data extractFrontSlice(Buffer::Instance& data) {
+  Buffer::SliceDataPtr slice = data.extractMutableFrontSlice();
+  absl::Span<uint8_t> bytes = slice->getMutableData();
+  return {bytes.size(), bytes.data(), releaseSlice, slice.release()};
+}
+
+} // namespace
+
 envoy_data toBridgeData(Buffer::Instance& data, uint32_t max_bytes) {
   updateMaxBytes(max_bytes, data);
+  if (max_bytes > 0 && data.frontSlice().len_ == max_bytes) {
+    return extractFrontSlice(data);
+  }
   envoy_data bridge_data = copyToBridgeData(data, max_bytes);
   data.drain(bridge_data.length);
   return bridge_data;
 }
 
+BridgeDataVector toBridgeDataVector(Buffer::Instance& data, uint32_t max_bytes) {
+  updateMaxBytes(max_bytes, data);
+  BridgeDataVector bridge_data;
+  while (max_bytes > 0) {
+    const uint64_t slice_length = data.frontSlice().len_;
+    if (slice_length > max_bytes) {
+      bridge_data.push_back(copyToBridgeData(data, max_bytes));
+      data.drain(max_bytes);
+      break;
+    }
+    bridge_data.push_back(extractFrontSlice(data));
+    max_bytes -= slice_length;
+  }
+  return bridge_data;
+}
+
+envoy_data toBridgeData(std::string&& str) {
+  if (str.empty()) {
+    return envoy_nodata;
+  }
+  auto* owned = new std::string(std::move(str));
+  return {owned->size(), reinterpret_cast<const uint8_t*>(owned->data()), releaseString, owned};
+}
+
 envoy_data copyToBridgeData(absl::string_view str) {
   uint8_t* buffer = static_cast<uint8_t*>(safe_malloc(sizeof(uint8_t) * str.length()));
   memcpy(buffer, str.data(), str.length()); // NOLINT(safe-memcpy)
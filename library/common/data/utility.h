@@ -2,6 +2,7 @@
 
 #include "envoy/buffer/buffer.h"
 
+#include "absl/container/inlined_vector.h"
 #include "library/common/types/c_types.h"
 
 namespace Envoy {
@@ -15,14 +16,38 @@ namespace Utility {
  */
 Buffer::InstancePtr toInternalData(envoy_data data);
 
+using BridgeDataVector = absl::InlinedVector<envoy_data, 16>;
+
 /**
- * Transform from Buffer::Instance to envoy_data.
+ * Transform from Buffer::Instance to envoy_data. The transformed bytes are drained from the
+ * Buffer::Instance. If they make up exactly the buffer's first slice, that slice is moved out of
+ * the buffer and handed over without copying; the slice is freed when the envoy_data is released.
+ * Otherwise the bytes are copied.
  * @param data, the Buffer::Instance to transform.
- * @param max_bytes, the maximum bytes to transform or 0 to copy all available data.
+ * @param max_bytes, the maximum bytes to transform or 0 to transform all available data.
  * @return envoy_data, the bridge transformation of the Buffer::Instance param.
  */
 envoy_data toBridgeData(Buffer::Instance& data, uint32_t max_bytes = 0);
 
+/**
+ * Transform from Buffer::Instance to one envoy_data per slice, without copying. The transformed
+ * slices are moved out of the Buffer::Instance; only a slice which straddles max_bytes has the
+ * bytes before the boundary copied.
+ * @param data, the Buffer::Instance to transform.
+ * @param max_bytes, the maximum bytes to transform or 0 to transform all available data.
+ * @return BridgeDataVector, the bridge transformation of the Buffer::Instance param. Each element
+ * must be released individually.
+ */
+BridgeDataVector toBridgeDataVector(Buffer::Instance& data, uint32_t max_bytes = 0);
+
+/**
+ * Transform from std::string to envoy_data without copying. The string is moved into the
+ * envoy_data, and freed when it is released.
+ * @param str, the string to transform.
+ * @return envoy_data, the bridge transformation of the string param.
+ */
+envoy_data toBridgeData(std::string&& str);
+
 /**
  * Copy from string to envoy_data.
  * @param str, the string to copy.
@@ -1,5 +1,9 @@
 #include "library/common/engine.h"
 
+#include <algorithm>
+#include <limits>
+
+#include "envoy/runtime/runtime.h"
 #include "envoy/stats/histogram.h"
 
 #include "source/common/common/lock_guard.h"
@@ -7,11 +11,30 @@
 #include "library/common/bridge/utility.h"
 #include "library/common/config/internal.h"
 #include "library/common/data/utility.h"
+#include "library/common/extensions/key_value/platform/config.h"
 #include "library/common/network/android.h"
 #include "library/common/stats/utility.h"
 
 namespace Envoy {
 
+namespace {
+
+constexpr absl::string_view StreamBufferLimitKey = "envoy_mobile.stream_buffer_limit_bytes";
+constexpr absl::string_view StreamBufferBudgetKey = "envoy_mobile.stream_buffer_budget_bytes";
+constexpr absl::string_view CallbackLatencySampleRateKey =
+    "envoy_mobile.callback_latency_sample_rate";
+constexpr absl::string_view EarlyDrainKey = "envoy_mobile.early_drain";
+
+// Reads a runtime integer which is stored as a uint32_t, saturating rather than truncating values
+// which don't fit.
+uint32_t getUint32(const Runtime::Snapshot& runtime, absl::string_view key,
+                   uint32_t default_value) {
+  return static_cast<uint32_t>(std::min<uint64_t>(runtime.getInteger(key, default_value),
+                                                  std::numeric_limits<uint32_t>::max()));
+}
+
+} // namespace
+
 Engine::Engine(envoy_engine_callbacks callbacks, envoy_logger logger,
                envoy_event_tracker event_tracker)
     : callbacks_(callbacks), logger_(logger), event_tracker_(event_tracker),
@@ -26,32 +49,44 @@ Engine::Engine(envoy_engine_callbacks callbacks, envoy_logger logger,
 
 envoy_status_t Engine::run(const std::string config, const std::string log_level,
                            const std::string admin_address_path) {
+  startup_trace_ = std::make_unique<StartupTrace>(time_source_);
   // Start the Envoy on the dedicated thread. Note: due to how the assignment operator works with
   // std::thread, main_thread_ is the same object after this call, but its state is replaced with
   // that of the temporary. The temporary object's state becomes the default state, which does
   // nothing.
-  main_thread_ = std::thread(&Engine::main, this, std::string(config), std::string(log_level),
-                             admin_address_path);
+  main_thread_ = std::thread(&Engine::main, this, std::string(config), nullptr,
+                             std::string(log_level), admin_address_path);
+  return ENVOY_SUCCESS;
+}
+
+envoy_status_t Engine::run(std::unique_ptr<envoy::config::bootstrap::v3::Bootstrap> bootstrap,
+                           const std::string log_level, const std::string admin_address_path) {
+  startup_trace_ = std::make_unique<StartupTrace>(time_source_);
+  main_thread_ = std::thread(&Engine::main, this, std::string(), std::move(bootstrap),
+                             std::string(log_level), admin_address_path);
   return ENVOY_SUCCESS;
 }
 
-envoy_status_t Engine::main(const std::string config, const std::string log_level,
-                            const std::string admin_address_path) {
+envoy_status_t Engine::main(const std::string config,
+                            std::unique_ptr<envoy::config::bootstrap::v3::Bootstrap> bootstrap,
+                            const std::string log_level, const std::string admin_address_path) {
   // Using unique_ptr ensures main_common's lifespan is strictly scoped to this function.
   std::unique_ptr<EngineCommon> main_common;
   const std::string name = "envoy";
   const std::string config_flag = "--config-yaml";
-  const std::string composed_config = absl::StrCat(config_header, config);
   const std::string log_flag = "-l";
   const std::string concurrency_option = "--concurrency";
   const std::string concurrency_arg = "0";
-  std::vector<const char*> envoy_argv = {name.c_str(),
-                                         config_flag.c_str(),
-                                         composed_config.c_str(),
-                                         concurrency_option.c_str(),
-                                         concurrency_arg.c_str(),
-                                         log_flag.c_str(),
+  std::vector<const char*> envoy_argv = {name.c_str(), concurrency_option.c_str(),
+                                         concurrency_arg.c_str(), log_flag.c_str(),
                                          log_level.c_str()};
+  // A bootstrap is handed to the server as is, and there's no YAML to parse.
+  std::string composed_config;
+  if (bootstrap == nullptr) {
+    composed_config = absl::StrCat(config_header, config);
+    envoy_argv.push_back(config_flag.c_str());
+    envoy_argv.push_back(composed_config.c_str());
+  }
   if (!admin_address_path.empty()) {
     envoy_argv.push_back("--admin-address-path");
     envoy_argv.push_back(admin_address_path.c_str());
@@ -75,6 +110,7 @@ envoy_status_t Engine::main(const std::string config, const std::string log_leve
             });
       }
 
+      startup_trace_->begin(StartupPhase::LogDelegate);
       // We let the thread clean up this log delegate pointer
       if (logger_.log) {
         log_delegate_ptr_ =
@@ -83,11 +119,22 @@ envoy_status_t Engine::main(const std::string config, const std::string log_leve
         log_delegate_ptr_ =
             std::make_unique<Logger::DefaultDelegate>(log_mutex_, Logger::Registry::getSink());
       }
+      startup_trace_->end(StartupPhase::LogDelegate);
 
-      main_common = std::make_unique<EngineCommon>(envoy_argv.size() - 1, envoy_argv.data());
+      startup_trace_->begin(StartupPhase::EngineCommon);
+      main_common =
+          std::make_unique<EngineCommon>(envoy_argv.size() - 1, envoy_argv.data(), bootstrap.get());
+      startup_trace_->end(StartupPhase::EngineCommon);
       server_ = main_common->server();
       event_dispatcher_ = &server_->dispatcher();
 
+      // Resolutions complete on the server's dispatcher, so none has completed before it runs.
+      auto dns_cache =
+          Network::ConnectivityManagerFactory{server_->serverFactoryContext()}.get()->dnsCache();
+      if (dns_cache != nullptr) {
+        startup_trace_->traceDnsResolution(*dns_cache);
+      }
+
       cv_.notifyAll();
     } catch (const Envoy::NoServingException& e) {
       PANIC(e.what());
@@ -97,47 +144,33 @@ envoy_status_t Engine::main(const std::string config, const std::string log_leve
       PANIC(e.what());
     }
 
-    // Note: We're waiting longer than we might otherwise to drain to the main thread's dispatcher.
-    // This is because we're not simply waiting for its availability and for it to have started, but
-    // also because we're waiting for clusters to have done their first attempt at DNS resolution.
-    // When we improve synchronous failure handling and/or move to dynamic forwarding, we only need
-    // to wait until the dispatcher is running (and can drain by enqueueing a drain callback on it,
-    // as we did previously).
-
+    // By default the engine starts accepting streams at PostInit, once clusters have made their
+    // first attempt at DNS resolution. In early drain mode it does so as soon as the main
+    // dispatcher is running, with the API listener, and streams through the dynamic forward proxy
+    // clusters only wait on the resolution of their own host.
+    const auto start_client = [this]() -> void {
+      ASSERT(Thread::MainThread::isMainOrTestThread());
+      if (http_client_ == nullptr) {
+        startClient();
+      }
+    };
     postinit_callback_handler_ = main_common->server()->lifecycleNotifier().registerCallback(
-        Envoy::Server::ServerLifecycleNotifier::Stage::PostInit, [this]() -> void {
-          ASSERT(Thread::MainThread::isMainOrTestThread());
-
-          connectivity_manager_ =
-              Network::ConnectivityManagerFactory{server_->serverFactoryContext()}.get();
-          Envoy::Network::Android::Utility::setAlternateGetifaddrs();
-          auto v4_interfaces = connectivity_manager_->enumerateV4Interfaces();
-          auto v6_interfaces = connectivity_manager_->enumerateV6Interfaces();
-          logInterfaces("netconf_get_v4_interfaces", v4_interfaces);
-          logInterfaces("netconf_get_v6_interfaces", v6_interfaces);
-          client_scope_ = server_->serverFactoryContext().scope().createScope("pulse.");
-          // StatNameSet is lock-free, the benefit of using it is being able to create StatsName
-          // on-the-fly without risking contention on system with lots of threads.
-          // It also comes with ease of programming.
-          stat_name_set_ = client_scope_->symbolTable().makeSet("pulse");
-          auto api_listener = server_->listenerManager().apiListener()->get().http();
-          ASSERT(api_listener.has_value());
-          http_client_ = std::make_unique<Http::Client>(api_listener.value(), *dispatcher_,
-                                                        server_->serverFactoryContext().scope(),
-                                                        server_->api().randomGenerator());
-          dispatcher_->drain(server_->dispatcher());
-          if (callbacks_.on_engine_running != nullptr) {
-            callbacks_.on_engine_running(callbacks_.context);
-          }
-        });
+        Envoy::Server::ServerLifecycleNotifier::Stage::PostInit, start_client);
+    if (server_->runtime().snapshot().getBoolean(EarlyDrainKey, false)) {
+      startup_callback_handler_ = main_common->server()->lifecycleNotifier().registerCallback(
+          Envoy::Server::ServerLifecycleNotifier::Stage::StartUp, start_client);
+    }
   } // mutex_
 
   // The main run loop must run without holding the mutex, so that the destructor can acquire it.
+  startup_trace_->begin(StartupPhase::ServerInit);
   bool run_success = main_common->run();
   // The above call is blocking; at this point the event loop has exited.
 
   // Ensure destructors run on Envoy's main thread.
   postinit_callback_handler_.reset(nullptr);
+  startup_callback_handler_.reset(nullptr);
+  startup_trace_.reset();
   connectivity_manager_.reset();
   client_scope_.reset();
   stat_name_set_.reset();
@@ -290,6 +323,33 @@ envoy_status_t Engine::makeAdminCall(absl::string_view path, absl::string_view m
 
 Event::ProvisionalDispatcher& Engine::dispatcher() { return *dispatcher_; }
 
+envoy_status_t Engine::enqueueStreamCommand(const Http::StreamCommand& command) {
+  if (!stream_commands_.enqueue(command)) {
+    // A drain is already scheduled and will pick this command up.
+    return ENVOY_SUCCESS;
+  }
+  return scheduleStreamCommandDrain();
+}
+
+envoy_status_t Engine::scheduleStreamCommandDrain() {
+  envoy_status_t status = dispatcher_->post([this]() -> void { drainStreamCommands(); });
+  if (status != ENVOY_SUCCESS) {
+    stream_commands_.onWakeupFailed();
+  }
+  return status;
+}
+
+void Engine::drainStreamCommands() {
+  ASSERT(dispatcher_->isThreadSafe(), "stream commands must be drained from dispatcher's context");
+  const uint64_t drained = stream_commands_.drain(
+      [this](Http::StreamCommand& command) -> void { http_client_->runCommand(command); });
+  // Yield to the event loop before running any remaining commands.
+  if (drained == Http::StreamCommandQueue::MaxCommandsPerDrain &&
+      stream_commands_.rescheduleDrain()) {
+    scheduleStreamCommandDrain();
+  }
+}
+
 Http::Client& Engine::httpClient() {
   RELEASE_ASSERT(dispatcher_->isThreadSafe(),
                  "httpClient must be accessed from dispatcher's context");
@@ -308,12 +368,79 @@ void Engine::flushStats() {
   server_->flushStats();
 }
 
+void Engine::suspend() {
+  ASSERT(dispatcher_->isThreadSafe(), "suspend must be called from the dispatcher's context");
+  // Streams may be started while suspended, so each call drains and trims again.
+  suspended_ = true;
+  ENVOY_LOG(debug, "suspending engine");
+
+  // Idle connections are closed now, and active ones once their streams complete, taking their
+  // buffers, TLS state and keepalive timers with them. TLS sessions remain cached, so that
+  // connections made once resumed can resume them.
+  server_->clusterManager().drainConnections(nullptr);
+  server_->flushStats();
+  Extensions::KeyValue::flushPlatformKeyValueStores(server_->dispatcher());
+  http_client_->trimMemory();
+}
+
+void Engine::resume() {
+  ASSERT(dispatcher_->isThreadSafe(), "resume must be called from the dispatcher's context");
+  if (!suspended_) {
+    return;
+  }
+  suspended_ = false;
+  ENVOY_LOG(debug, "resuming engine");
+
+  connectivity_manager_->refreshDns(connectivity_manager_->getConfigurationKey(), false);
+}
+
 Upstream::ClusterManager& Engine::getClusterManager() {
   ASSERT(dispatcher_->isThreadSafe(),
          "getClusterManager must be called from the dispatcher's context");
   return server_->clusterManager();
 }
 
+void Engine::startClient() {
+  startup_trace_->end(StartupPhase::ServerInit);
+  startup_trace_->begin(StartupPhase::PostInit);
+
+  connectivity_manager_ =
+      Network::ConnectivityManagerFactory{server_->serverFactoryContext()}.get();
+  Envoy::Network::Android::Utility::setAlternateGetifaddrs();
+  auto v4_interfaces = connectivity_manager_->enumerateV4Interfaces();
+  auto v6_interfaces = connectivity_manager_->enumerateV6Interfaces();
+  logInterfaces("netconf_get_v4_interfaces", v4_interfaces);
+  logInterfaces("netconf_get_v6_interfaces", v6_interfaces);
+  client_scope_ = server_->serverFactoryContext().scope().createScope("pulse.");
+  // StatNameSet is lock-free, the benefit of using it is being able to create StatsName
+  // on-the-fly without risking contention on system with lots of threads.
+  // It also comes with ease of programming.
+  stat_name_set_ = client_scope_->symbolTable().makeSet("pulse");
+  auto api_listener = server_->listenerManager().apiListener()->get().http();
+  ASSERT(api_listener.has_value());
+  // Buffer limits and callback latency sampling are configured through the bootstrap's static
+  // runtime layer.
+  const Runtime::Snapshot& runtime = server_->runtime().snapshot();
+  Http::StreamBufferBudget buffer_budget(
+      getUint32(runtime, StreamBufferLimitKey, Http::StreamBufferBudget::DefaultStreamLimit),
+      runtime.getInteger(StreamBufferBudgetKey, 0));
+  Http::CallbackLatencySampler callback_latency_sampler(
+      getUint32(runtime, CallbackLatencySampleRateKey, 1));
+  http_client_ = std::make_unique<Http::Client>(api_listener.value(), *dispatcher_,
+                                                server_->serverFactoryContext().scope(),
+                                                server_->api().randomGenerator(), buffer_budget,
+                                                callback_latency_sampler);
+  startup_trace_->end(StartupPhase::PostInit);
+
+  startup_trace_->begin(StartupPhase::Drain);
+  dispatcher_->drain(server_->dispatcher());
+  startup_trace_->end(StartupPhase::Drain);
+  startup_trace_->onEngineRunning(server_->serverFactoryContext().scope(), event_tracker_);
+  if (callbacks_.on_engine_running != nullptr) {
+    callbacks_.on_engine_running(callbacks_.context);
+  }
+}
+
 void Engine::logInterfaces(absl::string_view event,
                            std::vector<Network::InterfacePair>& interfaces) {
   std::vector<std::string> names;
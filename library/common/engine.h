@@ -1,8 +1,10 @@
 #pragma once
 
+#include "envoy/config/bootstrap/v3/bootstrap.pb.h"
 #include "envoy/server/lifecycle_notifier.h"
 
 #include "source/common/common/logger.h"
+#include "source/common/event/real_time_system.h"
 #include "source/extensions/clusters/logical_dns/logical_dns_cluster.h"
 
 #include "absl/base/call_once.h"
@@ -10,7 +12,9 @@
 #include "library/common/common/lambda_logger_delegate.h"
 #include "library/common/engine_common.h"
 #include "library/common/http/client.h"
+#include "library/common/http/stream_command_queue.h"
 #include "library/common/network/connectivity_manager.h"
+#include "library/common/startup_trace.h"
 #include "library/common/types/c_types.h"
 
 namespace Envoy {
@@ -39,6 +43,15 @@ public:
   envoy_status_t run(std::string config, std::string log_level,
                      const std::string admin_address_path);
 
+  /**
+   * Run the engine with the provided bootstrap, which is used as is rather than parsed from YAML.
+   * @param bootstrap, the Envoy bootstrap configuration to use.
+   * @param log_level, the log level.
+   * @param admin_address_path to set --admin-address-path, or an empty string if not needed.
+   */
+  envoy_status_t run(std::unique_ptr<envoy::config::bootstrap::v3::Bootstrap> bootstrap,
+                     std::string log_level, const std::string admin_address_path);
+
   /**
    * Immediately terminate the engine, if running.
    */
@@ -50,6 +63,14 @@ public:
    */
   Event::ProvisionalDispatcher& dispatcher();
 
+  /**
+   * Enqueue a stream operation to be run against the http client. May be called from any thread.
+   * A burst of commands only wakes up the dispatcher once.
+   * @param command, the stream operation. Ownership of its payload is transferred to the engine.
+   * @return envoy_status_t, ENVOY_FAILURE if the dispatcher is no longer accepting work.
+   */
+  envoy_status_t enqueueStreamCommand(const Http::StreamCommand& command);
+
   /**
    * Accessor for the http client. Must be called from the dispatcher's context.
    * @return Http::Client&, the (default) http client.
@@ -124,15 +145,38 @@ public:
    */
   void flushStats();
 
+  /**
+   * Releases the memory the engine doesn't need while the app is in the background: connections
+   * are drained, so that idle ones are closed, stats and the platform key value stores are flushed,
+   * and the memory held for completed streams is freed. Streams may still be started, and connect
+   * on demand, so a suspended engine may be suspended again to release what they used. Must be
+   * called from the dispatcher's context.
+   */
+  void suspend();
+
+  /**
+   * Resumes a suspended engine, refreshing the DNS cache, whose results may be stale, and
+   * reconnecting to preconnected hosts. Other connections are made on demand. Must be called from
+   * the dispatcher's context.
+   */
+  void resume();
+
   /**
    * Get cluster manager from the Engine.
    */
   Upstream::ClusterManager& getClusterManager();
 
 private:
-  envoy_status_t main(std::string config, std::string log_level, std::string admin_address_path);
+  envoy_status_t main(std::string config,
+                      std::unique_ptr<envoy::config::bootstrap::v3::Bootstrap> bootstrap,
+                      std::string log_level, std::string admin_address_path);
   static void logInterfaces(absl::string_view event,
                             std::vector<Network::InterfacePair>& interfaces);
+  envoy_status_t scheduleStreamCommandDrain();
+  void drainStreamCommands();
+  // Sets up the HTTP client on the main thread, then drains the calls dispatched before it existed
+  // and notifies the platform that the engine is running.
+  void startClient();
 
   Event::Dispatcher* event_dispatcher_{};
   Stats::ScopeSharedPtr client_scope_;
@@ -147,11 +191,20 @@ private:
   Http::ClientPtr http_client_;
   Network::ConnectivityManagerSharedPtr connectivity_manager_;
   Event::ProvisionalDispatcherPtr dispatcher_;
+  // Stream operations issued from platform threads, drained in batches on the dispatcher.
+  Http::StreamCommandQueue stream_commands_;
   // Used by the cerr logger to ensure logs don't overwrite each other.
   absl::Mutex log_mutex_;
   Logger::EventTrackingDelegatePtr log_delegate_ptr_{};
   Server::Instance* server_{};
   Server::ServerLifecycleNotifier::HandlePtr postinit_callback_handler_;
+  // Registered in early drain mode, to start the client before PostInit.
+  Server::ServerLifecycleNotifier::HandlePtr startup_callback_handler_;
+  Event::RealTimeSystem time_source_;
+  // Whether resume() has anything to refresh.
+  bool suspended_{};
+  // Created when the engine is run, and destroyed on the main thread before the server.
+  StartupTracePtr startup_trace_;
   // main_thread_ should be destroyed first, hence it is the last member variable. Objects with
   // instructions scheduled on the main_thread_ need to have a longer lifetime.
   std::thread main_thread_{}; // Empty placeholder to be populated later.
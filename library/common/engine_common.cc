@@ -5,9 +5,26 @@
 
 namespace Envoy {
 
-EngineCommon::EngineCommon(int argc, const char* const* argv)
-    : options_(argc, argv, &MainCommon::hotRestartVersion, spdlog::level::info),
-      base_(options_, real_time_system_, default_listener_hooks_, prod_component_factory_,
+namespace {
+
+std::unique_ptr<OptionsImpl> makeOptions(int argc, const char* const* argv,
+                                         const envoy::config::bootstrap::v3::Bootstrap* bootstrap) {
+  auto options = std::make_unique<OptionsImpl>(argc, argv, &MainCommon::hotRestartVersion,
+                                               spdlog::level::info);
+  if (bootstrap != nullptr) {
+    // The server merges the config proto into the bootstrap it loads. Without a config path or
+    // YAML on the command line, it's the only config.
+    options->setConfigProto(*bootstrap);
+  }
+  return options;
+}
+
+} // namespace
+
+EngineCommon::EngineCommon(int argc, const char* const* argv,
+                           const envoy::config::bootstrap::v3::Bootstrap* bootstrap)
+    : options_(makeOptions(argc, argv, bootstrap)),
+      base_(*options_, real_time_system_, default_listener_hooks_, prod_component_factory_,
             std::make_unique<PlatformImpl>(), std::make_unique<Random::RandomGeneratorImpl>(),
             nullptr) {
   // Disabling signal handling in the options makes it so that the server's event dispatcher _does
@@ -17,7 +34,7 @@ EngineCommon::EngineCommon(int argc, const char* const* argv)
   // https://github.com/envoyproxy/envoy-mobile/issues/831. Ignoring termination signals makes it
   // more likely that the event loop will only exit due to Engine destruction
   // https://github.com/envoyproxy/envoy-mobile/blob/a72a51e64543882ea05fba3c76178b5784d39cdc/library/common/engine.cc#L105.
-  options_.setSignalHandling(false);
+  options_->setSignalHandling(false);
 }
 
 } // namespace Envoy
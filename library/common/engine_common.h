@@ -1,5 +1,8 @@
 #pragma once
 
+#include <memory>
+
+#include "envoy/config/bootstrap/v3/bootstrap.pb.h"
 #include "envoy/event/timer.h"
 #include "envoy/server/instance.h"
 
@@ -22,7 +25,14 @@ namespace Envoy {
  */
 class EngineCommon {
 public:
-  EngineCommon(int argc, const char* const* argv);
+  /**
+   * @param argc, the number of command line arguments.
+   * @param argv, the command line arguments.
+   * @param bootstrap, the bootstrap config to run with, or nullptr to run with that given on the
+   *        command line. If given, it's used as is, so that no config is parsed at startup.
+   */
+  EngineCommon(int argc, const char* const* argv,
+               const envoy::config::bootstrap::v3::Bootstrap* bootstrap = nullptr);
   bool run() { return base_.run(); }
 
   /**
@@ -40,7 +50,8 @@ private:
 #endif
 
   Thread::MainThread register_main_thread_;
-  Envoy::OptionsImpl options_;
+  // Created before the server is, so that the bootstrap may be set on it.
+  std::unique_ptr<Envoy::OptionsImpl> options_;
   Event::RealTimeSystem real_time_system_; // NO_CHECK_FORMAT(real_time)
   DefaultListenerHooks default_listener_hooks_;
   ProdComponentFactory prod_component_factory_;
@@ -10,6 +10,14 @@ envoy_status_t EngineHandle::runOnEngineDispatcher(envoy_engine_t handle,
   return ENVOY_FAILURE;
 }
 
+envoy_status_t EngineHandle::dispatchStreamCommand(envoy_engine_t handle,
+                                                   const Http::StreamCommand& command) {
+  if (auto engine = reinterpret_cast<Envoy::Engine*>(handle)) {
+    return engine->enqueueStreamCommand(command);
+  }
+  return ENVOY_FAILURE;
+}
+
 envoy_engine_t EngineHandle::initEngine(envoy_engine_callbacks callbacks, envoy_logger logger,
                                         envoy_event_tracker event_tracker) {
   auto engine = new Envoy::Engine(callbacks, logger, event_tracker);
@@ -25,6 +33,17 @@ envoy_status_t EngineHandle::runEngine(envoy_engine_t handle, const char* config
   return ENVOY_FAILURE;
 }
 
+envoy_status_t
+EngineHandle::runEngine(envoy_engine_t handle,
+                        std::unique_ptr<envoy::config::bootstrap::v3::Bootstrap> bootstrap,
+                        const char* log_level, const char* admin_address_path) {
+  if (auto engine = reinterpret_cast<Envoy::Engine*>(handle)) {
+    engine->run(std::move(bootstrap), log_level, admin_address_path);
+    return ENVOY_SUCCESS;
+  }
+  return ENVOY_FAILURE;
+}
+
 void EngineHandle::terminateEngine(envoy_engine_t handle, bool release) {
   auto engine = reinterpret_cast<Envoy::Engine*>(handle);
   engine->terminate();
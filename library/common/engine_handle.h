@@ -22,11 +22,24 @@ public:
   static envoy_status_t runOnEngineDispatcher(envoy_engine_t engine,
                                               std::function<void(Envoy::Engine&)> func);
 
+  /**
+   * Enqueue a stream operation on the provided engine. Stream operations are batched and run on
+   * the engine's dispatcher in the order they were issued, with a single wakeup per batch.
+   * @param envoy_engine_t, handle to the engine which will run the command.
+   * @param command, the stream operation. Ownership of its payload is transferred to the engine.
+   * @return envoy_status_t, ENVOY_FAILURE if the engine does not exist or is no longer running.
+   */
+  static envoy_status_t dispatchStreamCommand(envoy_engine_t engine,
+                                              const Http::StreamCommand& command);
+
 private:
   static envoy_engine_t initEngine(envoy_engine_callbacks callbacks, envoy_logger logger,
                                    envoy_event_tracker event_tracker);
   static envoy_status_t runEngine(envoy_engine_t, const char* config, const char* log_level,
                                   const char* admin_address_path);
+  static envoy_status_t
+  runEngine(envoy_engine_t, std::unique_ptr<envoy::config::bootstrap::v3::Bootstrap> bootstrap,
+            const char* log_level, const char* admin_address_path);
   static void terminateEngine(envoy_engine_t handle, bool release);
 
   // Allow a specific list of functions to access the internal setup/teardown functionality.
@@ -34,6 +47,9 @@ private:
                                        envoy_event_tracker event_tracker);
   friend envoy_status_t(::run_engine)(envoy_engine_t, const char* config, const char* log_level,
                                       const char* admin_address_path);
+  friend envoy_status_t(::run_engine)(
+      envoy_engine_t, std::unique_ptr<envoy::config::bootstrap::v3::Bootstrap> bootstrap,
+      const char* log_level, const char* admin_address_path);
   friend void ::terminate_engine(envoy_engine_t engine, bool release);
 };
 
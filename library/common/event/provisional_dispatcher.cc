@@ -1,50 +1,130 @@
 #include "library/common/event/provisional_dispatcher.h"
 
-#include "source/common/common/lock_guard.h"
+#include <thread>
 
-#include "library/common/thread/lock_guard.h"
+#include "source/common/common/assert.h"
 
 namespace Envoy {
 namespace Event {
 
+ProvisionalDispatcher::~ProvisionalDispatcher() {
+  // Any callbacks which never ran are simply discarded.
+  while (PostNode* node = pop()) {
+    delete node;
+  }
+}
+
 void ProvisionalDispatcher::drain(Event::Dispatcher& event_dispatcher) {
   // TODO(goaway): Must be called from the Event::Dispatcher's thread, but we can't assert here
   // because of behavioral oddities in Event::Dispatcher: event_dispatcher_->isThreadSafe() will
   // crash.
-  Thread::LockGuard lock(state_lock_);
+  event_dispatcher_ = &event_dispatcher;
 
-  // Don't perform any work on the dispatcher if marked as terminated.
-  if (terminated_) {
-    event_dispatcher.exit();
-    return;
+  uint32_t state = 0;
+  if (!state_.compare_exchange_strong(state, Drained)) {
+    // Posts may be in flight, but the only other transition is to terminated, and in that case no
+    // work should be performed on the dispatcher.
+    RELEASE_ASSERT(!(state & Drained), "ProvisionalDispatcher::drain must only occur once");
+    if (state & Terminated) {
+      event_dispatcher.exit();
+      return;
+    }
+    // Only in-flight posts prevented the exchange; retry while preserving their count.
+    while (!state_.compare_exchange_weak(state, state | Drained)) {
+      if (state & Terminated) {
+        event_dispatcher.exit();
+        return;
+      }
+    }
   }
 
-  RELEASE_ASSERT(!drained_, "ProvisionalDispatcher::drain must only occur once");
-  drained_ = true;
-  event_dispatcher_ = &event_dispatcher;
-
-  for (const Event::PostCb& cb : init_queue_) {
-    event_dispatcher_->post(cb);
+  // Prior to draining, nothing consumes the queue, so it is non-empty iff head_ has moved. Posts
+  // which raced with the transition above will have observed Drained and scheduled a wakeup
+  // themselves.
+  if (head_.load() != tail_) {
+    scheduleWakeup();
   }
 }
 
 envoy_status_t ProvisionalDispatcher::post(Event::PostCb callback) {
-  Thread::LockGuard lock(state_lock_);
+  const uint32_t state = state_.fetch_add(PostInFlight);
 
   // Don't perform any work on the dispatcher if marked as terminated.
-  if (terminated_) {
+  if (state & Terminated) {
+    state_.fetch_sub(PostInFlight);
     return ENVOY_FAILURE;
   }
 
-  if (drained_) {
-    event_dispatcher_->post(callback);
-    return ENVOY_SUCCESS;
-  }
+  push(new PostNode(std::move(callback)));
 
-  init_queue_.push_back(callback);
+  // Prior to draining, the callback is run once drain() is called. Afterwards, only the first post
+  // since the last run of the queue needs to wake up the Event::Dispatcher.
+  if (state_.load() & Drained) {
+    scheduleWakeup();
+  }
+  state_.fetch_sub(PostInFlight);
   return ENVOY_SUCCESS;
 }
 
+void ProvisionalDispatcher::push(Node* node) {
+  node->next_.store(nullptr, std::memory_order_relaxed);
+  Node* prev = head_.exchange(node);
+  prev->next_.store(node, std::memory_order_release);
+}
+
+ProvisionalDispatcher::PostNode* ProvisionalDispatcher::pop() {
+  Node* tail = tail_;
+  Node* next = tail->next_.load(std::memory_order_acquire);
+  if (tail == &stub_) {
+    if (next == nullptr) {
+      return nullptr;
+    }
+    tail_ = next;
+    tail = next;
+    next = next->next_.load(std::memory_order_acquire);
+  }
+  if (next != nullptr) {
+    tail_ = next;
+    return static_cast<PostNode*>(tail);
+  }
+  if (tail != head_.load(std::memory_order_acquire)) {
+    // A producer has swapped head_ but not yet linked its node. It will schedule a wakeup once it
+    // has done so.
+    return nullptr;
+  }
+  // tail is the last node: re-insert the stub so that tail can be unlinked.
+  push(&stub_);
+  next = tail->next_.load(std::memory_order_acquire);
+  if (next != nullptr) {
+    tail_ = next;
+    return static_cast<PostNode*>(tail);
+  }
+  return nullptr;
+}
+
+void ProvisionalDispatcher::scheduleWakeup() {
+  if (!wakeup_pending_.exchange(true)) {
+    event_dispatcher_->post([this]() -> void { runPostedCallbacks(); });
+  }
+}
+
+void ProvisionalDispatcher::runPostedCallbacks() {
+  // Clear the pending flag before popping, so that any post which is not observed below schedules
+  // another wakeup.
+  wakeup_pending_.store(false);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  for (uint32_t i = 0; i < MaxCallbacksPerWakeup; ++i) {
+    std::unique_ptr<PostNode> node{pop()};
+    if (!node) {
+      return;
+    }
+    node->callback_();
+  }
+  // Yield to the event loop before continuing with any remaining callbacks.
+  scheduleWakeup();
+}
+
 Event::SchedulableCallbackPtr
 ProvisionalDispatcher::createSchedulableCallback(std::function<void()> cb) {
   RELEASE_ASSERT(
@@ -53,10 +133,16 @@ ProvisionalDispatcher::createSchedulableCallback(std::function<void()> cb) {
   return event_dispatcher_->createSchedulableCallback(cb);
 }
 
+Event::TimerPtr ProvisionalDispatcher::createTimer(Event::TimerCb cb) {
+  RELEASE_ASSERT(isThreadSafe(),
+                 "ProvisionalDispatcher::createTimer must be called from a threadsafe context");
+  return event_dispatcher_->createTimer(cb);
+}
+
 bool ProvisionalDispatcher::isThreadSafe() const {
-  // Doesn't require locking because if a thread has a stale view of drained_, then by definition
-  // this wasn't a threadsafe call.
-  return ABSL_TS_UNCHECKED_READ(drained_) && event_dispatcher_->isThreadSafe();
+  // If a thread has a stale view of the drained bit, then by definition this wasn't a threadsafe
+  // call.
+  return (state_.load(std::memory_order_acquire) & Drained) && event_dispatcher_->isThreadSafe();
 }
 
 void ProvisionalDispatcher::deferredDelete(DeferredDeletablePtr&& to_delete) {
@@ -89,11 +175,15 @@ bool ProvisionalDispatcher::trackedObjectStackIsEmpty() const {
 TimeSource& ProvisionalDispatcher::timeSource() { return event_dispatcher_->timeSource(); }
 
 void ProvisionalDispatcher::terminate() {
-  Thread::LockGuard lock(state_lock_);
-  if (drained_) {
+  const uint32_t state = state_.fetch_or(Terminated);
+  // Wait for posts which observed the non-terminated state to finish handing their callbacks to
+  // the Event::Dispatcher, as it may be destroyed once it exits.
+  while (state_.load() >= PostInFlight) {
+    std::this_thread::yield();
+  }
+  if (state & Drained) {
     event_dispatcher_->exit();
   }
-  terminated_ = true;
 }
 
 } // namespace Event
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+
 #include "envoy/event/deferred_deletable.h"
 #include "envoy/event/dispatcher.h"
 
@@ -14,11 +17,15 @@ namespace Event {
  * Wrapper around Envoy's Event::Dispatcher that queues callbacks until drain() is called. Future
  * versions may support correct calling semantics after the Event::Dispatcher has been
  * terminated/deleted or before it has been created.
+ *
+ * The implementation is lock-free: posted callbacks are pushed onto an intrusive multi-producer,
+ * single-consumer queue which is run on the Event::Dispatcher's thread. Once drained, a burst of
+ * posts results in a single post to the underlying Event::Dispatcher, rather than one per callback.
  */
 class ProvisionalDispatcher : public ScopeTracker {
 public:
   ProvisionalDispatcher() = default;
-  virtual ~ProvisionalDispatcher() = default;
+  virtual ~ProvisionalDispatcher();
 
   // ScopeTracker
   void pushTrackedObject(const ScopeTrackedObject* object) override;
@@ -31,13 +38,11 @@ public:
    */
   virtual void drain(Event::Dispatcher& event_dispatcher);
 
-  // TODO(goaway): return ENVOY_FAILURE after the underlying dispatcher has exited.
   /**
-   * Before the Event::Dispatcher is running, queues posted callbacks; afterwards passes them
-   * through.
+   * Queues a callback to be run on the Event::Dispatcher's thread. Before the Event::Dispatcher is
+   * running, callbacks are held until drain() is called. May be called from any thread.
    * @param callback, the callback to be dispatched.
-   * @return should return ENVOY_FAILURE when the Event::Dispatcher exits, but at present it
-   * always returns ENVOY_SUCCESS.
+   * @return ENVOY_FAILURE once terminate() has been called, otherwise ENVOY_SUCCESS.
    */
   virtual envoy_status_t post(Event::PostCb callback);
 
@@ -50,6 +55,13 @@ public:
    */
   virtual Event::SchedulableCallbackPtr createSchedulableCallback(std::function<void()> cb);
 
+  /**
+   * Allocates a timer. @see Timer for docs on how to use the timer.
+   * @param cb supplies the callback to invoke when the timer fires.
+   * Must be called from context where ProvisionalDispatcher::isThreadSafe() is true.
+   */
+  virtual Event::TimerPtr createTimer(Event::TimerCb cb);
+
   /**
    * @return false before the Event::Dispatcher is running, otherwise the result of the
    * underlying call to Event::Dispatcher::isThreadSafe().
@@ -75,15 +87,42 @@ public:
   // Used for testing.
   Thread::ThreadSynchronizer& synchronizer() { return synchronizer_; }
 
+  /**
+   * The maximum number of callbacks run per wakeup of the underlying Event::Dispatcher. Any
+   * remaining callbacks are run on a subsequent iteration so that posts do not starve I/O.
+   */
+  static constexpr uint32_t MaxCallbacksPerWakeup = 1024;
+
 private:
-  // TODO(goaway): This class supports a straightforward case-specific lock-free implementation, but
-  // uses heavyweight synchronization for expediency at present.
-  Thread::MutexBasicLockable state_lock_;
-  bool drained_ ABSL_GUARDED_BY(state_lock_){};
-  std::list<Event::PostCb> init_queue_ ABSL_GUARDED_BY(state_lock_);
+  struct Node {
+    std::atomic<Node*> next_{};
+  };
+
+  struct PostNode : public Node {
+    explicit PostNode(Event::PostCb&& callback) : callback_(std::move(callback)) {}
+    Event::PostCb callback_;
+  };
+
+  // Bits of state_. The remaining high bits count posts which are in flight, so that terminate()
+  // can wait for them before the underlying Event::Dispatcher exits.
+  static constexpr uint32_t Drained = 0x1;
+  static constexpr uint32_t Terminated = 0x2;
+  static constexpr uint32_t PostInFlight = 0x4;
+
+  void push(Node* node);
+  // Must only be called from the Event::Dispatcher's thread.
+  PostNode* pop();
+  void scheduleWakeup();
+  void runPostedCallbacks();
+
+  std::atomic<uint32_t> state_{};
+  std::atomic<bool> wakeup_pending_{};
+  // Producers push at head_; the single consumer pops from tail_.
+  std::atomic<Node*> head_{&stub_};
+  Node* tail_{&stub_};
+  Node stub_;
   Event::Dispatcher* event_dispatcher_{};
   Thread::ThreadSynchronizer synchronizer_;
-  bool terminated_ ABSL_GUARDED_BY(state_lock_){};
 };
 
 using ProvisionalDispatcherPtr = std::unique_ptr<ProvisionalDispatcher>;
@@ -0,0 +1,19 @@
+#include "library/common/extensions/cert_validator/root_certificates/config.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Tls {
+
+CertValidatorPtr RootCertificatesCertValidatorFactory::createCertValidator(
+    const Envoy::Ssl::CertificateValidationContextConfig* config, SslStats& stats,
+    TimeSource& time_source) {
+  return std::make_unique<RootCertificatesCertValidator>(config, stats, time_source);
+}
+
+REGISTER_FACTORY(RootCertificatesCertValidatorFactory, CertValidatorFactory);
+
+} // namespace Tls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
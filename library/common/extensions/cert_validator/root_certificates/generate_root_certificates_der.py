@@ -0,0 +1,35 @@
+"""Converts the PEM root certificates in certificates.inc to DER.
+
+The certificates are written as a C++ array initializer, concatenated in the order they appear,
+so that they can be compiled into the binary and parsed without decoding base64 at runtime.
+
+Usage: generate_root_certificates_der.py <certificates.inc> <output.inc>
+"""
+
+import base64
+import re
+import sys
+
+PEM_CERTIFICATE = re.compile(
+    r"-----BEGIN CERTIFICATE-----(.*?)-----END CERTIFICATE-----", re.DOTALL)
+BYTES_PER_LINE = 16
+
+
+def main(argv):
+    with open(argv[1]) as pem_file:
+        pem = pem_file.read()
+
+    der = b"".join(
+        base64.b64decode("".join(block.split()), validate=True)
+        for block in PEM_CERTIFICATE.findall(pem))
+    if not der:
+        sys.exit("no certificates found in " + argv[1])
+
+    with open(argv[2], "w") as der_file:
+        der_file.write("// Generated from %s, do not edit.\n" % argv[1])
+        for i in range(0, len(der), BYTES_PER_LINE):
+            der_file.write(",".join(str(b) for b in der[i:i + BYTES_PER_LINE]) + ",\n")
+
+
+if __name__ == "__main__":
+    main(sys.argv)
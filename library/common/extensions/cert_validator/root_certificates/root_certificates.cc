@@ -0,0 +1,42 @@
+#include "library/common/extensions/cert_validator/root_certificates/root_certificates.h"
+
+#include <cstdint>
+
+#include "source/common/common/assert.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Tls {
+
+namespace {
+
+// The certificates in library/common/config/certificates.inc, converted to DER at build time.
+constexpr uint8_t RootCertificatesDer[] = {
+#include "library/common/extensions/cert_validator/root_certificates/root_certificates_der.inc"
+};
+
+} // namespace
+
+bssl::UniquePtr<X509_STORE> createRootCertificateStore() {
+  bssl::UniquePtr<X509_STORE> store(X509_STORE_new());
+  RELEASE_ASSERT(store != nullptr, "");
+  const uint8_t* next = RootCertificatesDer;
+  const uint8_t* const end = RootCertificatesDer + sizeof(RootCertificatesDer);
+  while (next < end) {
+    bssl::UniquePtr<X509> certificate(d2i_X509(nullptr, &next, end - next));
+    RELEASE_ASSERT(certificate != nullptr, "invalid root certificate");
+    X509_STORE_add_cert(store.get(), certificate.get());
+  }
+  return store;
+}
+
+X509_STORE& rootCertificateStore() {
+  static X509_STORE* store = createRootCertificateStore().release();
+  return *store;
+}
+
+} // namespace Tls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
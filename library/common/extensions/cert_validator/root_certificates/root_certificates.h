@@ -0,0 +1,26 @@
+#pragma once
+
+#include "openssl/ssl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Tls {
+
+/**
+ * Parses the root certificates trusted by default, which are compiled into the binary as DER.
+ * @return bssl::UniquePtr<X509_STORE>, a new store holding the certificates.
+ */
+bssl::UniquePtr<X509_STORE> createRootCertificateStore();
+
+/**
+ * @return X509_STORE&, a store holding the root certificates trusted by default, created on first
+ *         use and shared by every TLS context which trusts them. It's never freed, and is only
+ *         read once created, so TLS contexts may hold references to it on any thread.
+ */
+X509_STORE& rootCertificateStore();
+
+} // namespace Tls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,64 @@
+#include "library/common/extensions/cert_validator/root_certificates/root_certificates_cert_validator.h"
+
+#include "library/common/extensions/cert_validator/root_certificates/root_certificates.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Tls {
+
+RootCertificatesCertValidator::RootCertificatesCertValidator(
+    const Envoy::Ssl::CertificateValidationContextConfig* config, SslStats& stats,
+    TimeSource& time_source)
+    : DefaultCertValidator(config, stats, time_source),
+      allow_untrusted_certificate_(config != nullptr &&
+                                   config->trustChainVerification() ==
+                                       envoy::extensions::transport_sockets::tls::v3::
+                                           CertificateValidationContext::ACCEPT_UNTRUSTED),
+      stats_(stats) {
+  ENVOY_BUG(config != nullptr && config->caCert().empty(),
+            "Invalid certificate validation context config.");
+}
+
+int RootCertificatesCertValidator::initializeSslContexts(std::vector<SSL_CTX*> contexts,
+                                                         bool handshaker_provides_certificates) {
+  const int verify_mode =
+      DefaultCertValidator::initializeSslContexts(contexts, handshaker_provides_certificates);
+  if (handshaker_provides_certificates) {
+    return verify_mode;
+  }
+
+  X509_STORE& store = rootCertificateStore();
+  for (SSL_CTX* context : contexts) {
+    // The context takes the reference.
+    X509_STORE_up_ref(&store);
+    SSL_CTX_set_cert_store(context, &store);
+  }
+  // Peers are required to present certificates, as they are when a trusted CA is configured.
+  return allow_untrusted_certificate_ ? SSL_VERIFY_PEER
+                                      : SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT;
+}
+
+int RootCertificatesCertValidator::doSynchronousVerifyCertChain(
+    X509_STORE_CTX* store_ctx, Ssl::SslExtendedSocketInfo* ssl_extended_info, X509& leaf_cert,
+    const Network::TransportSocketOptions* transport_socket_options) {
+  // The default implementation only verifies the chain when a trusted CA is configured, so it's
+  // verified against the root certificates here, with the same outcomes.
+  if (X509_verify_cert(store_ctx) <= 0) {
+    if (ssl_extended_info) {
+      ssl_extended_info->setCertificateValidationStatus(
+          Envoy::Ssl::ClientValidationStatus::Failed);
+    }
+    stats_.fail_verify_error_.inc();
+    ENVOY_LOG(debug, "verify cert failed: {}",
+              X509_verify_cert_error_string(X509_STORE_CTX_get_error(store_ctx)));
+    return allow_untrusted_certificate_ ? 1 : 0;
+  }
+  return DefaultCertValidator::doSynchronousVerifyCertChain(store_ctx, ssl_extended_info, leaf_cert,
+                                                            transport_socket_options);
+}
+
+} // namespace Tls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+
+#include "source/extensions/transport_sockets/tls/cert_validator/default_validator.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Tls {
+
+// A certificate validation implementation which verifies certificate chains against the root
+// certificates compiled into the library. The certificates are parsed once, into a store shared by
+// every TLS context, rather than from PEM for each context as a configured trusted CA would be.
+// Otherwise it validates as the default implementation does.
+class RootCertificatesCertValidator : public DefaultCertValidator {
+public:
+  RootCertificatesCertValidator(const Envoy::Ssl::CertificateValidationContextConfig* config,
+                                SslStats& stats, TimeSource& time_source);
+
+  // CertValidator
+  int initializeSslContexts(std::vector<SSL_CTX*> contexts,
+                            bool handshaker_provides_certificates) override;
+  int doSynchronousVerifyCertChain(
+      X509_STORE_CTX* store_ctx, Ssl::SslExtendedSocketInfo* ssl_extended_info, X509& leaf_cert,
+      const Network::TransportSocketOptions* transport_socket_options) override;
+
+private:
+  const bool allow_untrusted_certificate_;
+  SslStats& stats_;
+};
+
+} // namespace Tls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
@@ -221,7 +221,7 @@ envoy_final_stream_intel PlatformBridgeFilter::finalStreamIntel() {
   RELEASE_ASSERT(decoder_callbacks_, "StreamInfo accessed before filter callbacks are set");
   // FIXME: Stream handle cannot currently be set from the filter context.
   envoy_final_stream_intel final_stream_intel{-1, -1, -1, -1, -1, -1, -1, -1,
-                                              -1, -1, -1, 0,  0,  0,  0,  -1};
+                                              -1, -1, -1, 0,  0,  0,  0,  -1, 0};
   setFinalStreamIntel(decoder_callbacks_->streamInfo(), dispatcher_.timeSource(),
                       final_stream_intel);
   return final_stream_intel;
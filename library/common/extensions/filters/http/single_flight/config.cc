@@ -0,0 +1,29 @@
+#include "library/common/extensions/filters/http/single_flight/config.h"
+
+#include "library/common/extensions/filters/http/single_flight/filter.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace SingleFlight {
+
+Http::FilterFactoryCb SingleFlightFilterFactory::createFilterFactoryFromProtoTyped(
+    const envoymobile::extensions::filters::http::single_flight::SingleFlight& proto_config,
+    const std::string&, Server::Configuration::FactoryContext& context) {
+
+  SingleFlightFilterConfigSharedPtr filter_config =
+      std::make_shared<SingleFlightFilterConfig>(proto_config, context.threadLocal());
+  return [filter_config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
+    callbacks.addStreamFilter(std::make_shared<SingleFlightFilter>(filter_config));
+  };
+}
+
+/**
+ * Static registration for the SingleFlight filter. @see NamedHttpFilterConfigFactory.
+ */
+REGISTER_FACTORY(SingleFlightFilterFactory, Server::Configuration::NamedHttpFilterConfigFactory);
+
+} // namespace SingleFlight
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
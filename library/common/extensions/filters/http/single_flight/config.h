@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+
+#include "source/extensions/filters/http/common/factory_base.h"
+
+#include "library/common/extensions/filters/http/single_flight/filter.pb.h"
+#include "library/common/extensions/filters/http/single_flight/filter.pb.validate.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace SingleFlight {
+
+/**
+ * Config registration for the single_flight filter. @see NamedHttpFilterConfigFactory.
+ */
+class SingleFlightFilterFactory
+    : public Common::FactoryBase<
+          envoymobile::extensions::filters::http::single_flight::SingleFlight> {
+public:
+  SingleFlightFilterFactory() : FactoryBase("single_flight") {}
+
+private:
+  ::Envoy::Http::FilterFactoryCb createFilterFactoryFromProtoTyped(
+      const envoymobile::extensions::filters::http::single_flight::SingleFlight& config,
+      const std::string& stats_prefix, Server::Configuration::FactoryContext& context) override;
+};
+
+DECLARE_FACTORY(SingleFlightFilterFactory);
+
+} // namespace SingleFlight
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
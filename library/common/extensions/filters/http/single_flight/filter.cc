@@ -0,0 +1,215 @@
+#include "library/common/extensions/filters/http/single_flight/filter.h"
+
+#include <algorithm>
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/http/header_map_impl.h"
+#include "source/common/http/headers.h"
+
+#include "absl/strings/str_cat.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace SingleFlight {
+
+namespace {
+constexpr absl::string_view CoalescedDetails = "single_flight_coalesced";
+} // namespace
+
+SingleFlightFilterConfig::SingleFlightFilterConfig(
+    const envoymobile::extensions::filters::http::single_flight::SingleFlight& proto_config,
+    ThreadLocal::SlotAllocator& tls)
+    : tls_(ThreadLocal::TypedSlot<InFlightRequests>::makeUnique(tls)) {
+  for (const std::string& header : proto_config.key_headers()) {
+    key_headers_.emplace_back(header);
+  }
+  tls_->set([](Event::Dispatcher&) { return std::make_shared<InFlightRequests>(); });
+}
+
+bool LeaderResponse::shared() const {
+  return leader_ != nullptr && !leader_->followers_.empty();
+}
+
+void LeaderResponse::onDetached() {
+  if (leader_ != nullptr) {
+    leader_->onDetached();
+  }
+}
+
+std::string SingleFlightFilterConfig::requestKey(const Http::RequestHeaderMap& headers) const {
+  if (headers.getMethodValue() != Http::Headers::get().MethodValues.Get) {
+    return "";
+  }
+  // Header values cannot contain newlines, so they separate the key's parts unambiguously.
+  std::string key = absl::StrCat(headers.getSchemeValue(), "://", headers.getHostValue(),
+                                 headers.getPathValue());
+  for (const Http::LowerCaseString& name : key_headers_) {
+    absl::StrAppend(&key, "\n", name.get(), ":");
+    const auto values = headers.get(name);
+    for (size_t i = 0; i < values.size(); ++i) {
+      absl::StrAppend(&key, i == 0 ? "" : ",", values[i]->value().getStringView());
+    }
+  }
+  return key;
+}
+
+SingleFlightFilter::SingleFlightFilter(SingleFlightFilterConfigSharedPtr config)
+    : config_(config) {}
+
+template <class Fn> void SingleFlightFilter::forEachFollower(Fn fn) {
+  // Responding to a follower may end its stream, which removes it from followers_.
+  const std::vector<SingleFlightFilter*> followers = followers_;
+  for (SingleFlightFilter* follower : followers) {
+    if (std::find(followers_.begin(), followers_.end(), follower) != followers_.end()) {
+      fn(*follower);
+    }
+  }
+}
+
+Http::FilterHeadersStatus SingleFlightFilter::decodeHeaders(Http::RequestHeaderMap& headers,
+                                                            bool end_stream) {
+  // Only requests without a body are coalesced.
+  if (!end_stream) {
+    return Http::FilterHeadersStatus::Continue;
+  }
+  key_ = config_->requestKey(headers);
+  if (key_.empty()) {
+    return Http::FilterHeadersStatus::Continue;
+  }
+
+  auto& leaders = config_->inFlightRequests().leaders_;
+  auto leader = leaders.find(key_);
+  if (leader == leaders.end()) {
+    leaders.emplace(key_, this);
+    auto leader_response = std::make_shared<LeaderResponse>(*this);
+    leader_response_ = leader_response.get();
+    decoder_callbacks_->streamInfo().filterState()->setData(
+        StreamInfo::SharedResponse::key(), std::move(leader_response),
+        StreamInfo::FilterState::StateType::Mutable, StreamInfo::FilterState::LifeSpan::Request);
+    return Http::FilterHeadersStatus::Continue;
+  }
+
+  ENVOY_LOG(debug, "coalescing request into an identical request in flight");
+  leader_ = leader->second;
+  leader_->followers_.push_back(this);
+  return Http::FilterHeadersStatus::StopIteration;
+}
+
+Http::FilterHeadersStatus SingleFlightFilter::encodeHeaders(Http::ResponseHeaderMap& headers,
+                                                            bool end_stream) {
+  closeToFollowers();
+  forEachFollower([&](SingleFlightFilter& follower) {
+    follower.response_started_ = true;
+    follower.response_complete_ = end_stream;
+    follower.decoder_callbacks_->encodeHeaders(
+        Http::createHeaderMap<Http::ResponseHeaderMapImpl>(headers), end_stream, CoalescedDetails);
+  });
+  if (end_stream) {
+    detachFollowers();
+  }
+  return Http::FilterHeadersStatus::Continue;
+}
+
+Http::FilterDataStatus SingleFlightFilter::encodeData(Buffer::Instance& data, bool end_stream) {
+  forEachFollower([&](SingleFlightFilter& follower) {
+    Buffer::OwnedImpl follower_data(data);
+    follower.response_complete_ = end_stream;
+    follower.decoder_callbacks_->encodeData(follower_data, end_stream);
+  });
+  if (end_stream) {
+    detachFollowers();
+  }
+  return Http::FilterDataStatus::Continue;
+}
+
+Http::FilterTrailersStatus SingleFlightFilter::encodeTrailers(Http::ResponseTrailerMap& trailers) {
+  forEachFollower([&](SingleFlightFilter& follower) {
+    follower.response_complete_ = true;
+    follower.decoder_callbacks_->encodeTrailers(
+        Http::createHeaderMap<Http::ResponseTrailerMapImpl>(trailers));
+  });
+  detachFollowers();
+  return Http::FilterTrailersStatus::Continue;
+}
+
+void SingleFlightFilter::onDestroy() {
+  continue_decoding_callback_.reset();
+  reset_callback_.reset();
+  if (leader_response_ != nullptr) {
+    leader_response_->clear();
+    leader_response_ = nullptr;
+  }
+  closeToFollowers();
+  if (leader_ != nullptr) {
+    leader_->removeFollower(*this);
+    leader_ = nullptr;
+  }
+  forEachFollower([](SingleFlightFilter& follower) { follower.onLeaderDestroyed(); });
+  followers_.clear();
+}
+
+void SingleFlightFilter::closeToFollowers() {
+  if (key_.empty()) {
+    return;
+  }
+  auto& leaders = config_->inFlightRequests().leaders_;
+  auto leader = leaders.find(key_);
+  if (leader != leaders.end() && leader->second == this) {
+    leaders.erase(leader);
+  }
+}
+
+void SingleFlightFilter::removeFollower(SingleFlightFilter& follower) {
+  followers_.erase(std::remove(followers_.begin(), followers_.end(), &follower), followers_.end());
+  if (!detached_ || !followers_.empty()) {
+    return;
+  }
+  ENVOY_LOG(debug, "last follower of a detached request ended, resetting request");
+  if (reset_callback_ == nullptr) {
+    reset_callback_ = decoder_callbacks_->dispatcher().createSchedulableCallback(
+        [this]() { resetDetachedLeader(); });
+  }
+  reset_callback_->scheduleCallbackNextIteration();
+}
+
+void SingleFlightFilter::onDetached() {
+  ENVOY_LOG(debug, "request detached from the platform, continuing for its followers");
+  detached_ = true;
+}
+
+void SingleFlightFilter::resetDetachedLeader() {
+  // Requests may have joined since the reset was scheduled.
+  if (followers_.empty()) {
+    decoder_callbacks_->resetStream();
+  }
+}
+
+void SingleFlightFilter::detachFollowers() {
+  for (SingleFlightFilter* follower : followers_) {
+    follower->leader_ = nullptr;
+  }
+  followers_.clear();
+}
+
+void SingleFlightFilter::onLeaderDestroyed() {
+  leader_ = nullptr;
+  if (response_complete_) {
+    return;
+  }
+  if (response_started_) {
+    ENVOY_LOG(debug, "coalesced request ended before its response was complete");
+    decoder_callbacks_->resetStream();
+    return;
+  }
+  // Send the request upstream after all, outside of the leader's teardown.
+  ENVOY_LOG(debug, "coalesced request ended before its response started, sending request");
+  continue_decoding_callback_ = decoder_callbacks_->dispatcher().createSchedulableCallback(
+      [this]() { decoder_callbacks_->continueDecoding(); });
+  continue_decoding_callback_->scheduleCallbackNextIteration();
+}
+
+} // namespace SingleFlight
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
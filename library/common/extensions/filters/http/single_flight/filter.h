@@ -0,0 +1,140 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "envoy/http/filter.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "source/common/common/logger.h"
+#include "source/extensions/filters/http/common/pass_through_filter.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "library/common/extensions/filters/http/single_flight/filter.pb.h"
+#include "library/common/stream_info/shared_response.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace SingleFlight {
+
+class SingleFlightFilter;
+
+/**
+ * The requests in flight on one worker thread which later identical requests may join, by key.
+ */
+struct InFlightRequests : public ThreadLocal::ThreadLocalObject {
+  absl::flat_hash_map<std::string, SingleFlightFilter*> leaders_;
+};
+
+class SingleFlightFilterConfig {
+public:
+  SingleFlightFilterConfig(
+      const envoymobile::extensions::filters::http::single_flight::SingleFlight& proto_config,
+      ThreadLocal::SlotAllocator& tls);
+
+  /**
+   * @return std::string, the key identifying requests which may share a single upstream request,
+   *         or an empty string if the request may not be coalesced.
+   */
+  std::string requestKey(const Http::RequestHeaderMap& headers) const;
+
+  InFlightRequests& inFlightRequests() const { return *tls_->get(); }
+
+private:
+  std::vector<Http::LowerCaseString> key_headers_;
+  ThreadLocal::TypedSlotPtr<InFlightRequests> tls_;
+};
+
+using SingleFlightFilterConfigSharedPtr = std::shared_ptr<SingleFlightFilterConfig>;
+
+/**
+ * Filter state set on a leader's stream, telling the Http::Client whether its response is shared.
+ */
+class LeaderResponse : public StreamInfo::SharedResponse {
+public:
+  LeaderResponse(SingleFlightFilter& leader) : leader_(&leader) {}
+
+  // StreamInfo::SharedResponse
+  bool shared() const override;
+  void onDetached() override;
+
+  // Called once the leader's filter is destroyed.
+  void clear() { leader_ = nullptr; }
+
+private:
+  SingleFlightFilter* leader_;
+};
+
+/**
+ * Filter which coalesces identical GET requests in flight at the same time into a single upstream
+ * request.
+ *
+ * The first request for a key leads: it continues upstream as usual. Identical requests which
+ * arrive before the leader's response starts follow it: they are held, and the leader's response
+ * headers, body and trailers are copied to each of them. Requests arriving once the response has
+ * started are not coalesced.
+ *
+ * A follower which is cancelled simply stops receiving the response. A leader which the platform
+ * cancels while it has followers is detached from the platform rather than reset (see
+ * StreamInfo::SharedResponse), so its request runs on for them; it's reset once its last follower
+ * ends. If the leader ends before its response does otherwise, its followers are resumed and each
+ * sends its own request upstream, unless they had already started receiving the leader's
+ * response, in which case they are reset.
+ */
+class SingleFlightFilter final : public Http::PassThroughFilter,
+                                 public Logger::Loggable<Logger::Id::filter> {
+public:
+  SingleFlightFilter(SingleFlightFilterConfigSharedPtr config);
+
+  // StreamDecoderFilter
+  Http::FilterHeadersStatus decodeHeaders(Http::RequestHeaderMap& headers,
+                                          bool end_stream) override;
+
+  // StreamEncoderFilter
+  Http::FilterHeadersStatus encodeHeaders(Http::ResponseHeaderMap& headers,
+                                          bool end_stream) override;
+  Http::FilterDataStatus encodeData(Buffer::Instance& data, bool end_stream) override;
+  Http::FilterTrailersStatus encodeTrailers(Http::ResponseTrailerMap& trailers) override;
+
+  // StreamFilterBase
+  void onDestroy() override;
+
+private:
+  friend class LeaderResponse;
+
+  // Stops new requests from joining this leader's response.
+  void closeToFollowers();
+  // Detaches a follower which ended before the leader's response did.
+  void removeFollower(SingleFlightFilter& follower);
+  // Detaches all followers once the response is complete.
+  void detachFollowers();
+  // Runs fn on each follower still attached, tolerating followers which end as a result.
+  template <class Fn> void forEachFollower(Fn fn);
+  // Called on a follower whose leader ended before the response did.
+  void onLeaderDestroyed();
+  // Called on a leader detached from the platform, which no longer needs its response.
+  void onDetached();
+  // Resets a detached leader's stream, outside of its last follower's teardown.
+  void resetDetachedLeader();
+
+  const SingleFlightFilterConfigSharedPtr config_;
+  std::string key_;
+  // Set on followers.
+  SingleFlightFilter* leader_{};
+  // Set on leaders.
+  std::vector<SingleFlightFilter*> followers_;
+  // Set on leaders. Owned by the stream's filter state, which outlives the filter.
+  LeaderResponse* leader_response_{};
+  // Set on a leader once the platform has cancelled its stream.
+  bool detached_{};
+  bool response_started_{};
+  bool response_complete_{};
+  Event::SchedulableCallbackPtr continue_decoding_callback_;
+  Event::SchedulableCallbackPtr reset_callback_;
+};
+
+} // namespace SingleFlight
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
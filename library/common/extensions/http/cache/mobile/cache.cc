@@ -0,0 +1,427 @@
+#include "library/common/extensions/http/cache/mobile/cache.h"
+
+#include <vector>
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/common/base64.h"
+#include "source/common/http/header_map_impl.h"
+#include "source/common/http/headers.h"
+#include "source/common/protobuf/utility.h"
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+namespace {
+
+constexpr absl::string_view CacheName = "envoy.extensions.http.cache.mobile";
+constexpr absl::string_view PersistentKeyPrefix = "response_cache.";
+
+class MobileLookupContext : public LookupContext {
+public:
+  MobileLookupContext(MobileHttpCache& cache, LookupRequest&& request)
+      : cache_(cache), request_(std::move(request)) {}
+
+  void getHeaders(LookupHeadersCallback&& cb) override {
+    entry_ = cache_.lookup(request_.key());
+    LookupResult result;
+    if (entry_ != nullptr) {
+      result = request_.makeLookupResult(
+          Http::createHeaderMap<Http::ResponseHeaderMapImpl>(*entry_->response_headers_),
+          ResponseMetadata{entry_->metadata_}, entry_->body_.size(), entry_->trailers_ != nullptr);
+    }
+    cache_.onLookupResult(result);
+    cb(std::move(result));
+  }
+
+  void getBody(const AdjustedByteRange& range, LookupBodyCallback&& cb) override {
+    ASSERT(entry_ != nullptr);
+    ASSERT(range.end() <= entry_->body_.size(), "Attempt to read past end of body.");
+    cb(std::make_unique<Buffer::OwnedImpl>(&entry_->body_[range.begin()], range.length()));
+  }
+
+  void getTrailers(LookupTrailersCallback&& cb) override {
+    ASSERT(entry_ != nullptr && entry_->trailers_ != nullptr);
+    cb(Http::createHeaderMap<Http::ResponseTrailerMapImpl>(*entry_->trailers_));
+  }
+
+  void onDestroy() override {}
+
+  const LookupRequest& request() const { return request_; }
+
+private:
+  MobileHttpCache& cache_;
+  const LookupRequest request_;
+  // Held for the lifetime of the lookup, so that the body and trailers served are those of the
+  // headers served even if the entry is evicted or replaced meanwhile.
+  MobileHttpCache::EntrySharedPtr entry_;
+};
+
+class MobileInsertContext : public InsertContext {
+public:
+  MobileInsertContext(MobileLookupContext& lookup_context, MobileHttpCache& cache)
+      : key_(lookup_context.request().key()), cache_(cache) {}
+
+  void insertHeaders(const Http::ResponseHeaderMap& response_headers,
+                     const ResponseMetadata& metadata, bool end_stream) override {
+    ASSERT(!committed_);
+    // The key does not capture the request headers a response varies on.
+    if (!response_headers.get(Http::CustomHeaders::get().Vary).empty()) {
+      abandoned_ = true;
+      return;
+    }
+    entry_.response_headers_ = Http::createHeaderMap<Http::ResponseHeaderMapImpl>(response_headers);
+    entry_.metadata_ = metadata;
+    if (end_stream) {
+      commit();
+    }
+  }
+
+  void insertBody(const Buffer::Instance& chunk, InsertCallback ready_for_next_chunk,
+                  bool end_stream) override {
+    ASSERT(!committed_);
+    if (!abandoned_ && entry_.body_.size() + chunk.length() > cache_.maxEntryBytes()) {
+      abandoned_ = true;
+    }
+    if (abandoned_) {
+      if (ready_for_next_chunk) {
+        ready_for_next_chunk(false);
+      }
+      return;
+    }
+    entry_.body_.append(chunk.toString());
+    if (end_stream) {
+      commit();
+    } else if (ready_for_next_chunk) {
+      ready_for_next_chunk(true);
+    }
+  }
+
+  void insertTrailers(const Http::ResponseTrailerMap& trailers) override {
+    ASSERT(!committed_);
+    entry_.trailers_ = Http::createHeaderMap<Http::ResponseTrailerMapImpl>(trailers);
+    commit();
+  }
+
+  void onDestroy() override {}
+
+private:
+  void commit() {
+    committed_ = true;
+    if (!abandoned_) {
+      cache_.insert(key_, std::move(entry_));
+    }
+  }
+
+  const Key key_;
+  MobileHttpCache& cache_;
+  MobileHttpCache::Entry entry_;
+  bool committed_{};
+  bool abandoned_{};
+};
+
+// Applies the headers of a 304 response to the cached response's headers. Per RFC 9111 section
+// 4.3.4, the fields of the 304 replace the cached ones, except for those framing the body.
+void applyHeaderUpdate(const Http::ResponseHeaderMap& new_headers,
+                       Http::ResponseHeaderMap& headers_to_update) {
+  absl::flat_hash_set<std::string> replaced;
+  new_headers.iterate([&](const Http::HeaderEntry& header) -> Http::HeaderMap::Iterate {
+    const absl::string_view name = header.key().getStringView();
+    if (name == Http::Headers::get().ContentLength.get() ||
+        name == Http::Headers::get().Status.get() ||
+        name == Http::Headers::get().TransferEncoding.get()) {
+      return Http::HeaderMap::Iterate::Continue;
+    }
+    const Http::LowerCaseString lower_name(name);
+    if (replaced.insert(std::string(name)).second) {
+      headers_to_update.remove(lower_name);
+    }
+    headers_to_update.addCopy(lower_name, header.value().getStringView());
+    return Http::HeaderMap::Iterate::Continue;
+  });
+}
+
+void toProto(const Http::HeaderMap& headers,
+             Protobuf::RepeatedPtrField<envoy::config::core::v3::HeaderValue>& proto) {
+  headers.iterate([&proto](const Http::HeaderEntry& header) -> Http::HeaderMap::Iterate {
+    auto* value = proto.Add();
+    value->set_key(std::string(header.key().getStringView()));
+    value->set_value(std::string(header.value().getStringView()));
+    return Http::HeaderMap::Iterate::Continue;
+  });
+}
+
+template <class T>
+std::unique_ptr<T>
+fromProto(const Protobuf::RepeatedPtrField<envoy::config::core::v3::HeaderValue>& proto) {
+  auto headers = T::create();
+  for (const auto& header : proto) {
+    headers->addCopy(Http::LowerCaseString(header.key()), header.value());
+  }
+  return headers;
+}
+
+} // namespace
+
+MobileHttpCache::MobileHttpCache(uint64_t max_memory_bytes, uint64_t max_entry_bytes,
+                                 KeyValueStorePtr&& persistent_store, uint64_t max_persistent_bytes,
+                                 uint64_t max_persistent_entry_bytes, Stats::Scope& scope)
+    : max_memory_bytes_(max_memory_bytes),
+      max_entry_bytes_(max_entry_bytes != 0 ? std::min(max_entry_bytes, max_memory_bytes)
+                                            : max_memory_bytes),
+      stats_{ALL_RESPONSE_CACHE_STATS(POOL_COUNTER_PREFIX(scope, "http.client."))},
+      persistent_store_(std::move(persistent_store)),
+      max_persistent_bytes_(max_persistent_bytes != 0 ? max_persistent_bytes
+                                                      : DefaultMaxPersistentBytes),
+      max_persistent_entry_bytes_(std::min(max_persistent_entry_bytes != 0
+                                               ? max_persistent_entry_bytes
+                                               : DefaultMaxPersistentEntryBytes,
+                                           max_persistent_bytes_)) {
+  if (persistent_store_ == nullptr) {
+    return;
+  }
+  // Index the responses saved by previous engines, so that the store's limits apply to them too,
+  // e.g. after the limits have been lowered.
+  absl::MutexLock lock(&mutex_);
+  std::vector<std::string> oversized;
+  persistent_store_->iterate([&](const std::string& key, const std::string& value) {
+    if (absl::StartsWith(key, PersistentKeyPrefix)) {
+      mutex_.AssertHeld();
+      indexPersisted(key, value.size());
+      if (value.size() > max_persistent_entry_bytes_) {
+        oversized.push_back(key);
+      }
+    }
+    return KeyValueStore::Iterate::Continue;
+  });
+  for (const std::string& persistent_key : oversized) {
+    removePersisted(persistent_key);
+  }
+  trimPersisted();
+}
+
+LookupContextPtr MobileHttpCache::makeLookupContext(LookupRequest&& request,
+                                                    Http::StreamDecoderFilterCallbacks&) {
+  return std::make_unique<MobileLookupContext>(*this, std::move(request));
+}
+
+InsertContextPtr MobileHttpCache::makeInsertContext(LookupContextPtr&& lookup_context,
+                                                    Http::StreamEncoderFilterCallbacks&) {
+  ASSERT(lookup_context != nullptr);
+  return std::make_unique<MobileInsertContext>(static_cast<MobileLookupContext&>(*lookup_context),
+                                               *this);
+}
+
+void MobileHttpCache::updateHeaders(const LookupContext& lookup_context,
+                                    const Http::ResponseHeaderMap& response_headers,
+                                    const ResponseMetadata& metadata) {
+  const Key& key = static_cast<const MobileLookupContext&>(lookup_context).request().key();
+  EntrySharedPtr cached = lookup(key);
+  if (cached == nullptr) {
+    return;
+  }
+  // Entries are shared with lookups in progress, so the update is made to a copy.
+  Entry updated{Http::createHeaderMap<Http::ResponseHeaderMapImpl>(*cached->response_headers_),
+                metadata, cached->body_,
+                cached->trailers_ != nullptr
+                    ? Http::createHeaderMap<Http::ResponseTrailerMapImpl>(*cached->trailers_)
+                    : nullptr};
+  applyHeaderUpdate(response_headers, *updated.response_headers_);
+  insert(key, std::move(updated));
+}
+
+CacheInfo MobileHttpCache::cacheInfo() const {
+  CacheInfo cache_info;
+  cache_info.name_ = CacheName;
+  cache_info.supports_range_requests_ = true;
+  return cache_info;
+}
+
+MobileHttpCache::EntrySharedPtr MobileHttpCache::lookup(const Key& key) {
+  const std::string serialized_key = key.SerializeAsString();
+  absl::MutexLock lock(&mutex_);
+  auto it = memory_.find(serialized_key);
+  if (it != memory_.end()) {
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->entry_;
+  }
+  return loadPersisted(key, serialized_key);
+}
+
+bool MobileHttpCache::insert(const Key& key, Entry&& entry) {
+  if (entryBytes(entry) > max_entry_bytes_) {
+    return false;
+  }
+  const std::string serialized_key = key.SerializeAsString();
+  auto shared_entry = std::make_shared<const Entry>(std::move(entry));
+  absl::MutexLock lock(&mutex_);
+  insertInMemory(serialized_key, shared_entry);
+  persist(key, serialized_key, *shared_entry);
+  stats_.cache_insert_.inc();
+  return true;
+}
+
+void MobileHttpCache::onLookupResult(const LookupResult& result) {
+  switch (result.cache_entry_status_) {
+  case CacheEntryStatus::Ok:
+    stats_.cache_hit_.inc();
+    return;
+  case CacheEntryStatus::RequiresValidation:
+    stats_.cache_revalidate_.inc();
+    return;
+  default:
+    stats_.cache_miss_.inc();
+    return;
+  }
+}
+
+uint64_t MobileHttpCache::memoryBytes() const {
+  absl::MutexLock lock(&mutex_);
+  return memory_bytes_;
+}
+
+uint64_t MobileHttpCache::persistentBytes() const {
+  absl::MutexLock lock(&mutex_);
+  return persisted_bytes_;
+}
+
+uint64_t MobileHttpCache::entryBytes(const Entry& entry) {
+  return entry.response_headers_->byteSize() + entry.body_.size() +
+         (entry.trailers_ != nullptr ? entry.trailers_->byteSize() : 0);
+}
+
+std::string MobileHttpCache::persistentKey(const Key& key) {
+  return absl::StrCat(PersistentKeyPrefix, stableHashKey(key));
+}
+
+void MobileHttpCache::insertInMemory(const std::string& key, EntrySharedPtr entry) {
+  auto existing = memory_.find(key);
+  if (existing != memory_.end()) {
+    memory_bytes_ -= existing->second->bytes_;
+    lru_.erase(existing->second);
+    memory_.erase(existing);
+  }
+  const uint64_t bytes = entryBytes(*entry);
+  lru_.push_front(MemoryEntry{key, std::move(entry), bytes});
+  memory_[key] = lru_.begin();
+  memory_bytes_ += bytes;
+
+  while (memory_bytes_ > max_memory_bytes_) {
+    const MemoryEntry& evicted = lru_.back();
+    ENVOY_LOG(debug, "evicting {} byte response from memory", evicted.bytes_);
+    memory_bytes_ -= evicted.bytes_;
+    memory_.erase(evicted.key_);
+    lru_.pop_back();
+    stats_.cache_evict_.inc();
+  }
+}
+
+MobileHttpCache::EntrySharedPtr MobileHttpCache::loadPersisted(const Key& key,
+                                                               const std::string& serialized_key) {
+  if (persistent_store_ == nullptr) {
+    return nullptr;
+  }
+  const std::string persistent_key = persistentKey(key);
+  auto value = persistent_store_->get(persistent_key);
+  if (!value.has_value()) {
+    // Should the store have dropped the response itself, it no longer counts against its limit.
+    removePersisted(persistent_key);
+    return nullptr;
+  }
+  envoymobile::extensions::http::cache::mobile::CachedResponse cached;
+  if (!cached.ParseFromString(Base64::decode(std::string(value.value()))) ||
+      cached.key() != serialized_key) {
+    return nullptr;
+  }
+  auto persisted = persisted_.find(persistent_key);
+  if (persisted != persisted_.end()) {
+    persisted_lru_.splice(persisted_lru_.begin(), persisted_lru_, persisted->second);
+  }
+
+  Entry entry;
+  entry.response_headers_ = fromProto<Http::ResponseHeaderMapImpl>(cached.headers());
+  entry.metadata_.response_time_ =
+      SystemTime(std::chrono::milliseconds(Protobuf::util::TimeUtil::TimestampToMilliseconds(
+          cached.response_time())));
+  entry.body_ = cached.body();
+  if (cached.trailers_size() > 0) {
+    entry.trailers_ = fromProto<Http::ResponseTrailerMapImpl>(cached.trailers());
+  }
+  auto shared_entry = std::make_shared<const Entry>(std::move(entry));
+  insertInMemory(serialized_key, shared_entry);
+  return shared_entry;
+}
+
+void MobileHttpCache::persist(const Key& key, const std::string& serialized_key,
+                              const Entry& entry) {
+  if (persistent_store_ == nullptr) {
+    return;
+  }
+  envoymobile::extensions::http::cache::mobile::CachedResponse cached;
+  cached.set_key(serialized_key);
+  toProto(*entry.response_headers_, *cached.mutable_headers());
+  cached.set_body(entry.body_);
+  if (entry.trailers_ != nullptr) {
+    toProto(*entry.trailers_, *cached.mutable_trailers());
+  }
+  *cached.mutable_response_time() = Protobuf::util::TimeUtil::MillisecondsToTimestamp(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          entry.metadata_.response_time_.time_since_epoch())
+          .count());
+  // Platform stores hold strings, so the serialized response is encoded as text.
+  const std::string serialized = cached.SerializeAsString();
+  std::string encoded = Base64::encode(serialized.data(), serialized.size());
+  const std::string persistent_key = persistentKey(key);
+  if (encoded.size() > max_persistent_entry_bytes_) {
+    // The response is held only in memory, so a previous response for the key mustn't outlive it.
+    ENVOY_LOG(debug, "not persisting {} byte response", encoded.size());
+    removePersisted(persistent_key);
+    return;
+  }
+  const uint64_t bytes = encoded.size();
+  persistent_store_->addOrUpdate(persistent_key, std::move(encoded), absl::nullopt);
+  indexPersisted(persistent_key, bytes);
+  trimPersisted();
+}
+
+void MobileHttpCache::indexPersisted(const std::string& persistent_key, uint64_t bytes) {
+  auto existing = persisted_.find(persistent_key);
+  if (existing != persisted_.end()) {
+    persisted_bytes_ -= existing->second->bytes_;
+    persisted_lru_.erase(existing->second);
+    persisted_.erase(existing);
+  }
+  persisted_lru_.push_front(PersistedEntry{persistent_key, bytes});
+  persisted_[persistent_key] = persisted_lru_.begin();
+  persisted_bytes_ += bytes;
+}
+
+void MobileHttpCache::removePersisted(const std::string& persistent_key) {
+  auto existing = persisted_.find(persistent_key);
+  if (existing == persisted_.end()) {
+    return;
+  }
+  persisted_bytes_ -= existing->second->bytes_;
+  persisted_lru_.erase(existing->second);
+  persisted_.erase(existing);
+  persistent_store_->remove(persistent_key);
+}
+
+void MobileHttpCache::trimPersisted() {
+  while (persisted_bytes_ > max_persistent_bytes_) {
+    const PersistedEntry& evicted = persisted_lru_.back();
+    ENVOY_LOG(debug, "removing {} byte response from persistent store", evicted.bytes_);
+    const std::string persistent_key = evicted.persistent_key_;
+    removePersisted(persistent_key);
+  }
+}
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
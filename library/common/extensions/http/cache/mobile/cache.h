@@ -0,0 +1,158 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <string>
+
+#include "envoy/common/key_value_store.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "source/common/common/logger.h"
+#include "source/extensions/filters/http/cache/http_cache.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "library/common/extensions/http/cache/mobile/cache.pb.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+/**
+ * All response cache stats. @see stats_macros.h
+ */
+#define ALL_RESPONSE_CACHE_STATS(COUNTER)                                                          \
+  COUNTER(cache_hit)                                                                               \
+  COUNTER(cache_miss)                                                                              \
+  COUNTER(cache_revalidate)                                                                        \
+  COUNTER(cache_insert)                                                                            \
+  COUNTER(cache_evict)
+
+/**
+ * Struct definition for response cache stats. @see stats_macros.h
+ */
+struct ResponseCacheStats {
+  ALL_RESPONSE_CACHE_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * An HttpCache for Envoy Mobile, with two tiers:
+ * - responses are held in memory up to a byte limit, beyond which the least recently used are
+ *   evicted;
+ * - if a persistent store is configured, responses are also saved to it, so that they outlive the
+ *   engine, and responses not in memory are loaded from it on lookup. The store is bounded by its
+ *   own, smaller, byte limits, both in all and per response. The cache is expected to be the only
+ *   one removing responses from the store, i.e. the store should not bound its entries itself.
+ *
+ * Freshness and validation, i.e. Cache-Control and ETag/If-None-Match, are handled by the cache
+ * filter. Responses with a Vary header are not cached.
+ */
+class MobileHttpCache : public HttpCache, public Logger::Loggable<Logger::Id::cache_filter> {
+public:
+  struct Entry {
+    Http::ResponseHeaderMapPtr response_headers_;
+    ResponseMetadata metadata_;
+    std::string body_;
+    Http::ResponseTrailerMapPtr trailers_;
+  };
+  using EntrySharedPtr = std::shared_ptr<const Entry>;
+
+  static constexpr uint64_t DefaultMaxPersistentBytes = 1024 * 1024;
+  static constexpr uint64_t DefaultMaxPersistentEntryBytes = 64 * 1024;
+
+  /**
+   * @param max_memory_bytes, the bytes of responses held in memory.
+   * @param max_entry_bytes, the largest response which is cached, or 0 for max_memory_bytes.
+   * @param persistent_store, the store to save responses to, or nullptr to hold them only in
+   *        memory.
+   * @param max_persistent_bytes, the encoded bytes of responses saved to the persistent store, or
+   *        0 for DefaultMaxPersistentBytes.
+   * @param max_persistent_entry_bytes, the largest encoded response saved to the persistent store,
+   *        or 0 for DefaultMaxPersistentEntryBytes.
+   * @param scope, the scope for the cache's stats.
+   */
+  MobileHttpCache(uint64_t max_memory_bytes, uint64_t max_entry_bytes,
+                  KeyValueStorePtr&& persistent_store, uint64_t max_persistent_bytes,
+                  uint64_t max_persistent_entry_bytes, Stats::Scope& scope);
+
+  // HttpCache
+  LookupContextPtr makeLookupContext(LookupRequest&& request,
+                                     Http::StreamDecoderFilterCallbacks& callbacks) override;
+  InsertContextPtr makeInsertContext(LookupContextPtr&& lookup_context,
+                                     Http::StreamEncoderFilterCallbacks& callbacks) override;
+  void updateHeaders(const LookupContext& lookup_context,
+                     const Http::ResponseHeaderMap& response_headers,
+                     const ResponseMetadata& metadata) override;
+  CacheInfo cacheInfo() const override;
+
+  /**
+   * @return EntrySharedPtr, the response cached for the key, or nullptr if there is none.
+   */
+  EntrySharedPtr lookup(const Key& key);
+
+  /**
+   * Caches a response for the key, replacing any response already cached for it.
+   * @return bool, whether the response was cached.
+   */
+  bool insert(const Key& key, Entry&& entry);
+
+  /**
+   * Records the outcome of a lookup.
+   */
+  void onLookupResult(const LookupResult& result);
+
+  uint64_t maxEntryBytes() const { return max_entry_bytes_; }
+  uint64_t memoryBytes() const;
+  uint64_t persistentBytes() const;
+  const ResponseCacheStats& stats() const { return stats_; }
+
+private:
+  struct MemoryEntry {
+    std::string key_;
+    EntrySharedPtr entry_;
+    uint64_t bytes_;
+  };
+  using LruList = std::list<MemoryEntry>;
+  struct PersistedEntry {
+    std::string persistent_key_;
+    uint64_t bytes_;
+  };
+  using PersistedList = std::list<PersistedEntry>;
+
+  static uint64_t entryBytes(const Entry& entry);
+  static std::string persistentKey(const Key& key);
+
+  void insertInMemory(const std::string& key, EntrySharedPtr entry)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  EntrySharedPtr loadPersisted(const Key& key, const std::string& serialized_key)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void persist(const Key& key, const std::string& serialized_key, const Entry& entry)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void indexPersisted(const std::string& persistent_key, uint64_t bytes)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void removePersisted(const std::string& persistent_key) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void trimPersisted() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const uint64_t max_memory_bytes_;
+  const uint64_t max_entry_bytes_;
+  ResponseCacheStats stats_;
+  mutable absl::Mutex mutex_;
+  // Most recently used first.
+  LruList lru_ ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<std::string, LruList::iterator> memory_ ABSL_GUARDED_BY(mutex_);
+  uint64_t memory_bytes_ ABSL_GUARDED_BY(mutex_){};
+  const KeyValueStorePtr persistent_store_ ABSL_PT_GUARDED_BY(mutex_);
+  const uint64_t max_persistent_bytes_;
+  const uint64_t max_persistent_entry_bytes_;
+  // The responses saved to the persistent store, most recently used first.
+  PersistedList persisted_lru_ ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<std::string, PersistedList::iterator> persisted_ ABSL_GUARDED_BY(mutex_);
+  uint64_t persisted_bytes_ ABSL_GUARDED_BY(mutex_){};
+};
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,45 @@
+#include "library/common/extensions/http/cache/mobile/config.h"
+
+#include "envoy/registry/registry.h"
+
+#include "source/common/config/utility.h"
+#include "source/common/protobuf/utility.h"
+
+#include "library/common/extensions/http/cache/mobile/cache.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+std::shared_ptr<HttpCache> MobileHttpCacheFactory::getCache(
+    const envoy::extensions::filters::http::cache::v3::CacheConfig& config,
+    Server::Configuration::FactoryContext& context) {
+  const auto cache_config = MessageUtil::anyConvertAndValidate<
+      envoymobile::extensions::http::cache::mobile::MobileHttpCacheConfig>(
+      config.typed_config(), context.messageValidationVisitor());
+
+  KeyValueStorePtr persistent_store;
+  if (cache_config.has_persistent_store_config()) {
+    const auto& store_config = cache_config.persistent_store_config();
+    auto& factory =
+        Config::Utility::getAndCheckFactory<KeyValueStoreFactory>(store_config.config());
+    persistent_store =
+        factory.createStore(store_config, context.messageValidationVisitor(),
+                            context.mainThreadDispatcher(), context.api().fileSystem());
+  }
+  return std::make_shared<MobileHttpCache>(
+      cache_config.max_memory_bytes(), cache_config.max_entry_bytes(), std::move(persistent_store),
+      cache_config.max_persistent_bytes(), cache_config.max_persistent_entry_bytes(),
+      context.scope());
+}
+
+/**
+ * Static registration for the mobile HTTP cache. @see HttpCacheFactory.
+ */
+REGISTER_FACTORY(MobileHttpCacheFactory, HttpCacheFactory);
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
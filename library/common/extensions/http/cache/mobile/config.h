@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+
+#include "source/extensions/filters/http/cache/http_cache.h"
+
+#include "library/common/extensions/http/cache/mobile/cache.pb.h"
+#include "library/common/extensions/http/cache/mobile/cache.pb.validate.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+/**
+ * Config registration for the mobile HTTP cache. @see HttpCacheFactory.
+ */
+class MobileHttpCacheFactory : public HttpCacheFactory {
+public:
+  // HttpCacheFactory
+  std::shared_ptr<HttpCache>
+  getCache(const envoy::extensions::filters::http::cache::v3::CacheConfig& config,
+           Server::Configuration::FactoryContext& context) override;
+
+  // TypedFactory
+  ProtobufTypes::MessagePtr createEmptyConfigProto() override {
+    return std::make_unique<envoymobile::extensions::http::cache::mobile::MobileHttpCacheConfig>();
+  }
+
+  std::string name() const override { return "envoy.extensions.http.cache.mobile"; }
+};
+
+DECLARE_FACTORY(MobileHttpCacheFactory);
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -1,9 +1,15 @@
 #include "library/common/extensions/key_value/platform/config.h"
 
+#include <vector>
+
 #include "envoy/config/common/key_value/v3/config.pb.h"
 #include "envoy/config/common/key_value/v3/config.pb.validate.h"
 #include "envoy/registry/registry.h"
 
+#include "source/common/common/macros.h"
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/synchronization/mutex.h"
 #include "library/common/api/external.h"
 #include "library/common/data/utility.h"
 #include "library/common/extensions/key_value/platform/c_types.h"
@@ -46,18 +52,35 @@ PlatformInterfaceImpl& getPlatformInterfaceImplSingleton() {
   return impl;
 }
 
+// The live stores, across engines.
+struct PlatformStores {
+  absl::Mutex mutex_;
+  absl::flat_hash_set<PlatformKeyValueStore*> stores_ ABSL_GUARDED_BY(mutex_);
+};
+
+PlatformStores& platformStores() { MUTABLE_CONSTRUCT_ON_FIRST_USE(PlatformStores); }
+
 } // namespace
 
 PlatformKeyValueStore::PlatformKeyValueStore(Event::Dispatcher& dispatcher,
                                              std::chrono::milliseconds save_interval,
                                              PlatformInterface& platform_interface,
                                              uint64_t max_entries, const std::string& key)
-    : KeyValueStoreBase(dispatcher, save_interval, max_entries),
+    : KeyValueStoreBase(dispatcher, save_interval, max_entries), dispatcher_(dispatcher),
       platform_interface_(platform_interface), key_(key) {
   const std::string contents = platform_interface_.read(key);
   if (!parseContents(contents)) {
     ENVOY_LOG(warn, "Failed to parse key value store contents {}", key);
   }
+  PlatformStores& stores = platformStores();
+  absl::MutexLock lock(&stores.mutex_);
+  stores.stores_.insert(this);
+}
+
+PlatformKeyValueStore::~PlatformKeyValueStore() {
+  PlatformStores& stores = platformStores();
+  absl::MutexLock lock(&stores.mutex_);
+  stores.stores_.erase(this);
 }
 
 void PlatformKeyValueStore::flush() {
@@ -69,6 +92,24 @@ void PlatformKeyValueStore::flush() {
   platform_interface_.save(key_, output);
 }
 
+void flushPlatformKeyValueStores(Event::Dispatcher& dispatcher) {
+  std::vector<PlatformKeyValueStore*> to_flush;
+  {
+    PlatformStores& stores = platformStores();
+    absl::MutexLock lock(&stores.mutex_);
+    for (PlatformKeyValueStore* store : stores.stores_) {
+      if (&store->dispatcher() == &dispatcher) {
+        to_flush.push_back(store);
+      }
+    }
+  }
+  // Stores are destroyed on their dispatcher's thread, so those found remain alive until this
+  // returns. They're flushed without the lock, as the platform may save synchronously.
+  for (PlatformKeyValueStore* store : to_flush) {
+    store->flush();
+  }
+}
+
 KeyValueStorePtr
 PlatformKeyValueStoreFactory::createStore(const Protobuf::Message& config,
                                           ProtobufMessage::ValidationVisitor& validation_visitor,
@@ -28,14 +28,22 @@ public:
   PlatformKeyValueStore(Event::Dispatcher& dispatcher, std::chrono::milliseconds save_interval,
                         PlatformInterface& platform_interface, uint64_t max_entries,
                         const std::string& key);
+  ~PlatformKeyValueStore() override;
   // KeyValueStore
   void flush() override;
 
+  Event::Dispatcher& dispatcher() { return dispatcher_; }
+
 private:
+  Event::Dispatcher& dispatcher_;
   PlatformInterface& platform_interface_;
   const std::string key_;
 };
 
+// Flushes the platform key value stores which run on the dispatcher, rather than waiting for their
+// save intervals, e.g. before the app is suspended. Must be called on the dispatcher's thread.
+void flushPlatformKeyValueStores(Event::Dispatcher& dispatcher);
+
 class PlatformKeyValueStoreFactory : public KeyValueStoreFactory {
 public:
   PlatformKeyValueStoreFactory() = default;
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "envoy/common/time.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * Times a single platform callback against the monotonic clock. Intended to be allocated on the
+ * stack around the callback, so timing a callback costs two clock reads and no allocation.
+ */
+class CallbackTimer {
+public:
+  explicit CallbackTimer(TimeSource& time_source)
+      : time_source_(time_source), start_(time_source.monotonicTime()) {}
+
+  /**
+   * @return std::chrono::milliseconds, the time elapsed since the timer was created.
+   */
+  std::chrono::milliseconds elapsed() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(time_source_.monotonicTime() -
+                                                                 start_);
+  }
+
+private:
+  TimeSource& time_source_;
+  const MonotonicTime start_;
+};
+
+/**
+ * Selects which callback latencies are recorded in histograms: one in every sample_rate callbacks.
+ * Selection is a counter rather than a random draw, so deciding costs an increment and a compare.
+ *
+ * Not thread-safe. Used from the engine's dispatcher thread.
+ */
+class CallbackLatencySampler {
+public:
+  /**
+   * @param sample_rate, record one in every sample_rate callbacks. 1 records every callback, and 0
+   *        records none.
+   */
+  explicit CallbackLatencySampler(uint32_t sample_rate = 1) : sample_rate_(sample_rate) {}
+
+  /**
+   * @return bool, whether the current callback's latency should be recorded.
+   */
+  bool sample() {
+    if (sample_rate_ == 0 || ++calls_ < sample_rate_) {
+      return false;
+    }
+    calls_ = 0;
+    return true;
+  }
+
+  uint32_t sampleRate() const { return sample_rate_; }
+
+private:
+  const uint32_t sample_rate_;
+  uint32_t calls_{};
+};
+
+} // namespace Http
+} // namespace Envoy
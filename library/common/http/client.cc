@@ -1,5 +1,7 @@
 #include "library/common/http/client.h"
 
+#include <algorithm>
+
 #include "source/common/buffer/buffer_impl.h"
 #include "source/common/common/dump_state_utils.h"
 #include "source/common/common/scope_tracker.h"
@@ -8,6 +10,7 @@
 #include "source/common/http/headers.h"
 #include "source/common/http/utility.h"
 
+#include "absl/strings/numbers.h"
 #include "library/common/bridge/utility.h"
 #include "library/common/buffer/bridge_fragment.h"
 #include "library/common/data/utility.h"
@@ -32,13 +35,70 @@ namespace {
 
 constexpr auto SlowCallbackWarningTreshold = std::chrono::seconds(1);
 
+// The size of the chunks in which a file is sent by streams without a buffer limit.
+constexpr uint32_t UnlimitedFileChunkBytes = 64 * 1024;
+// Response details for streams reset because the file they were sending could not be read.
+constexpr absl::string_view FileUploadFailedDetails = "client_file_upload_failed";
+// Response details for streams failed because their response body could not be written.
+constexpr absl::string_view ResponseBodyWriteFailedDetails = "client_response_body_write_failed";
+
+// Returns the response's content-length, or 0 if it is absent or invalid.
+uint64_t contentLength(const ResponseHeaderMap& headers) {
+  uint64_t content_length = 0;
+  const HeaderEntry* entry = headers.ContentLength();
+  if (entry == nullptr || !absl::SimpleAtoi(entry->value().getStringView(), &content_length)) {
+    return 0;
+  }
+  return content_length;
+}
+
 } // namespace
 
+void Client::recordCallbackLatency(const CallbackTimer& timer, SampledLatencyHistogram& latency,
+                                   absl::string_view slow_callback_event) {
+  const std::chrono::milliseconds elapsed = timer.elapsed();
+  if (latency.sampler_.sample()) {
+    latency.histogram_.recordValue(elapsed.count());
+  }
+  // Slow callbacks are always reported, whether or not their latency is sampled.
+  if (elapsed > SlowCallbackWarningTreshold) {
+    ENVOY_LOG_EVENT(warn, slow_callback_event, std::to_string(elapsed.count()) + "ms");
+  }
+}
+
 Client::DirectStreamCallbacks::DirectStreamCallbacks(DirectStream& direct_stream,
                                                      envoy_http_callbacks bridge_callbacks,
                                                      Client& http_client)
     : direct_stream_(direct_stream), bridge_callbacks_(bridge_callbacks), http_client_(http_client),
-      explicit_flow_control_(direct_stream_.explicit_flow_control_) {}
+      // A response body written to a file is paced by the writes rather than by the platform.
+      explicit_flow_control_(direct_stream_.explicit_flow_control_ &&
+                             direct_stream_.response_body_fd_ < 0) {
+  if (direct_stream_.response_body_fd_ >= 0) {
+    response_body_file_ = std::make_unique<ResponseBodyFile>();
+    response_body_file_->writer_ = std::make_unique<Buffer::FileWriter>(
+        direct_stream_.response_body_fd_, http_client_.file_writer_thread_,
+        http_client_.dispatcher_, *this);
+    response_body_file_->reported_at_ = http_client_.timeSource().monotonicTime();
+  }
+  if (explicit_flow_control_ && direct_stream_.auto_tune_read_window_) {
+    read_window_.emplace(direct_stream_.buffer_limit_);
+  }
+  // With explicit flow control the platform already paces delivery, so responses are only
+  // aggregated without it; the aggregate limit then bounds what is held for the stream.
+  aggregating_ = !explicit_flow_control_ && !response_body_file_ &&
+                 direct_stream_.aggregate_body_limit_ > 0 &&
+                 bridge_callbacks_.on_aggregated_response != nullptr;
+}
+
+Client::DirectStreamCallbacks::~DirectStreamCallbacks() {
+  // Release an aggregated response which was never delivered, e.g. due to an error.
+  if (aggregated_headers_) {
+    release_envoy_headers(*aggregated_headers_);
+  }
+  if (aggregated_trailers_) {
+    release_envoy_headers(*aggregated_trailers_);
+  }
+}
 
 void Client::DirectStreamCallbacks::encodeHeaders(const ResponseHeaderMap& headers,
                                                   bool end_stream) {
@@ -48,6 +108,8 @@ void Client::DirectStreamCallbacks::encodeHeaders(const ResponseHeaderMap& heade
 
   ASSERT(http_client_.getStream(direct_stream_.stream_handle_,
                                 GetStreamFilters::ALLOW_FOR_ALL_STREAMS));
+  // A high priority stream stops holding back low priority streams once its response starts.
+  http_client_.resolvePriority(direct_stream_);
 
   // Capture some metadata before potentially closing the stream.
   absl::string_view alpn = "";
@@ -66,25 +128,43 @@ void Client::DirectStreamCallbacks::encodeHeaders(const ResponseHeaderMap& heade
   if (end_stream) {
     closeStream();
   }
+  if (detached_) {
+    if (end_stream) {
+      onComplete();
+    }
+    return;
+  }
 
   // Track success for later bookkeeping (stream could still be reset).
   uint64_t response_status = Utility::getResponseStatus(headers);
   success_ = CodeUtility::is2xx(response_status);
 
+  if (aggregating_) {
+    const uint64_t content_length = contentLength(headers);
+    if (content_length <= direct_stream_.aggregate_body_limit_) {
+      ENVOY_LOG(debug, "[S{}] aggregating response (content-length={})",
+                direct_stream_.stream_handle_, content_length);
+      aggregated_headers_ = Utility::toBridgeHeaders(headers, alpn);
+      aggregated_body_.reserve(content_length);
+      if (end_stream) {
+        onComplete();
+      }
+      return;
+    }
+    // The body is known to exceed the limit, so it is streamed from the start.
+    aggregating_ = false;
+  }
+
   ENVOY_LOG(debug, "[S{}] dispatching to platform response headers for stream (end_stream={}):\n{}",
             direct_stream_.stream_handle_, end_stream, headers);
 
-  auto callback_time_ms = std::make_unique<Stats::HistogramCompletableTimespanImpl>(
-      http_client_.stats().on_headers_callback_latency_, http_client_.timeSource());
+  CallbackTimer callback_timer(http_client_.timeSource());
 
   bridge_callbacks_.on_headers(Utility::toBridgeHeaders(headers, alpn), end_stream, streamIntel(),
                                bridge_callbacks_.context);
 
-  callback_time_ms->complete();
-  auto elapsed = callback_time_ms->elapsed();
-  if (elapsed > SlowCallbackWarningTreshold) {
-    ENVOY_LOG_EVENT(warn, "slow_on_headers_cb", std::to_string(elapsed.count()) + "ms");
-  }
+  http_client_.recordCallbackLatency(callback_timer, http_client_.on_headers_latency_,
+                                     "slow_on_headers_cb");
 
   response_headers_forwarded_ = true;
   if (end_stream) {
@@ -110,6 +190,34 @@ void Client::DirectStreamCallbacks::encodeData(Buffer::Instance& data, bool end_
   if (end_stream) {
     closeStream();
   }
+  if (detached_) {
+    data.drain(data.length());
+    if (end_stream) {
+      onComplete();
+    }
+    return;
+  }
+
+  if (response_body_file_) {
+    writeResponseBody(data);
+    maybeFinishResponseBody();
+    return;
+  }
+
+  if (aggregating_) {
+    if (aggregated_body_.size() + data.length() <= direct_stream_.aggregate_body_limit_) {
+      const size_t offset = aggregated_body_.size();
+      aggregated_body_.resize(offset + data.length());
+      data.copyOut(0, data.length(), &aggregated_body_[offset]);
+      data.drain(data.length());
+      if (end_stream) {
+        onComplete();
+      }
+      return;
+    }
+    // Deliver what has been aggregated so far, then stream the rest.
+    stopAggregating();
+  }
 
   // The response_data_ is systematically assigned here because resumeData can
   // incur an asynchronous callback to sendDataToBridge.
@@ -117,10 +225,11 @@ void Client::DirectStreamCallbacks::encodeData(Buffer::Instance& data, bool end_
     response_data_ = std::make_unique<Buffer::WatermarkBuffer>(
         [this]() -> void { this->onBufferedDataDrained(); },
         [this]() -> void { this->onHasBufferedData(); }, []() -> void {});
-    // Default to 1M per stream. This is fairly arbitrary and will result in
-    // Envoy buffering up to 1M + flow-control-window for HTTP/2 and HTTP/3,
-    // and having local data of 1M + kernel-buffer-limit for HTTP/1.1
-    response_data_->setWatermarks(1000000);
+    // Default to the stream's buffer limit (1M unless configured otherwise). This will result in
+    // Envoy buffering up to the limit + flow-control-window for HTTP/2 and HTTP/3, and having
+    // local data of the limit + kernel-buffer-limit for HTTP/1.1
+    response_watermark_ = direct_stream_.buffer_limit_;
+    response_data_->setWatermarks(response_watermark_);
   }
 
   // Send data if in default flow control mode, or if resumeData has been called in explicit
@@ -138,6 +247,36 @@ void Client::DirectStreamCallbacks::encodeData(Buffer::Instance& data, bool end_
         direct_stream_.stream_handle_, data.length(), data.length() + response_data_->length());
     response_data_->move(data);
   }
+  updateBufferBudget();
+}
+
+void Client::DirectStreamCallbacks::updateBufferBudget() {
+  if (!response_data_ || buffer_budget_released_) {
+    return;
+  }
+  StreamBufferBudget& budget = http_client_.buffer_budget_;
+  const uint64_t buffered = response_data_->length();
+  budget.update(budgeted_bytes_, buffered);
+  budgeted_bytes_ = buffered;
+  if (budget.budget() == 0) {
+    return;
+  }
+
+  // Lower the watermark as buffered data accumulates across the engine, and raise it again as it
+  // drains. Only this stream's watermark is adjusted; others adjust on their next update.
+  const uint32_t watermark = budget.limitFor(direct_stream_.requested_buffer_limit_);
+  if (watermark != response_watermark_) {
+    ENVOY_LOG(debug, "[S{}] resizing response buffer watermark from {} to {} ({} bytes buffered)",
+              direct_stream_.stream_handle_, response_watermark_, watermark, budget.buffered());
+    response_watermark_ = watermark;
+    response_data_->setWatermarks(watermark);
+  }
+}
+
+void Client::DirectStreamCallbacks::releaseBufferBudget() {
+  http_client_.buffer_budget_.update(budgeted_bytes_, 0);
+  budgeted_bytes_ = 0;
+  buffer_budget_released_ = true;
 }
 
 void Client::DirectStreamCallbacks::sendDataToBridge(Buffer::Instance& data, bool end_stream) {
@@ -154,21 +293,30 @@ void Client::DirectStreamCallbacks::sendDataToBridge(Buffer::Instance& data, boo
             "[S{}] dispatching to platform response data for stream (length={} end_stream={})",
             direct_stream_.stream_handle_, bytes_to_send, send_end_stream);
 
-  auto callback_time_ms = std::make_unique<Stats::HistogramCompletableTimespanImpl>(
-      http_client_.stats().on_data_callback_latency_, http_client_.timeSource());
+  CallbackTimer callback_timer(http_client_.timeSource());
 
-  bridge_callbacks_.on_data(Data::Utility::toBridgeData(data, bytes_to_send), send_end_stream,
-                            streamIntel(), bridge_callbacks_.context);
-
-  callback_time_ms->complete();
-  auto elapsed = callback_time_ms->elapsed();
-  if (elapsed > SlowCallbackWarningTreshold) {
-    ENVOY_LOG_EVENT(warn, "slow_on_data_cb", std::to_string(elapsed.count()) + "ms");
+  if (bridge_callbacks_.on_data_vectored != nullptr) {
+    // Hand over the received slices as they are, rather than linearizing them.
+    Data::Utility::BridgeDataVector slices = Data::Utility::toBridgeDataVector(data, bytes_to_send);
+    bridge_callbacks_.on_data_vectored(slices.data(), slices.size(), send_end_stream, streamIntel(),
+                                       bridge_callbacks_.context);
+  } else {
+    bridge_callbacks_.on_data(Data::Utility::toBridgeData(data, bytes_to_send), send_end_stream,
+                              streamIntel(), bridge_callbacks_.context);
   }
 
+  http_client_.recordCallbackLatency(callback_timer, http_client_.on_data_latency_,
+                                     "slow_on_data_cb");
+
   if (send_end_stream) {
     onComplete();
   }
+  if (read_window_) {
+    // Keep sending data as it arrives until the window's credit has been used.
+    bytes_to_send_ =
+        read_window_->onDelivered(bytes_to_send, http_client_.timeSource().monotonicTime());
+    return;
+  }
   // Make sure that when using explicit flow control this won't send more data until the next call
   // to resumeData.
   bytes_to_send_ = 0;
@@ -183,6 +331,24 @@ void Client::DirectStreamCallbacks::encodeTrailers(const ResponseTrailerMap& tra
                                 GetStreamFilters::ALLOW_FOR_ALL_STREAMS));
   direct_stream_.saveLatestStreamIntel();
   closeStream(); // Trailers always indicate the end of the stream.
+  if (detached_) {
+    onComplete();
+    return;
+  }
+
+  if (aggregating_) {
+    aggregated_trailers_ = Utility::toBridgeHeaders(trailers);
+    onComplete();
+    return;
+  }
+
+  // Trailers follow the body, so they're delivered once it has been written.
+  if (response_body_file_) {
+    response_body_file_->trailers_ = ResponseTrailerMapImpl::create();
+    HeaderMapImpl::copyFrom(*response_body_file_->trailers_, trailers);
+    maybeFinishResponseBody();
+    return;
+  }
 
   // For explicit flow control, don't send data unless prompted.
   if (explicit_flow_control_ && bytes_to_send_ == 0) {
@@ -198,26 +364,124 @@ void Client::DirectStreamCallbacks::sendTrailersToBridge(const ResponseTrailerMa
   ENVOY_LOG(debug, "[S{}] dispatching to platform response trailers for stream:\n{}",
             direct_stream_.stream_handle_, trailers);
 
-  auto callback_time_ms = std::make_unique<Stats::HistogramCompletableTimespanImpl>(
-      http_client_.stats().on_trailers_callback_latency_, http_client_.timeSource());
+  CallbackTimer callback_timer(http_client_.timeSource());
 
   bridge_callbacks_.on_trailers(Utility::toBridgeHeaders(trailers), streamIntel(),
                                 bridge_callbacks_.context);
 
-  callback_time_ms->complete();
-  auto elapsed = callback_time_ms->elapsed();
-  if (elapsed > SlowCallbackWarningTreshold) {
-    ENVOY_LOG_EVENT(warn, "slow_on_trailers_cb", std::to_string(elapsed.count()) + "ms");
-  }
+  http_client_.recordCallbackLatency(callback_timer, http_client_.on_trailers_latency_,
+                                     "slow_on_trailers_cb");
 
   onComplete();
 }
 
+void Client::DirectStreamCallbacks::writeResponseBody(Buffer::Instance& data) {
+  ResponseBodyFile& file = *response_body_file_;
+  ENVOY_LOG(debug, "[S{}] writing {} bytes of response body to file ({} bytes unwritten)",
+            direct_stream_.stream_handle_, data.length(), file.unwritten_ + data.length());
+  file.unwritten_ += data.length();
+  file.writer_->write(data);
+
+  // As for data buffered in explicit flow control mode, reading from upstream pauses while more
+  // than the stream's buffer limit is unwritten, and resumes once half of it is.
+  if (!file.writes_behind_ && file.unwritten_ > direct_stream_.buffer_limit_) {
+    file.writes_behind_ = true;
+    onHasBufferedData();
+  }
+}
+
+void Client::DirectStreamCallbacks::onWritten(uint64_t bytes) {
+  ScopeTrackerScopeState scope(&direct_stream_, http_client_.scopeTracker());
+  ResponseBodyFile& file = *response_body_file_;
+  file.unwritten_ -= bytes;
+  file.written_ += bytes;
+  direct_stream_.stream_intel_.consumed_bytes_from_response += bytes;
+
+  if (file.writes_behind_ && file.unwritten_ <= direct_stream_.buffer_limit_ / 2) {
+    file.writes_behind_ = false;
+    onBufferedDataDrained();
+  }
+  reportResponseBodyProgress();
+  maybeFinishResponseBody();
+}
+
+void Client::DirectStreamCallbacks::onWriteError(int error) {
+  ScopeTrackerScopeState scope(&direct_stream_, http_client_.scopeTracker());
+  ENVOY_LOG(debug, "[S{}] failed to write response body (errno={})", direct_stream_.stream_handle_,
+            error);
+  response_body_write_failed_ = true;
+  if (remote_end_stream_received_) {
+    // There is nothing left to reset upstream, so the stream fails straight away.
+    onError();
+    return;
+  }
+  direct_stream_.setResponseDetails(ResponseBodyWriteFailedDetails);
+  direct_stream_.resetStream(StreamResetReason::LocalReset);
+}
+
+void Client::DirectStreamCallbacks::reportResponseBodyProgress() {
+  ResponseBodyFile& file = *response_body_file_;
+  if (bridge_callbacks_.on_response_body_progress == nullptr || file.written_ == file.reported_) {
+    return;
+  }
+  const uint64_t progress_bytes = direct_stream_.response_body_progress_bytes_;
+  const std::chrono::milliseconds progress_interval =
+      direct_stream_.response_body_progress_interval_;
+  const MonotonicTime now = http_client_.timeSource().monotonicTime();
+  const bool finished = remote_end_stream_received_ && file.unwritten_ == 0;
+  const bool due = finished || (progress_bytes == 0 && progress_interval.count() == 0) ||
+                   (progress_bytes > 0 && file.written_ - file.reported_ >= progress_bytes) ||
+                   (progress_interval.count() > 0 && now - file.reported_at_ >= progress_interval);
+  if (!due) {
+    return;
+  }
+  file.reported_ = file.written_;
+  file.reported_at_ = now;
+
+  CallbackTimer callback_timer(http_client_.timeSource());
+
+  bridge_callbacks_.on_response_body_progress(file.written_, streamIntel(),
+                                              bridge_callbacks_.context);
+
+  http_client_.recordCallbackLatency(callback_timer,
+                                     http_client_.on_response_body_progress_latency_,
+                                     "slow_on_response_body_progress_cb");
+}
+
+void Client::DirectStreamCallbacks::maybeFinishResponseBody() {
+  if (!remote_end_stream_received_ || response_body_file_->unwritten_ > 0) {
+    return;
+  }
+  ENVOY_LOG(debug, "[S{}] response body written to file ({} bytes)",
+            direct_stream_.stream_handle_, response_body_file_->written_);
+  // Completing the stream removes it, and with it response_body_file_.
+  ResponseTrailerMapPtr trailers = std::move(response_body_file_->trailers_);
+  if (trailers) {
+    sendTrailersToBridge(*trailers);
+  } else {
+    onComplete();
+  }
+}
+
 void Client::DirectStreamCallbacks::resumeData(int32_t bytes_to_send) {
+  if (response_body_file_ || detached_) {
+    // The response body is written to file as it arrives, without waiting to be asked for.
+    return;
+  }
   ASSERT(explicit_flow_control_);
   ASSERT(bytes_to_send > 0);
 
-  bytes_to_send_ = bytes_to_send;
+  if (read_window_) {
+    const uint32_t window = read_window_->window();
+    bytes_to_send_ =
+        read_window_->onGrant(bytes_to_send, http_client_.timeSource().monotonicTime());
+    if (read_window_->window() != window) {
+      ENVOY_LOG(debug, "[S{}] read window resized from {} to {} bytes",
+                direct_stream_.stream_handle_, window, read_window_->window());
+    }
+  } else {
+    bytes_to_send_ = bytes_to_send;
+  }
 
   ENVOY_LOG(debug, "[S{}] received resume data call for {} bytes", direct_stream_.stream_handle_,
             bytes_to_send_);
@@ -229,7 +493,6 @@ void Client::DirectStreamCallbacks::resumeData(int32_t bytes_to_send) {
   if (hasBufferedData() ||
       (remote_end_stream_received_ && !remote_end_stream_forwarded_ && !response_trailers_)) {
     sendDataToBridge(*response_data_, remote_end_stream_received_ && !response_trailers_.get());
-    bytes_to_send_ = 0;
   }
 
   // If all buffered data has been sent, send and free up trailers.
@@ -238,6 +501,7 @@ void Client::DirectStreamCallbacks::resumeData(int32_t bytes_to_send) {
     response_trailers_.reset();
     bytes_to_send_ = 0;
   }
+  updateBufferBudget();
 }
 
 void Client::DirectStreamCallbacks::closeStream() {
@@ -245,20 +509,19 @@ void Client::DirectStreamCallbacks::closeStream() {
   // Latch stream intel on stream completion, as the stream info will go away.
   direct_stream_.saveFinalStreamIntel();
 
-  auto& client = direct_stream_.parent_;
-  auto stream = client.getStream(direct_stream_.stream_handle_, ALLOW_ONLY_FOR_OPEN_STREAMS);
-  ASSERT(stream != nullptr);
-  if (stream) {
-    client.closed_streams_.emplace(direct_stream_.stream_handle_, std::move(stream));
-    size_t erased = client.streams_.erase(direct_stream_.stream_handle_);
-    ASSERT(erased == 1, "closeStream should always remove one entry from the streams map");
-  }
+  bool closed = direct_stream_.parent_.streams_.close(direct_stream_.stream_handle_);
+  ASSERT(closed, "closeStream should always close an open stream in the streams table");
   direct_stream_.request_decoder_ = nullptr;
 }
 
 void Client::DirectStreamCallbacks::onComplete() {
   http_client_.removeStream(direct_stream_.stream_handle_);
   remote_end_stream_forwarded_ = true;
+  // The platform was told of a detached stream's end when it cancelled it.
+  if (detached_) {
+    ENVOY_LOG(debug, "[S{}] complete detached stream", direct_stream_.stream_handle_);
+    return;
+  }
   ENVOY_LOG(debug, "[S{}] complete stream (success={})", direct_stream_.stream_handle_, success_);
   if (success_) {
     http_client_.stats().stream_success_.inc();
@@ -266,21 +529,70 @@ void Client::DirectStreamCallbacks::onComplete() {
     http_client_.stats().stream_failure_.inc();
   }
 
-  auto callback_time_ms = std::make_unique<Stats::HistogramCompletableTimespanImpl>(
-      http_client_.stats().on_complete_callback_latency_, http_client_.timeSource());
+  if (aggregated_headers_) {
+    sendAggregatedResponseToBridge();
+    return;
+  }
+
+  CallbackTimer callback_timer(http_client_.timeSource());
 
   bridge_callbacks_.on_complete(streamIntel(), finalStreamIntel(), bridge_callbacks_.context);
 
-  callback_time_ms->complete();
-  auto elapsed = callback_time_ms->elapsed();
-  if (elapsed > SlowCallbackWarningTreshold) {
-    ENVOY_LOG_EVENT(warn, "slow_on_complete_cb", std::to_string(elapsed.count()) + "ms");
+  http_client_.recordCallbackLatency(callback_timer, http_client_.on_complete_latency_,
+                                     "slow_on_complete_cb");
+}
+
+void Client::DirectStreamCallbacks::sendAggregatedResponseToBridge() {
+  ENVOY_LOG(debug, "[S{}] dispatching to platform aggregated response (body length={})",
+            direct_stream_.stream_handle_, aggregated_body_.size());
+  aggregating_ = false;
+  direct_stream_.stream_intel_.consumed_bytes_from_response += aggregated_body_.size();
+  envoy_headers headers = *aggregated_headers_;
+  envoy_headers trailers = aggregated_trailers_.value_or(envoy_noheaders);
+  // Ownership of the headers and trailers passes to the platform.
+  aggregated_headers_.reset();
+  aggregated_trailers_.reset();
+
+  CallbackTimer callback_timer(http_client_.timeSource());
+
+  bridge_callbacks_.on_aggregated_response(headers,
+                                           Data::Utility::toBridgeData(std::move(aggregated_body_)),
+                                           trailers, streamIntel(), finalStreamIntel(),
+                                           bridge_callbacks_.context);
+
+  http_client_.recordCallbackLatency(callback_timer, http_client_.on_complete_latency_,
+                                     "slow_on_aggregated_response_cb");
+}
+
+void Client::DirectStreamCallbacks::stopAggregating() {
+  ENVOY_LOG(debug, "[S{}] response body exceeds the aggregate limit of {} bytes, streaming",
+            direct_stream_.stream_handle_, direct_stream_.aggregate_body_limit_);
+  aggregating_ = false;
+  envoy_headers headers = *aggregated_headers_;
+  aggregated_headers_.reset();
+
+  CallbackTimer callback_timer(http_client_.timeSource());
+
+  bridge_callbacks_.on_headers(headers, false, streamIntel(), bridge_callbacks_.context);
+
+  http_client_.recordCallbackLatency(callback_timer, http_client_.on_headers_latency_,
+                                     "slow_on_headers_cb");
+  response_headers_forwarded_ = true;
+
+  if (!aggregated_body_.empty()) {
+    Buffer::OwnedImpl body(aggregated_body_);
+    std::string().swap(aggregated_body_);
+    sendDataToBridge(body, false);
   }
 }
 
 void Client::DirectStreamCallbacks::onError() {
   ScopeTrackerScopeState scope(&direct_stream_, http_client_.scopeTracker());
   ENVOY_LOG(debug, "[S{}] remote reset stream", direct_stream_.stream_handle_);
+  if (detached_) {
+    http_client_.removeStream(direct_stream_.stream_handle_);
+    return;
+  }
 
   // When using explicit flow control, if any response data has been sent (e.g. headers), response
   // errors must be deferred until after resumeData has been called.
@@ -302,20 +614,19 @@ void Client::DirectStreamCallbacks::onError() {
             direct_stream_.stream_handle_);
   http_client_.stats().stream_failure_.inc();
 
-  auto callback_time_ms = std::make_unique<Stats::HistogramCompletableTimespanImpl>(
-      http_client_.stats().on_error_callback_latency_, http_client_.timeSource());
+  CallbackTimer callback_timer(http_client_.timeSource());
 
   bridge_callbacks_.on_error(error_.value(), streamIntel(), finalStreamIntel(),
                              bridge_callbacks_.context);
 
-  callback_time_ms->complete();
-  auto elapsed = callback_time_ms->elapsed();
-  if (elapsed > SlowCallbackWarningTreshold) {
-    ENVOY_LOG_EVENT(warn, "slow_on_error_cb", std::to_string(elapsed.count()) + "ms");
-  }
+  http_client_.recordCallbackLatency(callback_timer, http_client_.on_error_latency_,
+                                     "slow_on_error_cb");
 }
 
 void Client::DirectStreamCallbacks::onSendWindowAvailable() {
+  if (detached_) {
+    return;
+  }
   ENVOY_LOG(debug, "[S{}] remote send window available", direct_stream_.stream_handle_);
   bridge_callbacks_.on_send_window_available(streamIntel(), bridge_callbacks_.context);
 }
@@ -330,16 +641,34 @@ void Client::DirectStreamCallbacks::onCancel() {
   // is already complete.
   direct_stream_.saveFinalStreamIntel();
 
-  auto callback_time_ms = std::make_unique<Stats::HistogramCompletableTimespanImpl>(
-      http_client_.stats().on_cancel_callback_latency_, http_client_.timeSource());
+  CallbackTimer callback_timer(http_client_.timeSource());
 
   bridge_callbacks_.on_cancel(streamIntel(), finalStreamIntel(), bridge_callbacks_.context);
 
-  callback_time_ms->complete();
-  auto elapsed = callback_time_ms->elapsed();
-  if (elapsed > SlowCallbackWarningTreshold) {
-    ENVOY_LOG_EVENT(warn, "slow_on_cancel_cb", std::to_string(elapsed.count()) + "ms");
+  http_client_.recordCallbackLatency(callback_timer, http_client_.on_cancel_latency_,
+                                     "slow_on_cancel_cb");
+}
+
+void Client::DirectStreamCallbacks::detach() {
+  ENVOY_LOG(debug, "[S{}] detaching stream from platform", direct_stream_.stream_handle_);
+  detached_ = true;
+  if (direct_stream_.send_window_notifier_) {
+    direct_stream_.send_window_notifier_->cancel();
+  }
+  // The platform may close the response body file once it has cancelled the stream.
+  if (response_body_file_) {
+    const bool writes_behind = response_body_file_->writes_behind_;
+    response_body_file_.reset();
+    if (writes_behind) {
+      onBufferedDataDrained();
+    }
+  }
+  // Draining the data buffered for the platform resumes upstream if it was above its watermark.
+  if (hasBufferedData()) {
+    response_data_->drain(response_data_->length());
   }
+  response_trailers_.reset();
+  releaseBufferBudget();
 }
 
 void Client::DirectStreamCallbacks::onHasBufferedData() {
@@ -382,6 +711,16 @@ void Client::DirectStream::saveFinalStreamIntel() {
 }
 
 envoy_error Client::DirectStreamCallbacks::streamError() {
+  if (response_body_write_failed_) {
+    // The stream may have been closed, so its info is no longer available.
+    return {ENVOY_STREAM_RESET, Data::Utility::copyToBridgeData(ResponseBodyWriteFailedDetails),
+            0};
+  }
+  if (direct_stream_.request_decoder_ == nullptr) {
+    // The stream was held, so never started in the connection manager.
+    return {ENVOY_STREAM_RESET, Data::Utility::copyToBridgeData(direct_stream_.response_details_),
+            0};
+  }
   const auto& info = direct_stream_.request_decoder_->streamInfo();
   envoy_error error{};
 
@@ -433,13 +772,39 @@ void Client::DirectStream::readDisable(bool disable) {
   } else {
     ASSERT(read_disable_count_ > 0);
     --read_disable_count_;
-    if (read_disable_count_ == 0 && wants_write_notification_) {
+    if (read_disable_count_ == 0 && file_upload_ != nullptr) {
+      // The file resumes where it left off. The send window is made available once it's sent.
+      scheduleFileUpload();
+    } else if (read_disable_count_ == 0 && wants_write_notification_) {
       wants_write_notification_ = false;
       callbacks_->onSendWindowAvailable();
     }
   }
 }
 
+void Client::DirectStream::scheduleSendWindowNotification() {
+  if (send_window_notifier_ == nullptr) {
+    // The notifier is owned by the stream and cancelled when the stream is removed, so it never
+    // fires for a stream which is no longer in the table.
+    send_window_notifier_ = parent_.dispatcher_.createSchedulableCallback(
+        [this] { callbacks_->onSendWindowAvailable(); });
+  }
+  if (!send_window_notifier_->enabled()) {
+    send_window_notifier_->scheduleCallbackNextIteration();
+  }
+}
+
+void Client::DirectStream::scheduleFileUpload() {
+  if (file_upload_notifier_ == nullptr) {
+    // As with send_window_notifier_, the notifier is cancelled when the stream is removed.
+    file_upload_notifier_ =
+        parent_.dispatcher_.createSchedulableCallback([this] { parent_.sendFileChunk(*this); });
+  }
+  if (!file_upload_notifier_->enabled()) {
+    file_upload_notifier_->scheduleCallbackNextIteration();
+  }
+}
+
 void Client::DirectStream::dumpState(std::ostream&, int indent_level) const {
   // TODO(junr03): output to ostream arg - https://github.com/envoyproxy/envoy-mobile/issues/1497.
   std::stringstream ss;
@@ -449,27 +814,62 @@ void Client::DirectStream::dumpState(std::ostream&, int indent_level) const {
   ENVOY_LOG(error, "\n{}", ss.str());
 }
 
+Client::~Client() {
+  // Streams which were never removed are still owned by the table.
+  streams_.forEach([](DirectStream* direct_stream) { delete direct_stream; });
+}
+
 void Client::startStream(envoy_stream_t new_stream_handle, envoy_http_callbacks bridge_callbacks,
                          bool explicit_flow_control) {
+  envoy_stream_options options{};
+  options.explicit_flow_control = explicit_flow_control;
+  startStream(new_stream_handle, bridge_callbacks, options);
+}
+
+void Client::startStream(envoy_stream_t new_stream_handle, envoy_http_callbacks bridge_callbacks,
+                         const envoy_stream_options& options) {
   ASSERT(dispatcher_.isThreadSafe());
-  Client::DirectStreamSharedPtr direct_stream{new DirectStream(new_stream_handle, *this)};
-  direct_stream->explicit_flow_control_ = explicit_flow_control;
-  direct_stream->callbacks_ =
-      std::make_unique<DirectStreamCallbacks>(*direct_stream, bridge_callbacks, *this);
+  DirectStreamPtr direct_stream{new (*stream_pool_) DirectStream(new_stream_handle, *this)};
+  direct_stream->explicit_flow_control_ = options.explicit_flow_control;
+  // The connection manager reads the stream's buffer limit once, when the stream is created.
+  direct_stream->requested_buffer_limit_ = options.buffer_limit_bytes;
+  direct_stream->buffer_limit_ = buffer_budget_.limitFor(options.buffer_limit_bytes);
+  direct_stream->auto_tune_read_window_ = options.auto_tune_read_window;
+  direct_stream->aggregate_body_limit_ = options.aggregate_body_limit_bytes;
+  direct_stream->priority_ = options.priority;
+  if (options.write_response_body_to_file) {
+    direct_stream->response_body_fd_ = options.response_body_fd;
+    direct_stream->response_body_progress_bytes_ = options.response_body_progress_bytes;
+    direct_stream->response_body_progress_interval_ =
+        std::chrono::milliseconds(options.response_body_progress_interval_ms);
+  }
+  if (options.priority == ENVOY_STREAM_PRIORITY_HIGH) {
+    direct_stream->priority_pending_ = true;
+    priority_scheduler_.onHighPriorityPending();
+  } else if (priority_scheduler_.shouldHold(options.priority)) {
+    ENVOY_LOG(debug, "[S{}] holding low priority stream", new_stream_handle);
+    direct_stream->held_request_ = std::make_unique<HeldRequest>();
+    direct_stream->held_request_->held_at_ = timeSource().monotonicTime();
+    priority_scheduler_.hold(new_stream_handle, direct_stream->held_request_->held_at_);
+    armHoldTimer();
+  }
+  direct_stream->callbacks_.emplace(*direct_stream, bridge_callbacks, *this);
 
   // Note: streams created by Envoy Mobile are tagged as is_internally_created. This means that
-  // the Http::ConnectionManager _will not_ sanitize headers when creating a stream.
-  direct_stream->request_decoder_ =
-      &api_listener_.newStream(*direct_stream->callbacks_, true /* is_internally_created */);
+  // the Http::ConnectionManager _will not_ sanitize headers when creating a stream. Held streams
+  // are created once they're released.
+  if (direct_stream->held_request_ == nullptr) {
+    direct_stream->request_decoder_ =
+        &api_listener_.newStream(*direct_stream->callbacks_, true /* is_internally_created */);
+  }
 
-  streams_.emplace(new_stream_handle, std::move(direct_stream));
+  streams_.insert(new_stream_handle, direct_stream.release());
   ENVOY_LOG(debug, "[S{}] start stream", new_stream_handle);
 }
 
 void Client::sendHeaders(envoy_stream_t stream, envoy_headers headers, bool end_stream) {
   ASSERT(dispatcher_.isThreadSafe());
-  Client::DirectStreamSharedPtr direct_stream =
-      getStream(stream, GetStreamFilters::ALLOW_ONLY_FOR_OPEN_STREAMS);
+  DirectStream* direct_stream = getStream(stream, GetStreamFilters::ALLOW_ONLY_FOR_OPEN_STREAMS);
   // If direct_stream is not found, it means the stream has already closed or been reset
   // and the appropriate callback has been issued to the caller. There's nothing to do here
   // except silently swallow this.
@@ -478,13 +878,17 @@ void Client::sendHeaders(envoy_stream_t stream, envoy_headers headers, bool end_
   // from the caller.
   // https://github.com/envoyproxy/envoy-mobile/issues/301
   if (direct_stream) {
-    ScopeTrackerScopeState scope(direct_stream.get(), scopeTracker());
+    ScopeTrackerScopeState scope(direct_stream, scopeTracker());
     RequestHeaderMapPtr internal_headers = Utility::toRequestHeaders(headers);
 
     // This is largely a check for the android platform: is_cleartext_permitted
     // is a no-op for other platforms.
     if (internal_headers->getSchemeValue() != "https" &&
         !is_cleartext_permitted(internal_headers->getHostValue())) {
+      // A held stream is started in the connection manager first, to fail it with a local reply.
+      if (direct_stream->held_request_) {
+        releaseHeldStream(*direct_stream);
+      }
       direct_stream->request_decoder_->sendLocalReply(
           Http::Code::BadRequest, "Cleartext is not permitted", nullptr, absl::nullopt, "");
       return;
@@ -505,16 +909,21 @@ void Client::sendHeaders(envoy_stream_t stream, envoy_headers headers, bool end_
     // a request here:
     // https://github.com/envoyproxy/envoy/blob/c9e3b9d2c453c7fe56a0e3615f0c742ac0d5e768/source/common/router/config_impl.cc#L1091-L1096
     internal_headers->setReferenceForwardedProto(Headers::get().SchemeValues.Https);
+    setPriority(*internal_headers, direct_stream->priority_);
     ENVOY_LOG(debug, "[S{}] request headers for stream (end_stream={}):\n{}", stream, end_stream,
               *internal_headers);
+    if (direct_stream->held_request_) {
+      direct_stream->held_request_->headers_ = std::move(internal_headers);
+      direct_stream->held_request_->headers_end_stream_ = end_stream;
+      return;
+    }
     direct_stream->request_decoder_->decodeHeaders(std::move(internal_headers), end_stream);
   }
 }
 
 void Client::readData(envoy_stream_t stream, size_t bytes_to_read) {
   ASSERT(dispatcher_.isThreadSafe());
-  Client::DirectStreamSharedPtr direct_stream =
-      getStream(stream, GetStreamFilters::ALLOW_FOR_ALL_STREAMS);
+  DirectStream* direct_stream = getStream(stream, GetStreamFilters::ALLOW_FOR_ALL_STREAMS);
   // If direct_stream is not found, it means the stream has already closed or been reset
   // and the appropriate callback has been issued to the caller. There's nothing to do here
   // except silently swallow this.
@@ -525,8 +934,7 @@ void Client::readData(envoy_stream_t stream, size_t bytes_to_read) {
 
 void Client::sendData(envoy_stream_t stream, envoy_data data, bool end_stream) {
   ASSERT(dispatcher_.isThreadSafe());
-  Client::DirectStreamSharedPtr direct_stream =
-      getStream(stream, GetStreamFilters::ALLOW_ONLY_FOR_OPEN_STREAMS);
+  DirectStream* direct_stream = getStream(stream, GetStreamFilters::ALLOW_ONLY_FOR_OPEN_STREAMS);
   // If direct_stream is not found, it means the stream has already closed or been reset
   // and the appropriate callback has been issued to the caller. There's nothing to do here
   // except silently swallow this.
@@ -535,13 +943,36 @@ void Client::sendData(envoy_stream_t stream, envoy_data data, bool end_stream) {
   // from the caller.
   // https://github.com/envoyproxy/envoy-mobile/issues/301
   if (direct_stream) {
-    ScopeTrackerScopeState scope(direct_stream.get(), scopeTracker());
+    ScopeTrackerScopeState scope(direct_stream, scopeTracker());
     // The buffer is moved internally, in a synchronous fashion, so we don't need the lifetime
     // of the InstancePtr to outlive this function call.
     Buffer::InstancePtr buf = Data::Utility::toInternalData(data);
 
     ENVOY_LOG(debug, "[S{}] request data for stream (length={} end_stream={})\n", stream,
               data.length, end_stream);
+    if (direct_stream->file_upload_) {
+      FileUpload& last = direct_stream->file_upload_->last();
+      last.data_after_.move(*buf);
+      last.data_after_end_stream_ = end_stream;
+      return;
+    }
+    if (direct_stream->held_request_) {
+      direct_stream->held_request_->data_.move(*buf);
+      direct_stream->held_request_->data_end_stream_ = end_stream;
+      // Send window is only made available once the stream is released.
+      direct_stream->wants_write_notification_ =
+          direct_stream->explicit_flow_control_ && !end_stream;
+      // Outside explicit flow control nothing stops the platform sending more, so rather than
+      // buffer the whole request body, a stream whose held data exceeds its buffer limit is
+      // released early, and its body is then subject to upstream flow control as usual.
+      if (direct_stream->buffer_limit_ != 0 &&
+          direct_stream->held_request_->data_.length() > direct_stream->buffer_limit_) {
+        ENVOY_LOG(debug, "[S{}] releasing held stream with {} bytes of request data", stream,
+                  direct_stream->held_request_->data_.length());
+        releaseHeldStream(*direct_stream);
+      }
+      return;
+    }
     direct_stream->request_decoder_->decodeData(*buf, end_stream);
 
     if (direct_stream->explicit_flow_control_ && !end_stream) {
@@ -550,11 +981,7 @@ void Client::sendData(envoy_stream_t stream, envoy_data data, bool end_stream) {
         // that send window is available, on the next dispatcher iteration so
         // that repeated writes do not starve reads.
         direct_stream->wants_write_notification_ = false;
-        // A new callback must be scheduled each time to capture any changes to the
-        // DirectStream's callbacks from call to call.
-        scheduled_callback_ = dispatcher_.createSchedulableCallback(
-            [direct_stream] { direct_stream->callbacks_->onSendWindowAvailable(); });
-        scheduled_callback_->scheduleCallbackNextIteration();
+        direct_stream->scheduleSendWindowNotification();
       } else {
         // Otherwise, make sure the stack will send a notification when the
         // buffers are drained.
@@ -564,12 +991,110 @@ void Client::sendData(envoy_stream_t stream, envoy_data data, bool end_stream) {
   }
 }
 
+void Client::sendFile(envoy_stream_t stream, int fd, uint64_t offset, uint64_t length,
+                      bool end_stream) {
+  ASSERT(dispatcher_.isThreadSafe());
+  auto reader = std::make_unique<Buffer::FileReader>(fd, offset, length);
+  DirectStream* direct_stream = getStream(stream, GetStreamFilters::ALLOW_ONLY_FOR_OPEN_STREAMS);
+  // As with sendData, there's nothing to do for streams which have already closed.
+  if (direct_stream == nullptr) {
+    return;
+  }
+  ScopeTrackerScopeState scope(direct_stream, scopeTracker());
+  ENVOY_LOG(debug, "[S{}] request file for stream (offset={} length={} end_stream={})", stream,
+            offset, length, end_stream);
+  auto file_upload = std::make_unique<FileUpload>();
+  file_upload->reader_ = std::move(reader);
+  file_upload->end_stream_ = end_stream;
+  if (direct_stream->file_upload_) {
+    // Files are sent one at a time, in the order they're sent in.
+    ENVOY_LOG(debug, "[S{}] queueing request file behind another being sent", stream);
+    direct_stream->file_upload_->last().next_ = std::move(file_upload);
+    return;
+  }
+
+  direct_stream->file_upload_ = std::move(file_upload);
+  // The platform is told it may send more once the file has been sent.
+  direct_stream->wants_write_notification_ = false;
+  sendFileChunk(*direct_stream);
+}
+
+void Client::sendFileChunk(DirectStream& direct_stream) {
+  // Held streams send their file once released, and streams whose upstream buffers are full once
+  // they drain.
+  if (direct_stream.file_upload_ == nullptr || direct_stream.held_request_ != nullptr ||
+      direct_stream.read_disable_count_ > 0) {
+    return;
+  }
+  const envoy_stream_t stream = direct_stream.stream_handle_;
+  ScopeTrackerScopeState scope(&direct_stream, scopeTracker());
+
+  // Chunks are no larger than the stream's buffer limit, so that no more than a chunk is
+  // buffered past the high watermark before the stream is read disabled.
+  const uint32_t max_chunk_bytes =
+      direct_stream.buffer_limit_ != 0 ? direct_stream.buffer_limit_ : UnlimitedFileChunkBytes;
+  Buffer::OwnedImpl chunk;
+  if (!direct_stream.file_upload_->reader_->read(chunk, max_chunk_bytes)) {
+    ENVOY_LOG(debug, "[S{}] failed to read request file", stream);
+    direct_stream.file_upload_.reset();
+    direct_stream.setResponseDetails(FileUploadFailedDetails);
+    direct_stream.resetStream(StreamResetReason::LocalReset);
+    return;
+  }
+
+  if (direct_stream.file_upload_->reader_->remaining() > 0) {
+    direct_stream.request_decoder_->decodeData(chunk, false);
+    // Decoding may end the stream, e.g. with a local reply, or fill its upstream buffers, in
+    // which case readDisable resumes the file once they drain.
+    if (getStream(stream, GetStreamFilters::ALLOW_ONLY_FOR_OPEN_STREAMS) != nullptr &&
+        direct_stream.read_disable_count_ == 0) {
+      direct_stream.scheduleFileUpload();
+    }
+    return;
+  }
+
+  ENVOY_LOG(debug, "[S{}] request file sent", stream);
+  std::unique_ptr<FileUpload> file_upload = std::move(direct_stream.file_upload_);
+  bool end_stream = file_upload->end_stream_;
+  if (chunk.length() > 0 || end_stream) {
+    direct_stream.request_decoder_->decodeData(chunk, end_stream);
+  }
+  // As when replaying held requests, the stream is looked up again before each operation.
+  if ((file_upload->data_after_.length() > 0 || file_upload->data_after_end_stream_) &&
+      getStream(stream, GetStreamFilters::ALLOW_ONLY_FOR_OPEN_STREAMS) != nullptr) {
+    end_stream = file_upload->data_after_end_stream_;
+    direct_stream.request_decoder_->decodeData(file_upload->data_after_, end_stream);
+  }
+  if (file_upload->next_ != nullptr) {
+    // The next file follows, once upstream buffers allow.
+    if (getStream(stream, GetStreamFilters::ALLOW_ONLY_FOR_OPEN_STREAMS) != nullptr) {
+      direct_stream.file_upload_ = std::move(file_upload->next_);
+      if (direct_stream.read_disable_count_ == 0) {
+        direct_stream.scheduleFileUpload();
+      }
+    }
+    return;
+  }
+  if (file_upload->trailers_after_ &&
+      getStream(stream, GetStreamFilters::ALLOW_ONLY_FOR_OPEN_STREAMS) != nullptr) {
+    end_stream = true;
+    direct_stream.request_decoder_->decodeTrailers(std::move(file_upload->trailers_after_));
+  }
+  if (direct_stream.explicit_flow_control_ && !end_stream &&
+      getStream(stream, GetStreamFilters::ALLOW_ONLY_FOR_OPEN_STREAMS) != nullptr) {
+    if (direct_stream.read_disable_count_ == 0) {
+      direct_stream.scheduleSendWindowNotification();
+    } else {
+      direct_stream.wants_write_notification_ = true;
+    }
+  }
+}
+
 void Client::sendMetadata(envoy_stream_t, envoy_headers) { PANIC("not implemented"); }
 
 void Client::sendTrailers(envoy_stream_t stream, envoy_headers trailers) {
   ASSERT(dispatcher_.isThreadSafe());
-  Client::DirectStreamSharedPtr direct_stream =
-      getStream(stream, GetStreamFilters::ALLOW_ONLY_FOR_OPEN_STREAMS);
+  DirectStream* direct_stream = getStream(stream, GetStreamFilters::ALLOW_ONLY_FOR_OPEN_STREAMS);
   // If direct_stream is not found, it means the stream has already closed or been reset
   // and the appropriate callback has been issued to the caller. There's nothing to do here
   // except silently swallow this.
@@ -578,9 +1103,17 @@ void Client::sendTrailers(envoy_stream_t stream, envoy_headers trailers) {
   // from the caller.
   // https://github.com/envoyproxy/envoy-mobile/issues/301
   if (direct_stream) {
-    ScopeTrackerScopeState scope(direct_stream.get(), scopeTracker());
+    ScopeTrackerScopeState scope(direct_stream, scopeTracker());
     RequestTrailerMapPtr internal_trailers = Utility::toRequestTrailers(trailers);
     ENVOY_LOG(debug, "[S{}] request trailers for stream:\n{}", stream, *internal_trailers);
+    if (direct_stream->file_upload_) {
+      direct_stream->file_upload_->last().trailers_after_ = std::move(internal_trailers);
+      return;
+    }
+    if (direct_stream->held_request_) {
+      direct_stream->held_request_->trailers_ = std::move(internal_trailers);
+      return;
+    }
     direct_stream->request_decoder_->decodeTrailers(std::move(internal_trailers));
   }
 }
@@ -590,16 +1123,30 @@ void Client::cancelStream(envoy_stream_t stream) {
   // This is the one place where downstream->upstream communication is allowed
   // for closed streams: if the client cancels the stream it should be canceled
   // whether it was closed or not.
-  Client::DirectStreamSharedPtr direct_stream =
-      getStream(stream, GetStreamFilters::ALLOW_FOR_ALL_STREAMS);
-  scheduled_callback_ = nullptr;
-  if (direct_stream) {
+  DirectStream* direct_stream = getStream(stream, GetStreamFilters::ALLOW_FOR_ALL_STREAMS);
+  // A detached stream has already been cancelled.
+  if (direct_stream && !direct_stream->callbacks_->detached()) {
     // Attempt to latch the latest stream info. This will be a no-op if the stream
     // is already complete.
     direct_stream->saveFinalStreamIntel();
     bool stream_was_open =
         getStream(stream, GetStreamFilters::ALLOW_ONLY_FOR_OPEN_STREAMS) != nullptr;
-    ScopeTrackerScopeState scope(direct_stream.get(), scopeTracker());
+    ScopeTrackerScopeState scope(direct_stream, scopeTracker());
+
+    // A stream whose response is shared with other streams is detached rather than reset, so that
+    // the request runs on for them. It's removed once it ends, or once the filter sharing its
+    // response resets it.
+    StreamInfo::SharedResponse* shared_response =
+        stream_was_open ? sharedResponse(*direct_stream) : nullptr;
+    if (shared_response != nullptr && shared_response->shared()) {
+      ENVOY_LOG(debug, "[S{}] application cancelled stream whose response is shared", stream);
+      direct_stream->callbacks_->onCancel();
+      direct_stream->callbacks_->detach();
+      resolvePriority(*direct_stream);
+      shared_response->onDetached();
+      return;
+    }
+
     removeStream(direct_stream->stream_handle_);
 
     ENVOY_LOG(debug, "[S{}] application cancelled stream", stream);
@@ -622,21 +1169,132 @@ void Client::cancelStream(envoy_stream_t stream) {
   }
 }
 
+void Client::runCommand(StreamCommand& command) {
+  switch (command.type_) {
+  case StreamCommandType::Start:
+    startStream(command.stream_, command.start_.callbacks_, command.start_.options_);
+    return;
+  case StreamCommandType::SendHeaders:
+    sendHeaders(command.stream_, command.headers_, command.flag_);
+    return;
+  case StreamCommandType::ReadData:
+    readData(command.stream_, command.bytes_to_read_);
+    return;
+  case StreamCommandType::SendData:
+    sendData(command.stream_, command.data_, command.flag_);
+    return;
+  case StreamCommandType::SendFile:
+    sendFile(command.stream_, command.file_.fd_, command.file_.offset_, command.file_.length_,
+             command.flag_);
+    return;
+  case StreamCommandType::SendTrailers:
+    sendTrailers(command.stream_, command.headers_);
+    return;
+  case StreamCommandType::Cancel:
+    cancelStream(command.stream_);
+    return;
+  }
+}
+
 const HttpClientStats& Client::stats() const { return stats_; }
 
-Client::DirectStreamSharedPtr Client::getStream(envoy_stream_t stream,
-                                                GetStreamFilters get_stream_filters) {
-  auto direct_stream_pair_it = streams_.find(stream);
-  if (direct_stream_pair_it != streams_.end()) {
-    return direct_stream_pair_it->second;
+void Client::trimMemory() { stream_pool_->trim(); }
+
+void Client::resolvePriority(DirectStream& direct_stream) {
+  if (!direct_stream.priority_pending_) {
+    return;
   }
-  if (direct_stream_pair_it == streams_.end() && get_stream_filters == ALLOW_FOR_ALL_STREAMS) {
-    direct_stream_pair_it = closed_streams_.find(stream);
-    if (direct_stream_pair_it != closed_streams_.end()) {
-      return direct_stream_pair_it->second;
+  direct_stream.priority_pending_ = false;
+  if (!priority_scheduler_.onHighPriorityResolved()) {
+    return;
+  }
+  // Release held streams on the next iteration, rather than from within another stream's
+  // callbacks.
+  if (release_held_streams_ == nullptr) {
+    release_held_streams_ = dispatcher_.createSchedulableCallback([this] { releaseHeldStreams(); });
+  }
+  if (!release_held_streams_->enabled()) {
+    release_held_streams_->scheduleCallbackNextIteration();
+  }
+}
+
+void Client::releaseHeldStreams() {
+  for (envoy_stream_t stream : priority_scheduler_.release()) {
+    DirectStream* direct_stream = getStream(stream, GetStreamFilters::ALLOW_ONLY_FOR_OPEN_STREAMS);
+    // Streams cancelled while held, or released early, have nothing left to send.
+    if (direct_stream != nullptr && direct_stream->held_request_ != nullptr) {
+      releaseHeldStream(*direct_stream);
     }
   }
-  return nullptr;
+}
+
+void Client::releaseExpiredHeldStreams() {
+  for (envoy_stream_t stream : priority_scheduler_.releaseExpired(timeSource().monotonicTime())) {
+    DirectStream* direct_stream = getStream(stream, GetStreamFilters::ALLOW_ONLY_FOR_OPEN_STREAMS);
+    if (direct_stream != nullptr && direct_stream->held_request_ != nullptr) {
+      ENVOY_LOG(debug, "[S{}] low priority stream reached the maximum hold time", stream);
+      releaseHeldStream(*direct_stream);
+    }
+  }
+  armHoldTimer();
+}
+
+void Client::armHoldTimer() {
+  absl::optional<MonotonicTime> next_expiry = priority_scheduler_.nextExpiry();
+  if (!next_expiry.has_value()) {
+    return;
+  }
+  if (hold_timer_ == nullptr) {
+    hold_timer_ = dispatcher_.createTimer([this] { releaseExpiredHeldStreams(); });
+  }
+  if (!hold_timer_->enabled()) {
+    hold_timer_->enableTimer(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::max(next_expiry.value() - timeSource().monotonicTime(), MonotonicTime::duration{})));
+  }
+}
+
+void Client::releaseHeldStream(DirectStream& direct_stream) {
+  const envoy_stream_t stream = direct_stream.stream_handle_;
+  std::unique_ptr<HeldRequest> held_request = std::move(direct_stream.held_request_);
+  direct_stream.request_decoder_ =
+      &api_listener_.newStream(*direct_stream.callbacks_, true /* is_internally_created */);
+  direct_stream.envoy_final_stream_intel_.queueing_delay_ms =
+      std::chrono::duration_cast<std::chrono::milliseconds>(timeSource().monotonicTime() -
+                                                            held_request->held_at_)
+          .count();
+  ENVOY_LOG(debug, "[S{}] releasing low priority stream after {}ms", stream,
+            direct_stream.envoy_final_stream_intel_.queueing_delay_ms);
+
+  // Each replayed operation may end the stream, e.g. with a local reply, so the stream is looked
+  // up again before the next.
+  ScopeTrackerScopeState scope(&direct_stream, scopeTracker());
+  if (held_request->headers_) {
+    direct_stream.request_decoder_->decodeHeaders(std::move(held_request->headers_),
+                                                  held_request->headers_end_stream_);
+  }
+  if ((held_request->data_.length() > 0 || held_request->data_end_stream_) &&
+      getStream(stream, GetStreamFilters::ALLOW_ONLY_FOR_OPEN_STREAMS) != nullptr) {
+    direct_stream.request_decoder_->decodeData(held_request->data_,
+                                               held_request->data_end_stream_);
+  }
+  if (held_request->trailers_ &&
+      getStream(stream, GetStreamFilters::ALLOW_ONLY_FOR_OPEN_STREAMS) != nullptr) {
+    direct_stream.request_decoder_->decodeTrailers(std::move(held_request->trailers_));
+  }
+  if (direct_stream.wants_write_notification_ && direct_stream.read_disable_count_ == 0 &&
+      getStream(stream, GetStreamFilters::ALLOW_ONLY_FOR_OPEN_STREAMS) != nullptr) {
+    direct_stream.wants_write_notification_ = false;
+    direct_stream.scheduleSendWindowNotification();
+  }
+  // A file sent while the stream was held follows the data sent before it.
+  if (getStream(stream, GetStreamFilters::ALLOW_ONLY_FOR_OPEN_STREAMS) != nullptr) {
+    sendFileChunk(direct_stream);
+  }
+}
+
+Client::DirectStream* Client::getStream(envoy_stream_t stream,
+                                        GetStreamFilters get_stream_filters) {
+  return streams_.find(stream, get_stream_filters == ALLOW_FOR_ALL_STREAMS);
 }
 
 void Client::removeStream(envoy_stream_t stream_handle) {
@@ -644,50 +1302,82 @@ void Client::removeStream(envoy_stream_t stream_handle) {
       dispatcher_.isThreadSafe(),
       fmt::format("[S{}] stream removeStream must be performed on the dispatcher_'s thread.",
                   stream_handle));
-  Client::DirectStreamSharedPtr direct_stream =
-      getStream(stream_handle, GetStreamFilters::ALLOW_FOR_ALL_STREAMS);
+  // The entry in the table should not exist after removeStream. Hence why it is synchronously
+  // erased from the streams table.
+  DirectStreamPtr direct_stream{streams_.erase(stream_handle)};
   RELEASE_ASSERT(
       direct_stream,
       fmt::format(
           "[S{}] removeStream is a private method that is only called with stream ids that exist",
           stream_handle));
+  // No more response data is buffered for a removed stream.
+  direct_stream->callbacks_->releaseBufferBudget();
+  resolvePriority(*direct_stream);
+  // Nor should the platform be told it may send more data on it, or the file it was sending read.
+  if (direct_stream->send_window_notifier_) {
+    direct_stream->send_window_notifier_->cancel();
+  }
+  if (direct_stream->file_upload_notifier_) {
+    direct_stream->file_upload_notifier_->cancel();
+  }
+  direct_stream->file_upload_.reset();
+  direct_stream->callbacks_->stopWritingResponseBody();
 
   // The DirectStream should live through synchronous code that already has a reference to it.
-  // Hence why it is scheduled for deferred deletion. If this was all that was needed then it
-  // would be sufficient to return a shared_ptr in getStream. However, deferred deletion is still
-  // required because in Client::resetStream the DirectStream needs to live for as long and
-  // the HCM's ActiveStream lives. Hence its deletion needs to live beyond the synchronous code in
-  // Client::resetStream.
-  auto direct_stream_wrapper = std::make_unique<DirectStreamWrapper>(std::move(direct_stream));
-  dispatcher_.deferredDelete(std::move(direct_stream_wrapper));
-  // However, the entry in the map should not exist after removeStream.
-  // Hence why it is synchronously erased from the streams map.
-  size_t erased = streams_.erase(stream_handle);
-  if (erased != 1) {
-    erased = closed_streams_.erase(stream_handle);
-  }
-  ASSERT(erased == 1, "removeStream should always remove one entry from the streams map");
+  // Hence why it is scheduled for deferred deletion. Deferred deletion is also required because in
+  // Client::resetStream the DirectStream needs to live for as long as the HCM's ActiveStream
+  // lives. Hence its deletion needs to live beyond the synchronous code in Client::resetStream.
+  dispatcher_.deferredDelete(std::move(direct_stream));
   ENVOY_LOG(debug, "[S{}] erased stream from streams container", stream_handle);
 }
 
+StreamInfo::SharedResponse* Client::sharedResponse(DirectStream& direct_stream) {
+  if (direct_stream.request_decoder_ == nullptr) {
+    return nullptr;
+  }
+  const StreamInfo::FilterStateSharedPtr& filter_state =
+      direct_stream.request_decoder_->streamInfo().filterState();
+  if (!filter_state->hasData<StreamInfo::SharedResponse>(StreamInfo::SharedResponse::key())) {
+    return nullptr;
+  }
+  return filter_state->getDataMutable<StreamInfo::SharedResponse>(
+      StreamInfo::SharedResponse::key());
+}
+
 namespace {
 
 const LowerCaseString ClusterHeader{"x-envoy-mobile-cluster"};
+// RFC 9218 extensible priorities, understood by both HTTP/2 and HTTP/3 servers.
+const LowerCaseString PriorityHeader{"priority"};
 const LowerCaseString ProtocolHeader{"x-envoy-mobile-upstream-protocol"};
 
-const char* BaseCluster = "base";
-const char* H2Cluster = "base_h2";
-const char* H3Cluster = "base_h3";
-const char* ClearTextCluster = "base_clear";
+// Cluster names are added to request headers by reference, so they must have static storage.
+constexpr absl::string_view BaseCluster = "base";
+constexpr absl::string_view H2Cluster = "base_h2";
+constexpr absl::string_view H3Cluster = "base_h3";
+constexpr absl::string_view ClearTextCluster = "base_clear";
+
+constexpr absl::string_view HighUrgency = "u=1";
+constexpr absl::string_view LowUrgency = "u=6";
 
 } // namespace
 
+void Client::setPriority(RequestHeaderMap& headers, envoy_stream_priority_t priority) {
+  // Requests which set their own priority are left as they are. Normal priority requests use the
+  // default urgency, u=3, and so carry no header.
+  if (priority == ENVOY_STREAM_PRIORITY_NORMAL || !headers.get(PriorityHeader).empty()) {
+    return;
+  }
+  headers.addReference(PriorityHeader, priority == ENVOY_STREAM_PRIORITY_HIGH ? HighUrgency
+                                                                               : LowUrgency);
+}
+
 void Client::setDestinationCluster(Http::RequestHeaderMap& headers) {
   // Determine upstream cluster:
   // - Use TLS with ALPN by default.
   // - Use http/2 or ALPN if requested explicitly via x-envoy-mobile-upstream-protocol.
   // - Force http/1.1 if request scheme is http (cleartext).
-  const char* cluster{};
+  absl::string_view cluster;
   auto protocol_header = headers.get(ProtocolHeader);
   if (headers.getSchemeValue() == Headers::get().SchemeValues.Http) {
     cluster = ClearTextCluster;
@@ -714,7 +1404,7 @@ void Client::setDestinationCluster(Http::RequestHeaderMap& headers) {
     headers.remove(ProtocolHeader);
   }
 
-  headers.addCopy(ClusterHeader, std::string{cluster});
+  headers.addReference(ClusterHeader, cluster);
 }
 
 } // namespace Http
@@ -10,16 +10,25 @@
 #include "envoy/stats/histogram.h"
 #include "envoy/stats/stats_macros.h"
 
+#include "source/common/buffer/buffer_impl.h"
 #include "source/common/buffer/watermark_buffer.h"
 #include "source/common/common/logger.h"
 #include "source/common/http/codec_helper.h"
 #include "source/common/network/socket_impl.h"
-#include "source/common/stats/timespan_impl.h"
 
-#include "absl/container/flat_hash_map.h"
 #include "absl/types/optional.h"
+#include "library/common/buffer/file_reader.h"
+#include "library/common/buffer/file_writer.h"
+#include "library/common/common/slab_pool.h"
 #include "library/common/event/provisional_dispatcher.h"
+#include "library/common/http/callback_latency.h"
+#include "library/common/http/read_window.h"
+#include "library/common/http/stream_buffer_budget.h"
+#include "library/common/http/stream_command_queue.h"
+#include "library/common/http/stream_priority_scheduler.h"
+#include "library/common/http/stream_slot_table.h"
 #include "library/common/network/synthetic_address_impl.h"
+#include "library/common/stream_info/shared_response.h"
 #include "library/common/types/c_types.h"
 
 namespace Envoy {
@@ -37,7 +46,8 @@ namespace Http {
   HISTOGRAM(on_trailers_callback_latency, Milliseconds)                                            \
   HISTOGRAM(on_complete_callback_latency, Milliseconds)                                            \
   HISTOGRAM(on_cancel_callback_latency, Milliseconds)                                              \
-  HISTOGRAM(on_error_callback_latency, Milliseconds)
+  HISTOGRAM(on_error_callback_latency, Milliseconds)                                               \
+  HISTOGRAM(on_response_body_progress_callback_latency, Milliseconds)
 
 /**
  * Struct definition for client stats. @see stats_macros.h
@@ -51,14 +61,32 @@ struct HttpClientStats {
  */
 class Client : public Logger::Loggable<Logger::Id::http> {
 public:
+  /**
+   * @param buffer_budget, the default per-stream buffer limit and the memory budget for response
+   *        data buffered across streams in explicit flow control mode.
+   * @param callback_latency_sampler, selects the platform callbacks whose latency is recorded in
+   *        the on_*_callback_latency histograms. Each histogram samples its own callbacks.
+   */
   Client(ApiListener& api_listener, Event::ProvisionalDispatcher& dispatcher, Stats::Scope& scope,
-         Random::RandomGenerator& random)
+         Random::RandomGenerator& random, StreamBufferBudget buffer_budget = StreamBufferBudget(),
+         CallbackLatencySampler callback_latency_sampler = CallbackLatencySampler())
       : api_listener_(api_listener), dispatcher_(dispatcher),
         stats_(
             HttpClientStats{ALL_HTTP_CLIENT_STATS(POOL_COUNTER_PREFIX(scope, "http.client."),
                                                   POOL_HISTOGRAM_PREFIX(scope, "http.client."))}),
+        on_headers_latency_{stats_.on_headers_callback_latency_, callback_latency_sampler},
+        on_data_latency_{stats_.on_data_callback_latency_, callback_latency_sampler},
+        on_trailers_latency_{stats_.on_trailers_callback_latency_, callback_latency_sampler},
+        on_complete_latency_{stats_.on_complete_callback_latency_, callback_latency_sampler},
+        on_cancel_latency_{stats_.on_cancel_callback_latency_, callback_latency_sampler},
+        on_error_latency_{stats_.on_error_callback_latency_, callback_latency_sampler},
+        on_response_body_progress_latency_{stats_.on_response_body_progress_callback_latency_,
+                                           callback_latency_sampler},
+        buffer_budget_(buffer_budget),
+        stream_pool_(SlabPool::create(sizeof(DirectStream), StreamsPerSlab)),
         address_provider_(std::make_shared<Network::Address::SyntheticAddressImpl>(), nullptr),
         random_(random) {}
+  ~Client();
 
   /**
    * Attempts to open a new stream to the remote. Note that this function is asynchronous and
@@ -71,6 +99,15 @@ public:
   void startStream(envoy_stream_t stream, envoy_http_callbacks bridge_callbacks,
                    bool explicit_flow_control);
 
+  /**
+   * Attempts to open a new stream to the remote, with the given options.
+   * @param stream, the stream to start.
+   * @param bridge_callbacks, wrapper for callbacks for events on this stream.
+   * @param options, the options for the stream.
+   */
+  void startStream(envoy_stream_t stream, envoy_http_callbacks bridge_callbacks,
+                   const envoy_stream_options& options);
+
   /**
    * Send headers over an open HTTP stream. This method can be invoked once and needs to be called
    * before send_data.
@@ -95,6 +132,18 @@ public:
    */
   void sendData(envoy_stream_t stream, envoy_data data, bool end_stream);
 
+  /**
+   * Send a range of a file over an open HTTP stream, as request data. The file is read a buffer's
+   * worth at a time, only while the stream's upstream buffers have room, so that large files are
+   * never resident at once. Data and trailers sent before the file has been sent are sent after it.
+   * @param stream, the stream to send the file over.
+   * @param fd, the file to send, which the client takes ownership of and closes.
+   * @param offset, the position in the file to start sending from.
+   * @param length, the bytes to send.
+   * @param end_stream, indicates whether to close the stream locally after sending the file.
+   */
+  void sendFile(envoy_stream_t stream, int fd, uint64_t offset, uint64_t length, bool end_stream);
+
   /**
    * Send metadata over an HTTP stream. This method can be invoked multiple times.
    * @param stream, the stream to send metadata over.
@@ -117,6 +166,19 @@ public:
    */
   void cancelStream(envoy_stream_t stream);
 
+  /**
+   * Run a stream operation dequeued from a StreamCommandQueue. Takes ownership of the command's
+   * payload, exactly as the equivalent direct call would.
+   * @param command, the operation to run.
+   */
+  void runCommand(StreamCommand& command);
+
+  /**
+   * Frees the memory held for streams which have since completed, e.g. while the engine is
+   * suspended. Active streams are unaffected.
+   */
+  void trimMemory();
+
   const HttpClientStats& stats() const;
   Event::ScopeTracker& scopeTracker() const { return dispatcher_; }
 
@@ -130,6 +192,63 @@ public:
 private:
   class DirectStream;
   friend class ClientTest;
+
+  /**
+   * The request of a stream held back by the priority scheduler. The stream is only started in the
+   * connection manager once it's released, so that its stream idle timeout doesn't run while it's
+   * held. Request operations are recorded as they are made, and replayed in order when the stream
+   * is released. A stream is released early if its request data exceeds its buffer limit, so that
+   * data_ stays bounded.
+   */
+  struct HeldRequest {
+    MonotonicTime held_at_;
+    RequestHeaderMapPtr headers_;
+    bool headers_end_stream_{};
+    Buffer::OwnedImpl data_;
+    bool data_end_stream_{};
+    RequestTrailerMapPtr trailers_;
+  };
+
+  /**
+   * A file being sent as request data, and the request operations made while it is, which are
+   * sent after it. A file sent while another is being sent is queued after the data sent after
+   * that one.
+   */
+  struct FileUpload {
+    // The last of the files queued from this one, which later operations are sent after.
+    FileUpload& last() {
+      FileUpload* upload = this;
+      while (upload->next_ != nullptr) {
+        upload = upload->next_.get();
+      }
+      return *upload;
+    }
+
+    Buffer::FileReaderPtr reader_;
+    bool end_stream_{};
+    Buffer::OwnedImpl data_after_;
+    bool data_after_end_stream_{};
+    std::unique_ptr<FileUpload> next_;
+    RequestTrailerMapPtr trailers_after_;
+  };
+
+  /**
+   * A response body being written to a file rather than delivered to the bridge.
+   */
+  struct ResponseBodyFile {
+    Buffer::FileWriterPtr writer_;
+    // The bytes written, and the bytes passed to the writer which are not yet written.
+    uint64_t written_{};
+    uint64_t unwritten_{};
+    // Set true while upstream is read disabled because the writes have fallen behind.
+    bool writes_behind_{};
+    // The bytes written when progress was last reported, and when it was.
+    uint64_t reported_{};
+    MonotonicTime reported_at_;
+    // Trailers received before the body has been written, delivered once it is.
+    ResponseTrailerMapPtr trailers_;
+  };
+
   /**
    * Notifies caller of async HTTP stream status.
    * Note the HTTP stream is full-duplex, even if the local to remote stream has been ended
@@ -137,16 +256,24 @@ private:
    * DirectStreamCallbacks can continue to receive events until the remote to local stream is
    * closed, or resetStream is called.
    */
-  class DirectStreamCallbacks : public ResponseEncoder, public Logger::Loggable<Logger::Id::http> {
+  class DirectStreamCallbacks : public ResponseEncoder,
+                                public Buffer::FileWriterCallbacks,
+                                public Logger::Loggable<Logger::Id::http> {
   public:
     DirectStreamCallbacks(DirectStream& direct_stream, envoy_http_callbacks bridge_callbacks,
                           Client& http_client);
+    ~DirectStreamCallbacks() override;
 
     void closeStream();
     void onComplete();
     void onCancel();
     void onError();
     void onSendWindowAvailable();
+    // Stops delivering callbacks to the platform, which has cancelled the stream, while the stream
+    // runs on for others sharing its response. Data it would have held for the platform is
+    // dropped, so that upstream is never paused on its behalf.
+    void detach();
+    bool detached() const { return detached_; }
 
     // Remove the stream and clear up state if possible, else set up deferred
     // removal path.
@@ -169,6 +296,10 @@ private:
     void onHasBufferedData();
     void onBufferedDataDrained();
 
+    // Buffer::FileWriterCallbacks
+    void onWritten(uint64_t bytes) override;
+    void onWriteError(int error) override;
+
     // To be called by mobile library when in explicit flow control mode and more data is wanted.
     // If bytes are available, the bytes available (up to the limit of
     // bytes_to_send) will be shipped the bridge immediately.
@@ -177,16 +308,40 @@ private:
     // network, up to bytes_to_send bytes will be shipped to the bridge.
     //
     // Bytes will only be sent up once, even if the bytes available are fewer
-    // than bytes_to_send.
+    // than bytes_to_send. With an auto-tuned read window, bytes_to_send instead
+    // tops up the window's credit, and data is shipped until the credit is used.
     void resumeData(int32_t bytes_to_send);
 
     void setFinalStreamIntel(StreamInfo::StreamInfo& stream_info);
 
+    // Returns the bytes buffered for the stream to the Client's buffer budget. Called when the
+    // stream is removed, after which no more data is buffered for it.
+    void releaseBufferBudget();
+
+    // Stops writing the response body to file, if it is. Called when the stream is removed.
+    void stopWritingResponseBody() { response_body_file_.reset(); }
+
   private:
+    // Records the bytes currently buffered in response_data_ against the Client's buffer budget,
+    // and resizes the buffer's watermark to the stream's share of what remains of the budget.
+    void updateBufferBudget();
+
     bool hasBufferedData() { return response_data_.get() && response_data_->length() != 0; }
 
     void sendDataToBridge(Buffer::Instance& data, bool end_stream);
     void sendTrailersToBridge(const ResponseTrailerMap& trailers);
+    // Passes response data to response_body_file_'s writer, read disabling upstream if the writes
+    // have fallen too far behind.
+    void writeResponseBody(Buffer::Instance& data);
+    // Reports the progress of the writes via on_response_body_progress, if due.
+    void reportResponseBodyProgress();
+    // Completes the stream once the whole response body has been written.
+    void maybeFinishResponseBody();
+    // Delivers the aggregated response in a single on_aggregated_response callback.
+    void sendAggregatedResponseToBridge();
+    // Falls back to streaming once the body exceeds the aggregate limit: delivers the aggregated
+    // headers and body via on_headers and on_data.
+    void stopAggregating();
     envoy_stream_intel streamIntel();
     envoy_final_stream_intel& finalStreamIntel();
     envoy_error streamError();
@@ -196,6 +351,8 @@ private:
     Client& http_client_;
     absl::optional<envoy_error> error_;
     bool success_{};
+    // Set true once the stream has been detached from the platform.
+    bool detached_{};
 
     // Buffered response data when in explicit flow control mode.
     Buffer::InstancePtr response_data_;
@@ -211,21 +368,54 @@ private:
     // Set true when the end stream has been forwarded to the bridge.
     bool remote_end_stream_forwarded_{};
     uint32_t bytes_to_send_{};
+    // The bytes of response_data_ recorded against the Client's buffer budget.
+    uint64_t budgeted_bytes_{};
+    // The high watermark currently set on response_data_.
+    uint32_t response_watermark_{};
+    // Set true once the budgeted bytes have been returned, when the stream is removed.
+    bool buffer_budget_released_{};
+    // Present if the stream auto-tunes its read window. bytes_to_send_ then holds the remaining
+    // credit, rather than the size of the next callback.
+    absl::optional<ReadWindow> read_window_;
+    // True while the response is being aggregated, to be delivered whole in one
+    // on_aggregated_response callback.
+    bool aggregating_{};
+    // The aggregated response, held until the response completes or the aggregate limit is
+    // exceeded. Headers and trailers are converted as they arrive, so that they are not copied.
+    absl::optional<envoy_headers> aggregated_headers_;
+    absl::optional<envoy_headers> aggregated_trailers_;
+    std::string aggregated_body_;
+    // Present if the response body is written to a file.
+    std::unique_ptr<ResponseBodyFile> response_body_file_;
+    // Set true if writing the response body failed, which fails the stream.
+    bool response_body_write_failed_{};
   };
 
-  using DirectStreamCallbacksPtr = std::unique_ptr<DirectStreamCallbacks>;
-
   /**
    * Contains state about an HTTP stream; both in the outgoing direction via an underlying
    * AsyncClient::Stream and in the incoming direction via DirectStreamCallbacks.
+   *
+   * DirectStreams are allocated from the Client's SlabPool, together with their callbacks, and are
+   * destroyed via deferred deletion. The deferred deletion is important due to the necessary
+   * ordering of ActiveStream deletion w.r.t DirectStream deletion; the former needs to be
+   * destroyed first. Using post to defer delete the DirectStream provides no ordering guarantee
+   * per envoy/source/common/event/libevent.h.
    */
   class DirectStream : public Stream,
                        public StreamCallbackHelper,
                        public ScopeTrackedObject,
+                       public Event::DeferredDeletable,
                        public Logger::Loggable<Logger::Id::http> {
   public:
     DirectStream(envoy_stream_t stream_handle, Client& http_client);
-    ~DirectStream();
+    ~DirectStream() override;
+
+    static void* operator new(size_t size, SlabPool& pool) {
+      ASSERT(size == sizeof(DirectStream));
+      return pool.allocate();
+    }
+    static void operator delete(void* stream, SlabPool&) { SlabPool::deallocate(stream); }
+    static void operator delete(void* stream) { SlabPool::deallocate(stream); }
 
     // Stream
     void addCallbacks(StreamCallbacks& callbacks) override { addCallbacksHelper(callbacks); }
@@ -242,10 +432,7 @@ private:
     // It only has an effect in explicit flow control mode, where when all buffers are drained,
     // on_send_window_available callbacks are called.
     void readDisable(bool disable) override;
-    uint32_t bufferLimit() const override {
-      // 1Mb
-      return 1024000;
-    }
+    uint32_t bufferLimit() const override { return buffer_limit_; }
     // Not applicable
     void setAccount(Buffer::BufferMemoryAccountSharedPtr) override {
       // Acounting became default in https://github.com/envoyproxy/envoy/pull/17702 but is a no=op.
@@ -269,12 +456,21 @@ private:
     // Latches latency info from stream info before it goes away.
     void saveFinalStreamIntel();
 
+    // Schedules an on_send_window_available notification for the next dispatcher iteration.
+    // Repeated calls before the notification fires are coalesced into one.
+    void scheduleSendWindowNotification();
+
+    // Schedules sending the next chunk of the file being uploaded for the next dispatcher
+    // iteration, so that large files do not starve the event loop.
+    void scheduleFileUpload();
+
     const envoy_stream_t stream_handle_;
 
     // Used to issue outgoing HTTP stream operations.
     RequestDecoder* request_decoder_;
-    // Used to receive incoming HTTP stream operations.
-    DirectStreamCallbacksPtr callbacks_;
+    // Used to receive incoming HTTP stream operations. Constructed in place to avoid a separate
+    // allocation.
+    absl::optional<DirectStreamCallbacks> callbacks_;
     Client& parent_;
     // Response details used by the connection manager.
     absl::string_view response_details_;
@@ -285,6 +481,9 @@ private:
     // Set true in explicit flow control mode if the library has sent body data and may want to
     // send more when buffer is available.
     bool wants_write_notification_{};
+    // Delivers scheduled on_send_window_available notifications. Created on first use and reused
+    // for the lifetime of the stream.
+    Event::SchedulableCallbackPtr send_window_notifier_;
     // True if the bridge should operate in explicit flow control mode.
     //
     // In this mode only one callback can be sent to the bridge until more is
@@ -294,29 +493,40 @@ private:
     // back, avoids excessive buffering of response bodies if the response body is
     // read faster than the mobile caller can process it.
     bool explicit_flow_control_ = false;
+    // The buffer limit requested when the stream was started, or 0 for the engine default.
+    uint32_t requested_buffer_limit_{};
+    // The buffer limit granted by the Client's buffer budget when the stream was started.
+    uint32_t buffer_limit_{StreamBufferBudget::DefaultStreamLimit};
+    // True if the stream auto-tunes its read window in explicit flow control mode.
+    bool auto_tune_read_window_{};
+    // The largest response body delivered whole via on_aggregated_response, or 0 to stream all
+    // responses.
+    uint32_t aggregate_body_limit_{};
+    envoy_stream_priority_t priority_{ENVOY_STREAM_PRIORITY_NORMAL};
+    // The file the response body is written to, or -1 to deliver it to the bridge.
+    int response_body_fd_{-1};
+    // The thresholds for reporting the progress of the writes. 0 disables a threshold.
+    uint64_t response_body_progress_bytes_{};
+    std::chrono::milliseconds response_body_progress_interval_{};
+    // True while a high priority stream is pending in the Client's priority scheduler.
+    bool priority_pending_{};
+    // Present while the stream is held by the Client's priority scheduler.
+    std::unique_ptr<HeldRequest> held_request_;
+    // Present while a file is being sent as request data.
+    std::unique_ptr<FileUpload> file_upload_;
+    // Sends the chunks of file_upload_. Created on first use.
+    Event::SchedulableCallbackPtr file_upload_notifier_;
     // Latest intel data retrieved from the StreamInfo.
     envoy_stream_intel stream_intel_{-1, -1, 0, 0};
     envoy_final_stream_intel envoy_final_stream_intel_{-1, -1, -1, -1, -1, -1, -1, -1,
-                                                       -1, -1, -1, 0,  0,  0,  0,  -1};
+                                                       -1, -1, -1, 0,  0,  0,  0,  -1, 0};
     StreamInfo::BytesMeterSharedPtr bytes_meter_;
   };
 
-  using DirectStreamSharedPtr = std::shared_ptr<DirectStream>;
+  using DirectStreamPtr = std::unique_ptr<DirectStream>;
 
-  // Used to deferredDelete the ref count of the DirectStream owned by streams_ while still
-  // maintaining a container of DirectStreamSharedPtr. Using deferredDelete is important due to the
-  // necessary ordering of ActiveStream deletion w.r.t DirectStream deletion; the former needs to be
-  // destroyed first. Using post to defer delete the DirectStream provides no ordering guarantee per
-  // envoy/source/common/event/libevent.h Maintaining a container of DirectStreamSharedPtr is
-  // important because Client::resetStream is initiated by a platform thread.
-  struct DirectStreamWrapper : public Event::DeferredDeletable {
-    DirectStreamWrapper(DirectStreamSharedPtr stream) : stream_(stream) {}
-
-  private:
-    const DirectStreamSharedPtr stream_;
-  };
-
-  using DirectStreamWrapperPtr = std::unique_ptr<DirectStreamWrapper>;
+  // The number of DirectStreams allocated at once when the stream pool is exhausted.
+  static constexpr size_t StreamsPerSlab = 32;
 
   enum GetStreamFilters {
     // If a stream has been finished from upstream, but stream completion has
@@ -331,20 +541,67 @@ private:
     // data for the stream).
     ALLOW_FOR_ALL_STREAMS,
   };
-  DirectStreamSharedPtr getStream(envoy_stream_t stream_handle, GetStreamFilters filters);
+  DirectStream* getStream(envoy_stream_t stream_handle, GetStreamFilters filters);
   void removeStream(envoy_stream_t stream_handle);
+  // Returns the shared response a filter has set on the stream, if any.
+  StreamInfo::SharedResponse* sharedResponse(DirectStream& direct_stream);
+  // Called when a pending high priority stream receives its response headers or is removed.
+  // Schedules the release of held streams if no high priority stream remains pending.
+  void resolvePriority(DirectStream& direct_stream);
+  // Sends the requests of the streams held by the priority scheduler upstream.
+  void releaseHeldStreams();
+  // Releases the streams held for the priority scheduler's maximum hold time.
+  void releaseExpiredHeldStreams();
+  // Arms the hold timer for the next held stream to reach the maximum hold time, if any.
+  void armHoldTimer();
+  // Starts the stream in the connection manager, and sends the request recorded while the stream
+  // was held upstream.
+  void releaseHeldStream(DirectStream& direct_stream);
+  // Sends the next chunk of the file being uploaded on the stream, and once the file has been
+  // sent, the request operations made while it was.
+  void sendFileChunk(DirectStream& direct_stream);
+  // A callback latency histogram, and the sampler selecting which of its callbacks are recorded.
+  // Streams invoke their callbacks in a fixed order, so a sampler shared between histograms would
+  // only ever select the same callbacks.
+  struct SampledLatencyHistogram {
+    Stats::Histogram& histogram_;
+    CallbackLatencySampler sampler_;
+  };
+
+  // Records a sampled callback latency, and warns if the callback was slow.
+  void recordCallbackLatency(const CallbackTimer& timer, SampledLatencyHistogram& latency,
+                             absl::string_view slow_callback_event);
   void setDestinationCluster(RequestHeaderMap& headers);
+  // Sets the request's priority header for the stream's priority class.
+  void setPriority(RequestHeaderMap& headers, envoy_stream_priority_t priority);
 
   ApiListener& api_listener_;
   Event::ProvisionalDispatcher& dispatcher_;
-  Event::SchedulableCallbackPtr scheduled_callback_;
   HttpClientStats stats_;
-  // The set of open streams, which can safely have request data sent on them
-  // or response data received.
-  absl::flat_hash_map<envoy_stream_t, DirectStreamSharedPtr> streams_;
-  // The set of closed streams, where end stream has been received from upstream
-  // but not yet communicated to the mobile library.
-  absl::flat_hash_map<envoy_stream_t, DirectStreamSharedPtr> closed_streams_;
+  SampledLatencyHistogram on_headers_latency_;
+  SampledLatencyHistogram on_data_latency_;
+  SampledLatencyHistogram on_trailers_latency_;
+  SampledLatencyHistogram on_complete_latency_;
+  SampledLatencyHistogram on_cancel_latency_;
+  SampledLatencyHistogram on_error_latency_;
+  SampledLatencyHistogram on_response_body_progress_latency_;
+  // Limits the response data buffered by streams in explicit flow control mode.
+  StreamBufferBudget buffer_budget_;
+  // Holds back low priority streams while high priority streams are pending.
+  StreamPriorityScheduler priority_scheduler_;
+  // Releases held streams on the dispatcher iteration after they become eligible.
+  Event::SchedulableCallbackPtr release_held_streams_;
+  // Releases streams held for the maximum hold time, while high priority streams remain pending.
+  Event::TimerPtr hold_timer_;
+  // Writes the response bodies of streams writing them to file, shared by the streams' writers.
+  const Buffer::FileWriterThreadSharedPtr file_writer_thread_{
+      std::make_shared<Buffer::FileWriterThread>()};
+  // Backing storage for DirectStreams.
+  SlabPool::Ptr stream_pool_;
+  // All live streams, owned by the table until removeStream. Open streams can safely have request
+  // data sent on them or response data received. Closed streams have received end stream from
+  // upstream, which has not yet been communicated to the mobile library.
+  StreamSlotTable<DirectStream> streams_;
   // Shared synthetic address providers across DirectStreams.
   Network::ConnectionInfoSetterImpl address_provider_;
   Random::RandomGenerator& random_;
@@ -3,20 +3,51 @@
 #include "source/common/http/header_map_impl.h"
 #include "source/extensions/http/header_formatters/preserve_case/preserve_case_formatter.h"
 
+#include "absl/strings/ascii.h"
+#include "library/common/data/bridge_map_builder.h"
 #include "library/common/data/utility.h"
+#include "library/common/http/well_known_headers.h"
 
 namespace Envoy {
 namespace Http {
 namespace Utility {
 
+namespace {
+
+absl::string_view toStringView(envoy_data data) {
+  return {reinterpret_cast<const char*>(data.bytes), data.length};
+}
+
+bool isLowerCase(absl::string_view key) {
+  for (const char c : key) {
+    if (absl::ascii_isupper(c)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
 void toEnvoyHeaders(HeaderMap& envoy_result_headers, envoy_headers headers) {
   Envoy::Http::StatefulHeaderKeyFormatter& formatter = envoy_result_headers.formatter().value();
   for (envoy_map_size_t i = 0; i < headers.length; i++) {
-    std::string key = Data::Utility::copyToString(headers.entries[i].key);
+    const absl::string_view key = toStringView(headers.entries[i].key);
+    const absl::string_view value = toStringView(headers.entries[i].value);
+    if (isLowerCase(key)) {
+      // Keys the formatter has not seen are emitted as they are, so it only needs to learn the
+      // original case of keys which are not lowercase already.
+      const LowerCaseString* well_known_key = WellKnownHeaders::get().find(key);
+      if (well_known_key != nullptr) {
+        envoy_result_headers.addReferenceKey(*well_known_key, value);
+      } else {
+        envoy_result_headers.addCopy(LowerCaseString(key), value);
+      }
+      continue;
+    }
     // Make sure the formatter knows the original case.
     formatter.processKey(key);
-    envoy_result_headers.addCopy(LowerCaseString(key),
-                                 Data::Utility::copyToString(headers.entries[i].value));
+    envoy_result_headers.addCopy(LowerCaseString(key), value);
   }
   // The C envoy_headers struct can be released now because the headers have been copied.
   release_envoy_headers(headers);
@@ -36,9 +67,8 @@ RequestHeaderMapPtr toRequestHeaders(envoy_headers headers) {
 RequestTrailerMapPtr toRequestTrailers(envoy_headers trailers) {
   RequestTrailerMapPtr transformed_trailers = RequestTrailerMapImpl::create();
   for (envoy_map_size_t i = 0; i < trailers.length; i++) {
-    transformed_trailers->addCopy(
-        LowerCaseString(Data::Utility::copyToString(trailers.entries[i].key)),
-        Data::Utility::copyToString(trailers.entries[i].value));
+    transformed_trailers->addCopy(LowerCaseString(toStringView(trailers.entries[i].key)),
+                                  toStringView(trailers.entries[i].value));
   }
   // The C envoy_headers struct can be released now because the headers have been copied.
   release_envoy_headers(trailers);
@@ -46,35 +76,34 @@ RequestTrailerMapPtr toRequestTrailers(envoy_headers trailers) {
 }
 
 envoy_headers toBridgeHeaders(const HeaderMap& header_map, absl::string_view alpn) {
-  int alpn_entry = alpn.empty() ? 0 : 1;
-  envoy_map_entry* headers = static_cast<envoy_map_entry*>(
-      safe_malloc(sizeof(envoy_map_entry) * (header_map.size() + alpn_entry)));
-  envoy_headers transformed_headers;
-  transformed_headers.length = 0;
-  transformed_headers.entries = headers;
-
-  header_map.iterate(
-      [&transformed_headers, &header_map](const HeaderEntry& header) -> HeaderMap::Iterate {
-        std::string key_val = std::string(header.key().getStringView());
-        if (header_map.formatter().has_value()) {
-          const Envoy::Http::StatefulHeaderKeyFormatter& formatter = header_map.formatter().value();
-          key_val = formatter.format(key_val);
-        }
-        envoy_data key = Data::Utility::copyToBridgeData(key_val);
-        envoy_data value = Data::Utility::copyToBridgeData(header.value().getStringView());
+  static constexpr absl::string_view AlpnHeader = "x-envoy-upstream-alpn";
 
-        transformed_headers.entries[transformed_headers.length] = {key, value};
-        transformed_headers.length++;
+  // Size the block holding the entries and all of their bytes, so that it is allocated only once.
+  Data::BridgeMapBuilder builder;
+  builder.reserve(header_map.size(), header_map.byteSize());
+  if (!alpn.empty()) {
+    builder.reserve(1, AlpnHeader.size() + alpn.size());
+  }
 
+  StatefulHeaderKeyFormatterOptConstRef formatter = header_map.formatter();
+  header_map.iterate([&builder, &formatter](const HeaderEntry& header) -> HeaderMap::Iterate {
+    absl::string_view key = header.key().getStringView();
+    if (formatter.has_value()) {
+      // Formatting restores the original case of the key, so its length is expected to be
+      // unchanged. Otherwise it would not fit in the reserved space, so fall back to the key as is.
+      const std::string formatted_key = formatter->format(key);
+      if (formatted_key.size() == key.size()) {
+        builder.add(formatted_key, header.value().getStringView());
         return HeaderMap::Iterate::Continue;
-      });
+      }
+    }
+    builder.add(key, header.value().getStringView());
+    return HeaderMap::Iterate::Continue;
+  });
   if (!alpn.empty()) {
-    envoy_data key = Data::Utility::copyToBridgeData("x-envoy-upstream-alpn");
-    envoy_data value = Data::Utility::copyToBridgeData(alpn);
-    transformed_headers.entries[transformed_headers.length] = {key, value};
-    transformed_headers.length++;
+    builder.add(AlpnHeader, alpn);
   }
-  return transformed_headers;
+  return builder.finish();
 }
 
 } // namespace Utility
@@ -12,8 +12,10 @@ namespace Utility {
 /**
  * Transform envoy_headers to the supplied HeaderMap
  * This function copies the content.
+ * Well-known keys which are already lowercase are added by reference to interned keys, and only
+ * keys which are not lowercase are passed to the formatter.
  * @param envoy_result_headers, the Envoy headers to fill in. These headers must have a formatter
- *        set.
+ *        set, which must leave keys it has not processed unchanged.
  * @param headers, the envoy_headers to transform. headers is free'd. Use after function return is
  * unsafe.
  */
@@ -39,7 +41,8 @@ RequestTrailerMapPtr toRequestTrailers(envoy_headers trailers);
 
 /**
  * Transform envoy_headers to HeaderMap.
- * This function copies the content.
+ * This function copies the content into a single allocation, which holds the entries as well as
+ * the bytes of every key and value.
  * Caller owns the allocated bytes for the return value, and needs to free after use.
  * @param headers, the HeaderMap to transform.
  * @param alpn, the optional alpn to add to the headers.
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+#include "envoy/common/time.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * Auto-tunes the read credit extended to a platform consumer in explicit flow control mode, in the
+ * spirit of TCP receive window auto-tuning.
+ *
+ * Each read_data grant tops the stream's credit up to the current window, and data is delivered
+ * while credit remains rather than once per grant, so a consumer which keeps up is not limited to
+ * one bridge round trip per chunk. The window starts at the size of the consumer's grants:
+ * - if the credit ran out and the consumer granted more within FastGrantInterval, the window was
+ *   what limited delivery, and it is doubled, up to the stream's buffer limit;
+ * - if the consumer took longer than SlowGrantInterval to grant more after data was delivered, it
+ *   is falling behind, and the window is halved, down to the size of its grants.
+ *
+ * The window never exceeds the stream's buffer limit, so the memory bounds of explicit flow control
+ * are kept. Not thread-safe.
+ */
+class ReadWindow {
+public:
+  static constexpr std::chrono::milliseconds FastGrantInterval{10};
+  static constexpr std::chrono::milliseconds SlowGrantInterval{100};
+
+  /**
+   * @param max_window, the largest window, i.e. the stream's buffer limit.
+   */
+  explicit ReadWindow(uint32_t max_window) : max_window_(max_window) {}
+
+  /**
+   * Called when the consumer grants more credit.
+   * @param requested_bytes, the bytes the consumer asked for.
+   * @param now, the current time.
+   * @return uint32_t, the credit now available, which is at least requested_bytes.
+   */
+  uint32_t onGrant(uint32_t requested_bytes, MonotonicTime now) {
+    if (window_ == 0) {
+      window_ = std::min(requested_bytes, max_window_);
+    } else if (credit_ == 0 && now - exhausted_at_ <= FastGrantInterval) {
+      window_ = static_cast<uint32_t>(
+          std::min<uint64_t>(uint64_t{window_} * 2, std::max(max_window_, requested_bytes)));
+    } else if (delivered_since_grant_ && now - last_delivery_ >= SlowGrantInterval) {
+      window_ = std::max(window_ / 2, requested_bytes);
+    }
+    credit_ = std::max(window_, requested_bytes);
+    delivered_since_grant_ = false;
+    return credit_;
+  }
+
+  /**
+   * Called when data is delivered to the consumer.
+   * @param bytes, the bytes delivered, which must not exceed the available credit.
+   * @param now, the current time.
+   * @return uint32_t, the credit remaining.
+   */
+  uint32_t onDelivered(uint64_t bytes, MonotonicTime now) {
+    credit_ -= std::min<uint64_t>(bytes, credit_);
+    last_delivery_ = now;
+    delivered_since_grant_ = true;
+    if (credit_ == 0) {
+      exhausted_at_ = now;
+    }
+    return credit_;
+  }
+
+  uint32_t window() const { return window_; }
+  uint32_t credit() const { return credit_; }
+
+private:
+  const uint32_t max_window_;
+  uint32_t window_{};
+  uint32_t credit_{};
+  bool delivered_since_grant_{};
+  MonotonicTime exhausted_at_;
+  MonotonicTime last_delivery_;
+};
+
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "source/common/common/assert.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * Apportions an engine-wide memory budget for buffered stream data between streams.
+ *
+ * Each stream is granted a buffer limit: its own limit if it set one, or the engine's default
+ * otherwise. While a budget is configured, the granted limit shrinks in proportion to the fraction
+ * of the budget already held in stream buffers, so that as the total buffered bytes grow,
+ * watermarks are lowered and flow control engages earlier on every stream. Limits never drop
+ * below MinStreamLimit, so that every stream can still make progress.
+ *
+ * Only the response data buffered by streams in explicit flow control mode is counted against the
+ * budget, and only their response watermarks are resized as it fills. Other streams pass response
+ * data straight to the platform; they are granted a limit from the budget when started, but their
+ * request and response buffers are not counted.
+ *
+ * Not thread-safe. Used from the engine's dispatcher thread.
+ */
+class StreamBufferBudget {
+public:
+  // 1Mb
+  static constexpr uint32_t DefaultStreamLimit = 1024000;
+  static constexpr uint32_t MinStreamLimit = 32 * 1024;
+
+  /**
+   * @param default_stream_limit, the limit for streams which do not set their own.
+   * @param budget, the number of bytes which may be buffered across all streams, or 0 for no
+   *        budget.
+   */
+  explicit StreamBufferBudget(uint32_t default_stream_limit = DefaultStreamLimit,
+                              uint64_t budget = 0)
+      : default_stream_limit_(default_stream_limit), budget_(budget) {}
+
+  /**
+   * @param requested_limit, the stream's own limit, or 0 to use the default.
+   * @return uint32_t, the limit to apply to the stream given the bytes currently buffered.
+   */
+  uint32_t limitFor(uint32_t requested_limit) const {
+    const uint32_t limit = requested_limit != 0 ? requested_limit : default_stream_limit_;
+    if (budget_ == 0) {
+      return limit;
+    }
+    const uint64_t remaining = budget_ > buffered_ ? budget_ - buffered_ : 0;
+    const double available = static_cast<double>(remaining) / static_cast<double>(budget_);
+    const auto scaled = static_cast<uint32_t>(limit * available);
+    return std::max(scaled, std::min(limit, MinStreamLimit));
+  }
+
+  /**
+   * Records a change in the number of bytes buffered by one stream.
+   * @param previous, the bytes the stream previously had buffered.
+   * @param current, the bytes the stream now has buffered.
+   */
+  void update(uint64_t previous, uint64_t current) {
+    ASSERT(buffered_ >= previous);
+    buffered_ = buffered_ - previous + current;
+  }
+
+  uint64_t buffered() const { return buffered_; }
+  uint64_t budget() const { return budget_; }
+
+private:
+  const uint32_t default_stream_limit_;
+  const uint64_t budget_;
+  uint64_t buffered_{};
+};
+
+} // namespace Http
+} // namespace Envoy
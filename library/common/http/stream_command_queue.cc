@@ -0,0 +1,160 @@
+#include "library/common/http/stream_command_queue.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "absl/numeric/bits.h"
+
+namespace Envoy {
+namespace Http {
+
+StreamCommand StreamCommand::start(envoy_stream_t stream, envoy_http_callbacks callbacks,
+                                   envoy_stream_options options) {
+  StreamCommand command;
+  command.stream_ = stream;
+  command.type_ = StreamCommandType::Start;
+  command.flag_ = false;
+  command.start_.callbacks_ = callbacks;
+  command.start_.options_ = options;
+  return command;
+}
+
+StreamCommand StreamCommand::sendHeaders(envoy_stream_t stream, envoy_headers headers,
+                                         bool end_stream) {
+  StreamCommand command;
+  command.stream_ = stream;
+  command.type_ = StreamCommandType::SendHeaders;
+  command.flag_ = end_stream;
+  command.headers_ = headers;
+  return command;
+}
+
+StreamCommand StreamCommand::readData(envoy_stream_t stream, size_t bytes_to_read) {
+  StreamCommand command;
+  command.stream_ = stream;
+  command.type_ = StreamCommandType::ReadData;
+  command.flag_ = false;
+  command.bytes_to_read_ = bytes_to_read;
+  return command;
+}
+
+StreamCommand StreamCommand::sendData(envoy_stream_t stream, envoy_data data, bool end_stream) {
+  StreamCommand command;
+  command.stream_ = stream;
+  command.type_ = StreamCommandType::SendData;
+  command.flag_ = end_stream;
+  command.data_ = data;
+  return command;
+}
+
+StreamCommand StreamCommand::sendFile(envoy_stream_t stream, int fd, uint64_t offset,
+                                      uint64_t length, bool end_stream) {
+  StreamCommand command;
+  command.stream_ = stream;
+  command.type_ = StreamCommandType::SendFile;
+  command.flag_ = end_stream;
+  command.file_.fd_ = fd;
+  command.file_.offset_ = offset;
+  command.file_.length_ = length;
+  return command;
+}
+
+StreamCommand StreamCommand::sendTrailers(envoy_stream_t stream, envoy_headers trailers) {
+  StreamCommand command;
+  command.stream_ = stream;
+  command.type_ = StreamCommandType::SendTrailers;
+  command.flag_ = true;
+  command.headers_ = trailers;
+  return command;
+}
+
+StreamCommand StreamCommand::cancel(envoy_stream_t stream) {
+  StreamCommand command;
+  command.stream_ = stream;
+  command.type_ = StreamCommandType::Cancel;
+  command.flag_ = false;
+  return command;
+}
+
+void StreamCommand::releasePayload() {
+  switch (type_) {
+  case StreamCommandType::SendHeaders:
+  case StreamCommandType::SendTrailers:
+    release_envoy_headers(headers_);
+    break;
+  case StreamCommandType::SendData:
+    release_envoy_data(data_);
+    break;
+  case StreamCommandType::SendFile:
+    close(file_.fd_);
+    break;
+  case StreamCommandType::Start:
+  case StreamCommandType::ReadData:
+  case StreamCommandType::Cancel:
+    break;
+  }
+}
+
+StreamCommandQueue::StreamCommandQueue(size_t capacity)
+    : mask_(absl::bit_ceil(std::max<size_t>(capacity, 2)) - 1), cells_(new Cell[mask_ + 1]) {
+  for (size_t i = 0; i <= mask_; ++i) {
+    cells_[i].sequence_.store(i, std::memory_order_relaxed);
+  }
+}
+
+StreamCommandQueue::~StreamCommandQueue() {
+  while (drain([](StreamCommand& command) { command.releasePayload(); }) > 0) {
+  }
+}
+
+bool StreamCommandQueue::enqueue(const StreamCommand& command) {
+  if (overflow_active_.load(std::memory_order_acquire) || !tryEnqueue(command)) {
+    Thread::LockGuard lock(overflow_lock_);
+    overflow_active_.store(true, std::memory_order_release);
+    overflow_.push_back(command);
+  }
+  // Only the first command after a drain has started needs to wake up the consumer.
+  return !wakeup_pending_.exchange(true);
+}
+
+bool StreamCommandQueue::tryEnqueue(const StreamCommand& command) {
+  size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+  Cell* cell;
+  while (true) {
+    cell = &cells_[pos & mask_];
+    const size_t sequence = cell->sequence_.load(std::memory_order_acquire);
+    const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+    if (diff == 0) {
+      if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // The consumer has not yet released this cell: the ring is full.
+      return false;
+    } else {
+      pos = enqueue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+  synchronizer_.syncPoint("publish");
+  cell->command_ = command;
+  cell->sequence_.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+bool StreamCommandQueue::tryDequeue(StreamCommand& command) {
+  Cell& cell = cells_[dequeue_pos_ & mask_];
+  const size_t sequence = cell.sequence_.load(std::memory_order_acquire);
+  if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(dequeue_pos_ + 1) < 0) {
+    // Either empty, or a producer has claimed this cell but not yet published to it. In the latter
+    // case the producer will schedule another drain once it publishes.
+    return false;
+  }
+  command = cell.command_;
+  cell.sequence_.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+  ++dequeue_pos_;
+  return true;
+}
+
+} // namespace Http
+} // namespace Envoy
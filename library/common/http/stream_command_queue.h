@@ -0,0 +1,202 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+
+#include "envoy/thread/thread.h"
+
+#include "source/common/common/assert.h"
+#include "source/common/common/lock_guard.h"
+#include "source/common/common/thread.h"
+#include "source/common/common/thread_synchronizer.h"
+
+#include "library/common/types/c_types.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * Stream operations which may be issued from platform threads via the public C API.
+ */
+enum class StreamCommandType : uint8_t {
+  Start,
+  SendHeaders,
+  ReadData,
+  SendData,
+  SendFile,
+  SendTrailers,
+  Cancel,
+};
+
+/**
+ * A fixed-size, tagged record describing one stream operation. Bridge payloads are owned by the
+ * command until it is run against the Http::Client, which then takes ownership exactly as it does
+ * for the equivalent direct calls. The record is trivially copyable so that it can be stored by
+ * value in the StreamCommandQueue without any allocation.
+ */
+struct StreamCommand {
+  static StreamCommand start(envoy_stream_t stream, envoy_http_callbacks callbacks,
+                             envoy_stream_options options);
+  static StreamCommand sendHeaders(envoy_stream_t stream, envoy_headers headers, bool end_stream);
+  static StreamCommand readData(envoy_stream_t stream, size_t bytes_to_read);
+  static StreamCommand sendData(envoy_stream_t stream, envoy_data data, bool end_stream);
+  static StreamCommand sendFile(envoy_stream_t stream, int fd, uint64_t offset, uint64_t length,
+                                bool end_stream);
+  static StreamCommand sendTrailers(envoy_stream_t stream, envoy_headers trailers);
+  static StreamCommand cancel(envoy_stream_t stream);
+
+  /**
+   * Releases any bridge payload still owned by this command. Used when a command is discarded
+   * without being run.
+   */
+  void releasePayload();
+
+  envoy_stream_t stream_;
+  StreamCommandType type_;
+  // end_stream for SendHeaders/SendData/SendFile.
+  bool flag_;
+  union {
+    struct {
+      envoy_http_callbacks callbacks_;
+      envoy_stream_options options_;
+    } start_;
+    envoy_headers headers_;
+    envoy_data data_;
+    // The command owns fd_, which is closed if the command is discarded.
+    struct {
+      int fd_;
+      uint64_t offset_;
+      uint64_t length_;
+    } file_;
+    size_t bytes_to_read_;
+  };
+};
+
+/**
+ * A multi-producer, single-consumer queue of StreamCommands.
+ *
+ * Producers (platform threads) enqueue into a bounded lock-free ring of fixed-size records; the
+ * consumer (the engine's dispatcher thread) drains what is available in batches of at most
+ * MaxCommandsPerDrain. The queue tracks whether a drain is already pending so that a burst of
+ * commands results in a single wakeup of the event loop rather than one post per command.
+ *
+ * If the ring is full, commands spill into a mutex-guarded overflow list. While the overflow is in
+ * use all producers append to it, and it is only drained once every command claimed in the ring
+ * before it has been published and drained, which preserves the per-producer ordering of commands.
+ */
+class StreamCommandQueue {
+public:
+  /**
+   * @param capacity, the number of commands held by the lock-free ring. Rounded up to a power of
+   * two.
+   */
+  explicit StreamCommandQueue(size_t capacity = DefaultCapacity);
+
+  /**
+   * Releases the payloads of any commands which were never drained.
+   */
+  ~StreamCommandQueue();
+
+  /**
+   * Enqueue a command. May be called from any thread.
+   * @param command, the command to enqueue. Ownership of its payload is transferred to the queue.
+   * @return bool, true if the caller must schedule a drain, i.e. no drain was pending.
+   */
+  bool enqueue(const StreamCommand& command);
+
+  /**
+   * Must be called if the caller was asked to schedule a drain but could not, so that a later
+   * producer retries the wakeup.
+   */
+  void onWakeupFailed() { wakeup_pending_.store(false); }
+
+  /**
+   * Runs cb on up to MaxCommandsPerDrain available commands, in order. Must only be called from
+   * the consumer thread.
+   * @param cb, invoked with each command; takes ownership of the command's payload.
+   * @return uint64_t, the number of commands drained. If it's MaxCommandsPerDrain, commands may
+   *         remain, and the caller must schedule another drain if rescheduleDrain() asks it to.
+   */
+  template <class Callback> uint64_t drain(Callback cb) {
+    // Clear the pending flag before reading so that a command published after the last read is
+    // guaranteed to schedule another drain.
+    wakeup_pending_.store(false);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    uint64_t drained = 0;
+    StreamCommand command;
+    while (drained < MaxCommandsPerDrain) {
+      if (!overflow_batch_.empty()) {
+        // Left over from a previous drain, and ahead of anything enqueued in the ring since.
+        cb(overflow_batch_.front());
+        overflow_batch_.pop_front();
+        ++drained;
+        continue;
+      }
+      if (tryDequeue(command)) {
+        cb(command);
+        ++drained;
+        continue;
+      }
+      // A cell claimed but not yet published may hold a command which precedes, for the same
+      // producer, the commands in the overflow. Its producer schedules another drain once it
+      // publishes it.
+      if (!overflow_active_.load(std::memory_order_acquire) ||
+          dequeue_pos_ != enqueue_pos_.load(std::memory_order_acquire)) {
+        break;
+      }
+      Thread::LockGuard lock(overflow_lock_);
+      overflow_batch_.swap(overflow_);
+      overflow_active_.store(false, std::memory_order_release);
+    }
+    return drained;
+  }
+
+  /**
+   * Must be called by the consumer after a drain which stopped at MaxCommandsPerDrain, so that the
+   * remaining commands are drained once the event loop has run.
+   * @return bool, true if the caller must schedule a drain, i.e. no drain was pending.
+   */
+  bool rescheduleDrain() { return !wakeup_pending_.exchange(true); }
+
+  size_t capacity() const { return mask_ + 1; }
+
+  // Used for testing.
+  Thread::ThreadSynchronizer& synchronizer() { return synchronizer_; }
+
+  static constexpr size_t DefaultCapacity = 1024;
+
+  /**
+   * The maximum number of commands run per drain, so that a busy producer can't starve the event
+   * loop's timers and network events.
+   */
+  static constexpr uint64_t MaxCommandsPerDrain = 1024;
+
+private:
+  struct Cell {
+    std::atomic<size_t> sequence_;
+    StreamCommand command_;
+  };
+
+  bool tryEnqueue(const StreamCommand& command);
+  bool tryDequeue(StreamCommand& command);
+
+  const size_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+  // Producer and consumer positions live on separate cache lines to avoid false sharing.
+  alignas(64) std::atomic<size_t> enqueue_pos_{0};
+  alignas(64) size_t dequeue_pos_{0};
+  alignas(64) std::atomic<bool> wakeup_pending_{false};
+  std::atomic<bool> overflow_active_{false};
+  Thread::MutexBasicLockable overflow_lock_;
+  std::deque<StreamCommand> overflow_ ABSL_GUARDED_BY(overflow_lock_);
+  // Overflow commands taken by the consumer but not yet run. Only accessed by the consumer.
+  std::deque<StreamCommand> overflow_batch_;
+  Thread::ThreadSynchronizer synchronizer_;
+};
+
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "envoy/common/time.h"
+
+#include "source/common/common/assert.h"
+
+#include "absl/types/optional.h"
+#include "library/common/types/c_types.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * Decides which streams the Http::Client holds back in favor of higher priority streams.
+ *
+ * A high priority stream is pending from when it is started until its response headers arrive or
+ * it ends. While any high priority stream is pending, newly started low priority streams are held:
+ * their requests are not sent upstream, so that they do not compete for connections and
+ * concurrent stream slots. Once no high priority stream is pending, the held streams are released
+ * in the order they were started. Only the wait for response headers is considered, so that a
+ * long-lived high priority stream does not hold back low priority streams for its whole life.
+ * So that a steady flow of high priority streams can't starve them, streams held for the maximum
+ * hold time are released regardless.
+ *
+ * Not thread-safe. Used from the engine's dispatcher thread.
+ */
+class StreamPriorityScheduler {
+public:
+  /**
+   * @param max_hold_time, how long a stream may be held before it's released regardless.
+   */
+  explicit StreamPriorityScheduler(std::chrono::milliseconds max_hold_time = DefaultMaxHoldTime)
+      : max_hold_time_(max_hold_time) {}
+
+  /**
+   * @param priority, the priority of a stream being started.
+   * @return bool, whether the stream should be held.
+   */
+  bool shouldHold(envoy_stream_priority_t priority) const {
+    return priority == ENVOY_STREAM_PRIORITY_LOW && pending_high_priority_ > 0;
+  }
+
+  /**
+   * Records a held stream, to be returned by release() or releaseExpired().
+   * @param now, the time at which the stream is held.
+   */
+  void hold(envoy_stream_t stream, MonotonicTime now) { held_.push_back({stream, now}); }
+
+  /**
+   * Called when a high priority stream starts.
+   */
+  void onHighPriorityPending() { ++pending_high_priority_; }
+
+  /**
+   * Called when a pending high priority stream receives its response headers, or ends.
+   * @return bool, true if no high priority stream remains pending and streams are held, i.e. if
+   *         release() should now be called.
+   */
+  bool onHighPriorityResolved() {
+    ASSERT(pending_high_priority_ > 0);
+    --pending_high_priority_;
+    return pending_high_priority_ == 0 && !held_.empty();
+  }
+
+  /**
+   * @return std::vector<envoy_stream_t>, the held streams in the order they were held, or none if
+   *         a high priority stream is pending. Returned streams are no longer held.
+   */
+  std::vector<envoy_stream_t> release() {
+    std::vector<envoy_stream_t> released;
+    if (pending_high_priority_ == 0) {
+      for (const HeldStream& held : held_) {
+        released.push_back(held.stream_);
+      }
+      held_.clear();
+    }
+    return released;
+  }
+
+  /**
+   * @param now, the current time.
+   * @return std::vector<envoy_stream_t>, the streams held for at least the maximum hold time, in
+   *         the order they were held, whether or not a high priority stream is pending. Returned
+   *         streams are no longer held.
+   */
+  std::vector<envoy_stream_t> releaseExpired(MonotonicTime now) {
+    std::vector<envoy_stream_t> released;
+    while (!held_.empty() && now - held_.front().held_at_ >= max_hold_time_) {
+      released.push_back(held_.front().stream_);
+      held_.pop_front();
+    }
+    return released;
+  }
+
+  /**
+   * @return absl::optional<MonotonicTime>, when the longest held stream reaches the maximum hold
+   *         time, if any stream is held.
+   */
+  absl::optional<MonotonicTime> nextExpiry() const {
+    if (held_.empty()) {
+      return absl::nullopt;
+    }
+    return held_.front().held_at_ + max_hold_time_;
+  }
+
+  uint32_t pendingHighPriority() const { return pending_high_priority_; }
+  size_t held() const { return held_.size(); }
+
+  // Longer than the connection manager's default stream idle timeout, which a held stream isn't
+  // subject to, but short enough that a low priority request isn't indefinitely delayed.
+  static constexpr std::chrono::milliseconds DefaultMaxHoldTime{30000};
+
+private:
+  struct HeldStream {
+    envoy_stream_t stream_;
+    MonotonicTime held_at_;
+  };
+
+  const std::chrono::milliseconds max_hold_time_;
+  uint32_t pending_high_priority_{};
+  // In the order the streams were held, which is also the order they expire in.
+  std::deque<HeldStream> held_;
+};
+
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "source/common/common/assert.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "library/common/types/c_types.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * Maps stream handles to stream objects, tracking whether each stream is open or closed.
+ *
+ * Stream handles are allocated from a monotonically increasing counter, so the handles of the
+ * streams live at any one time are clustered. The table is therefore indexed directly by the low
+ * bits of the handle; the full handle is stored in the slot and acts as a generation tag, so that
+ * a stale handle whose slot has since been reused is rejected by a single comparison, without
+ * hashing.
+ *
+ * If a new handle lands on a slot held by a live stream, the table doubles in size, which is
+ * guaranteed to separate the two handles once it spans their distance. Beyond MaxSlots,
+ * colliding streams (e.g. a very long-lived stream) are held in an overflow map instead.
+ *
+ * Not thread-safe. The table does not own the streams.
+ */
+template <class T> class StreamSlotTable {
+public:
+  static constexpr size_t InitialSlots = 64;
+  static constexpr size_t MaxSlots = 64 * 1024;
+
+  StreamSlotTable() : slots_(InitialSlots) {}
+
+  /**
+   * Inserts a new, open stream.
+   * @param handle, the stream's handle, which must not already be present.
+   * @param stream, the stream.
+   */
+  void insert(envoy_stream_t handle, T* stream) {
+    ASSERT(stream != nullptr);
+    ASSERT(find(handle, true) == nullptr);
+    while (true) {
+      Slot& slot = slotFor(handle);
+      if (slot.stream_ == nullptr) {
+        slot = Slot{handle, stream, false};
+        break;
+      }
+      if (slots_.size() >= MaxSlots) {
+        overflow_.emplace(handle, Slot{handle, stream, false});
+        break;
+      }
+      grow();
+    }
+    ++size_;
+  }
+
+  /**
+   * @param handle, the stream to find.
+   * @param include_closed, whether closed streams should be returned.
+   * @return T*, the stream, or nullptr if it is not present (or closed, unless requested).
+   */
+  T* find(envoy_stream_t handle, bool include_closed) {
+    Slot* slot = findSlot(handle);
+    if (slot == nullptr || (slot->closed_ && !include_closed)) {
+      return nullptr;
+    }
+    return slot->stream_;
+  }
+
+  /**
+   * Marks an open stream as closed.
+   * @param handle, the stream to close.
+   * @return bool, true if the stream was present and open.
+   */
+  bool close(envoy_stream_t handle) {
+    Slot* slot = findSlot(handle);
+    if (slot == nullptr || slot->closed_) {
+      return false;
+    }
+    slot->closed_ = true;
+    return true;
+  }
+
+  /**
+   * Removes a stream, whether open or closed.
+   * @param handle, the stream to remove.
+   * @return T*, the removed stream, or nullptr if it was not present.
+   */
+  T* erase(envoy_stream_t handle) {
+    Slot& slot = slotFor(handle);
+    T* stream = nullptr;
+    if (slot.stream_ != nullptr && slot.handle_ == handle) {
+      stream = slot.stream_;
+      slot = Slot{};
+    } else if (!overflow_.empty()) {
+      auto it = overflow_.find(handle);
+      if (it != overflow_.end()) {
+        stream = it->second.stream_;
+        overflow_.erase(it);
+      }
+    }
+    if (stream != nullptr) {
+      --size_;
+    }
+    return stream;
+  }
+
+  /**
+   * Invokes cb on every stream in the table, open or closed.
+   */
+  template <class Callback> void forEach(Callback cb) {
+    for (Slot& slot : slots_) {
+      if (slot.stream_ != nullptr) {
+        cb(slot.stream_);
+      }
+    }
+    for (auto& entry : overflow_) {
+      cb(entry.second.stream_);
+    }
+  }
+
+  size_t size() const { return size_; }
+  size_t slots() const { return slots_.size(); }
+
+private:
+  struct Slot {
+    envoy_stream_t handle_{};
+    T* stream_{};
+    bool closed_{};
+  };
+
+  Slot& slotFor(envoy_stream_t handle) {
+    return slots_[static_cast<size_t>(handle) & (slots_.size() - 1)];
+  }
+
+  Slot* findSlot(envoy_stream_t handle) {
+    Slot& slot = slotFor(handle);
+    if (slot.stream_ != nullptr && slot.handle_ == handle) {
+      return &slot;
+    }
+    if (overflow_.empty()) {
+      return nullptr;
+    }
+    auto it = overflow_.find(handle);
+    return it == overflow_.end() ? nullptr : &it->second;
+  }
+
+  void grow() {
+    std::vector<Slot> old_slots(slots_.size() * 2);
+    old_slots.swap(slots_);
+    // Handles which did not collide in the smaller table cannot collide in the larger one.
+    for (Slot& slot : old_slots) {
+      if (slot.stream_ != nullptr) {
+        slotFor(slot.handle_) = slot;
+      }
+    }
+  }
+
+  std::vector<Slot> slots_;
+  absl::flat_hash_map<envoy_stream_t, Slot> overflow_;
+  size_t size_{};
+};
+
+} // namespace Http
+} // namespace Envoy
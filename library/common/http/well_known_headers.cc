@@ -0,0 +1,61 @@
+#include "library/common/http/well_known_headers.h"
+
+#include "source/common/common/assert.h"
+
+namespace Envoy {
+namespace Http {
+
+namespace {
+
+constexpr uint32_t MaxSeedAttempts = 1 << 16;
+
+} // namespace
+
+WellKnownHeaderValues::WellKnownHeaderValues()
+    : keys_{LowerCaseString(":authority"),
+            LowerCaseString(":method"),
+            LowerCaseString(":path"),
+            LowerCaseString(":protocol"),
+            LowerCaseString(":scheme"),
+            LowerCaseString("accept"),
+            LowerCaseString("accept-encoding"),
+            LowerCaseString("accept-language"),
+            LowerCaseString("authorization"),
+            LowerCaseString("cache-control"),
+            LowerCaseString("content-encoding"),
+            LowerCaseString("content-length"),
+            LowerCaseString("content-type"),
+            LowerCaseString("cookie"),
+            LowerCaseString("grpc-timeout"),
+            LowerCaseString("if-modified-since"),
+            LowerCaseString("if-none-match"),
+            LowerCaseString("origin"),
+            LowerCaseString("range"),
+            LowerCaseString("referer"),
+            LowerCaseString("te"),
+            LowerCaseString("user-agent"),
+            LowerCaseString("x-envoy-mobile-upstream-protocol"),
+            LowerCaseString("x-request-id")} {
+  // Search for a seed under which no two keys share a slot. The keys are fixed, so this always
+  // settles on the same seed after a handful of attempts.
+  for (uint32_t seed = 1; seed < MaxSeedAttempts; ++seed) {
+    table_.fill(nullptr);
+    bool collision = false;
+    for (const LowerCaseString& key : keys_) {
+      const LowerCaseString*& entry = table_[slot(key.get(), seed)];
+      if (entry != nullptr) {
+        collision = true;
+        break;
+      }
+      entry = &key;
+    }
+    if (!collision) {
+      seed_ = seed;
+      return;
+    }
+  }
+  PANIC("no perfect hash found for well-known headers");
+}
+
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "envoy/http/header_map.h"
+
+#include "source/common/singleton/const_singleton.h"
+
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * Interned keys of the request headers most commonly sent by the platform, so that they can be
+ * added to header maps by reference rather than copied into every request.
+ *
+ * Keys are looked up through a perfect hash over a few of their characters, chosen when the table
+ * is built, so that a lookup costs one hash and at most one string comparison.
+ */
+class WellKnownHeaderValues {
+public:
+  WellKnownHeaderValues();
+
+  /**
+   * @param key, a header key, which is matched exactly (i.e. case-sensitively).
+   * @return const LowerCaseString*, the interned key, or nullptr if key is not well known.
+   */
+  const LowerCaseString* find(absl::string_view key) const {
+    if (key.empty()) {
+      return nullptr;
+    }
+    const LowerCaseString* candidate = table_[slot(key, seed_)];
+    return candidate != nullptr && candidate->get() == key ? candidate : nullptr;
+  }
+
+  const std::vector<LowerCaseString>& keys() const { return keys_; }
+
+private:
+  static constexpr size_t TableBits = 7;
+
+  static size_t slot(absl::string_view key, uint32_t seed) {
+    uint32_t hash = seed;
+    hash = (hash ^ static_cast<uint32_t>(key.size())) * 0x01000193;
+    hash = (hash ^ static_cast<uint8_t>(key.front())) * 0x01000193;
+    hash = (hash ^ static_cast<uint8_t>(key[key.size() / 2])) * 0x01000193;
+    hash = (hash ^ static_cast<uint8_t>(key.back())) * 0x01000193;
+    return hash >> (32 - TableBits);
+  }
+
+  const std::vector<LowerCaseString> keys_;
+  std::array<const LowerCaseString*, 1 << TableBits> table_{};
+  uint32_t seed_{};
+};
+
+using WellKnownHeaders = ConstSingleton<WellKnownHeaderValues>;
+
+} // namespace Http
+} // namespace Envoy
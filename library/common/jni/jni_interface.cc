@@ -937,7 +937,9 @@ extern "C" JNIEXPORT jint JNICALL Java_io_envoyproxy_envoymobile_engine_JniLibra
                                            jvm_on_complete,
                                            jvm_on_cancel,
                                            jvm_on_send_window_available,
-                                           retained_context};
+                                           retained_context,
+                                           nullptr,
+                                           nullptr};
   envoy_status_t result = start_stream(static_cast<envoy_engine_t>(engine_handle),
                                        static_cast<envoy_stream_t>(stream_handle), native_callbacks,
                                        explicit_flow_control);
@@ -1,5 +1,7 @@
 #include "library/common/main_interface.h"
 
+#include <unistd.h>
+
 #include <atomic>
 #include <string>
 
@@ -9,6 +11,7 @@
 #include "library/common/engine_handle.h"
 #include "library/common/extensions/filters/http/platform_bridge/c_types.h"
 #include "library/common/http/client.h"
+#include "library/common/http/stream_command_queue.h"
 #include "library/common/network/connectivity_manager.h"
 
 // NOLINT(namespace-envoy)
@@ -19,33 +22,45 @@ envoy_stream_t init_stream(envoy_engine_t) { return current_stream_handle_++; }
 
 envoy_status_t start_stream(envoy_engine_t engine, envoy_stream_t stream,
                             envoy_http_callbacks callbacks, bool explicit_flow_control) {
-  return Envoy::EngineHandle::runOnEngineDispatcher(
-      engine, [stream, callbacks, explicit_flow_control](auto& engine) -> void {
-        engine.httpClient().startStream(stream, callbacks, explicit_flow_control);
-      });
+  envoy_stream_options options{};
+  options.explicit_flow_control = explicit_flow_control;
+  return start_stream_with_options(engine, stream, callbacks, options);
+}
+
+envoy_status_t start_stream_with_options(envoy_engine_t engine, envoy_stream_t stream,
+                                         envoy_http_callbacks callbacks,
+                                         envoy_stream_options options) {
+  return Envoy::EngineHandle::dispatchStreamCommand(
+      engine, Envoy::Http::StreamCommand::start(stream, callbacks, options));
 }
 
 envoy_status_t send_headers(envoy_engine_t engine, envoy_stream_t stream, envoy_headers headers,
                             bool end_stream) {
-  return Envoy::EngineHandle::runOnEngineDispatcher(
-      engine, ([stream, headers, end_stream](auto& engine) -> void {
-        engine.httpClient().sendHeaders(stream, headers, end_stream);
-      }));
+  return Envoy::EngineHandle::dispatchStreamCommand(
+      engine, Envoy::Http::StreamCommand::sendHeaders(stream, headers, end_stream));
 }
 
 envoy_status_t read_data(envoy_engine_t engine, envoy_stream_t stream, size_t bytes_to_read) {
-  return Envoy::EngineHandle::runOnEngineDispatcher(
-      engine, [stream, bytes_to_read](auto& engine) -> void {
-        engine.httpClient().readData(stream, bytes_to_read);
-      });
+  return Envoy::EngineHandle::dispatchStreamCommand(
+      engine, Envoy::Http::StreamCommand::readData(stream, bytes_to_read));
 }
 
 envoy_status_t send_data(envoy_engine_t engine, envoy_stream_t stream, envoy_data data,
                          bool end_stream) {
-  return Envoy::EngineHandle::runOnEngineDispatcher(
-      engine, [stream, data, end_stream](auto& engine) -> void {
-        engine.httpClient().sendData(stream, data, end_stream);
-      });
+  return Envoy::EngineHandle::dispatchStreamCommand(
+      engine, Envoy::Http::StreamCommand::sendData(stream, data, end_stream));
+}
+
+envoy_status_t send_file(envoy_engine_t engine, envoy_stream_t stream, int fd, uint64_t offset,
+                         uint64_t length, bool end_stream) {
+  // The engine reads the file after this returns, from its own descriptor.
+  const int engine_fd = dup(fd);
+  if (engine_fd < 0) {
+    return ENVOY_FAILURE;
+  }
+  // As with send_data's payload, the queued command owns the descriptor.
+  return Envoy::EngineHandle::dispatchStreamCommand(
+      engine, Envoy::Http::StreamCommand::sendFile(stream, engine_fd, offset, length, end_stream));
 }
 
 // TODO: implement.
@@ -54,15 +69,13 @@ envoy_status_t send_metadata(envoy_engine_t, envoy_stream_t, envoy_headers) {
 }
 
 envoy_status_t send_trailers(envoy_engine_t engine, envoy_stream_t stream, envoy_headers trailers) {
-  return Envoy::EngineHandle::runOnEngineDispatcher(
-      engine, [stream, trailers](auto& engine) -> void {
-        engine.httpClient().sendTrailers(stream, trailers);
-      });
+  return Envoy::EngineHandle::dispatchStreamCommand(
+      engine, Envoy::Http::StreamCommand::sendTrailers(stream, trailers));
 }
 
 envoy_status_t reset_stream(envoy_engine_t engine, envoy_stream_t stream) {
-  return Envoy::EngineHandle::runOnEngineDispatcher(
-      engine, [stream](auto& engine) -> void { engine.httpClient().cancelStream(stream); });
+  return Envoy::EngineHandle::dispatchStreamCommand(engine,
+                                                    Envoy::Http::StreamCommand::cancel(stream));
 }
 
 envoy_status_t set_preferred_network(envoy_engine_t engine, envoy_network_t network) {
@@ -82,6 +95,14 @@ envoy_status_t set_proxy_settings(envoy_engine_t e, const char* host, const uint
           -> void { engine.networkConnectivityManager().setProxySettings(proxy_settings); });
 }
 
+envoy_status_t preconnect(envoy_engine_t e, const char* authority,
+                          envoy_preconnect_protocol_t protocol, uint32_t connections) {
+  return Envoy::EngineHandle::runOnEngineDispatcher(
+      e, [authority = std::string(authority), protocol, connections](auto& engine) -> void {
+        engine.networkConnectivityManager().preconnect(authority, protocol, connections);
+      });
+}
+
 envoy_status_t record_counter_inc(envoy_engine_t e, const char* elements, envoy_stats_tags tags,
                                   uint64_t count) {
   return Envoy::EngineHandle::runOnEngineDispatcher(
@@ -195,6 +216,12 @@ envoy_status_t run_engine(envoy_engine_t engine, const char* config, const char*
   return Envoy::EngineHandle::runEngine(engine, config, log_level, admin_path);
 }
 
+envoy_status_t run_engine(envoy_engine_t engine,
+                          std::unique_ptr<envoy::config::bootstrap::v3::Bootstrap> bootstrap,
+                          const char* log_level, const char* admin_path) {
+  return Envoy::EngineHandle::runEngine(engine, std::move(bootstrap), log_level, admin_path);
+}
+
 void terminate_engine(envoy_engine_t engine, bool release) {
   Envoy::EngineHandle::terminateEngine(engine, release);
 }
@@ -203,3 +230,11 @@ envoy_status_t reset_connectivity_state(envoy_engine_t e) {
   return Envoy::EngineHandle::runOnEngineDispatcher(
       e, [](auto& engine) { engine.networkConnectivityManager().resetConnectivityState(); });
 }
+
+envoy_status_t suspend_engine(envoy_engine_t e) {
+  return Envoy::EngineHandle::runOnEngineDispatcher(e, [](auto& engine) { engine.suspend(); });
+}
+
+envoy_status_t resume_engine(envoy_engine_t e) {
+  return Envoy::EngineHandle::runOnEngineDispatcher(e, [](auto& engine) { engine.resume(); });
+}
@@ -32,6 +32,19 @@ envoy_stream_t init_stream(envoy_engine_t engine);
 envoy_status_t start_stream(envoy_engine_t engine, envoy_stream_t stream,
                             envoy_http_callbacks callbacks, bool explicit_flow_control);
 
+/**
+ * Open an underlying HTTP stream with the given options. Note: Streams must be started before other
+ * interaction can occur.
+ * @param engine, handle to the engine associated with this stream.
+ * @param stream, handle to the stream to be started.
+ * @param callbacks, the callbacks that will run the stream callbacks.
+ * @param options, the options for the stream.
+ * @return envoy_stream, with a stream handle and a success status, or a failure status.
+ */
+envoy_status_t start_stream_with_options(envoy_engine_t engine, envoy_stream_t stream,
+                                         envoy_http_callbacks callbacks,
+                                         envoy_stream_options options);
+
 /**
  * Send headers over an open HTTP stream. This method can be invoked once and needs to be called
  * before send_data.
@@ -46,7 +59,8 @@ envoy_status_t send_headers(envoy_engine_t engine, envoy_stream_t stream, envoy_
 
 /**
  * Notify the stream that the caller is ready to receive more data from the response stream. Only
- * used in explicit flow control mode.
+ * used in explicit flow control mode. If the stream was started with an auto-tuned read window,
+ * data keeps being delivered until the window's credit is used up, rather than in one callback.
  * @param bytes_to_read, the quantity of data the caller is prepared to process.
  */
 envoy_status_t read_data(envoy_engine_t engine, envoy_stream_t stream, size_t bytes_to_read);
@@ -62,6 +76,25 @@ envoy_status_t read_data(envoy_engine_t engine, envoy_stream_t stream, size_t by
 envoy_status_t send_data(envoy_engine_t engine, envoy_stream_t stream, envoy_data data,
                          bool end_stream);
 
+/**
+ * Send a range of a file over an open HTTP stream, as request data, without reading it into
+ * memory first. Regular files are mapped into memory, other files read, a buffer's worth at a
+ * time as upstream flow control allows, so that large files are never resident at once. Data,
+ * files and trailers sent before the file has been sent are queued, and sent after it in the order
+ * they were sent in. In explicit flow control mode, on_send_window_available is called once the
+ * last queued file has been sent.
+ * @param engine, the engine associated with this stream.
+ * @param stream, the stream to send the file over.
+ * @param fd, the file to send. It is duplicated, so the caller may close it once this returns.
+ * @param offset, the position in the file to start sending from. Ignored for files which are not
+ *        regular files, e.g. pipes, which are sent from their current position.
+ * @param length, the bytes to send.
+ * @param end_stream, supplies whether this is the last data in the stream.
+ * @return envoy_status_t, the resulting status of the operation.
+ */
+envoy_status_t send_file(envoy_engine_t engine, envoy_stream_t stream, int fd, uint64_t offset,
+                         uint64_t length, bool end_stream);
+
 /**
  * Send metadata over an HTTP stream. This method can be invoked multiple times.
  * @param engine, the engine associated with this stream.
@@ -108,6 +141,20 @@ envoy_status_t set_preferred_network(envoy_engine_t engine, envoy_network_t netw
  */
 envoy_status_t set_proxy_settings(envoy_engine_t engine, const char* host, const uint16_t port);
 
+/**
+ * Establish idle connections to a host ahead of requests to it, so that they need not wait for
+ * connection and TLS handshakes. Connections are re-established when the preferred network
+ * changes. May be called before the engine is running.
+ * @param engine, the engine which will send requests to the host.
+ * @param authority, the host, and optionally port, to connect to.
+ * @param protocol, the upstream protocol requests to the host will use.
+ * @param connections, the number of connections to establish. Connections which multiplex
+ *        streams, as HTTP/2 and HTTP/3 connections do, may stand in for several.
+ * @return envoy_status_t, the resulting status of the operation.
+ */
+envoy_status_t preconnect(envoy_engine_t engine, const char* authority,
+                          envoy_preconnect_protocol_t protocol, uint32_t connections);
+
 /**
  * Increment a counter with the given elements and by the given count.
  * @param engine, the engine that owns the counter.
@@ -222,6 +269,48 @@ void terminate_engine(envoy_engine_t engine, bool release);
  */
 envoy_status_t reset_connectivity_state(envoy_engine_t engine);
 
+/**
+ * Suspend an engine while the app is in the background, releasing the memory it doesn't need.
+ * Connections are drained, stats and key value stores are flushed, and the memory held for
+ * completed streams is freed. The engine keeps running, and streams may still be started.
+ * Suspending it again releases what they used.
+ * @param engine, handle to the engine to suspend.
+ * @return envoy_status_t, the resulting status of the operation.
+ */
+envoy_status_t suspend_engine(envoy_engine_t engine);
+
+/**
+ * Resume a suspended engine. DNS is refreshed, and connections are made again on demand.
+ * @param engine, handle to the engine to resume.
+ * @return envoy_status_t, the resulting status of the operation.
+ */
+envoy_status_t resume_engine(envoy_engine_t engine);
+
 #ifdef __cplusplus
 } // functions
+
+#include <memory>
+
+namespace envoy {
+namespace config {
+namespace bootstrap {
+namespace v3 {
+class Bootstrap;
+} // namespace v3
+} // namespace bootstrap
+} // namespace config
+} // namespace envoy
+
+/**
+ * External entry point for C++ callers, which runs the engine with a bootstrap built in memory. The
+ * bootstrap is used as is, so that no config is parsed at startup.
+ * @param engine, handle to the engine to run.
+ * @param bootstrap, the bootstrap config to run envoy with.
+ * @param log_level, the logging level to run envoy with.
+ * @param admin_path, the file path to log the admin address to if desired.
+ * @return envoy_status_t, the resulting status of the operation.
+ */
+envoy_status_t run_engine(envoy_engine_t engine,
+                          std::unique_ptr<envoy::config::bootstrap::v3::Bootstrap> bootstrap,
+                          const char* log_level, const char* admin_path);
 #endif
@@ -8,8 +8,12 @@
 #include "source/common/common/assert.h"
 #include "source/common/common/scalar_to_byte_vector.h"
 #include "source/common/common/utility.h"
+#include "source/common/http/header_map_impl.h"
+#include "source/common/http/utility.h"
 #include "source/common/network/addr_family_aware_socket_option_impl.h"
 #include "source/common/network/address_impl.h"
+#include "source/common/network/transport_socket_options_impl.h"
+#include "source/common/upstream/load_balancer_impl.h"
 #include "source/extensions/common/dynamic_forward_proxy/dns_cache_manager_impl.h"
 
 #include "fmt/ostream.h"
@@ -71,12 +75,61 @@ SINGLETON_MANAGER_REGISTRATION(connectivity_manager);
 
 constexpr absl::string_view BaseDnsCache = "base_dns_cache";
 
+// Preconnect hosts use TLS, and so the HTTPS port by default.
+constexpr uint16_t DefaultPreconnectPort = 443;
+
 // The number of faults allowed on a newly-established connection before switching socket mode.
 constexpr unsigned int InitialFaultThreshold = 1;
 // The number of faults allowed on a previously-successful connection (i.e. able to send and receive
 // L7 bytes) before switching socket mode.
 constexpr unsigned int MaxFaultThreshold = 3;
 
+namespace {
+
+absl::string_view preconnectCluster(envoy_preconnect_protocol_t protocol) {
+  // These match the clusters Http::Client routes requests to by upstream protocol.
+  switch (protocol) {
+  case ENVOY_PRECONNECT_HTTP2:
+    return "base_h2";
+  case ENVOY_PRECONNECT_HTTP3:
+    return "base_h3";
+  case ENVOY_PRECONNECT_ALPN:
+    break;
+  }
+  return "base";
+}
+
+/**
+ * Selects the same host and connection pool as requests to the authority: the dynamic forward
+ * proxy clusters pick the host by the request's authority, and connection pools are keyed by the
+ * upstream socket options and the SNI set by auto_sni.
+ */
+class PreconnectLoadBalancerContext : public Upstream::LoadBalancerContextBase {
+public:
+  PreconnectLoadBalancerContext(absl::string_view authority, Socket::OptionsSharedPtr options)
+      : headers_(Http::RequestHeaderMapImpl::create()), options_(std::move(options)) {
+    headers_->setHost(authority);
+    headers_->setScheme(Http::Headers::get().SchemeValues.Https);
+    const std::string host(Http::Utility::parseAuthority(authority).host_);
+    transport_socket_options_ = std::make_shared<TransportSocketOptionsImpl>(
+        host, std::vector<std::string>{host});
+  }
+
+  // Upstream::LoadBalancerContext
+  const Http::RequestHeaderMap* downstreamHeaders() const override { return headers_.get(); }
+  Socket::OptionsSharedPtr upstreamSocketOptions() const override { return options_; }
+  TransportSocketOptionsConstSharedPtr upstreamTransportSocketOptions() const override {
+    return transport_socket_options_;
+  }
+
+private:
+  Http::RequestHeaderMapPtr headers_;
+  const Socket::OptionsSharedPtr options_;
+  TransportSocketOptionsConstSharedPtr transport_socket_options_;
+};
+
+} // namespace
+
 ConnectivityManagerImpl::NetworkState ConnectivityManagerImpl::network_state_{
     1, ENVOY_NET_GENERIC, MaxFaultThreshold, DefaultPreferredNetworkMode,
     Thread::MutexBasicLockable{}};
@@ -220,6 +273,11 @@ void ConnectivityManagerImpl::onDnsResolutionComplete(
     // Pass predicate to only drain connections to the resolved host (for any cluster).
     cluster_manager_.drainConnections(
         [resolved_host](const Upstream::Host& host) { return host.hostname() == resolved_host; });
+
+    // Connections to preconnect hosts are established again on the current network.
+    if (preconnect_hosts_.contains(resolved_host)) {
+      establishConnections(resolved_host);
+    }
   }
 }
 
@@ -269,6 +327,14 @@ void ConnectivityManagerImpl::refreshDns(envoy_netconf_t configuration_key,
     }
 
     dns_cache->forceRefreshHosts();
+
+    // Connections are pooled per network, so preconnect hosts are connected to again on the
+    // current one. Hosts whose connections will be drained are connected to once that's done.
+    for (const auto& [dns_host, hosts] : preconnect_hosts_) {
+      if (!hosts_to_drain_.contains(dns_host)) {
+        warmConnections(dns_host);
+      }
+    }
   }
 }
 
@@ -292,6 +358,100 @@ void ConnectivityManagerImpl::resetConnectivityState() {
   refreshDns(configuration_key, true);
 }
 
+void ConnectivityManagerImpl::preconnect(absl::string_view authority,
+                                         envoy_preconnect_protocol_t protocol,
+                                         uint32_t connections) {
+  if (connections == 0) {
+    return;
+  }
+
+  // Requests' authorities are normalized by the DNS cache in the same way.
+  std::string dns_host(authority);
+  if (!Http::Utility::parseAuthority(authority).port_.has_value()) {
+    absl::StrAppend(&dns_host, ":", DefaultPreconnectPort);
+  }
+
+  auto& hosts = preconnect_hosts_[dns_host];
+  auto it = std::find_if(hosts.begin(), hosts.end(), [&](const PreconnectHost& host) {
+    return host.authority_ == authority && host.protocol_ == protocol;
+  });
+  if (it != hosts.end()) {
+    it->connections_ = connections;
+  } else {
+    hosts.push_back({std::string(authority), protocol, connections});
+  }
+
+  ENVOY_LOG_EVENT(debug, "netconf_preconnect", dns_host);
+  warmConnections(dns_host);
+}
+
+void ConnectivityManagerImpl::warmConnections(const std::string& dns_host) {
+  auto dns_cache = dnsCache();
+  if (!dns_cache) {
+    return;
+  }
+
+  // Only hosts the DNS cache has resolved are known to the dynamic forward proxy clusters.
+  auto pending = std::make_unique<PendingPreconnect>(*this, dns_host);
+  auto result = dns_cache->loadDnsCacheEntry(dns_host, DefaultPreconnectPort, false, *pending);
+  switch (result.status_) {
+  case Extensions::Common::DynamicForwardProxy::DnsCache::LoadDnsCacheEntryStatus::InCache:
+    establishConnections(dns_host);
+    break;
+  case Extensions::Common::DynamicForwardProxy::DnsCache::LoadDnsCacheEntryStatus::Loading:
+    // Replacing a pending preconnect for the host cancels its callback, not its resolution.
+    pending->handle_ = std::move(result.handle_);
+    pending_preconnects_[dns_host] = std::move(pending);
+    break;
+  case Extensions::Common::DynamicForwardProxy::DnsCache::LoadDnsCacheEntryStatus::Overflow:
+    ENVOY_LOG_EVENT(debug, "netconf_preconnect_dns_overflow", dns_host);
+    break;
+  }
+}
+
+void ConnectivityManagerImpl::onPreconnectResolved(const std::string& dns_host) {
+  // The pending preconnect, whose host this references, is destroyed once it is no longer used.
+  auto it = pending_preconnects_.find(dns_host);
+  ASSERT(it != pending_preconnects_.end());
+  std::unique_ptr<PendingPreconnect> pending = std::move(it->second);
+  pending_preconnects_.erase(it);
+  establishConnections(pending->dnsHost());
+}
+
+void ConnectivityManagerImpl::establishConnections(const std::string& dns_host) {
+  auto it = preconnect_hosts_.find(dns_host);
+  if (it == preconnect_hosts_.end()) {
+    return;
+  }
+
+  for (const PreconnectHost& host : it->second) {
+    auto* cluster = cluster_manager_.getThreadLocalCluster(preconnectCluster(host.protocol_));
+    if (cluster == nullptr) {
+      ENVOY_LOG_EVENT(debug, "netconf_preconnect_cluster_missing",
+                      std::string(preconnectCluster(host.protocol_)));
+      continue;
+    }
+
+    auto options = std::make_shared<Socket::Options>();
+    addUpstreamSocketOptions(options);
+    PreconnectLoadBalancerContext context(host.authority_, std::move(options));
+    auto pool = cluster->httpConnPool(Upstream::ResourcePriority::Default, absl::nullopt, &context);
+    if (!pool.has_value()) {
+      ENVOY_LOG_EVENT(debug, "netconf_preconnect_host_missing", host.authority_);
+      continue;
+    }
+
+    // Each call establishes a connection while the pool's connections could carry fewer streams
+    // than requested, so HTTP/1 pools get one connection per stream, while a single multiplexed
+    // connection suffices.
+    for (uint32_t i = 0; i < host.connections_; ++i) {
+      if (!pool->maybePreconnect(host.connections_)) {
+        break;
+      }
+    }
+  }
+}
+
 std::vector<InterfacePair> ConnectivityManagerImpl::enumerateV4Interfaces() {
   return enumerateInterfaces(AF_INET, 0, 0);
 }
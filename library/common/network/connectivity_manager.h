@@ -165,6 +165,17 @@ public:
    */
   virtual void resetConnectivityState() PURE;
 
+  /**
+   * Establish idle connections to a host ahead of requests to it, once its address is resolved.
+   * The host is remembered, and connections to it are established again after DNS refreshes
+   * triggered by network changes. May be no-op.
+   * @param authority, the host, and optionally port, to connect to.
+   * @param protocol, the upstream protocol requests to the host will use.
+   * @param connections, the number of connections to establish.
+   */
+  virtual void preconnect(absl::string_view authority, envoy_preconnect_protocol_t protocol,
+                          uint32_t connections) PURE;
+
   /**
    * @returns the current socket options that should be used for connections.
    */
@@ -227,11 +238,16 @@ public:
   void setInterfaceBindingEnabled(bool enabled) override;
   void refreshDns(envoy_netconf_t configuration_key, bool drain_connections) override;
   void resetConnectivityState() override;
+  void preconnect(absl::string_view authority, envoy_preconnect_protocol_t protocol,
+                  uint32_t connections) override;
   Socket::OptionsSharedPtr getUpstreamSocketOptions(envoy_network_t network,
                                                     envoy_socket_mode_t socket_mode) override;
   envoy_netconf_t addUpstreamSocketOptions(Socket::OptionsSharedPtr options) override;
   Extensions::Common::DynamicForwardProxy::DnsCacheSharedPtr dnsCache() override;
 
+  // The number of preconnect hosts whose DNS resolution is awaited.
+  size_t pendingPreconnects() const { return pending_preconnects_.size(); }
+
 private:
   struct NetworkState {
     // The configuration key is passed through calls dispatched on the run loop to determine if
@@ -242,12 +258,47 @@ private:
     envoy_socket_mode_t socket_mode_ ABSL_GUARDED_BY(mutex_);
     Thread::MutexBasicLockable mutex_;
   };
+  struct PreconnectHost {
+    std::string authority_;
+    envoy_preconnect_protocol_t protocol_;
+    uint32_t connections_;
+  };
+  // Establishes connections once a preconnect host's DNS resolution completes.
+  class PendingPreconnect
+      : public Extensions::Common::DynamicForwardProxy::DnsCache::LoadDnsCacheEntryCallbacks {
+  public:
+    PendingPreconnect(ConnectivityManagerImpl& parent, std::string dns_host)
+        : parent_(parent), dns_host_(std::move(dns_host)) {}
+
+    // LoadDnsCacheEntryCallbacks
+    void onLoadDnsCacheComplete(
+        const Extensions::Common::DynamicForwardProxy::DnsHostInfoSharedPtr&) override {
+      parent_.onPreconnectResolved(dns_host_);
+    }
+
+    const std::string& dnsHost() const { return dns_host_; }
+
+    Extensions::Common::DynamicForwardProxy::DnsCache::LoadDnsCacheEntryHandlePtr handle_;
+
+  private:
+    ConnectivityManagerImpl& parent_;
+    const std::string dns_host_;
+  };
+
   Socket::OptionsSharedPtr getAlternateInterfaceSocketOptions(envoy_network_t network);
   InterfacePair getActiveAlternateInterface(envoy_network_t network, unsigned short family);
+  // Resolves a preconnect host, if needed, and establishes connections to it.
+  void warmConnections(const std::string& dns_host);
+  void establishConnections(const std::string& dns_host);
+  // Establishes connections to a host whose resolution was awaited, and stops awaiting it.
+  void onPreconnectResolved(const std::string& dns_host);
 
   bool enable_drain_post_dns_refresh_{false};
   bool enable_interface_binding_{false};
   absl::flat_hash_set<std::string> hosts_to_drain_;
+  // Keyed by the DNS cache's name for the host, which includes the port.
+  absl::flat_hash_map<std::string, std::vector<PreconnectHost>> preconnect_hosts_;
+  absl::flat_hash_map<std::string, std::unique_ptr<PendingPreconnect>> pending_preconnects_;
   Extensions::Common::DynamicForwardProxy::DnsCache::AddUpdateCallbacksHandlePtr
       dns_callbacks_handle_{nullptr};
   Upstream::ClusterManager& cluster_manager_;
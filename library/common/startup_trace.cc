@@ -0,0 +1,130 @@
+#include "library/common/startup_trace.h"
+
+#include <chrono>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "library/common/bridge/utility.h"
+
+namespace Envoy {
+
+namespace {
+
+// Indexed by StartupPhase.
+constexpr absl::string_view PhaseNames[] = {
+    "log_delegate", "engine_common", "server_init", "first_dns_resolution", "post_init", "drain",
+};
+static_assert(std::size(PhaseNames) == static_cast<size_t>(StartupPhase::Drain) + 1);
+
+uint64_t microseconds(MonotonicTime::duration duration) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+
+} // namespace
+
+StartupTrace::StartupTrace(TimeSource& time_source)
+    : time_source_(time_source), start_(time_source.monotonicTime()) {}
+
+void StartupTrace::begin(StartupPhase phase) {
+  phases_[static_cast<size_t>(phase)].start_ = time_source_.monotonicTime();
+}
+
+void StartupTrace::end(StartupPhase phase) {
+  Phase& traced = phases_[static_cast<size_t>(phase)];
+  if (traced.start_.has_value() && !traced.end_.has_value()) {
+    traced.end_ = time_source_.monotonicTime();
+  }
+}
+
+void StartupTrace::traceDnsResolution(
+    Extensions::Common::DynamicForwardProxy::DnsCache& dns_cache) {
+  begin(StartupPhase::FirstDnsResolution);
+  dns_callbacks_ = dns_cache.addUpdateCallbacks(*this);
+}
+
+void StartupTrace::onDnsResolutionComplete(
+    const std::string&, const Extensions::Common::DynamicForwardProxy::DnsHostInfoSharedPtr&,
+    Network::DnsResolver::ResolutionStatus) {
+  // The callbacks are left registered, as they can't be removed while the cache calls them. Only
+  // the first resolution is traced.
+  const Phase& dns = phases_[static_cast<size_t>(StartupPhase::FirstDnsResolution)];
+  if (dns.end_.has_value()) {
+    return;
+  }
+  end(StartupPhase::FirstDnsResolution);
+  if (stats_ != nullptr) {
+    reportDnsResolution();
+  }
+}
+
+void StartupTrace::onEngineRunning(Stats::Scope& scope, envoy_event_tracker event_tracker) {
+  if (stats_ != nullptr) {
+    return;
+  }
+  running_ = time_source_.monotonicTime();
+  stats_ = std::make_unique<StartupStats>(
+      StartupStats{ALL_STARTUP_STATS(POOL_GAUGE_PREFIX(scope, "startup."))});
+  event_tracker_ = event_tracker;
+  report();
+}
+
+void StartupTrace::report() {
+  const auto set = [this](Stats::Gauge& gauge, StartupPhase phase) {
+    absl::optional<uint64_t> duration = durationUs(phase);
+    if (duration.has_value()) {
+      gauge.set(duration.value());
+    }
+  };
+  set(stats_->log_delegate_us_, StartupPhase::LogDelegate);
+  set(stats_->engine_common_us_, StartupPhase::EngineCommon);
+  set(stats_->server_init_us_, StartupPhase::ServerInit);
+  set(stats_->first_dns_resolution_us_, StartupPhase::FirstDnsResolution);
+  set(stats_->post_init_us_, StartupPhase::PostInit);
+  set(stats_->drain_us_, StartupPhase::Drain);
+  stats_->total_us_.set(microseconds(running_.value() - start_));
+  track(event());
+}
+
+void StartupTrace::reportDnsResolution() {
+  const size_t index = static_cast<size_t>(StartupPhase::FirstDnsResolution);
+  const uint64_t duration = durationUs(StartupPhase::FirstDnsResolution).value();
+  stats_->first_dns_resolution_us_.set(duration);
+  track({{"name", "startup_first_dns_resolution"},
+         {absl::StrCat(PhaseNames[index], "_start_us"),
+          absl::StrCat(microseconds(phases_[index].start_.value() - start_))},
+         {absl::StrCat(PhaseNames[index], "_us"), absl::StrCat(duration)}});
+}
+
+void StartupTrace::track(const std::vector<std::pair<std::string, std::string>>& event) {
+  ENVOY_LOG(debug, "startup: {}", absl::StrJoin(event, ", ", absl::PairFormatter("=")));
+  if (event_tracker_.track != nullptr) {
+    event_tracker_.track(Bridge::Utility::makeEnvoyMap(event), event_tracker_.context);
+  }
+}
+
+absl::optional<uint64_t> StartupTrace::durationUs(StartupPhase phase) const {
+  const Phase& traced = phases_[static_cast<size_t>(phase)];
+  if (!traced.end_.has_value()) {
+    return absl::nullopt;
+  }
+  return microseconds(traced.end_.value() - traced.start_.value());
+}
+
+std::vector<std::pair<std::string, std::string>> StartupTrace::event() const {
+  std::vector<std::pair<std::string, std::string>> startup_event = {{"name", "startup"}};
+  for (size_t i = 0; i < phases_.size(); i++) {
+    absl::optional<uint64_t> duration = durationUs(static_cast<StartupPhase>(i));
+    if (!duration.has_value()) {
+      continue;
+    }
+    startup_event.emplace_back(absl::StrCat(PhaseNames[i], "_start_us"),
+                               absl::StrCat(microseconds(phases_[i].start_.value() - start_)));
+    startup_event.emplace_back(absl::StrCat(PhaseNames[i], "_us"), absl::StrCat(*duration));
+  }
+  if (running_.has_value()) {
+    startup_event.emplace_back("total_us", absl::StrCat(microseconds(running_.value() - start_)));
+  }
+  return startup_event;
+}
+
+} // namespace Envoy
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "envoy/common/time.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "source/common/common/logger.h"
+#include "source/extensions/common/dynamic_forward_proxy/dns_cache.h"
+
+#include "absl/types/optional.h"
+#include "library/common/types/c_types.h"
+
+namespace Envoy {
+
+/**
+ * The duration of each phase of the engine's startup, and of the startup as a whole, in
+ * microseconds.
+ */
+#define ALL_STARTUP_STATS(GAUGE)                                                                   \
+  GAUGE(drain_us, NeverImport)                                                                     \
+  GAUGE(engine_common_us, NeverImport)                                                             \
+  GAUGE(first_dns_resolution_us, NeverImport)                                                      \
+  GAUGE(log_delegate_us, NeverImport)                                                              \
+  GAUGE(post_init_us, NeverImport)                                                                 \
+  GAUGE(server_init_us, NeverImport)                                                               \
+  GAUGE(total_us, NeverImport)
+
+struct StartupStats {
+  ALL_STARTUP_STATS(GENERATE_GAUGE_STRUCT)
+};
+
+/**
+ * The phases of the engine's startup, from run_engine() to on_engine_running.
+ */
+enum class StartupPhase {
+  // Setting up the log delegate.
+  LogDelegate,
+  // Constructing EngineCommon, which parses the options and constructs the server.
+  EngineCommon,
+  // Initializing the server and warming its clusters, until the HTTP client is set up. In early
+  // drain mode that's as soon as the main dispatcher runs, whether or not the clusters are warm.
+  ServerInit,
+  // From when the server is constructed until the DNS cache first completes a resolution.
+  FirstDnsResolution,
+  // Setting up the engine's HTTP client, at PostInit or, in early drain mode, at StartUp.
+  PostInit,
+  // Draining the calls dispatched before the engine was running.
+  Drain,
+};
+
+/**
+ * Times the phases of the engine's startup, with monotonic time, and reports them once the engine
+ * is running: as a single "startup" event to the event tracker, and as gauges under "startup.".
+ *
+ * The DNS cache's first resolution may complete after the engine is running, e.g. when no hosts
+ * are preresolved. It's then left out of the startup event, and reported once it completes as a
+ * separate "startup_first_dns_resolution" event and the "startup.first_dns_resolution_us" gauge.
+ * Must be used on the engine's main thread.
+ */
+class StartupTrace : public Extensions::Common::DynamicForwardProxy::DnsCache::UpdateCallbacks,
+                     public Logger::Loggable<Logger::Id::main> {
+public:
+  /**
+   * Starts the trace, which the phases' starts are measured from.
+   * @param time_source, the source of the monotonic time the phases are measured with.
+   */
+  explicit StartupTrace(TimeSource& time_source);
+
+  /**
+   * Records the start of a phase.
+   */
+  void begin(StartupPhase phase);
+
+  /**
+   * Records the end of a phase. Phases which have already ended are not changed.
+   */
+  void end(StartupPhase phase);
+
+  /**
+   * Begins the FirstDnsResolution phase, which ends once the DNS cache completes a resolution.
+   * @param dns_cache, the cache to watch, which must outlive the trace.
+   */
+  void traceDnsResolution(Extensions::Common::DynamicForwardProxy::DnsCache& dns_cache);
+
+  /**
+   * Ends the startup and reports it, along with the first DNS resolution if it has completed.
+   * @param scope, the scope the gauges are created in, which must outlive the trace.
+   * @param event_tracker, the tracker the events are emitted to, if it tracks events.
+   */
+  void onEngineRunning(Stats::Scope& scope, envoy_event_tracker event_tracker);
+
+  /**
+   * @return the startup event. For each phase which ended, e.g. "drain", it holds the phase's
+   *         start relative to the trace's start, as "drain_start_us", and its duration, as
+   *         "drain_us". The startup's duration is held as "total_us" once the engine is running.
+   */
+  std::vector<std::pair<std::string, std::string>> event() const;
+
+  // Extensions::Common::DynamicForwardProxy::DnsCache::UpdateCallbacks
+  void onDnsHostAddOrUpdate(
+      const std::string& /*host*/,
+      const Extensions::Common::DynamicForwardProxy::DnsHostInfoSharedPtr&) override {}
+  void onDnsHostRemove(const std::string& /*host*/) override {}
+  void onDnsResolutionComplete(const std::string& /*host*/,
+                               const Extensions::Common::DynamicForwardProxy::DnsHostInfoSharedPtr&,
+                               Network::DnsResolver::ResolutionStatus) override;
+
+private:
+  struct Phase {
+    absl::optional<MonotonicTime> start_;
+    absl::optional<MonotonicTime> end_;
+  };
+
+  void report();
+  void reportDnsResolution();
+  void track(const std::vector<std::pair<std::string, std::string>>& event);
+  absl::optional<uint64_t> durationUs(StartupPhase phase) const;
+
+  TimeSource& time_source_;
+  const MonotonicTime start_;
+  absl::optional<MonotonicTime> running_;
+  std::array<Phase, static_cast<size_t>(StartupPhase::Drain) + 1> phases_;
+  Extensions::Common::DynamicForwardProxy::DnsCache::AddUpdateCallbacksHandlePtr dns_callbacks_;
+  // Set once the engine is running and the startup has been reported.
+  std::unique_ptr<StartupStats> stats_;
+  envoy_event_tracker event_tracker_{};
+};
+
+using StartupTracePtr = std::unique_ptr<StartupTrace>;
+
+} // namespace Envoy
@@ -0,0 +1,13 @@
+#include "library/common/stream_info/shared_response.h"
+
+#include "source/common/common/macros.h"
+
+namespace Envoy {
+namespace StreamInfo {
+
+const std::string& SharedResponse::key() {
+  CONSTRUCT_ON_FIRST_USE(std::string, "envoy_mobile.shared_response");
+}
+
+} // namespace StreamInfo
+} // namespace Envoy
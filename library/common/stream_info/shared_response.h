@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+
+#include "envoy/common/pure.h"
+#include "envoy/stream_info/filter_state.h"
+
+namespace Envoy {
+namespace StreamInfo {
+
+/**
+ * Filter state set by filters which share a stream's response with other streams, e.g. the single
+ * flight filter.
+ *
+ * When the platform cancels a stream whose response is shared, the Http::Client detaches the
+ * stream rather than resetting it: the platform is told the stream is cancelled and receives no
+ * further callbacks for it, but the request runs on for the streams sharing its response. The
+ * filter resets the stream once its response is no longer shared, if it hasn't ended by then.
+ */
+class SharedResponse : public FilterState::Object {
+public:
+  static const std::string& key();
+
+  /**
+   * @return bool, whether other streams currently share the stream's response.
+   */
+  virtual bool shared() const PURE;
+
+  /**
+   * Called when the platform has cancelled the stream and it has been detached.
+   */
+  virtual void onDetached() PURE;
+};
+
+} // namespace StreamInfo
+} // namespace Envoy
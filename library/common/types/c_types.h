@@ -73,6 +73,31 @@ typedef enum {
   ENVOY_NET_WWAN = 2,
 } envoy_network_t;
 
+/**
+ * Priority classes for HTTP streams. High and low priority requests carry an RFC 9218 priority
+ * header, which HTTP/2 and HTTP/3 servers may use to schedule responses. Low priority streams are
+ * also held back by the engine while high priority streams are awaiting their response headers, for
+ * up to 30 seconds.
+ */
+typedef enum {
+  ENVOY_STREAM_PRIORITY_NORMAL = 0,
+  // For user-visible requests.
+  ENVOY_STREAM_PRIORITY_HIGH = 1,
+  // For background requests, e.g. analytics uploads.
+  ENVOY_STREAM_PRIORITY_LOW = 2,
+} envoy_stream_priority_t;
+
+/**
+ * Upstream protocols which connections may be established for ahead of requests. Each matches the
+ * x-envoy-mobile-upstream-protocol requests to the host will be sent with.
+ */
+typedef enum {
+  // TLS, negotiating the protocol with ALPN, as requests are sent by default.
+  ENVOY_PRECONNECT_ALPN = 0,
+  ENVOY_PRECONNECT_HTTP2 = 1,
+  ENVOY_PRECONNECT_HTTP3 = 2,
+} envoy_preconnect_protocol_t;
+
 // The name used to registered event tracker api.
 extern const char* envoy_event_tracker_api_name;
 
@@ -220,8 +245,47 @@ typedef struct {
   // Http2 == 2
   // Http3 == 3
   int64_t upstream_protocol;
+  // The time the stream was held back by the engine's priority scheduler before its request was
+  // sent upstream, in ms. 0 if the stream was not held.
+  uint64_t queueing_delay_ms;
 } envoy_final_stream_intel;
 
+/**
+ * Options applied to a stream when it is started. Zero-initialized options select the defaults.
+ */
+typedef struct {
+  // Whether to enable explicit flow control on the response stream.
+  bool explicit_flow_control;
+  // The maximum number of bytes buffered for the stream, or 0 to use the engine's default. The
+  // engine may lower the limit while its memory budget for buffered data is in use.
+  uint32_t buffer_limit_bytes;
+  // With explicit flow control, whether each read_data call extends an auto-tuned read window
+  // rather than permitting a single on_data callback. The window grows while the platform keeps
+  // up, so that several chunks are delivered per call, and shrinks when it falls behind.
+  bool auto_tune_read_window;
+  // If non-zero, and the callbacks set on_aggregated_response, responses whose body fits within
+  // this many bytes are delivered whole in a single on_aggregated_response callback. Responses
+  // with larger bodies fall back to streaming. Ignored with explicit flow control.
+  uint32_t aggregate_body_limit_bytes;
+  // The stream's priority class.
+  envoy_stream_priority_t priority;
+  // Whether to write the response body to response_body_fd rather than deliver it via on_data.
+  // The body is written on a background thread, and the stream is read disabled while the writes
+  // fall behind, so that explicit flow control is neither needed nor applied. Headers, trailers
+  // and the terminal callback are delivered as usual, the terminal callback once the body has
+  // been written, and progress via on_response_body_progress.
+  bool write_response_body_to_file;
+  // The file the response body is written to, from its current position. It must be blocking,
+  // and the caller must keep it open until the stream's terminal callback.
+  int response_body_fd;
+  // With write_response_body_to_file, on_response_body_progress is called once at least this
+  // many bytes have been written, or this many milliseconds have passed, since the last call. A
+  // threshold of 0 is disabled, and with both disabled it is called after every write. It is
+  // always called once the whole body has been written.
+  uint32_t response_body_progress_bytes;
+  uint32_t response_body_progress_interval_ms;
+} envoy_stream_options;
+
 #ifdef __cplusplus
 extern "C" { // utility functions
 #endif
@@ -331,6 +395,59 @@ typedef void* (*envoy_on_headers_f)(envoy_headers headers, bool end_stream,
 typedef void* (*envoy_on_data_f)(envoy_data data, bool end_stream, envoy_stream_intel stream_intel,
                                  void* context);
 
+/**
+ * Callback signature for vectored data on an HTTP stream.
+ *
+ * This callback can be invoked multiple times when data is streamed. Each chunk of data is passed
+ * as the sequence of slices in which it was received, without being linearized.
+ *
+ * @param slices, the data received. Ownership of each slice is transferred to the callee, which
+ * must release every slice; the array itself is only valid for the duration of the call.
+ * @param slice_count, the number of slices, which may be zero when only end_stream is signalled.
+ * @param end_stream, whether the data is the last data frame.
+ * @param stream_intel, contains internal stream metrics, context, and other details.
+ * @param context, contains the necessary state to carry out platform-specific dispatch and
+ * execution.
+ * @return void*, return context (may be unused).
+ */
+typedef void* (*envoy_on_data_vectored_f)(const envoy_data* slices, size_t slice_count,
+                                          bool end_stream, envoy_stream_intel stream_intel,
+                                          void* context);
+
+/**
+ * Callback signature for a whole response on an HTTP stream, delivered instead of on_headers,
+ * on_data, on_trailers and on_complete when the response is aggregated.
+ *
+ * This is a terminal callback: no further callbacks are invoked for the stream.
+ *
+ * @param headers, the response headers.
+ * @param body, the response body, which is empty if the response has none.
+ * @param trailers, the response trailers, which are empty if the response has none.
+ * @param stream_intel, contains internal stream metrics, context, and other details.
+ * @param final_stream_intel, contains final internal stream metrics, context, and other details.
+ * @param context, contains the necessary state to carry out platform-specific dispatch and
+ * execution.
+ * @return void*, return context (may be unused).
+ */
+typedef void* (*envoy_on_aggregated_response_f)(envoy_headers headers, envoy_data body,
+                                                envoy_headers trailers,
+                                                envoy_stream_intel stream_intel,
+                                                envoy_final_stream_intel final_stream_intel,
+                                                void* context);
+
+/**
+ * Callback signature for the progress of a response body being written to a file.
+ * @see envoy_stream_options.
+ *
+ * @param bytes_written, the bytes of the body written so far.
+ * @param stream_intel, contains internal stream metrics, context, and other details.
+ * @param context, contains the necessary state to carry out platform-specific dispatch and
+ * execution.
+ * @return void*, return context (may be unused).
+ */
+typedef void* (*envoy_on_response_body_progress_f)(uint64_t bytes_written,
+                                                   envoy_stream_intel stream_intel, void* context);
+
 /**
  * Callback signature for metadata on an HTTP stream.
  *
@@ -475,6 +592,13 @@ typedef struct {
   envoy_on_send_window_available_f on_send_window_available;
   // Context passed through to callbacks to provide dispatch and execution state.
   void* context;
+  // Optional. If set, response data is delivered via this callback instead of on_data.
+  envoy_on_data_vectored_f on_data_vectored;
+  // Optional. If set, and the stream is started with an aggregate body limit, small responses are
+  // delivered whole via this callback. @see envoy_stream_options.
+  envoy_on_aggregated_response_f on_aggregated_response;
+  // Optional. Called as a response body is written to a file. @see envoy_stream_options.
+  envoy_on_response_body_progress_f on_response_body_progress;
 } envoy_http_callbacks;
 
 /**
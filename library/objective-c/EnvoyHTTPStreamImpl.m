@@ -165,7 +165,7 @@ static void *ios_on_error(envoy_error error, envoy_stream_intel stream_intel,
   envoy_http_callbacks native_callbacks = {
       ios_on_headers, ios_on_data,     ios_on_metadata, ios_on_trailers,
       ios_on_error,   ios_on_complete, ios_on_cancel,   ios_on_send_window_available,
-      context};
+      context,        NULL,            NULL};
   _nativeCallbacks = native_callbacks;
 
   _engineHandle = engineHandle;
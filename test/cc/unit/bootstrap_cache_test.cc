@@ -0,0 +1,82 @@
+#include <string>
+
+#include "envoy/config/bootstrap/v3/bootstrap.pb.h"
+
+#include "test/test_common/utility.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "gtest/gtest.h"
+#include "library/cc/bootstrap_cache.h"
+#include "library/cc/engine_builder.h"
+
+namespace Envoy {
+namespace Platform {
+namespace {
+
+class TestKeyValueStore : public KeyValueStore {
+public:
+  absl::optional<std::string> read(const std::string& key) override {
+    auto it = values_.find(key);
+    if (it == values_.end()) {
+      return absl::nullopt;
+    }
+    return it->second;
+  }
+  void save(std::string key, std::string value) override { values_[key] = value; }
+  void remove(const std::string& key) override { values_.erase(key); }
+
+  absl::flat_hash_map<std::string, std::string> values_;
+};
+
+class BootstrapCacheTest : public testing::Test {
+public:
+  BootstrapCacheTest() { bootstrap_.mutable_node()->set_id("node"); }
+
+  std::shared_ptr<TestKeyValueStore> store_{std::make_shared<TestKeyValueStore>()};
+  BootstrapCache cache_{store_};
+  envoy::config::bootstrap::v3::Bootstrap bootstrap_;
+};
+
+TEST_F(BootstrapCacheTest, ReadsSavedBootstrap) {
+  const std::string key = BootstrapCache::key("config");
+  EXPECT_EQ(nullptr, cache_.read(key));
+
+  cache_.save(key, bootstrap_.SerializeAsString());
+  std::unique_ptr<envoy::config::bootstrap::v3::Bootstrap> bootstrap = cache_.read(key);
+  ASSERT_NE(nullptr, bootstrap);
+  EXPECT_TRUE(TestUtility::protoEqual(bootstrap_, *bootstrap));
+}
+
+TEST_F(BootstrapCacheTest, OtherConfigsMiss) {
+  cache_.save(BootstrapCache::key("config"), bootstrap_.SerializeAsString());
+  EXPECT_EQ(nullptr, cache_.read(BootstrapCache::key("other config")));
+
+  // Only the latest bootstrap is kept.
+  cache_.save(BootstrapCache::key("other config"), bootstrap_.SerializeAsString());
+  EXPECT_EQ(nullptr, cache_.read(BootstrapCache::key("config")));
+  EXPECT_NE(nullptr, cache_.read(BootstrapCache::key("other config")));
+  EXPECT_EQ(1, store_->values_.size());
+}
+
+TEST_F(BootstrapCacheTest, UnparseableBootstrapMisses) {
+  const std::string key = BootstrapCache::key("config");
+  cache_.save(key, "not a bootstrap");
+  EXPECT_EQ(nullptr, cache_.read(key));
+}
+
+TEST_F(BootstrapCacheTest, KeyChangesWithBuilderOptions) {
+  EngineBuilder engine_builder;
+  const std::string key = BootstrapCache::key(engine_builder.generateConfigStr());
+  EXPECT_EQ(key, BootstrapCache::key(EngineBuilder().generateConfigStr()));
+
+  engine_builder.addConnectTimeoutSeconds(123);
+  const std::string changed_key = BootstrapCache::key(engine_builder.generateConfigStr());
+  EXPECT_NE(key, changed_key);
+
+  engine_builder.addPlatformFilter("platform_filter");
+  EXPECT_NE(changed_key, BootstrapCache::key(engine_builder.generateConfigStr()));
+}
+
+} // namespace
+} // namespace Platform
+} // namespace Envoy
@@ -0,0 +1,74 @@
+// Compares the cost of producing the engine's bootstrap at startup from the YAML config, which
+// Envoy parses, against building it directly and reading it from a BootstrapCache.
+
+#include "envoy/config/bootstrap/v3/bootstrap.pb.h"
+
+#include "source/common/protobuf/message_validator_impl.h"
+#include "source/common/protobuf/utility.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "benchmark/benchmark.h"
+#include "library/cc/bootstrap_cache.h"
+#include "library/cc/engine_builder.h"
+#include "library/common/config/internal.h"
+
+namespace Envoy {
+namespace Platform {
+namespace {
+
+// Generates the YAML config and loads it, as the server does when run with --config-yaml.
+void bmBootstrapFromYaml(benchmark::State& state) {
+  EngineBuilder engine_builder;
+  for (auto _ : state) { // NOLINT(clang-analyzer-deadcode.DeadStores)
+    envoy::config::bootstrap::v3::Bootstrap bootstrap;
+    MessageUtil::loadFromYaml(absl::StrCat(config_header, engine_builder.generateConfigStr()),
+                              bootstrap, ProtobufMessage::getStrictValidationVisitor());
+    benchmark::DoNotOptimize(bootstrap);
+  }
+}
+BENCHMARK(bmBootstrapFromYaml)->Unit(benchmark::kMillisecond);
+
+// Generates the bootstrap and merges it, as the server does when given it as the config proto.
+void bmBootstrapFromProto(benchmark::State& state) {
+  EngineBuilder engine_builder;
+  for (auto _ : state) { // NOLINT(clang-analyzer-deadcode.DeadStores)
+    envoy::config::bootstrap::v3::Bootstrap bootstrap;
+    bootstrap.MergeFrom(*engine_builder.generateBootstrap());
+    benchmark::DoNotOptimize(bootstrap);
+  }
+}
+BENCHMARK(bmBootstrapFromProto)->Unit(benchmark::kMillisecond);
+
+class InMemoryKeyValueStore : public KeyValueStore {
+public:
+  absl::optional<std::string> read(const std::string& key) override {
+    auto it = values_.find(key);
+    if (it == values_.end()) {
+      return absl::nullopt;
+    }
+    return it->second;
+  }
+  void save(std::string key, std::string value) override { values_[key] = value; }
+  void remove(const std::string& key) override { values_.erase(key); }
+
+private:
+  absl::flat_hash_map<std::string, std::string> values_;
+};
+
+// Hashes the config and reads the bootstrap cached by an earlier launch, as the builder does when
+// given a BootstrapCache.
+void bmBootstrapFromCache(benchmark::State& state) {
+  EngineBuilder engine_builder;
+  BootstrapCache cache(std::make_shared<InMemoryKeyValueStore>());
+  cache.save(BootstrapCache::key(engine_builder.generateConfigStr()),
+             engine_builder.generateBootstrap()->SerializeAsString());
+  for (auto _ : state) { // NOLINT(clang-analyzer-deadcode.DeadStores)
+    auto bootstrap = cache.read(BootstrapCache::key(engine_builder.generateConfigStr()));
+    benchmark::DoNotOptimize(bootstrap);
+  }
+}
+BENCHMARK(bmBootstrapFromCache)->Unit(benchmark::kMillisecond);
+
+} // namespace
+} // namespace Platform
+} // namespace Envoy
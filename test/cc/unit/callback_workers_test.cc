@@ -0,0 +1,93 @@
+#include <thread>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "gtest/gtest.h"
+#include "library/cc/callback_workers.h"
+
+namespace Envoy {
+namespace {
+
+using namespace Platform;
+
+TEST(CallbackWorkersTest, StreamCallbacksRunInOrder) {
+  absl::Mutex mutex;
+  std::vector<int> first_stream;
+  std::vector<int> second_stream;
+  {
+    CallbackWorkers workers(2);
+    for (int i = 0; i < 100; i++) {
+      workers.post(1, [&, i]() {
+        absl::MutexLock lock(&mutex);
+        first_stream.push_back(i);
+      });
+      workers.post(2, [&, i]() {
+        absl::MutexLock lock(&mutex);
+        second_stream.push_back(i);
+      });
+    }
+    // Callbacks already posted are run before the workers stop.
+  }
+
+  std::vector<int> expected;
+  for (int i = 0; i < 100; i++) {
+    expected.push_back(i);
+  }
+  EXPECT_EQ(expected, first_stream);
+  EXPECT_EQ(expected, second_stream);
+}
+
+TEST(CallbackWorkersTest, StreamsSpreadAcrossWorkers) {
+  CallbackWorkers workers(2);
+  EXPECT_EQ(2, workers.size());
+
+  // A callback blocked on one worker does not hold up streams on the other.
+  absl::Notification release;
+  absl::Notification other_ran;
+  std::thread::id blocked_thread;
+  std::thread::id other_thread;
+  workers.post(1, [&]() {
+    blocked_thread = std::this_thread::get_id();
+    release.WaitForNotification();
+  });
+  workers.post(2, [&]() {
+    other_thread = std::this_thread::get_id();
+    other_ran.Notify();
+  });
+  other_ran.WaitForNotification();
+  release.Notify();
+
+  // Streams are mapped to workers by handle.
+  absl::Notification same_worker_ran;
+  std::thread::id same_worker_thread;
+  workers.post(3, [&]() {
+    same_worker_thread = std::this_thread::get_id();
+    same_worker_ran.Notify();
+  });
+  same_worker_ran.WaitForNotification();
+  EXPECT_NE(blocked_thread, other_thread);
+  EXPECT_EQ(blocked_thread, same_worker_thread);
+}
+
+TEST(CallbackWorkersTest, DestroyedFromCallback) {
+  auto workers = std::make_unique<CallbackWorkers>(2);
+  absl::Notification posted;
+  absl::Notification destroyed;
+  absl::Notification next_ran;
+  workers->post(1, [&]() {
+    posted.WaitForNotification();
+    workers.reset();
+    destroyed.Notify();
+  });
+  // Callbacks posted before the workers are destroyed still run, after the one destroying them.
+  workers->post(1, [&]() {
+    EXPECT_TRUE(destroyed.HasBeenNotified());
+    next_ran.Notify();
+  });
+  posted.Notify();
+  next_ran.WaitForNotification();
+}
+
+} // namespace
+} // namespace Envoy
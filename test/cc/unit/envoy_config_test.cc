@@ -1,6 +1,10 @@
+#include <limits>
 #include <string>
 #include <vector>
 
+#include "envoy/extensions/transport_sockets/http_11_proxy/v3/upstream_http_11_connect.pb.h"
+#include "envoy/extensions/transport_sockets/tls/v3/tls.pb.h"
+
 #include "test/test_common/utility.h"
 
 #include "absl/strings/str_replace.h"
@@ -11,6 +15,7 @@
 #include "library/common/api/external.h"
 #include "library/common/config/internal.h"
 #include "library/common/data/utility.h"
+#include "library/common/extensions/cert_validator/root_certificates/root_certificates.pb.h"
 
 #if defined(__APPLE__)
 #include "source/extensions/network/dns_resolver/apple/apple_dns_impl.h"
@@ -58,7 +63,7 @@ TEST(TestConfig, ConfigIsApplied) {
                                            ("- &metadata { device_os: probably-ubuntu-on-CI, "
                                             "app_version: 1.2.3, app_id: 1234-1234-1234 }"),
                                            R"(- &validation_context
-  trusted_ca:)"};
+  custom_validator_config:)"};
   for (const auto& string : must_contain) {
     ASSERT_NE(config_str.find(string), std::string::npos) << "'" << string << "' not found";
   }
@@ -125,6 +130,42 @@ TEST(TestConfig, SetSocketTag) {
   ASSERT_THAT(bootstrap.DebugString(), HasSubstr("http.socket_tag.SocketTag"));
 }
 
+TEST(TestConfig, EnableRequestCoalescing) {
+  EngineBuilder engine_builder;
+
+  engine_builder.enableRequestCoalescing(false);
+  std::string config_str = engine_builder.generateConfigStr();
+  envoy::config::bootstrap::v3::Bootstrap bootstrap;
+  TestUtility::loadFromYaml(absl::StrCat(config_header, config_str), bootstrap);
+  ASSERT_THAT(bootstrap.DebugString(), Not(HasSubstr("http.single_flight.SingleFlight")));
+
+  engine_builder.enableRequestCoalescing(true);
+  config_str = engine_builder.generateConfigStr();
+  TestUtility::loadFromYaml(absl::StrCat(config_header, config_str), bootstrap);
+  ASSERT_THAT(bootstrap.DebugString(), HasSubstr("http.single_flight.SingleFlight"));
+}
+
+TEST(TestConfig, EnableResponseCache) {
+  EngineBuilder engine_builder;
+
+  std::string config_str = engine_builder.generateConfigStr();
+  envoy::config::bootstrap::v3::Bootstrap bootstrap;
+  TestUtility::loadFromYaml(absl::StrCat(config_header, config_str), bootstrap);
+  ASSERT_THAT(bootstrap.DebugString(), Not(HasSubstr("MobileHttpCacheConfig")));
+
+  engine_builder.enableResponseCache(true, 1024 * 1024);
+  config_str = engine_builder.generateConfigStr();
+  ASSERT_THAT(config_str, HasSubstr("&response_cache_max_memory_bytes 1048576"));
+  TestUtility::loadFromYaml(absl::StrCat(config_header, config_str), bootstrap);
+  ASSERT_THAT(bootstrap.DebugString(), HasSubstr("MobileHttpCacheConfig"));
+  ASSERT_THAT(bootstrap.DebugString(), Not(HasSubstr("PlatformKeyValueStoreConfig")));
+
+  engine_builder.enableResponseCache(true, 1024 * 1024, true);
+  config_str = engine_builder.generateConfigStr();
+  TestUtility::loadFromYaml(absl::StrCat(config_header, config_str), bootstrap);
+  ASSERT_THAT(bootstrap.DebugString(), HasSubstr("PlatformKeyValueStoreConfig"));
+}
+
 TEST(TestConfig, SetAltSvcCache) {
   EngineBuilder engine_builder;
 
@@ -165,6 +206,42 @@ TEST(TestConfig, PerTryIdleTimeout) {
   TestUtility::loadFromYaml(absl::StrCat(config_header, config_str), bootstrap);
 }
 
+TEST(TestConfig, BufferLimits) {
+  EngineBuilder engine_builder;
+
+  std::string config_str = engine_builder.generateConfigStr();
+  ASSERT_THAT(config_str, HasSubstr("&stream_buffer_limit 1024000"));
+  ASSERT_THAT(config_str, HasSubstr("&stream_buffer_budget 0"));
+  ASSERT_THAT(config_str, HasSubstr("&per_connection_buffer_limit 10485760"));
+  envoy::config::bootstrap::v3::Bootstrap bootstrap;
+  TestUtility::loadFromYaml(absl::StrCat(config_header, config_str), bootstrap);
+
+  engine_builder.setStreamBufferLimitBytes(65536)
+      .setStreamBufferMemoryBudgetBytes(8388608)
+      .setPerConnectionBufferLimitBytes(131072);
+  config_str = engine_builder.generateConfigStr();
+  ASSERT_THAT(config_str, HasSubstr("&stream_buffer_limit 65536"));
+  ASSERT_THAT(config_str, HasSubstr("&stream_buffer_budget 8388608"));
+  ASSERT_THAT(config_str, HasSubstr("&per_connection_buffer_limit 131072"));
+  TestUtility::loadFromYaml(absl::StrCat(config_header, config_str), bootstrap);
+  EXPECT_EQ(131072,
+            bootstrap.static_resources().listeners(0).per_connection_buffer_limit_bytes().value());
+}
+
+TEST(TestConfig, CallbackLatencySampleRate) {
+  EngineBuilder engine_builder;
+
+  std::string config_str = engine_builder.generateConfigStr();
+  ASSERT_THAT(config_str, HasSubstr("&callback_latency_sample_rate 1"));
+  envoy::config::bootstrap::v3::Bootstrap bootstrap;
+  TestUtility::loadFromYaml(absl::StrCat(config_header, config_str), bootstrap);
+
+  engine_builder.setCallbackLatencySampleRate(100);
+  config_str = engine_builder.generateConfigStr();
+  ASSERT_THAT(config_str, HasSubstr("&callback_latency_sample_rate 100"));
+  TestUtility::loadFromYaml(absl::StrCat(config_header, config_str), bootstrap);
+}
+
 TEST(TestConfig, EnableAdminInterface) {
   EngineBuilder engine_builder;
 
@@ -207,6 +284,20 @@ TEST(TestConfig, EnableDrainPostDnsRefresh) {
   TestUtility::loadFromYaml(absl::StrCat(config_header, config_str), bootstrap);
 }
 
+TEST(TestConfig, EnableEarlyDrain) {
+  EngineBuilder engine_builder;
+
+  std::string config_str = engine_builder.generateConfigStr();
+  ASSERT_THAT(config_str, HasSubstr("&enable_early_drain false"));
+  envoy::config::bootstrap::v3::Bootstrap bootstrap;
+  TestUtility::loadFromYaml(absl::StrCat(config_header, config_str), bootstrap);
+
+  engine_builder.enableEarlyDrain(true);
+  config_str = engine_builder.generateConfigStr();
+  ASSERT_THAT(config_str, HasSubstr("&enable_early_drain true"));
+  TestUtility::loadFromYaml(absl::StrCat(config_header, config_str), bootstrap);
+}
+
 TEST(TestConfig, EnableH2ExtendKeepaliveTimeout) {
   EngineBuilder engine_builder;
 
@@ -329,7 +420,8 @@ TEST(TestConfig, EnablePlatformCertificatesValidation) {
   TestUtility::loadFromYaml(absl::StrCat(config_header, config_str1), bootstrap);
   ASSERT_THAT(bootstrap.DebugString(),
               Not(HasSubstr("envoy_mobile.cert_validator.platform_bridge_cert_validator")));
-  ASSERT_THAT(bootstrap.DebugString(), HasSubstr("trusted_ca"));
+  ASSERT_THAT(bootstrap.DebugString(),
+              HasSubstr("envoy_mobile.cert_validator.root_certificates_cert_validator"));
 
 #if not defined(__APPLE__)
   engine_builder.enablePlatformCertificatesValidation(true);
@@ -337,13 +429,114 @@ TEST(TestConfig, EnablePlatformCertificatesValidation) {
   TestUtility::loadFromYaml(absl::StrCat(config_header, config_str2), bootstrap);
   ASSERT_THAT(bootstrap.DebugString(),
               HasSubstr("envoy_mobile.cert_validator.platform_bridge_cert_validator"));
-  ASSERT_THAT(bootstrap.DebugString(), Not(HasSubstr("trusted_ca")));
+  ASSERT_THAT(bootstrap.DebugString(),
+              Not(HasSubstr("envoy_mobile.cert_validator.root_certificates_cert_validator")));
 #else
   EXPECT_DEATH(engine_builder.enablePlatformCertificatesValidation(true),
                "Certificates validation using platform provided APIs is not supported in IOS");
 #endif
 }
 
+// Expects the bootstrap to be the config which Envoy would load from the generated YAML.
+void expectBootstrapMatchesConfigStr(const EngineBuilder& engine_builder) {
+  envoy::config::bootstrap::v3::Bootstrap expected;
+  TestUtility::loadFromYaml(absl::StrCat(config_header, engine_builder.generateConfigStr()),
+                            expected);
+  std::unique_ptr<envoy::config::bootstrap::v3::Bootstrap> bootstrap =
+      engine_builder.generateBootstrap();
+
+  // The YAML's static runtime layer has a hex literal which is loaded as a string, so the layers
+  // are compared by value.
+  const ProtobufWkt::Struct& layer = bootstrap->layered_runtime().layers(0).static_layer();
+  const ProtobufWkt::Struct& expected_layer = expected.layered_runtime().layers(0).static_layer();
+  for (const std::string& key : {"envoy", "envoy_mobile"}) {
+    EXPECT_TRUE(TestUtility::protoEqual(expected_layer.fields().at(key), layer.fields().at(key)))
+        << key;
+  }
+  EXPECT_EQ(std::numeric_limits<uint32_t>::max(), layer.fields()
+                                                      .at("overload")
+                                                      .struct_value()
+                                                      .fields()
+                                                      .at("global_downstream_max_connections")
+                                                      .number_value());
+  bootstrap->clear_layered_runtime();
+  expected.clear_layered_runtime();
+
+  EXPECT_TRUE(TestUtility::protoEqual(expected, *bootstrap))
+      << "expected:\n"
+      << expected.DebugString() << "\nactual:\n"
+      << bootstrap->DebugString();
+}
+
+TEST(TestConfig, BootstrapMatchesConfigStr) {
+  EngineBuilder engine_builder;
+  expectBootstrapMatchesConfigStr(engine_builder);
+
+  engine_builder.addGrpcStatsDomain("asdf.fake.website")
+      .addConnectTimeoutSeconds(123)
+      .addDnsRefreshSeconds(456)
+      .addDnsMinRefreshSeconds(567)
+      .addDnsFailureRefreshSeconds(789, 987)
+      .addDnsQueryTimeoutSeconds(321)
+      .addH2ConnectionKeepaliveIdleIntervalMilliseconds(222)
+      .addH2ConnectionKeepaliveTimeoutSeconds(333)
+      .addMaxConnectionsPerHost(16)
+      .addStatsFlushSeconds(654)
+      .addStatsSinks({statsdSinkConfig(1), statsdSinkConfig(2)})
+      .addNativeFilter(
+          "envoy.filters.http.buffer",
+          "{\"@type\":\"type.googleapis.com/envoy.extensions.filters.http.buffer.v3.Buffer\","
+          "\"max_request_bytes\":5242880}")
+      .addPlatformFilter("first_platform_filter")
+      .addPlatformFilter("second_platform_filter")
+      .setAppVersion("version")
+      .setAppId("1234-1234-1234")
+      .setDeviceOs("probably-ubuntu-on-CI")
+      .setStreamIdleTimeoutSeconds(42)
+      .setPerTryIdleTimeoutSeconds(43)
+      .setStreamBufferLimitBytes(65536)
+      .setStreamBufferMemoryBudgetBytes(8388608)
+      .setPerConnectionBufferLimitBytes(131072)
+      .setCallbackLatencySampleRate(100)
+      .enableBrotli(true)
+      .enableSocketTagging(true)
+      .enableRequestCoalescing(true)
+      .enableResponseCache(true, 1024 * 1024, true)
+      .enableAdminInterface(true)
+      .enableHappyEyeballs(false)
+      .enableHttp3(true)
+      .enableInterfaceBinding(true)
+      .enableDrainPostDnsRefresh(true)
+      .enableEarlyDrain(true)
+      .enableH2ExtendKeepaliveTimeout(true)
+      .enforceTrustChainVerification(false);
+  expectBootstrapMatchesConfigStr(engine_builder);
+
+#if not defined(__APPLE__)
+  engine_builder.enablePlatformCertificatesValidation(true);
+  expectBootstrapMatchesConfigStr(engine_builder);
+#endif
+}
+
+TEST(TestConfig, BootstrapTrustsRootCertificates) {
+  EngineBuilder engine_builder;
+  std::unique_ptr<envoy::config::bootstrap::v3::Bootstrap> bootstrap =
+      engine_builder.generateBootstrap();
+  envoy::extensions::transport_sockets::http_11_proxy::v3::Http11ProxyUpstreamTransport proxy;
+  ASSERT_TRUE(bootstrap->static_resources().clusters(1).transport_socket().typed_config().UnpackTo(
+      &proxy));
+  envoy::extensions::transport_sockets::tls::v3::UpstreamTlsContext tls_context;
+  ASSERT_TRUE(proxy.transport_socket().typed_config().UnpackTo(&tls_context));
+
+  // The bundled root certificates are trusted through the validator which compiles them in.
+  const envoy::config::core::v3::TypedExtensionConfig& validator =
+      tls_context.common_tls_context().validation_context().custom_validator_config();
+  EXPECT_EQ("envoy_mobile.cert_validator.root_certificates_cert_validator", validator.name());
+  EXPECT_TRUE(validator.typed_config().Is<envoy_mobile::extensions::cert_validator::
+                                              root_certificates::RootCertificatesCertValidator>());
+  EXPECT_FALSE(tls_context.common_tls_context().validation_context().has_trusted_ca());
+}
+
 // Implementation of StringAccessor which tracks the number of times it was used.
 class TestStringAccessor : public StringAccessor {
 public:
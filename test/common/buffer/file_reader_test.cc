@@ -0,0 +1,79 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "source/common/buffer/buffer_impl.h"
+
+#include "test/test_common/environment.h"
+
+#include "gtest/gtest.h"
+#include "library/common/buffer/file_reader.h"
+
+namespace Envoy {
+namespace Buffer {
+
+class FileReaderTest : public testing::Test {
+public:
+  int openFile(const std::string& contents) {
+    const std::string path =
+        TestEnvironment::writeStringToFileForTest("file_reader_test", contents);
+    return open(path.c_str(), O_RDONLY);
+  }
+};
+
+TEST_F(FileReaderTest, ReadsRangeInChunks) {
+  FileReader reader(openFile("0123456789abcdefghij"), 3, 15);
+  EXPECT_EQ(15, reader.remaining());
+
+  OwnedImpl buffer;
+  ASSERT_TRUE(reader.read(buffer, 8));
+  EXPECT_EQ("3456789a", buffer.toString());
+  EXPECT_EQ(7, reader.remaining());
+
+  // Chunks are added after those not yet drained.
+  ASSERT_TRUE(reader.read(buffer, 8));
+  EXPECT_EQ("3456789abcdefghi", buffer.toString());
+  EXPECT_EQ(0, reader.remaining());
+
+  // Nothing is left to read.
+  ASSERT_TRUE(reader.read(buffer, 8));
+  EXPECT_EQ(15, buffer.length());
+  buffer.drain(buffer.length());
+}
+
+TEST_F(FileReaderTest, ChunksOutliveReader) {
+  OwnedImpl buffer;
+  {
+    FileReader reader(openFile("file contents"), 0, 13);
+    ASSERT_TRUE(reader.read(buffer, 64));
+  }
+  EXPECT_EQ("file contents", buffer.toString());
+}
+
+TEST_F(FileReaderTest, RangePastEndOfFileFails) {
+  FileReader reader(openFile("short"), 2, 10);
+  OwnedImpl buffer;
+  EXPECT_FALSE(reader.read(buffer, 64));
+  EXPECT_EQ(0, buffer.length());
+}
+
+TEST_F(FileReaderTest, ReadsPipes) {
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  ASSERT_EQ(10, write(fds[1], "pipe bytes", 10));
+  close(fds[1]);
+
+  // Pipes are read from their current position, whatever the offset.
+  FileReader reader(fds[0], 100, 10);
+  OwnedImpl buffer;
+  while (reader.remaining() > 0) {
+    ASSERT_TRUE(reader.read(buffer, 4));
+  }
+  EXPECT_EQ("pipe bytes", buffer.toString());
+
+  // The pipe ending before the range does is an error.
+  FileReader short_reader(dup(fds[0]), 0, 1);
+  EXPECT_FALSE(short_reader.read(buffer, 4));
+}
+
+} // namespace Buffer
+} // namespace Envoy
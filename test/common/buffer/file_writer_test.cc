@@ -0,0 +1,180 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <thread>
+
+#include "source/common/buffer/buffer_impl.h"
+
+#include "test/common/mocks/event/mocks.h"
+#include "test/test_common/environment.h"
+
+#include "absl/synchronization/mutex.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "library/common/buffer/file_writer.h"
+
+using testing::_;
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Buffer {
+
+class MockFileWriterCallbacks : public FileWriterCallbacks {
+public:
+  MOCK_METHOD(void, onWritten, (uint64_t bytes));
+  MOCK_METHOD(void, onWriteError, (int error));
+};
+
+class FileWriterTest : public testing::Test {
+public:
+  FileWriterTest() {
+    ON_CALL(dispatcher_, post_(_)).WillByDefault([this](std::function<void()>) {
+      absl::MutexLock lock(&mutex_);
+      ++posts_;
+      return ENVOY_SUCCESS;
+    });
+  }
+
+  // Waits for the writer thread to post the given number of callbacks.
+  void waitForPosts(uint32_t posts) {
+    absl::MutexLock lock(&mutex_);
+    const auto posted = [this, posts]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+      return posts_ >= posts;
+    };
+    mutex_.Await(absl::Condition(&posted));
+  }
+
+  // Waits for the given number of callbacks, and runs them as the dispatcher would.
+  void runPosts(uint32_t posts) {
+    waitForPosts(posts);
+    for (auto& callback : dispatcher_.callbacks_) {
+      callback();
+    }
+    dispatcher_.callbacks_.clear();
+  }
+
+  std::string path_{TestEnvironment::temporaryPath("file_writer_test")};
+  NiceMock<Event::MockProvisionalDispatcher> dispatcher_;
+  MockFileWriterCallbacks callbacks_;
+  absl::Mutex mutex_;
+  uint32_t posts_ ABSL_GUARDED_BY(mutex_){};
+  FileWriterThreadSharedPtr thread_{std::make_shared<FileWriterThread>()};
+};
+
+TEST_F(FileWriterTest, WritesInOrder) {
+  const int fd = open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  ASSERT_GE(fd, 0);
+  {
+    FileWriter writer(fd, thread_, dispatcher_, callbacks_);
+
+    // Each slice is written, fragments included.
+    OwnedImpl first("hello ");
+    BufferFragmentImpl fragment("large ", 6, nullptr);
+    first.addBufferFragment(fragment);
+    OwnedImpl second("world");
+    writer.write(first);
+    writer.write(second);
+    EXPECT_EQ(0, first.length());
+    EXPECT_EQ(0, second.length());
+
+    testing::InSequence s;
+    EXPECT_CALL(callbacks_, onWritten(12));
+    EXPECT_CALL(callbacks_, onWritten(5));
+    runPosts(2);
+  }
+  close(fd);
+  EXPECT_EQ("hello large world", TestEnvironment::readFileToStringForTest(path_));
+}
+
+TEST_F(FileWriterTest, WriteErrorStopsWriting) {
+  TestEnvironment::writeStringToFileForTest("file_writer_test", "");
+  const int fd = open(path_.c_str(), O_RDONLY);
+  ASSERT_GE(fd, 0);
+  FileWriter writer(fd, thread_, dispatcher_, callbacks_);
+
+  OwnedImpl data("data");
+  writer.write(data);
+  EXPECT_CALL(callbacks_, onWriteError(EBADF));
+  runPosts(1);
+
+  // Nothing more is written once a write has failed.
+  EXPECT_CALL(callbacks_, onWritten(_)).Times(0);
+  writer.write(data);
+  close(fd);
+}
+
+TEST_F(FileWriterTest, NoCallbacksOnceDestroyed) {
+  const int fd = open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  ASSERT_GE(fd, 0);
+  auto writer = std::make_unique<FileWriter>(fd, thread_, dispatcher_, callbacks_);
+  OwnedImpl data("data");
+  writer->write(data);
+  waitForPosts(1);
+  writer.reset();
+
+  EXPECT_CALL(callbacks_, onWritten(_)).Times(0);
+  runPosts(1);
+  close(fd);
+}
+
+TEST_F(FileWriterTest, WritersShareThread) {
+  const std::string other_path = TestEnvironment::temporaryPath("file_writer_test_other");
+  const int fd = open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  const int other_fd = open(other_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  ASSERT_GE(fd, 0);
+  ASSERT_GE(other_fd, 0);
+  MockFileWriterCallbacks other_callbacks;
+  {
+    FileWriter writer(fd, thread_, dispatcher_, callbacks_);
+    FileWriter other_writer(other_fd, thread_, dispatcher_, other_callbacks);
+    // The writers write to their own duplicates of the files.
+    close(fd);
+    close(other_fd);
+
+    OwnedImpl data("hello");
+    OwnedImpl other_data("world");
+    writer.write(data);
+    other_writer.write(other_data);
+    EXPECT_CALL(callbacks_, onWritten(5));
+    EXPECT_CALL(other_callbacks, onWritten(5));
+    runPosts(2);
+  }
+  EXPECT_EQ("hello", TestEnvironment::readFileToStringForTest(path_));
+  EXPECT_EQ("world", TestEnvironment::readFileToStringForTest(other_path));
+}
+
+TEST_F(FileWriterTest, DroppedPostsReleaseDataOnDispatcherThread) {
+  const int fd = open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  ASSERT_GE(fd, 0);
+  // The dispatcher has terminated.
+  ON_CALL(dispatcher_, post_(_)).WillByDefault([this](std::function<void()>) {
+    absl::MutexLock lock(&mutex_);
+    ++posts_;
+    return ENVOY_FAILURE;
+  });
+  bool released = false;
+  std::thread::id released_on;
+  {
+    FileWriter writer(fd, thread_, dispatcher_, callbacks_);
+    OwnedImpl data("data");
+    data.addDrainTracker([&]() {
+      released = true;
+      released_on = std::this_thread::get_id();
+    });
+    writer.write(data);
+    waitForPosts(1);
+  }
+  // The written data is held by the thread, rather than released with the dropped post.
+  EXPECT_FALSE(released);
+
+  EXPECT_CALL(callbacks_, onWritten(_)).Times(0);
+  thread_.reset();
+  EXPECT_TRUE(released);
+  EXPECT_EQ(std::this_thread::get_id(), released_on);
+  close(fd);
+  EXPECT_EQ("data", TestEnvironment::readFileToStringForTest(path_));
+}
+
+} // namespace Buffer
+} // namespace Envoy
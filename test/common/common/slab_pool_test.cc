@@ -0,0 +1,82 @@
+#include <cstdint>
+#include <set>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "library/common/common/slab_pool.h"
+
+namespace Envoy {
+
+TEST(SlabPoolTest, AllocatesAlignedDistinctBlocks) {
+  SlabPool::Ptr pool = SlabPool::create(24, 4);
+  std::set<void*> blocks;
+  for (int i = 0; i < 10; ++i) {
+    void* block = pool->allocate();
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(block) % alignof(std::max_align_t));
+    EXPECT_TRUE(blocks.insert(block).second);
+  }
+  EXPECT_EQ(10, pool->outstanding());
+  EXPECT_EQ(12, pool->capacity());
+  for (void* block : blocks) {
+    SlabPool::deallocate(block);
+  }
+  EXPECT_EQ(0, pool->outstanding());
+}
+
+TEST(SlabPoolTest, ReusesFreedBlocks) {
+  SlabPool::Ptr pool = SlabPool::create(64, 2);
+  void* first = pool->allocate();
+  SlabPool::deallocate(first);
+  EXPECT_EQ(first, pool->allocate());
+  EXPECT_EQ(2, pool->capacity());
+  SlabPool::deallocate(first);
+}
+
+TEST(SlabPoolTest, OutstandingBlocksOutliveOwner) {
+  std::vector<void*> blocks;
+  {
+    SlabPool::Ptr pool = SlabPool::create(sizeof(uint64_t), 8);
+    for (int i = 0; i < 3; ++i) {
+      blocks.push_back(pool->allocate());
+      *static_cast<uint64_t*>(blocks.back()) = i;
+    }
+  }
+  // The pool stays alive until the last block is returned.
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(i, *static_cast<uint64_t*>(blocks[i]));
+    SlabPool::deallocate(blocks[i]);
+  }
+}
+
+TEST(SlabPoolTest, TrimFreesEmptySlabs) {
+  SlabPool::Ptr pool = SlabPool::create(32, 2);
+  std::vector<void*> blocks;
+  for (int i = 0; i < 6; ++i) {
+    blocks.push_back(pool->allocate());
+  }
+  EXPECT_EQ(6, pool->capacity());
+
+  // The first and last slabs are emptied, in an order unrelated to their blocks' addresses.
+  SlabPool::deallocate(blocks[5]);
+  SlabPool::deallocate(blocks[0]);
+  SlabPool::deallocate(blocks[2]);
+  SlabPool::deallocate(blocks[4]);
+  SlabPool::deallocate(blocks[1]);
+  pool->trim();
+  EXPECT_EQ(2, pool->capacity());
+  EXPECT_EQ(1, pool->outstanding());
+
+  // The remaining free block is reused before a slab is added.
+  EXPECT_EQ(blocks[2], pool->allocate());
+  EXPECT_EQ(2, pool->capacity());
+  SlabPool::deallocate(blocks[2]);
+  SlabPool::deallocate(blocks[3]);
+
+  pool->trim();
+  EXPECT_EQ(0, pool->capacity());
+  void* block = pool->allocate();
+  EXPECT_EQ(2, pool->capacity());
+  SlabPool::deallocate(block);
+}
+
+} // namespace Envoy
@@ -0,0 +1,49 @@
+#include "gtest/gtest.h"
+#include "library/common/data/bridge_map_builder.h"
+#include "library/common/data/utility.h"
+#include "library/common/types/c_types.h"
+
+namespace Envoy {
+namespace Data {
+
+TEST(BridgeMapBuilderTest, Empty) {
+  BridgeMapBuilder builder;
+  envoy_map map = builder.finish();
+  ASSERT_EQ(0, map.length);
+  release_envoy_map(map);
+}
+
+TEST(BridgeMapBuilderTest, EntriesShareOneBlock) {
+  BridgeMapBuilder builder;
+  builder.reserve(2, 13);
+  builder.add(":status", "200");
+  builder.add("a", "");
+
+  envoy_map map = builder.finish();
+  ASSERT_EQ(2, map.length);
+  EXPECT_EQ(":status", Utility::copyToString(map.entries[0].key));
+  EXPECT_EQ("200", Utility::copyToString(map.entries[0].value));
+  EXPECT_EQ("a", Utility::copyToString(map.entries[1].key));
+  EXPECT_EQ("", Utility::copyToString(map.entries[1].value));
+
+  // Keys and values are laid out after the entries, in order.
+  const uint8_t* block_end = reinterpret_cast<const uint8_t*>(map.entries + map.length);
+  EXPECT_EQ(block_end, map.entries[0].key.bytes);
+  EXPECT_EQ(block_end + 7, map.entries[0].value.bytes);
+  EXPECT_EQ(block_end + 10, map.entries[1].key.bytes);
+  release_envoy_map(map);
+}
+
+TEST(BridgeMapBuilderTest, FewerEntriesThanReserved) {
+  BridgeMapBuilder builder;
+  builder.reserve(3, 100);
+  builder.add("key", "value");
+
+  envoy_map map = builder.finish();
+  ASSERT_EQ(1, map.length);
+  EXPECT_EQ("value", Utility::copyToString(map.entries[0].value));
+  release_envoy_map(map);
+}
+
+} // namespace Data
+} // namespace Envoy
@@ -59,6 +59,82 @@ TEST(DataConstructorTest, FromCppToCPartial) {
   release_envoy_data(c_data);
 }
 
+TEST(DataConstructorTest, FromCppToCMovesSingleSlice) {
+  Buffer::OwnedImpl cpp_data;
+  cpp_data.add("test string");
+  const void* slice_data = cpp_data.frontSlice().mem_;
+
+  envoy_data c_data = Utility::toBridgeData(cpp_data);
+
+  // The slice is handed over without copying.
+  ASSERT_EQ(c_data.bytes, slice_data);
+  ASSERT_EQ(Utility::copyToString(c_data), "test string");
+  ASSERT_EQ(cpp_data.length(), 0);
+  release_envoy_data(c_data);
+}
+
+TEST(DataConstructorTest, FromStringToCMovesString) {
+  std::string str(1024, 'a');
+  const void* str_data = str.data();
+
+  envoy_data c_data = Utility::toBridgeData(std::move(str));
+
+  // The string's storage is handed over without copying.
+  ASSERT_EQ(c_data.bytes, str_data);
+  ASSERT_EQ(Utility::copyToString(c_data), std::string(1024, 'a'));
+  release_envoy_data(c_data);
+
+  envoy_data empty = Utility::toBridgeData(std::string());
+  ASSERT_EQ(empty.length, 0);
+  release_envoy_data(empty);
+}
+
+TEST(DataConstructorTest, FromCppToCMultipleSlices) {
+  Buffer::OwnedImpl cpp_data;
+  cpp_data.appendSliceForTest("test ");
+  cpp_data.appendSliceForTest("string");
+
+  envoy_data c_data = Utility::toBridgeData(cpp_data);
+
+  ASSERT_EQ(Utility::copyToString(c_data), "test string");
+  ASSERT_EQ(cpp_data.length(), 0);
+  release_envoy_data(c_data);
+}
+
+TEST(DataConstructorTest, FromCppToCVector) {
+  Buffer::OwnedImpl cpp_data;
+  cpp_data.appendSliceForTest("test ");
+  cpp_data.appendSliceForTest("string");
+  const void* first_slice_data = cpp_data.frontSlice().mem_;
+
+  Utility::BridgeDataVector c_data = Utility::toBridgeDataVector(cpp_data);
+
+  ASSERT_EQ(c_data.size(), 2);
+  ASSERT_EQ(c_data[0].bytes, first_slice_data);
+  ASSERT_EQ(Utility::copyToString(c_data[0]), "test ");
+  ASSERT_EQ(Utility::copyToString(c_data[1]), "string");
+  ASSERT_EQ(cpp_data.length(), 0);
+  for (envoy_data& slice : c_data) {
+    release_envoy_data(slice);
+  }
+}
+
+TEST(DataConstructorTest, FromCppToCVectorPartial) {
+  Buffer::OwnedImpl cpp_data;
+  cpp_data.appendSliceForTest("test ");
+  cpp_data.appendSliceForTest("string");
+
+  Utility::BridgeDataVector c_data = Utility::toBridgeDataVector(cpp_data, 7);
+
+  ASSERT_EQ(c_data.size(), 2);
+  ASSERT_EQ(Utility::copyToString(c_data[0]), "test ");
+  ASSERT_EQ(Utility::copyToString(c_data[1]), "st");
+  ASSERT_EQ(cpp_data.toString(), "ring");
+  for (envoy_data& slice : c_data) {
+    release_envoy_data(slice);
+  }
+}
+
 TEST(DataConstructorTest, CopyFromCppToC) {
   std::string s = "test string";
   Buffer::OwnedImpl cpp_data = Buffer::OwnedImpl(absl::string_view(s));
@@ -1,3 +1,9 @@
+#include "envoy/config/bootstrap/v3/bootstrap.pb.h"
+
+#include "source/common/protobuf/utility.h"
+
+#include "test/test_common/utility.h"
+
 #include "gtest/gtest.h"
 #include "library/common/engine_common.h"
 
@@ -13,4 +19,23 @@ TEST(EngineCommonTest, SignalHandlingFalse) {
   ASSERT_FALSE(main_common.server()->options().signalHandlingEnabled());
 }
 
+TEST(EngineCommonTest, RunsWithBootstrap) {
+  envoy::config::bootstrap::v3::Bootstrap bootstrap;
+  envoy::config::bootstrap::v3::RuntimeLayer* layer =
+      bootstrap.mutable_layered_runtime()->add_layers();
+  layer->set_name("static_layer_0");
+  ProtobufWkt::Struct overload;
+  (*overload.mutable_fields())["global_downstream_max_connections"] =
+      ValueUtil::numberValue(50000);
+  (*layer->mutable_static_layer()->mutable_fields())["overload"] =
+      ValueUtil::structValue(overload);
+
+  // No config is given on the command line.
+  std::vector<const char*> envoy_argv{"envoy", nullptr};
+  EngineCommon main_common{1, &envoy_argv[0], &bootstrap};
+  EXPECT_TRUE(TestUtility::protoEqual(bootstrap, main_common.server()->options().configProto()));
+  EXPECT_EQ(50000, main_common.server()->runtime().snapshot().getInteger(
+                       "overload.global_downstream_max_connections", 0));
+}
+
 } // namespace Envoy
@@ -1,8 +1,13 @@
+#include <atomic>
+
+#include "test/common/http/common.h"
+
 #include "absl/synchronization/notification.h"
 #include "gtest/gtest.h"
 #include "library/common/config/templates.h"
 #include "library/common/engine.h"
 #include "library/common/engine_handle.h"
+#include "library/common/http/header_utility.h"
 #include "library/common/main_interface.h"
 
 namespace Envoy {
@@ -42,15 +47,80 @@ layered_runtime:
       overload: { global_downstream_max_connections: 50000 }
 )";
 
+// Routes streams through the dynamic forward proxy, alongside a strict DNS cluster whose host
+// never resolves, so that the cluster is still warming, and PostInit not reached, while the first
+// streams run in early drain mode.
+const std::string WARMING_CLUSTER_TEST_CONFIG = R"(
+typed_dns_resolver_config: &dns_resolver_config
+  name: envoy.network.dns_resolver.getaddrinfo
+  typed_config:
+    "@type": type.googleapis.com/envoy.extensions.network.dns_resolver.getaddrinfo.v3.GetAddrInfoDnsResolverConfig
+static_resources:
+  listeners:
+  - name: base_api_listener
+    address:
+      socket_address: { protocol: TCP, address: 0.0.0.0, port_value: 10000 }
+    api_listener:
+      api_listener:
+        "@type": type.googleapis.com/envoy.extensions.filters.network.http_connection_manager.v3.EnvoyMobileHttpConnectionManager
+        config:
+          stat_prefix: hcm
+          route_config:
+            name: api_router
+            virtual_hosts:
+            - name: api
+              domains: ["*"]
+              routes:
+              - match: { prefix: "/" }
+                route: { cluster_header: x-envoy-mobile-cluster }
+          http_filters:
+          - name: envoy.filters.http.dynamic_forward_proxy
+            typed_config:
+              "@type": type.googleapis.com/envoy.extensions.filters.http.dynamic_forward_proxy.v3.FilterConfig
+              dns_cache_config: &dns_cache_config
+                name: base_dns_cache
+                dns_lookup_family: V4_ONLY
+                typed_dns_resolver_config: *dns_resolver_config
+          - name: envoy.router
+            typed_config:
+              "@type": type.googleapis.com/envoy.extensions.filters.http.router.v3.Router
+  clusters:
+  - name: base
+    connect_timeout: 1s
+    lb_policy: CLUSTER_PROVIDED
+    cluster_type:
+      name: envoy.clusters.dynamic_forward_proxy
+      typed_config:
+        "@type": type.googleapis.com/envoy.extensions.clusters.dynamic_forward_proxy.v3.ClusterConfig
+        dns_cache_config: *dns_cache_config
+  - name: warming
+    type: STRICT_DNS
+    connect_timeout: 1s
+    load_assignment:
+      cluster_name: warming
+      endpoints:
+      - lb_endpoints:
+        - endpoint:
+            address:
+              socket_address: { address: warming.invalid, port_value: 443 }
+layered_runtime:
+  layers:
+  - name: static_layer_0
+    static_layer:
+      overload: { global_downstream_max_connections: 50000 }
+      envoy_mobile: { early_drain: true }
+)";
+
 // RAII wrapper for the engine, ensuring that we properly shut down the engine. If the engine
 // thread is not torn down, we end up with TSAN failures during shutdown due to a data race
 // between the main thread and the engine thread both writing to the
 // Envoy::Logger::current_log_context global.
 struct TestEngineHandle {
   envoy_engine_t handle_;
-  TestEngineHandle(envoy_engine_callbacks callbacks, const std::string& level) {
+  TestEngineHandle(envoy_engine_callbacks callbacks, const std::string& level,
+                   const std::string& config = MINIMAL_TEST_CONFIG) {
     handle_ = init_engine(callbacks, {}, {});
-    run_engine(handle_, MINIMAL_TEST_CONFIG.c_str(), level.c_str(), "");
+    run_engine(handle_, config.c_str(), level.c_str(), "");
   }
 
   void terminate() { terminate_engine(handle_, /* release */ false); }
@@ -66,6 +136,7 @@ public:
 typedef struct {
   absl::Notification on_engine_running;
   absl::Notification on_exit;
+  std::atomic<int> engine_running_calls{0};
 } engine_test_context;
 
 TEST_F(EngineTest, EarlyExit) {
@@ -130,4 +201,80 @@ TEST_F(EngineTest, AccessEngineAfterInitialization) {
   engine_.reset();
 }
 
+typedef struct {
+  Engine* engine{};
+  absl::Notification on_complete;
+  // Whether the warming cluster was still warming when the stream completed.
+  bool completed_while_warming{};
+} early_drain_stream_context;
+
+TEST_F(EngineTest, EarlyDrainNotifiesEngineRunningOnce) {
+  const std::string level = "debug";
+
+  engine_test_context test_context{};
+  envoy_engine_callbacks callbacks{[](void* context) -> void {
+                                     auto* engine_running =
+                                         static_cast<engine_test_context*>(context);
+                                     engine_running->engine_running_calls++;
+                                     engine_running->on_engine_running.Notify();
+                                   } /*on_engine_running*/,
+                                   [](void* context) -> void {
+                                     auto* exit = static_cast<engine_test_context*>(context);
+                                     exit->on_exit.Notify();
+                                   } /*on_exit*/,
+                                   &test_context /*context*/};
+
+  // The client is started at StartUp, as the warming cluster holds back PostInit.
+  engine_ = std::make_unique<TestEngineHandle>(callbacks, level, WARMING_CLUSTER_TEST_CONFIG);
+  envoy_engine_t handle = engine_->handle_;
+  ASSERT_TRUE(test_context.on_engine_running.WaitForNotificationWithTimeout(absl::Seconds(3)));
+
+  early_drain_stream_context stream_context{};
+  absl::Notification engine_captured;
+  ASSERT_EQ(ENVOY_SUCCESS, EngineHandle::runOnEngineDispatcher(
+                               handle, [&stream_context, &engine_captured](Engine& engine) {
+                                 stream_context.engine = &engine;
+                                 engine_captured.Notify();
+                               }));
+  ASSERT_TRUE(engine_captured.WaitForNotificationWithTimeout(absl::Seconds(3)));
+
+  // A stream through the dynamic forward proxy only waits on its own host, which is an IP address.
+  // Nothing listens on its port, so the stream completes with a local reply.
+  envoy_http_callbacks stream_cbs{
+      nullptr /* on_headers */,
+      nullptr /* on_data */,
+      nullptr /* on_metadata */,
+      nullptr /* on_trailers */,
+      nullptr /* on_error */,
+      [](envoy_stream_intel, envoy_final_stream_intel, void* context) -> void* {
+        auto* stream_context = static_cast<early_drain_stream_context*>(context);
+        // Clusters only get a thread local cluster once they're warm.
+        stream_context->completed_while_warming =
+            stream_context->engine->getClusterManager().getThreadLocalCluster("warming") ==
+            nullptr;
+        stream_context->on_complete.Notify();
+        return nullptr;
+      } /* on_complete */,
+      nullptr /* on_cancel */,
+      nullptr /* on_send_window_available*/,
+      &stream_context /* context */,
+      nullptr /* on_data_vectored */,
+      nullptr /* on_aggregated_response */};
+  Http::TestRequestHeaderMapImpl headers{{":method", "GET"},
+                                         {":scheme", "http"},
+                                         {":authority", "127.0.0.1:1"},
+                                         {":path", "/"},
+                                         {"x-envoy-mobile-cluster", "base"}};
+  envoy_stream_t stream = init_stream(handle);
+  start_stream(handle, stream, stream_cbs, false);
+  send_headers(handle, stream, Http::Utility::toBridgeHeaders(headers), true);
+  ASSERT_TRUE(stream_context.on_complete.WaitForNotificationWithTimeout(absl::Seconds(3)));
+  EXPECT_TRUE(stream_context.completed_while_warming);
+
+  engine_->terminate();
+  ASSERT_TRUE(test_context.on_exit.WaitForNotificationWithTimeout(absl::Seconds(3)));
+  EXPECT_EQ(1, test_context.engine_running_calls);
+  engine_.reset();
+}
+
 } // namespace Envoy
@@ -0,0 +1,116 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+#include "library/common/event/provisional_dispatcher.h"
+
+namespace Envoy {
+namespace Event {
+
+class ProvisionalDispatcherTest : public testing::Test {
+protected:
+  ProvisionalDispatcherTest()
+      : api_(Api::createApiForTest()), dispatcher_(api_->allocateDispatcher("test_thread")) {}
+
+  Api::ApiPtr api_;
+  DispatcherPtr dispatcher_;
+  ProvisionalDispatcher provisional_dispatcher_;
+};
+
+TEST_F(ProvisionalDispatcherTest, QueuesCallbacksUntilDrained) {
+  std::vector<int> order;
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(ENVOY_SUCCESS, provisional_dispatcher_.post([&order, i]() { order.push_back(i); }));
+  }
+  EXPECT_FALSE(provisional_dispatcher_.isThreadSafe());
+  dispatcher_->run(Dispatcher::RunType::NonBlock);
+  EXPECT_TRUE(order.empty());
+
+  provisional_dispatcher_.drain(*dispatcher_);
+  dispatcher_->run(Dispatcher::RunType::NonBlock);
+  EXPECT_EQ((std::vector<int>{0, 1, 2}), order);
+}
+
+TEST_F(ProvisionalDispatcherTest, PassesCallbacksThroughAfterDrain) {
+  provisional_dispatcher_.drain(*dispatcher_);
+
+  std::vector<int> order;
+  provisional_dispatcher_.post([&order]() { order.push_back(0); });
+  dispatcher_->run(Dispatcher::RunType::NonBlock);
+  EXPECT_EQ(std::vector<int>{0}, order);
+
+  // Callbacks posted from a callback run on a later wakeup.
+  provisional_dispatcher_.post([&]() {
+    order.push_back(1);
+    provisional_dispatcher_.post([&order]() { order.push_back(2); });
+  });
+  dispatcher_->run(Dispatcher::RunType::NonBlock);
+  dispatcher_->run(Dispatcher::RunType::NonBlock);
+  EXPECT_EQ((std::vector<int>{0, 1, 2}), order);
+}
+
+TEST_F(ProvisionalDispatcherTest, LargeBurstIsRunInBatches) {
+  const uint32_t total = ProvisionalDispatcher::MaxCallbacksPerWakeup * 3 + 1;
+  uint32_t ran = 0;
+  for (uint32_t i = 0; i < total; ++i) {
+    provisional_dispatcher_.post([&ran, i]() { EXPECT_EQ(ran++, i); });
+  }
+  provisional_dispatcher_.drain(*dispatcher_);
+  while (ran < total) {
+    dispatcher_->run(Dispatcher::RunType::NonBlock);
+  }
+  EXPECT_EQ(total, ran);
+}
+
+TEST_F(ProvisionalDispatcherTest, PostFailsAfterTerminate) {
+  provisional_dispatcher_.drain(*dispatcher_);
+  provisional_dispatcher_.terminate();
+
+  bool ran = false;
+  EXPECT_EQ(ENVOY_FAILURE, provisional_dispatcher_.post([&ran]() { ran = true; }));
+  dispatcher_->run(Dispatcher::RunType::NonBlock);
+  EXPECT_FALSE(ran);
+}
+
+TEST_F(ProvisionalDispatcherTest, TerminateBeforeDrainDiscardsCallbacks) {
+  bool ran = false;
+  provisional_dispatcher_.post([&ran]() { ran = true; });
+  provisional_dispatcher_.terminate();
+  provisional_dispatcher_.drain(*dispatcher_);
+  dispatcher_->run(Dispatcher::RunType::NonBlock);
+  EXPECT_FALSE(ran);
+}
+
+TEST_F(ProvisionalDispatcherTest, ConcurrentPostsPreservePerThreadOrder) {
+  constexpr int threads = 8;
+  constexpr int posts_per_thread = 10000;
+  std::vector<int> next(threads, 0);
+  std::atomic<int> total{0};
+
+  std::vector<std::thread> producers;
+  for (int t = 0; t < threads; ++t) {
+    producers.emplace_back([&, t]() {
+      for (int i = 0; i < posts_per_thread; ++i) {
+        provisional_dispatcher_.post([&, t, i]() {
+          EXPECT_EQ(next[t]++, i);
+          total++;
+        });
+      }
+    });
+  }
+  // Drain while posts are still in flight.
+  provisional_dispatcher_.drain(*dispatcher_);
+  while (total < threads * posts_per_thread) {
+    dispatcher_->run(Dispatcher::RunType::NonBlock);
+  }
+  for (std::thread& producer : producers) {
+    producer.join();
+  }
+  EXPECT_EQ(threads * posts_per_thread, total);
+}
+
+} // namespace Event
+} // namespace Envoy
@@ -0,0 +1,186 @@
+#include <string>
+#include <vector>
+
+#include "envoy/extensions/transport_sockets/tls/v3/common.pb.h"
+
+#include "source/common/ssl/certificate_validation_context_config_impl.h"
+#include "source/extensions/transport_sockets/tls/stats.h"
+
+#include "test/common/stats/stat_test_utility.h"
+#include "test/extensions/transport_sockets/tls/ssl_test_utility.h"
+#include "test/test_common/environment.h"
+#include "test/test_common/utility.h"
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/strip.h"
+#include "gtest/gtest.h"
+#include "library/common/extensions/cert_validator/root_certificates/config.h"
+#include "library/common/extensions/cert_validator/root_certificates/root_certificates.h"
+#include "openssl/pem.h"
+#include "openssl/ssl.h"
+
+using envoy::extensions::transport_sockets::tls::v3::CertificateValidationContext;
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Tls {
+namespace {
+
+// The PEM certificates the DER ones are generated from, indented as a YAML block scalar.
+const char* indented_pem_certificates =
+#include "library/common/config/certificates.inc"
+    ;
+
+std::string toDer(X509* certificate) {
+  uint8_t* der = nullptr;
+  const int length = i2d_X509(certificate, &der);
+  EXPECT_GT(length, 0);
+  std::string result(reinterpret_cast<char*>(der), length);
+  OPENSSL_free(der);
+  return result;
+}
+
+absl::flat_hash_set<std::string> pemCertificates() {
+  std::vector<absl::string_view> lines = absl::StrSplit(indented_pem_certificates, '\n');
+  for (absl::string_view& line : lines) {
+    absl::ConsumePrefix(&line, "  ");
+  }
+  const std::string pem = absl::StrJoin(lines, "\n");
+  bssl::UniquePtr<BIO> bio(BIO_new_mem_buf(pem.data(), pem.size()));
+  bssl::UniquePtr<STACK_OF(X509_INFO)> infos(
+      PEM_X509_INFO_read_bio(bio.get(), nullptr, nullptr, nullptr));
+  absl::flat_hash_set<std::string> certificates;
+  for (const X509_INFO* info : infos.get()) {
+    if (info->x509 != nullptr) {
+      certificates.insert(toDer(info->x509));
+    }
+  }
+  return certificates;
+}
+
+absl::flat_hash_set<std::string> storeCertificates(X509_STORE& store) {
+  absl::flat_hash_set<std::string> certificates;
+  for (X509_OBJECT* object : X509_STORE_get0_objects(&store)) {
+    X509* certificate = X509_OBJECT_get0_X509(object);
+    if (certificate != nullptr) {
+      certificates.insert(toDer(certificate));
+    }
+  }
+  return certificates;
+}
+
+// Returns a root certificate which is currently valid and may be presented by a server itself, so
+// that a chain of just that certificate ends in a root certificate.
+bssl::UniquePtr<X509> serverRootCertificate() {
+  for (X509_OBJECT* object : X509_STORE_get0_objects(&rootCertificateStore())) {
+    X509* certificate = X509_OBJECT_get0_X509(object);
+    if (certificate != nullptr && X509_cmp_current_time(X509_get0_notBefore(certificate)) < 0 &&
+        X509_cmp_current_time(X509_get0_notAfter(certificate)) > 0 &&
+        X509_check_purpose(certificate, X509_PURPOSE_SSL_SERVER, 0) == 1) {
+      return bssl::UpRef(certificate);
+    }
+  }
+  return nullptr;
+}
+
+TEST(RootCertificatesTest, StoreHoldsBundledCertificates) {
+  const absl::flat_hash_set<std::string> expected = pemCertificates();
+  ASSERT_FALSE(expected.empty());
+  EXPECT_EQ(expected, storeCertificates(*createRootCertificateStore()));
+}
+
+TEST(RootCertificatesTest, StoreIsCreatedOnce) {
+  EXPECT_EQ(&rootCertificateStore(), &rootCertificateStore());
+}
+
+class RootCertificatesCertValidatorTest
+    : public testing::TestWithParam<CertificateValidationContext::TrustChainVerification> {
+protected:
+  RootCertificatesCertValidatorTest()
+      : api_(Api::createApiForTest()), stats_(generateSslStats(test_store_)),
+        config_(validationContext(), *api_) {}
+
+  CertificateValidationContext validationContext() {
+    CertificateValidationContext validation_context;
+    validation_context.set_trust_chain_verification(GetParam());
+    return validation_context;
+  }
+
+  bool acceptUntrusted() { return GetParam() == CertificateValidationContext::ACCEPT_UNTRUSTED; }
+
+  Api::ApiPtr api_;
+  Stats::TestUtil::TestStore test_store_;
+  SslStats stats_;
+  Ssl::CertificateValidationContextConfigImpl config_;
+};
+
+INSTANTIATE_TEST_SUITE_P(TrustMode, RootCertificatesCertValidatorTest,
+                         testing::ValuesIn({CertificateValidationContext::VERIFY_TRUST_CHAIN,
+                                            CertificateValidationContext::ACCEPT_UNTRUSTED}));
+
+TEST_P(RootCertificatesCertValidatorTest, ContextsShareStore) {
+  RootCertificatesCertValidator validator(&config_, stats_, api_->timeSource());
+  bssl::UniquePtr<SSL_CTX> first(SSL_CTX_new(TLS_method()));
+  bssl::UniquePtr<SSL_CTX> second(SSL_CTX_new(TLS_method()));
+
+  const int verify_mode = validator.initializeSslContexts({first.get(), second.get()}, false);
+  EXPECT_EQ(acceptUntrusted() ? SSL_VERIFY_PEER
+                              : SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT,
+            verify_mode);
+  EXPECT_EQ(&rootCertificateStore(), SSL_CTX_get_cert_store(first.get()));
+  EXPECT_EQ(&rootCertificateStore(), SSL_CTX_get_cert_store(second.get()));
+
+  // The store outlives the contexts holding it.
+  first.reset();
+  second.reset();
+  EXPECT_FALSE(storeCertificates(rootCertificateStore()).empty());
+}
+
+TEST_P(RootCertificatesCertValidatorTest, RejectsChainNotFromRootCertificates) {
+  RootCertificatesCertValidator validator(&config_, stats_, api_->timeSource());
+  bssl::UniquePtr<SSL_CTX> ssl_ctx(SSL_CTX_new(TLS_method()));
+  validator.initializeSslContexts({ssl_ctx.get()}, false);
+
+  // Signed by the test CA, which isn't among the root certificates.
+  bssl::UniquePtr<STACK_OF(X509)> cert_chain = readCertChainFromFile(TestEnvironment::substitute(
+      "{{ test_rundir }}/test/extensions/transport_sockets/tls/test_data/san_dns2_cert.pem"));
+  TestSslExtendedSocketInfo ssl_extended_info;
+  ValidationResults results = validator.doVerifyCertChain(
+      *cert_chain, Ssl::ValidateResultCallbackPtr(), &ssl_extended_info, nullptr, *ssl_ctx,
+      CertValidator::ExtraValidationContext(), false, "server1.example.com");
+  EXPECT_EQ(acceptUntrusted() ? ValidationResults::ValidationStatus::Successful
+                              : ValidationResults::ValidationStatus::Failed,
+            results.status);
+  EXPECT_EQ(1, stats_.fail_verify_error_.value());
+}
+
+TEST_P(RootCertificatesCertValidatorTest, AcceptsChainFromRootCertificates) {
+  RootCertificatesCertValidator validator(&config_, stats_, api_->timeSource());
+  bssl::UniquePtr<SSL_CTX> ssl_ctx(SSL_CTX_new(TLS_method()));
+  validator.initializeSslContexts({ssl_ctx.get()}, false);
+
+  bssl::UniquePtr<X509> root = serverRootCertificate();
+  ASSERT_NE(nullptr, root);
+  bssl::UniquePtr<STACK_OF(X509)> cert_chain(sk_X509_new_null());
+  ASSERT_TRUE(bssl::PushToStack(cert_chain.get(), std::move(root)));
+  TestSslExtendedSocketInfo ssl_extended_info;
+  ValidationResults results = validator.doVerifyCertChain(
+      *cert_chain, Ssl::ValidateResultCallbackPtr(), &ssl_extended_info, nullptr, *ssl_ctx,
+      CertValidator::ExtraValidationContext(), false, "server1.example.com");
+  EXPECT_EQ(ValidationResults::ValidationStatus::Successful, results.status);
+  EXPECT_EQ(0, stats_.fail_verify_error_.value());
+}
+
+TEST(RootCertificatesCertValidatorFactoryTest, IsRegistered) {
+  EXPECT_NE(nullptr, Registry::FactoryRegistry<CertValidatorFactory>::getFactory(
+                         "envoy_mobile.cert_validator.root_certificates_cert_validator"));
+}
+
+} // namespace
+} // namespace Tls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,67 @@
+// Compares the cost of trusting the root certificates in the engine's TLS contexts by parsing
+// them from PEM for each context, as when they're configured as a trusted CA, against parsing them
+// once from DER into the store every context shares.
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/strip.h"
+#include "benchmark/benchmark.h"
+#include "library/common/extensions/cert_validator/root_certificates/root_certificates.h"
+#include "openssl/pem.h"
+#include "openssl/ssl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Tls {
+namespace {
+
+const char* indented_pem_certificates =
+#include "library/common/config/certificates.inc"
+    ;
+
+std::string pemCertificates() {
+  std::vector<absl::string_view> lines = absl::StrSplit(indented_pem_certificates, '\n');
+  for (absl::string_view& line : lines) {
+    absl::ConsumePrefix(&line, "  ");
+  }
+  return absl::StrJoin(lines, "\n");
+}
+
+// Parses the certificates from PEM into a store for each of the given number of contexts.
+void bmPemStorePerContext(benchmark::State& state) {
+  const std::string pem = pemCertificates();
+  for (auto _ : state) { // NOLINT(clang-analyzer-deadcode.DeadStores)
+    for (int64_t context = 0; context < state.range(0); context++) {
+      bssl::UniquePtr<BIO> bio(BIO_new_mem_buf(pem.data(), pem.size()));
+      bssl::UniquePtr<STACK_OF(X509_INFO)> infos(
+          PEM_X509_INFO_read_bio(bio.get(), nullptr, nullptr, nullptr));
+      bssl::UniquePtr<X509_STORE> store(X509_STORE_new());
+      for (const X509_INFO* info : infos.get()) {
+        if (info->x509 != nullptr) {
+          X509_STORE_add_cert(store.get(), info->x509);
+        }
+      }
+      benchmark::DoNotOptimize(store);
+    }
+  }
+}
+BENCHMARK(bmPemStorePerContext)->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond);
+
+// Parses the certificates from DER into the one store, which every context shares.
+void bmSharedDerStore(benchmark::State& state) {
+  for (auto _ : state) { // NOLINT(clang-analyzer-deadcode.DeadStores)
+    bssl::UniquePtr<X509_STORE> store = createRootCertificateStore();
+    benchmark::DoNotOptimize(store);
+  }
+}
+BENCHMARK(bmSharedDerStore)->Unit(benchmark::kMillisecond);
+
+} // namespace
+} // namespace Tls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
@@ -41,6 +41,9 @@ public:
   MOCK_METHOD(void, setInterfaceBindingEnabled, (bool enabled));
   MOCK_METHOD(void, refreshDns, (envoy_netconf_t configuration_key, bool drain_connections));
   MOCK_METHOD(void, resetConnectivityState, ());
+  MOCK_METHOD(void, preconnect,
+              (absl::string_view authority, envoy_preconnect_protocol_t protocol,
+               uint32_t connections));
   MOCK_METHOD(Network::Socket::OptionsSharedPtr, getUpstreamSocketOptions,
               (envoy_network_t network, envoy_socket_mode_t socket_mode));
   MOCK_METHOD(envoy_netconf_t, addUpstreamSocketOptions,
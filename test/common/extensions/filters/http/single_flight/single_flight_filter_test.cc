@@ -0,0 +1,232 @@
+#include "source/common/buffer/buffer_impl.h"
+
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+#include "library/common/extensions/filters/http/single_flight/filter.h"
+#include "library/common/extensions/filters/http/single_flight/filter.pb.h"
+
+using testing::_;
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace SingleFlight {
+namespace {
+
+// A filter with its own stream callbacks, as each request has.
+struct TestStream {
+  explicit TestStream(SingleFlightFilterConfigSharedPtr config)
+      : filter_(std::make_unique<SingleFlightFilter>(config)) {
+    filter_->setDecoderFilterCallbacks(decoder_callbacks_);
+    filter_->setEncoderFilterCallbacks(encoder_callbacks_);
+  }
+
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> decoder_callbacks_;
+  NiceMock<Http::MockStreamEncoderFilterCallbacks> encoder_callbacks_;
+  std::unique_ptr<SingleFlightFilter> filter_;
+};
+
+class SingleFlightFilterTest : public testing::Test {
+public:
+  SingleFlightFilterTest() {
+    envoymobile::extensions::filters::http::single_flight::SingleFlight proto_config;
+    proto_config.add_key_headers("authorization");
+    config_ = std::make_shared<SingleFlightFilterConfig>(proto_config, tls_);
+  }
+
+  Http::TestRequestHeaderMapImpl requestHeaders(absl::string_view path = "/config") {
+    return {{":method", "GET"},
+            {":scheme", "https"},
+            {":authority", "example.com"},
+            {":path", std::string(path)},
+            {"authorization", "token"}};
+  }
+
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  SingleFlightFilterConfigSharedPtr config_;
+};
+
+TEST_F(SingleFlightFilterTest, IdenticalRequestsShareResponse) {
+  TestStream leader(config_);
+  TestStream follower(config_);
+  auto leader_headers = requestHeaders();
+  auto follower_headers = requestHeaders();
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            leader.filter_->decodeHeaders(leader_headers, true));
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            follower.filter_->decodeHeaders(follower_headers, true));
+
+  Http::TestResponseHeaderMapImpl response_headers{{":status", "200"}};
+  EXPECT_CALL(follower.decoder_callbacks_,
+              encodeHeaders_(HeaderMapEqualRef(&response_headers), false));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            leader.filter_->encodeHeaders(response_headers, false));
+
+  Buffer::OwnedImpl response_data("response body");
+  EXPECT_CALL(follower.decoder_callbacks_, encodeData(BufferStringEqual("response body"), false));
+  EXPECT_EQ(Http::FilterDataStatus::Continue, leader.filter_->encodeData(response_data, false));
+  EXPECT_EQ("response body", response_data.toString());
+
+  Http::TestResponseTrailerMapImpl response_trailers{{"trailer", "value"}};
+  EXPECT_CALL(follower.decoder_callbacks_,
+              encodeTrailers_(HeaderMapEqualRef(&response_trailers)));
+  EXPECT_EQ(Http::FilterTrailersStatus::Continue,
+            leader.filter_->encodeTrailers(response_trailers));
+
+  follower.filter_->onDestroy();
+  leader.filter_->onDestroy();
+}
+
+TEST_F(SingleFlightFilterTest, DifferentRequestsNotCoalesced) {
+  TestStream leader(config_);
+  auto leader_headers = requestHeaders();
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            leader.filter_->decodeHeaders(leader_headers, true));
+
+  // Another path.
+  TestStream other_path(config_);
+  auto other_path_headers = requestHeaders("/avatar");
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            other_path.filter_->decodeHeaders(other_path_headers, true));
+
+  // Another key header value.
+  TestStream other_authorization(config_);
+  auto other_authorization_headers = requestHeaders();
+  other_authorization_headers.setCopy(Http::LowerCaseString("authorization"), "other");
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            other_authorization.filter_->decodeHeaders(other_authorization_headers, true));
+
+  // Not a GET.
+  TestStream post(config_);
+  auto post_headers = requestHeaders();
+  post_headers.setMethod("POST");
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, post.filter_->decodeHeaders(post_headers, true));
+
+  // A request with a body.
+  TestStream with_body(config_);
+  auto with_body_headers = requestHeaders();
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            with_body.filter_->decodeHeaders(with_body_headers, false));
+
+  for (TestStream* stream : {&leader, &other_path, &other_authorization, &post, &with_body}) {
+    stream->filter_->onDestroy();
+  }
+}
+
+TEST_F(SingleFlightFilterTest, RequestsAfterResponseStartedNotCoalesced) {
+  TestStream leader(config_);
+  auto leader_headers = requestHeaders();
+  leader.filter_->decodeHeaders(leader_headers, true);
+  Http::TestResponseHeaderMapImpl response_headers{{":status", "200"}};
+  leader.filter_->encodeHeaders(response_headers, false);
+
+  TestStream late(config_);
+  auto late_headers = requestHeaders();
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, late.filter_->decodeHeaders(late_headers, true));
+
+  late.filter_->onDestroy();
+  leader.filter_->onDestroy();
+}
+
+TEST_F(SingleFlightFilterTest, CancelledFollowerDoesNotAffectLeader) {
+  TestStream leader(config_);
+  TestStream cancelled(config_);
+  TestStream follower(config_);
+  auto leader_headers = requestHeaders();
+  auto cancelled_headers = requestHeaders();
+  auto follower_headers = requestHeaders();
+  leader.filter_->decodeHeaders(leader_headers, true);
+  cancelled.filter_->decodeHeaders(cancelled_headers, true);
+  follower.filter_->decodeHeaders(follower_headers, true);
+
+  EXPECT_CALL(leader.decoder_callbacks_, resetStream).Times(0);
+  cancelled.filter_->onDestroy();
+
+  Http::TestResponseHeaderMapImpl response_headers{{":status", "200"}};
+  EXPECT_CALL(cancelled.decoder_callbacks_, encodeHeaders_(_, _)).Times(0);
+  EXPECT_CALL(follower.decoder_callbacks_, encodeHeaders_(_, true));
+  leader.filter_->encodeHeaders(response_headers, true);
+
+  follower.filter_->onDestroy();
+  leader.filter_->onDestroy();
+}
+
+TEST_F(SingleFlightFilterTest, FollowerSendsRequestWhenLeaderEndsBeforeResponse) {
+  TestStream leader(config_);
+  TestStream follower(config_);
+  auto leader_headers = requestHeaders();
+  auto follower_headers = requestHeaders();
+  leader.filter_->decodeHeaders(leader_headers, true);
+  follower.filter_->decodeHeaders(follower_headers, true);
+
+  auto* continue_decoding =
+      new NiceMock<Event::MockSchedulableCallback>(&follower.decoder_callbacks_.dispatcher_);
+  EXPECT_CALL(*continue_decoding, scheduleCallbackNextIteration());
+  leader.filter_->onDestroy();
+
+  EXPECT_CALL(follower.decoder_callbacks_, continueDecoding());
+  continue_decoding->invokeCallback();
+  follower.filter_->onDestroy();
+}
+
+TEST_F(SingleFlightFilterTest, FollowerResetWhenLeaderEndsDuringResponse) {
+  TestStream leader(config_);
+  TestStream follower(config_);
+  auto leader_headers = requestHeaders();
+  auto follower_headers = requestHeaders();
+  leader.filter_->decodeHeaders(leader_headers, true);
+  follower.filter_->decodeHeaders(follower_headers, true);
+
+  Http::TestResponseHeaderMapImpl response_headers{{":status", "200"}};
+  leader.filter_->encodeHeaders(response_headers, false);
+
+  EXPECT_CALL(follower.decoder_callbacks_, resetStream);
+  leader.filter_->onDestroy();
+  follower.filter_->onDestroy();
+}
+
+TEST_F(SingleFlightFilterTest, DetachedLeaderContinuesForFollowers) {
+  TestStream leader(config_);
+  TestStream follower(config_);
+  auto leader_headers = requestHeaders();
+  auto follower_headers = requestHeaders();
+  leader.filter_->decodeHeaders(leader_headers, true);
+
+  auto* shared_response =
+      leader.decoder_callbacks_.stream_info_.filterState()
+          ->getDataMutable<StreamInfo::SharedResponse>(StreamInfo::SharedResponse::key());
+  ASSERT_NE(nullptr, shared_response);
+  EXPECT_FALSE(shared_response->shared());
+  follower.filter_->decodeHeaders(follower_headers, true);
+  EXPECT_TRUE(shared_response->shared());
+
+  // The platform cancels the leader, which runs on for its follower.
+  shared_response->onDetached();
+  EXPECT_CALL(leader.decoder_callbacks_, resetStream).Times(0);
+  Http::TestResponseHeaderMapImpl response_headers{{":status", "200"}};
+  EXPECT_CALL(follower.decoder_callbacks_, encodeHeaders_(_, false));
+  leader.filter_->encodeHeaders(response_headers, false);
+
+  // Once the follower ends too, nothing needs the response.
+  auto* reset =
+      new NiceMock<Event::MockSchedulableCallback>(&leader.decoder_callbacks_.dispatcher_);
+  EXPECT_CALL(*reset, scheduleCallbackNextIteration());
+  follower.filter_->onDestroy();
+  EXPECT_FALSE(shared_response->shared());
+
+  EXPECT_CALL(leader.decoder_callbacks_, resetStream);
+  reset->invokeCallback();
+  leader.filter_->onDestroy();
+  EXPECT_FALSE(shared_response->shared());
+}
+
+} // namespace
+} // namespace SingleFlight
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
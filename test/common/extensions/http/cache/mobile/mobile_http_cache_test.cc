@@ -0,0 +1,255 @@
+#include "source/common/http/header_map_impl.h"
+#include "source/common/stats/isolated_store_impl.h"
+
+#include "test/mocks/common.h"
+#include "test/test_common/utility.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "gtest/gtest.h"
+#include "library/common/extensions/http/cache/mobile/cache.h"
+
+using testing::_;
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+namespace {
+
+// A key value store whose contents outlive it, as a platform store's do.
+std::unique_ptr<NiceMock<MockKeyValueStore>>
+persistentStore(absl::flat_hash_map<std::string, std::string>& contents) {
+  auto store = std::make_unique<NiceMock<MockKeyValueStore>>();
+  ON_CALL(*store, addOrUpdate(_, _, _))
+      .WillByDefault([&contents](absl::string_view key, absl::string_view value, auto) {
+        contents[key] = std::string(value);
+      });
+  ON_CALL(*store, get(_))
+      .WillByDefault([&contents](absl::string_view key) -> absl::optional<absl::string_view> {
+        auto it = contents.find(key);
+        if (it == contents.end()) {
+          return absl::nullopt;
+        }
+        return it->second;
+      });
+  ON_CALL(*store, remove(_)).WillByDefault([&contents](absl::string_view key) {
+    contents.erase(key);
+  });
+  ON_CALL(*store, iterate(_)).WillByDefault([&contents](KeyValueStore::ConstIterateCb cb) {
+    for (const auto& [key, value] : contents) {
+      if (cb(key, value) == KeyValueStore::Iterate::Break) {
+        return;
+      }
+    }
+  });
+  return store;
+}
+
+class MobileHttpCacheTest : public testing::Test {
+public:
+  std::unique_ptr<MobileHttpCache> createCache(uint64_t max_memory_bytes,
+                                               KeyValueStorePtr persistent_store = nullptr,
+                                               uint64_t max_persistent_bytes = 0,
+                                               uint64_t max_persistent_entry_bytes = 0) {
+    return std::make_unique<MobileHttpCache>(max_memory_bytes, 0, std::move(persistent_store),
+                                             max_persistent_bytes, max_persistent_entry_bytes,
+                                             stats_store_);
+  }
+
+  Key key(absl::string_view path) {
+    Key key;
+    key.set_host("example.com");
+    key.set_path(std::string(path));
+    key.set_scheme(Key::https);
+    return key;
+  }
+
+  MobileHttpCache::Entry entry(absl::string_view body) {
+    MobileHttpCache::Entry entry;
+    entry.response_headers_ = Http::ResponseHeaderMapImpl::create();
+    entry.response_headers_->setStatus(200);
+    entry.response_headers_->addCopy(Http::LowerCaseString("etag"), "\"v1\"");
+    entry.metadata_.response_time_ = SystemTime(std::chrono::seconds(1000));
+    entry.body_ = std::string(body);
+    return entry;
+  }
+
+  uint64_t counter(absl::string_view name) {
+    return TestUtility::findCounter(stats_store_, absl::StrCat("http.client.", name))->value();
+  }
+
+  Stats::IsolatedStoreImpl stats_store_;
+};
+
+TEST_F(MobileHttpCacheTest, InsertAndLookup) {
+  auto cache = createCache(1024);
+  EXPECT_EQ(nullptr, cache->lookup(key("/config")));
+
+  EXPECT_TRUE(cache->insert(key("/config"), entry("config")));
+  auto cached = cache->lookup(key("/config"));
+  ASSERT_NE(nullptr, cached);
+  EXPECT_EQ("config", cached->body_);
+  EXPECT_EQ("\"v1\"", cached->response_headers_->get(Http::LowerCaseString("etag"))[0]
+                          ->value()
+                          .getStringView());
+  EXPECT_EQ(nullptr, cache->lookup(key("/avatar")));
+  EXPECT_EQ(1, counter("cache_insert"));
+}
+
+TEST_F(MobileHttpCacheTest, InsertReplacesEntry) {
+  auto cache = createCache(1024);
+  cache->insert(key("/config"), entry("old"));
+  cache->insert(key("/config"), entry("new"));
+  EXPECT_EQ("new", cache->lookup(key("/config"))->body_);
+}
+
+TEST_F(MobileHttpCacheTest, EvictsLeastRecentlyUsed) {
+  const std::string body(100, 'a');
+  // Room for two entries, but not three.
+  auto cache = createCache(300);
+  cache->insert(key("/a"), entry(body));
+  cache->insert(key("/b"), entry(body));
+  // Using /a makes /b the least recently used.
+  EXPECT_NE(nullptr, cache->lookup(key("/a")));
+  cache->insert(key("/c"), entry(body));
+
+  EXPECT_NE(nullptr, cache->lookup(key("/a")));
+  EXPECT_EQ(nullptr, cache->lookup(key("/b")));
+  EXPECT_NE(nullptr, cache->lookup(key("/c")));
+  EXPECT_LE(cache->memoryBytes(), 300);
+  EXPECT_EQ(1, counter("cache_evict"));
+}
+
+TEST_F(MobileHttpCacheTest, OversizedEntriesNotCached) {
+  auto cache = createCache(64);
+  EXPECT_FALSE(cache->insert(key("/large"), entry(std::string(100, 'a'))));
+  EXPECT_EQ(nullptr, cache->lookup(key("/large")));
+  EXPECT_EQ(0, cache->memoryBytes());
+}
+
+TEST_F(MobileHttpCacheTest, EntriesOutliveCacheInPersistentStore) {
+  absl::flat_hash_map<std::string, std::string> contents;
+  {
+    auto cache = createCache(1024, persistentStore(contents));
+    MobileHttpCache::Entry with_trailers = entry("config");
+    with_trailers.trailers_ = Http::ResponseTrailerMapImpl::create();
+    with_trailers.trailers_->addCopy(Http::LowerCaseString("checksum"), "abc");
+    cache->insert(key("/config"), std::move(with_trailers));
+  }
+  EXPECT_EQ(1, contents.size());
+
+  auto cache = createCache(1024, persistentStore(contents));
+  auto cached = cache->lookup(key("/config"));
+  ASSERT_NE(nullptr, cached);
+  EXPECT_EQ("config", cached->body_);
+  EXPECT_EQ("200", cached->response_headers_->getStatusValue());
+  ASSERT_NE(nullptr, cached->trailers_);
+  EXPECT_EQ("abc", cached->trailers_->get(Http::LowerCaseString("checksum"))[0]
+                       ->value()
+                       .getStringView());
+  EXPECT_EQ(SystemTime(std::chrono::seconds(1000)), cached->metadata_.response_time_);
+  // Loaded responses are held in memory.
+  EXPECT_GT(cache->memoryBytes(), 0);
+}
+
+TEST_F(MobileHttpCacheTest, EvictedEntriesReloadedFromPersistentStore) {
+  absl::flat_hash_map<std::string, std::string> contents;
+  const std::string body(100, 'a');
+  auto cache = createCache(150, persistentStore(contents));
+  cache->insert(key("/a"), entry(body));
+  cache->insert(key("/b"), entry(body));
+  EXPECT_EQ(1, counter("cache_evict"));
+
+  auto cached = cache->lookup(key("/a"));
+  ASSERT_NE(nullptr, cached);
+  EXPECT_EQ(body, cached->body_);
+}
+
+TEST_F(MobileHttpCacheTest, PersistentStoreBoundedInBytes) {
+  absl::flat_hash_map<std::string, std::string> contents;
+  const std::string body(100, 'a');
+  uint64_t entry_bytes;
+  {
+    auto cache = createCache(4096, persistentStore(contents));
+    cache->insert(key("/a"), entry(body));
+    entry_bytes = cache->persistentBytes();
+  }
+  // Room for two responses in the store, but not three. Those saved by the previous cache count.
+  const uint64_t max_persistent_bytes = 2 * entry_bytes + entry_bytes / 2;
+  auto cache = createCache(4096, persistentStore(contents), max_persistent_bytes);
+  EXPECT_EQ(entry_bytes, cache->persistentBytes());
+  cache->insert(key("/b"), entry(body));
+  // Using /a makes /b the least recently used.
+  EXPECT_NE(nullptr, cache->lookup(key("/a")));
+  cache->insert(key("/c"), entry(body));
+  EXPECT_EQ(2, contents.size());
+  EXPECT_LE(cache->persistentBytes(), max_persistent_bytes);
+
+  auto reloaded = createCache(4096, persistentStore(contents), max_persistent_bytes);
+  EXPECT_NE(nullptr, reloaded->lookup(key("/a")));
+  EXPECT_EQ(nullptr, reloaded->lookup(key("/b")));
+  EXPECT_NE(nullptr, reloaded->lookup(key("/c")));
+}
+
+TEST_F(MobileHttpCacheTest, ResponsesDroppedByPersistentStoreNotCounted) {
+  absl::flat_hash_map<std::string, std::string> contents;
+  auto cache = createCache(150, persistentStore(contents));
+  const std::string body(100, 'a');
+  cache->insert(key("/a"), entry(body));
+  const uint64_t entry_bytes = cache->persistentBytes();
+  cache->insert(key("/b"), entry(body));
+  EXPECT_EQ(2 * entry_bytes, cache->persistentBytes());
+
+  // /a is no longer in memory, and the store has dropped it.
+  EXPECT_EQ(1, contents.erase(absl::StrCat("response_cache.", stableHashKey(key("/a")))));
+  EXPECT_EQ(nullptr, cache->lookup(key("/a")));
+  EXPECT_EQ(entry_bytes, cache->persistentBytes());
+}
+
+TEST_F(MobileHttpCacheTest, LargeEntriesHeldOnlyInMemory) {
+  absl::flat_hash_map<std::string, std::string> contents;
+  auto cache = createCache(4096, persistentStore(contents), 0, 256);
+  cache->insert(key("/config"), entry("config"));
+  EXPECT_EQ(1, contents.size());
+
+  // The larger response replaces the persisted one, which would otherwise outlive it.
+  const std::string body(1000, 'a');
+  EXPECT_TRUE(cache->insert(key("/config"), entry(body)));
+  EXPECT_EQ(body, cache->lookup(key("/config"))->body_);
+  EXPECT_TRUE(contents.empty());
+  EXPECT_EQ(0, cache->persistentBytes());
+}
+
+TEST_F(MobileHttpCacheTest, CorruptPersistedEntriesIgnored) {
+  absl::flat_hash_map<std::string, std::string> contents;
+  auto cache = createCache(1024, persistentStore(contents));
+  cache->insert(key("/config"), entry("config"));
+  for (auto& [persistent_key, value] : contents) {
+    value = "not a cached response";
+  }
+
+  auto reloaded = createCache(1024, persistentStore(contents));
+  EXPECT_EQ(nullptr, reloaded->lookup(key("/config")));
+}
+
+TEST_F(MobileHttpCacheTest, LookupResultStats) {
+  auto cache = createCache(1024);
+  LookupResult result;
+  result.cache_entry_status_ = CacheEntryStatus::Ok;
+  cache->onLookupResult(result);
+  result.cache_entry_status_ = CacheEntryStatus::RequiresValidation;
+  cache->onLookupResult(result);
+  cache->onLookupResult(LookupResult{});
+
+  EXPECT_EQ(1, counter("cache_hit"));
+  EXPECT_EQ(1, counter("cache_revalidate"));
+  EXPECT_EQ(1, counter("cache_miss"));
+}
+
+} // namespace
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -120,6 +120,23 @@ TEST_F(PlatformStoreTest, Iterate) {
   EXPECT_EQ(1, stop_early_counter);
 }
 
+TEST_F(PlatformStoreTest, FlushStoresOnDispatcher) {
+  NiceMock<Event::MockDispatcher> other_dispatcher;
+  PlatformKeyValueStore other_store(other_dispatcher, save_interval_, mock_platform_,
+                                    std::numeric_limits<uint64_t>::max(), "other_key");
+  store_->addOrUpdate("foo", "bar", absl::nullopt);
+  other_store.addOrUpdate("baz", "eep", absl::nullopt);
+
+  // Only the stores on the dispatcher are flushed, without waiting for the save interval.
+  flushPlatformKeyValueStores(dispatcher_);
+  EXPECT_EQ("3\nfoo3\nbar", mock_platform_.read(key_));
+  EXPECT_EQ("", mock_platform_.read("other_key"));
+
+  // Destroyed stores are no longer flushed.
+  store_.reset();
+  flushPlatformKeyValueStores(dispatcher_);
+}
+
 } // namespace
 } // namespace KeyValue
 } // namespace Extensions
@@ -0,0 +1,72 @@
+// Compares the per-chunk cost of timing a platform callback with the heap-allocated
+// HistogramCompletableTimespanImpl previously used by the Http::Client against the stack-allocated
+// CallbackTimer, with latencies recorded for every callback or for a sample of them.
+
+#include <memory>
+
+#include "source/common/event/real_time_system.h"
+#include "source/common/stats/isolated_store_impl.h"
+#include "source/common/stats/timespan_impl.h"
+
+#include "benchmark/benchmark.h"
+#include "library/common/http/callback_latency.h"
+
+namespace Envoy {
+namespace Http {
+namespace {
+
+constexpr auto SlowCallback = std::chrono::seconds(1);
+
+// Stand-in for the platform's on_data callback.
+void onData(uint64_t& chunks) { benchmark::DoNotOptimize(++chunks); }
+
+class CallbackLatencyHarness {
+public:
+  CallbackLatencyHarness()
+      : histogram_(store_.histogramFromString("on_data_callback_latency",
+                                              Stats::Histogram::Unit::Milliseconds)) {}
+
+  Event::RealTimeSystem time_system_;
+  Stats::IsolatedStoreImpl store_;
+  Stats::Histogram& histogram_;
+  uint64_t chunks_{};
+  uint64_t slow_callbacks_{};
+};
+
+void bmHeapTimespan(benchmark::State& state) {
+  CallbackLatencyHarness harness;
+  for (auto _ : state) { // NOLINT(clang-analyzer-deadcode.DeadStores)
+    auto callback_time_ms = std::make_unique<Stats::HistogramCompletableTimespanImpl>(
+        harness.histogram_, harness.time_system_);
+    onData(harness.chunks_);
+    callback_time_ms->complete();
+    if (callback_time_ms->elapsed() > SlowCallback) {
+      ++harness.slow_callbacks_;
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(bmHeapTimespan);
+
+// The argument is the sample rate.
+void bmSampledCallbackTimer(benchmark::State& state) {
+  CallbackLatencyHarness harness;
+  CallbackLatencySampler sampler(state.range(0));
+  for (auto _ : state) { // NOLINT(clang-analyzer-deadcode.DeadStores)
+    CallbackTimer callback_timer(harness.time_system_);
+    onData(harness.chunks_);
+    const std::chrono::milliseconds elapsed = callback_timer.elapsed();
+    if (sampler.sample()) {
+      harness.histogram_.recordValue(elapsed.count());
+    }
+    if (elapsed > SlowCallback) {
+      ++harness.slow_callbacks_;
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(bmSampledCallbackTimer)->Arg(1)->Arg(16)->Arg(128)->Arg(0);
+
+} // namespace
+} // namespace Http
+} // namespace Envoy
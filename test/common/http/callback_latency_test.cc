@@ -0,0 +1,45 @@
+#include "test/test_common/simulated_time_system.h"
+
+#include "gtest/gtest.h"
+#include "library/common/http/callback_latency.h"
+
+namespace Envoy {
+namespace Http {
+
+TEST(CallbackLatencySamplerTest, RecordsEveryCallbackByDefault) {
+  CallbackLatencySampler sampler;
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(sampler.sample());
+  }
+}
+
+TEST(CallbackLatencySamplerTest, RecordsOneInSampleRate) {
+  CallbackLatencySampler sampler(4);
+  int sampled = 0;
+  for (int i = 0; i < 100; ++i) {
+    if (sampler.sample()) {
+      ++sampled;
+      // Samples are evenly spaced.
+      EXPECT_EQ(3, i % 4);
+    }
+  }
+  EXPECT_EQ(25, sampled);
+}
+
+TEST(CallbackLatencySamplerTest, ZeroDisablesRecording) {
+  CallbackLatencySampler sampler(0);
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_FALSE(sampler.sample());
+  }
+}
+
+TEST(CallbackTimerTest, MeasuresElapsedTime) {
+  Event::SimulatedTimeSystem time_system;
+  CallbackTimer timer(time_system);
+  EXPECT_EQ(std::chrono::milliseconds(0), timer.elapsed());
+  time_system.advanceTimeWait(std::chrono::milliseconds(1500));
+  EXPECT_EQ(std::chrono::milliseconds(1500), timer.elapsed());
+}
+
+} // namespace Http
+} // namespace Envoy
@@ -1,3 +1,5 @@
+#include <fcntl.h>
+
 #include <atomic>
 
 #include "source/common/buffer/buffer_impl.h"
@@ -7,21 +9,27 @@
 #include "test/common/http/common.h"
 #include "test/common/mocks/event/mocks.h"
 #include "test/mocks/buffer/mocks.h"
+#include "test/mocks/common.h"
 #include "test/mocks/event/mocks.h"
 #include "test/mocks/http/api_listener.h"
 #include "test/mocks/http/mocks.h"
 #include "test/mocks/local_info/mocks.h"
+#include "test/mocks/stats/mocks.h"
 #include "test/mocks/upstream/mocks.h"
+#include "test/test_common/environment.h"
 
+#include "absl/synchronization/mutex.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "library/common/data/utility.h"
 #include "library/common/http/client.h"
 #include "library/common/http/header_utility.h"
+#include "library/common/stream_info/shared_response.h"
 #include "library/common/types/c_types.h"
 
 using testing::_;
 using testing::NiceMock;
+using testing::Property;
 using testing::Return;
 using testing::ReturnPointee;
 using testing::ReturnRef;
@@ -44,6 +52,15 @@ ResponseHeaderMapPtr toResponseHeaders(envoy_headers headers) {
   return transformed_headers;
 }
 
+// A response shared with other streams, as the single flight filter's leaders' are.
+class TestSharedResponse : public StreamInfo::SharedResponse {
+public:
+  bool shared() const override { return true; }
+  void onDetached() override { detached_ = true; }
+
+  bool detached_{};
+};
+
 class ClientTest : public testing::TestWithParam<bool> {
 public:
   typedef struct {
@@ -57,6 +74,8 @@ public:
     std::string expected_status_;
     bool end_stream_with_headers_;
     std::string body_data_;
+    uint32_t on_aggregated_response_calls;
+    uint64_t response_body_written;
   } callbacks_called;
 
   ClientTest() {
@@ -111,6 +130,60 @@ public:
       cc->on_trailers_calls++;
       return nullptr;
     };
+    bridge_callbacks_.on_aggregated_response =
+        [](envoy_headers c_headers, envoy_data c_body, envoy_headers c_trailers, envoy_stream_intel,
+           envoy_final_stream_intel, void* context) -> void* {
+      ResponseHeaderMapPtr response_headers = toResponseHeaders(c_headers);
+      callbacks_called* cc = static_cast<callbacks_called*>(context);
+      EXPECT_EQ(response_headers->Status()->value().getStringView(), cc->expected_status_);
+      cc->on_aggregated_response_calls++;
+      cc->body_data_ += Data::Utility::copyToString(c_body);
+      release_envoy_data(c_body);
+      if (c_trailers.length > 0) {
+        cc->on_trailers_calls++;
+      }
+      release_envoy_headers(c_trailers);
+      return nullptr;
+    };
+    bridge_callbacks_.on_response_body_progress = [](uint64_t bytes_written, envoy_stream_intel,
+                                                     void* context) -> void* {
+      callbacks_called* cc = static_cast<callbacks_called*>(context);
+      EXPECT_GT(bytes_written, cc->response_body_written);
+      cc->response_body_written = bytes_written;
+      return nullptr;
+    };
+    // Callbacks may be posted from other threads, e.g. by response body writers.
+    ON_CALL(dispatcher_, post_(_)).WillByDefault([this](std::function<void()>) {
+      absl::MutexLock lock(&posts_mutex_);
+      ++posts_;
+      return ENVOY_SUCCESS;
+    });
+  }
+
+  // Waits for the given number of callbacks to have been posted in all, and runs those not yet
+  // run, as the dispatcher would.
+  void runPosts(uint32_t posts) {
+    {
+      absl::MutexLock lock(&posts_mutex_);
+      const auto posted = [this, posts]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(posts_mutex_) {
+        return posts_ >= posts;
+      };
+      posts_mutex_.Await(absl::Condition(&posted));
+    }
+    std::list<std::function<void()>> callbacks;
+    callbacks.swap(dispatcher_.callbacks_);
+    for (auto& callback : callbacks) {
+      callback();
+    }
+  }
+
+  void createFileStream(int fd) {
+    envoy_stream_options options{};
+    options.explicit_flow_control = explicit_flow_control_;
+    options.buffer_limit_bytes = 8;
+    options.write_response_body_to_file = true;
+    options.response_body_fd = fd;
+    createStream(options);
   }
 
   envoy_headers defaultRequestHeaders() {
@@ -121,6 +194,12 @@ public:
   }
 
   void createStream() {
+    envoy_stream_options options{};
+    options.explicit_flow_control = explicit_flow_control_;
+    createStream(options);
+  }
+
+  void createStream(const envoy_stream_options& options) {
     ON_CALL(dispatcher_, isThreadSafe()).WillByDefault(Return(true));
     ON_CALL(*request_decoder_, streamInfo()).WillByDefault(ReturnRef(stream_info_));
 
@@ -132,7 +211,14 @@ public:
           response_encoder_ = &encoder;
           return *request_decoder_;
         }));
-    http_client_.startStream(stream_, bridge_callbacks_, explicit_flow_control_);
+    http_client_.startStream(stream_, bridge_callbacks_, options);
+  }
+
+  void createAggregatingStream(uint32_t aggregate_body_limit_bytes) {
+    envoy_stream_options options{};
+    options.explicit_flow_control = explicit_flow_control_;
+    options.aggregate_body_limit_bytes = aggregate_body_limit_bytes;
+    createStream(options);
   }
 
   void resumeDataIfExplicitFlowControl(int32_t bytes) {
@@ -148,11 +234,13 @@ public:
   NiceMock<StreamInfo::MockStreamInfo> stream_info_;
   ResponseEncoder* response_encoder_{};
   NiceMock<Event::MockProvisionalDispatcher> dispatcher_;
-  envoy_http_callbacks bridge_callbacks_;
-  callbacks_called cc_ = {0, 0, 0, 0, 0, 0, 0, "200", true, ""};
+  envoy_http_callbacks bridge_callbacks_{};
+  callbacks_called cc_ = {0, 0, 0, 0, 0, 0, 0, "200", true, "", 0, 0};
   NiceMock<Random::MockRandomGenerator> random_;
   Stats::IsolatedStoreImpl stats_store_;
   bool explicit_flow_control_{GetParam()};
+  absl::Mutex posts_mutex_;
+  uint32_t posts_ ABSL_GUARDED_BY(posts_mutex_){};
   Client http_client_{api_listener_, dispatcher_, stats_store_, random_};
   envoy_stream_t stream_ = 1;
 };
@@ -297,6 +385,160 @@ TEST_P(ClientTest, BasicStreamData) {
   ASSERT_EQ(cc_.on_complete_calls, 1);
 }
 
+TEST_P(ClientTest, BasicStreamDataVectored) {
+  cc_.end_stream_with_headers_ = false;
+
+  bridge_callbacks_.on_data = [](envoy_data, bool, envoy_stream_intel, void*) -> void* {
+    ADD_FAILURE() << "on_data should not be called when on_data_vectored is set";
+    return nullptr;
+  };
+  bridge_callbacks_.on_data_vectored = [](const envoy_data* slices, size_t slice_count,
+                                          bool end_stream, envoy_stream_intel,
+                                          void* context) -> void* {
+    EXPECT_TRUE(end_stream);
+    EXPECT_EQ(slice_count, 2);
+    EXPECT_EQ(Data::Utility::copyToString(slices[0]), "response ");
+    EXPECT_EQ(Data::Utility::copyToString(slices[1]), "body");
+    callbacks_called* cc = static_cast<callbacks_called*>(context);
+    cc->on_data_calls++;
+    for (size_t i = 0; i < slice_count; ++i) {
+      release_envoy_data(slices[i]);
+    }
+    return nullptr;
+  };
+
+  // Create a stream, and set up request_decoder_ and response_encoder_
+  createStream();
+  resumeDataIfExplicitFlowControl(20);
+
+  // Encode response data, received as two slices.
+  EXPECT_CALL(dispatcher_, pushTrackedObject(_));
+  EXPECT_CALL(dispatcher_, popTrackedObject(_));
+  EXPECT_CALL(dispatcher_, deferredDelete_(_));
+  Buffer::OwnedImpl response_data;
+  response_data.appendSliceForTest("response ");
+  response_data.appendSliceForTest("body");
+  response_encoder_->encodeData(response_data, true);
+  ASSERT_EQ(cc_.on_data_calls, 1);
+  // Ensure that the callbacks on the bridge_callbacks_ were called.
+  ASSERT_EQ(cc_.on_complete_calls, 1);
+}
+
+TEST_P(ClientTest, AggregatedResponse) {
+  cc_.end_stream_with_headers_ = false;
+  createAggregatingStream(64);
+  resumeDataIfExplicitFlowControl(20);
+
+  TestResponseHeaderMapImpl response_headers{{":status", "200"}, {"content-length", "13"}};
+  response_encoder_->encodeHeaders(response_headers, false);
+  EXPECT_CALL(dispatcher_, deferredDelete_(_));
+  Buffer::OwnedImpl response_data("response body");
+  response_encoder_->encodeData(response_data, true);
+  EXPECT_EQ("response body", cc_.body_data_);
+
+  if (explicit_flow_control_) {
+    // Responses are not aggregated with explicit flow control.
+    EXPECT_EQ(cc_.on_aggregated_response_calls, 0);
+    EXPECT_EQ(cc_.on_headers_calls, 1);
+    EXPECT_EQ(cc_.on_complete_calls, 1);
+    return;
+  }
+  // The whole response is delivered in a single callback.
+  EXPECT_EQ(cc_.on_aggregated_response_calls, 1);
+  EXPECT_EQ(cc_.on_headers_calls, 0);
+  EXPECT_EQ(cc_.on_data_calls, 0);
+  EXPECT_EQ(cc_.on_complete_calls, 0);
+}
+
+TEST_P(ClientTest, AggregatedResponseWithTrailers) {
+  if (explicit_flow_control_) {
+    return;
+  }
+  cc_.end_stream_with_headers_ = false;
+  createAggregatingStream(64);
+
+  TestResponseHeaderMapImpl response_headers{{":status", "200"}};
+  response_encoder_->encodeHeaders(response_headers, false);
+  Buffer::OwnedImpl response_data("response body");
+  response_encoder_->encodeData(response_data, false);
+  EXPECT_CALL(dispatcher_, deferredDelete_(_));
+  TestResponseTrailerMapImpl response_trailers{{"x-test-trailer", "test_trailer"}};
+  response_encoder_->encodeTrailers(response_trailers);
+
+  EXPECT_EQ(cc_.on_aggregated_response_calls, 1);
+  EXPECT_EQ(cc_.on_trailers_calls, 1);
+  EXPECT_EQ("response body", cc_.body_data_);
+  EXPECT_EQ(cc_.on_complete_calls, 0);
+}
+
+TEST_P(ClientTest, AggregatedResponseFallsBackToStreaming) {
+  if (explicit_flow_control_) {
+    return;
+  }
+  cc_.end_stream_with_headers_ = false;
+  createAggregatingStream(16);
+
+  TestResponseHeaderMapImpl response_headers{{":status", "200"}};
+  response_encoder_->encodeHeaders(response_headers, false);
+  Buffer::OwnedImpl response_data("response ");
+  response_encoder_->encodeData(response_data, false);
+  EXPECT_EQ(cc_.on_headers_calls, 0);
+
+  // Exceeding the limit delivers what was aggregated, then streams the rest.
+  Buffer::OwnedImpl response_data2("body, continued");
+  response_encoder_->encodeData(response_data2, false);
+  EXPECT_EQ(cc_.on_headers_calls, 1);
+  EXPECT_EQ(cc_.on_data_calls, 2);
+
+  EXPECT_CALL(dispatcher_, deferredDelete_(_));
+  Buffer::OwnedImpl response_data3(" and done");
+  response_encoder_->encodeData(response_data3, true);
+  EXPECT_EQ(cc_.on_data_calls, 3);
+  EXPECT_EQ("response body, continued and done", cc_.body_data_);
+  EXPECT_EQ(cc_.on_complete_calls, 1);
+  EXPECT_EQ(cc_.on_aggregated_response_calls, 0);
+}
+
+TEST_P(ClientTest, AggregatedResponseStreamsLargeContentLength) {
+  if (explicit_flow_control_) {
+    return;
+  }
+  cc_.end_stream_with_headers_ = false;
+  createAggregatingStream(16);
+
+  // A body known to exceed the limit is streamed from the start.
+  TestResponseHeaderMapImpl response_headers{{":status", "200"}, {"content-length", "17"}};
+  response_encoder_->encodeHeaders(response_headers, false);
+  EXPECT_EQ(cc_.on_headers_calls, 1);
+
+  EXPECT_CALL(dispatcher_, deferredDelete_(_));
+  Buffer::OwnedImpl response_data("response body 17b");
+  response_encoder_->encodeData(response_data, true);
+  EXPECT_EQ(cc_.on_data_calls, 1);
+  EXPECT_EQ(cc_.on_complete_calls, 1);
+  EXPECT_EQ(cc_.on_aggregated_response_calls, 0);
+}
+
+TEST_P(ClientTest, AggregatedResponseReleasedOnCancel) {
+  if (explicit_flow_control_) {
+    return;
+  }
+  cc_.end_stream_with_headers_ = false;
+  createAggregatingStream(64);
+
+  TestResponseHeaderMapImpl response_headers{{":status", "200"}};
+  response_encoder_->encodeHeaders(response_headers, false);
+  Buffer::OwnedImpl response_data("response body");
+  response_encoder_->encodeData(response_data, false);
+
+  // The aggregated headers are released with the stream, without being delivered.
+  EXPECT_CALL(dispatcher_, deferredDelete_(_));
+  http_client_.cancelStream(stream_);
+  EXPECT_EQ(cc_.on_cancel_calls, 1);
+  EXPECT_EQ(cc_.on_headers_calls, 0);
+  EXPECT_EQ(cc_.on_aggregated_response_calls, 0);
+}
+
 TEST_P(ClientTest, BasicStreamTrailers) {
   bridge_callbacks_.on_trailers = [](envoy_headers c_trailers, envoy_stream_intel,
                                      void* context) -> void* {
@@ -413,6 +655,486 @@ TEST_P(ClientTest, MultipleDataStream) {
   ASSERT_EQ(cc_.on_complete_calls, 1);
 }
 
+TEST_P(ClientTest, SendWindowNotificationsPerStream) {
+  if (!explicit_flow_control_) {
+    return;
+  }
+  Event::MockDispatcher dispatcher;
+  ON_CALL(dispatcher_, drain).WillByDefault([&](Event::Dispatcher& event_dispatcher) {
+    dispatcher_.Event::ProvisionalDispatcher::drain(event_dispatcher);
+  });
+  dispatcher_.drain(dispatcher);
+  ON_CALL(dispatcher_, createSchedulableCallback).WillByDefault([&](std::function<void()> cb) {
+    return dispatcher_.Event::ProvisionalDispatcher::createSchedulableCallback(cb);
+  });
+  // Each stream allocates its own notifier, once.
+  auto* first_notifier = new NiceMock<Event::MockSchedulableCallback>(&dispatcher);
+  auto* second_notifier = new NiceMock<Event::MockSchedulableCallback>(&dispatcher);
+  EXPECT_CALL(*first_notifier, scheduleCallbackNextIteration()).Times(2);
+  EXPECT_CALL(*second_notifier, scheduleCallbackNextIteration());
+
+  cc_.end_stream_with_headers_ = false;
+  createStream();
+  http_client_.sendHeaders(stream_, defaultRequestHeaders(), false);
+
+  NiceMock<MockRequestDecoder> second_decoder;
+  ON_CALL(second_decoder, streamInfo()).WillByDefault(ReturnRef(stream_info_));
+  EXPECT_CALL(api_listener_, newStream(_, _)).WillOnce(ReturnRef(second_decoder));
+  envoy_stream_t second_stream = stream_ + 1;
+  http_client_.startStream(second_stream, bridge_callbacks_, explicit_flow_control_);
+  http_client_.sendHeaders(second_stream, defaultRequestHeaders(), false);
+
+  // Repeated writes within one loop iteration are coalesced into a single notification, and a
+  // write on one stream does not displace the pending notification of another.
+  http_client_.sendData(stream_, Data::Utility::copyToBridgeData("chunk 1"), false);
+  http_client_.sendData(stream_, Data::Utility::copyToBridgeData("chunk 2"), false);
+  http_client_.sendData(second_stream, Data::Utility::copyToBridgeData("chunk 1"), false);
+  EXPECT_TRUE(first_notifier->enabled_);
+  EXPECT_TRUE(second_notifier->enabled_);
+  first_notifier->invokeCallback();
+  second_notifier->invokeCallback();
+  EXPECT_EQ(cc_.on_send_window_available_calls, 2);
+
+  // The notifier is reused for later writes.
+  http_client_.sendData(stream_, Data::Utility::copyToBridgeData("chunk 3"), false);
+  first_notifier->invokeCallback();
+  EXPECT_EQ(cc_.on_send_window_available_calls, 3);
+
+  // A pending notification is dropped when its stream is cancelled.
+  http_client_.sendData(second_stream, Data::Utility::copyToBridgeData("chunk 2"), false);
+  EXPECT_TRUE(second_notifier->enabled_);
+  http_client_.cancelStream(second_stream);
+  EXPECT_FALSE(second_notifier->enabled_);
+  http_client_.cancelStream(stream_);
+  EXPECT_EQ(cc_.on_send_window_available_calls, 3);
+  ASSERT_EQ(cc_.on_cancel_calls, 2);
+}
+
+TEST_P(ClientTest, LowPriorityStreamHeldForHighPriorityStream) {
+  Event::MockDispatcher dispatcher;
+  ON_CALL(dispatcher_, drain).WillByDefault([&](Event::Dispatcher& event_dispatcher) {
+    dispatcher_.Event::ProvisionalDispatcher::drain(event_dispatcher);
+  });
+  dispatcher_.drain(dispatcher);
+  ON_CALL(dispatcher_, createSchedulableCallback).WillByDefault([&](std::function<void()> cb) {
+    return dispatcher_.Event::ProvisionalDispatcher::createSchedulableCallback(cb);
+  });
+  ON_CALL(dispatcher_, createTimer).WillByDefault([&](Event::TimerCb cb) {
+    return dispatcher_.Event::ProvisionalDispatcher::createTimer(cb);
+  });
+  auto* release_callback = new NiceMock<Event::MockSchedulableCallback>(&dispatcher);
+  new NiceMock<Event::MockTimer>(&dispatcher);
+
+  envoy_stream_options high_options{};
+  high_options.explicit_flow_control = explicit_flow_control_;
+  high_options.priority = ENVOY_STREAM_PRIORITY_HIGH;
+  createStream(high_options);
+  EXPECT_CALL(*request_decoder_, decodeHeaders_(_, true))
+      .WillOnce(Invoke([](RequestHeaderMapPtr& headers, bool) {
+        EXPECT_EQ("u=1", headers->get(LowerCaseString("priority"))[0]->value().getStringView());
+      }));
+  http_client_.sendHeaders(stream_, defaultRequestHeaders(), true);
+
+  // A low priority stream started while the high priority stream awaits its response is held,
+  // and only created in the connection manager once it's released.
+  NiceMock<MockRequestDecoder> low_decoder;
+  ON_CALL(low_decoder, streamInfo()).WillByDefault(ReturnRef(stream_info_));
+  EXPECT_CALL(api_listener_, newStream(_, _)).WillOnce(ReturnRef(low_decoder));
+  envoy_stream_options low_options{};
+  low_options.explicit_flow_control = explicit_flow_control_;
+  low_options.priority = ENVOY_STREAM_PRIORITY_LOW;
+  envoy_stream_t low_stream = stream_ + 1;
+  http_client_.startStream(low_stream, bridge_callbacks_, low_options);
+  EXPECT_CALL(low_decoder, decodeHeaders_(_, _)).Times(0);
+  EXPECT_CALL(low_decoder, decodeData(_, _)).Times(0);
+  http_client_.sendHeaders(low_stream, defaultRequestHeaders(), false);
+  http_client_.sendData(low_stream, Data::Utility::copyToBridgeData("request body"), true);
+  testing::Mock::VerifyAndClearExpectations(&low_decoder);
+
+  // Response headers on the high priority stream release the held stream on the next iteration.
+  TestResponseHeaderMapImpl response_headers{{":status", "200"}};
+  response_encoder_->encodeHeaders(response_headers, false);
+  EXPECT_TRUE(release_callback->enabled_);
+
+  EXPECT_CALL(low_decoder, decodeHeaders_(_, false))
+      .WillOnce(Invoke([](RequestHeaderMapPtr& headers, bool) {
+        EXPECT_EQ("u=6", headers->get(LowerCaseString("priority"))[0]->value().getStringView());
+      }));
+  EXPECT_CALL(low_decoder, decodeData(BufferStringEqual("request body"), true));
+  release_callback->invokeCallback();
+
+  http_client_.cancelStream(low_stream);
+  http_client_.cancelStream(stream_);
+  ASSERT_EQ(cc_.on_cancel_calls, 2);
+}
+
+TEST_P(ClientTest, HeldStreamCancelledBeforeRelease) {
+  Event::MockDispatcher dispatcher;
+  ON_CALL(dispatcher_, drain).WillByDefault([&](Event::Dispatcher& event_dispatcher) {
+    dispatcher_.Event::ProvisionalDispatcher::drain(event_dispatcher);
+  });
+  dispatcher_.drain(dispatcher);
+  ON_CALL(dispatcher_, createSchedulableCallback).WillByDefault([&](std::function<void()> cb) {
+    return dispatcher_.Event::ProvisionalDispatcher::createSchedulableCallback(cb);
+  });
+  ON_CALL(dispatcher_, createTimer).WillByDefault([&](Event::TimerCb cb) {
+    return dispatcher_.Event::ProvisionalDispatcher::createTimer(cb);
+  });
+  auto* release_callback = new NiceMock<Event::MockSchedulableCallback>(&dispatcher);
+  new NiceMock<Event::MockTimer>(&dispatcher);
+
+  envoy_stream_options high_options{};
+  high_options.explicit_flow_control = explicit_flow_control_;
+  high_options.priority = ENVOY_STREAM_PRIORITY_HIGH;
+  createStream(high_options);
+
+  NiceMock<MockRequestDecoder> low_decoder;
+  ON_CALL(low_decoder, streamInfo()).WillByDefault(ReturnRef(stream_info_));
+  EXPECT_CALL(api_listener_, newStream(_, _)).Times(0);
+  envoy_stream_options low_options{};
+  low_options.explicit_flow_control = explicit_flow_control_;
+  low_options.priority = ENVOY_STREAM_PRIORITY_LOW;
+  envoy_stream_t low_stream = stream_ + 1;
+  http_client_.startStream(low_stream, bridge_callbacks_, low_options);
+  http_client_.sendHeaders(low_stream, defaultRequestHeaders(), true);
+
+  // A held stream which is cancelled is never started in the connection manager.
+  http_client_.cancelStream(low_stream);
+  // Cancelling the high priority stream resolves it just as a response would.
+  http_client_.cancelStream(stream_);
+  EXPECT_TRUE(release_callback->enabled_);
+  release_callback->invokeCallback();
+  ASSERT_EQ(cc_.on_cancel_calls, 2);
+}
+
+TEST_P(ClientTest, HeldStreamReleasedWhenBodyExceedsBufferLimit) {
+  Event::MockDispatcher dispatcher;
+  ON_CALL(dispatcher_, drain).WillByDefault([&](Event::Dispatcher& event_dispatcher) {
+    dispatcher_.Event::ProvisionalDispatcher::drain(event_dispatcher);
+  });
+  dispatcher_.drain(dispatcher);
+  ON_CALL(dispatcher_, createSchedulableCallback).WillByDefault([&](std::function<void()> cb) {
+    return dispatcher_.Event::ProvisionalDispatcher::createSchedulableCallback(cb);
+  });
+  ON_CALL(dispatcher_, createTimer).WillByDefault([&](Event::TimerCb cb) {
+    return dispatcher_.Event::ProvisionalDispatcher::createTimer(cb);
+  });
+  auto* release_callback = new NiceMock<Event::MockSchedulableCallback>(&dispatcher);
+  new NiceMock<Event::MockTimer>(&dispatcher);
+
+  envoy_stream_options high_options{};
+  high_options.explicit_flow_control = explicit_flow_control_;
+  high_options.priority = ENVOY_STREAM_PRIORITY_HIGH;
+  createStream(high_options);
+  http_client_.sendHeaders(stream_, defaultRequestHeaders(), true);
+
+  NiceMock<MockRequestDecoder> low_decoder;
+  ON_CALL(low_decoder, streamInfo()).WillByDefault(ReturnRef(stream_info_));
+  EXPECT_CALL(api_listener_, newStream(_, _)).WillOnce(ReturnRef(low_decoder));
+  envoy_stream_options low_options{};
+  low_options.explicit_flow_control = explicit_flow_control_;
+  low_options.priority = ENVOY_STREAM_PRIORITY_LOW;
+  low_options.buffer_limit_bytes = 8;
+  envoy_stream_t low_stream = stream_ + 1;
+  http_client_.startStream(low_stream, bridge_callbacks_, low_options);
+
+  // Request data within the stream's buffer limit is held.
+  EXPECT_CALL(low_decoder, decodeHeaders_(_, _)).Times(0);
+  EXPECT_CALL(low_decoder, decodeData(_, _)).Times(0);
+  http_client_.sendHeaders(low_stream, defaultRequestHeaders(), false);
+  http_client_.sendData(low_stream, Data::Utility::copyToBridgeData("0123"), false);
+  testing::Mock::VerifyAndClearExpectations(&low_decoder);
+
+  // Data beyond it releases the stream, although the high priority stream is still pending, rather
+  // than being buffered.
+  EXPECT_CALL(low_decoder, decodeHeaders_(_, false));
+  EXPECT_CALL(low_decoder, decodeData(BufferStringEqual("0123456789ab"), false));
+  http_client_.sendData(low_stream, Data::Utility::copyToBridgeData("456789ab"), false);
+  testing::Mock::VerifyAndClearExpectations(&low_decoder);
+
+  // Later data is sent upstream as it arrives, and the stream isn't released a second time.
+  EXPECT_CALL(low_decoder, decodeData(BufferStringEqual(std::string(64, 'a')), true));
+  http_client_.sendData(low_stream, Data::Utility::copyToBridgeData(std::string(64, 'a')), true);
+  EXPECT_CALL(low_decoder, decodeHeaders_(_, _)).Times(0);
+  TestResponseHeaderMapImpl response_headers{{":status", "200"}};
+  response_encoder_->encodeHeaders(response_headers, false);
+  release_callback->invokeCallback();
+
+  http_client_.cancelStream(low_stream);
+  http_client_.cancelStream(stream_);
+  ASSERT_EQ(cc_.on_cancel_calls, 2);
+}
+
+TEST_P(ClientTest, HeldStreamReleasedAfterMaxHoldTime) {
+  NiceMock<MockTimeSystem> time_system;
+  MonotonicTime now = time_system.monotonicTime();
+  ON_CALL(time_system, monotonicTime()).WillByDefault(ReturnPointee(&now));
+  ON_CALL(dispatcher_, timeSource()).WillByDefault(ReturnRef(time_system));
+  Event::MockDispatcher dispatcher;
+  ON_CALL(dispatcher_, drain).WillByDefault([&](Event::Dispatcher& event_dispatcher) {
+    dispatcher_.Event::ProvisionalDispatcher::drain(event_dispatcher);
+  });
+  dispatcher_.drain(dispatcher);
+  ON_CALL(dispatcher_, createTimer).WillByDefault([&](Event::TimerCb cb) {
+    return dispatcher_.Event::ProvisionalDispatcher::createTimer(cb);
+  });
+  auto* hold_timer = new NiceMock<Event::MockTimer>(&dispatcher);
+
+  envoy_stream_options high_options{};
+  high_options.explicit_flow_control = explicit_flow_control_;
+  high_options.priority = ENVOY_STREAM_PRIORITY_HIGH;
+  createStream(high_options);
+  http_client_.sendHeaders(stream_, defaultRequestHeaders(), true);
+
+  NiceMock<MockRequestDecoder> low_decoder;
+  ON_CALL(low_decoder, streamInfo()).WillByDefault(ReturnRef(stream_info_));
+  EXPECT_CALL(api_listener_, newStream(_, _)).Times(0);
+  EXPECT_CALL(*hold_timer, enableTimer(StreamPriorityScheduler::DefaultMaxHoldTime, _));
+  envoy_stream_options low_options{};
+  low_options.explicit_flow_control = explicit_flow_control_;
+  low_options.priority = ENVOY_STREAM_PRIORITY_LOW;
+  envoy_stream_t low_stream = stream_ + 1;
+  http_client_.startStream(low_stream, bridge_callbacks_, low_options);
+  http_client_.sendHeaders(low_stream, defaultRequestHeaders(), true);
+
+  // Held past the connection manager's default stream idle timeout of 15s, the stream hasn't been
+  // created, so it can't time out.
+  now += std::chrono::seconds(20);
+  testing::Mock::VerifyAndClearExpectations(&api_listener_);
+  EXPECT_EQ(0, cc_.on_error_calls);
+
+  // Once held for the maximum hold time, it's released although the high priority stream is still
+  // pending.
+  now += StreamPriorityScheduler::DefaultMaxHoldTime - std::chrono::seconds(20);
+  EXPECT_CALL(api_listener_, newStream(_, _)).WillOnce(ReturnRef(low_decoder));
+  EXPECT_CALL(low_decoder, decodeHeaders_(_, true));
+  hold_timer->invokeCallback();
+  EXPECT_FALSE(hold_timer->enabled_);
+
+  http_client_.cancelStream(low_stream);
+  http_client_.cancelStream(stream_);
+  ASSERT_EQ(cc_.on_cancel_calls, 2);
+}
+
+TEST_P(ClientTest, SendFileInChunksWithFlowControl) {
+  Event::MockDispatcher dispatcher;
+  ON_CALL(dispatcher_, drain).WillByDefault([&](Event::Dispatcher& event_dispatcher) {
+    dispatcher_.Event::ProvisionalDispatcher::drain(event_dispatcher);
+  });
+  dispatcher_.drain(dispatcher);
+  ON_CALL(dispatcher_, createSchedulableCallback).WillByDefault([&](std::function<void()> cb) {
+    return dispatcher_.Event::ProvisionalDispatcher::createSchedulableCallback(cb);
+  });
+  auto* file_upload_notifier = new NiceMock<Event::MockSchedulableCallback>(&dispatcher);
+  const std::string path =
+      TestEnvironment::writeStringToFileForTest("request_body", "0123456789abcdefghij");
+
+  // Chunks are no larger than the stream's buffer limit.
+  envoy_stream_options options{};
+  options.explicit_flow_control = explicit_flow_control_;
+  options.buffer_limit_bytes = 8;
+  cc_.end_stream_with_headers_ = false;
+  createStream(options);
+  http_client_.sendHeaders(stream_, defaultRequestHeaders(), false);
+
+  // The first chunk is sent straight away, and the next on the next iteration.
+  EXPECT_CALL(*request_decoder_, decodeData(BufferStringEqual("01234567"), false));
+  http_client_.sendFile(stream_, open(path.c_str(), O_RDONLY), 0, 20, true);
+  EXPECT_TRUE(file_upload_notifier->enabled_);
+
+  // No chunks are sent while upstream buffers are full.
+  Stream& stream = response_encoder_->getStream();
+  stream.readDisable(true);
+  file_upload_notifier->invokeCallback();
+  EXPECT_FALSE(file_upload_notifier->enabled_);
+
+  stream.readDisable(false);
+  EXPECT_TRUE(file_upload_notifier->enabled_);
+  EXPECT_CALL(*request_decoder_, decodeData(BufferStringEqual("89abcdef"), false));
+  file_upload_notifier->invokeCallback();
+  EXPECT_CALL(*request_decoder_, decodeData(BufferStringEqual("ghij"), true));
+  file_upload_notifier->invokeCallback();
+  EXPECT_FALSE(file_upload_notifier->enabled_);
+  EXPECT_EQ(cc_.on_send_window_available_calls, 0);
+}
+
+TEST_P(ClientTest, SendFileWithoutBufferLimit) {
+  Event::MockDispatcher dispatcher;
+  ON_CALL(dispatcher_, drain).WillByDefault([&](Event::Dispatcher& event_dispatcher) {
+    dispatcher_.Event::ProvisionalDispatcher::drain(event_dispatcher);
+  });
+  dispatcher_.drain(dispatcher);
+  ON_CALL(dispatcher_, createSchedulableCallback).WillByDefault([&](std::function<void()> cb) {
+    return dispatcher_.Event::ProvisionalDispatcher::createSchedulableCallback(cb);
+  });
+  auto* file_upload_notifier = new NiceMock<Event::MockSchedulableCallback>(&dispatcher);
+  const std::string body(100 * 1024, 'a');
+  const std::string path = TestEnvironment::writeStringToFileForTest("request_body", body);
+
+  // Without a buffer limit, the file is still sent in bounded chunks.
+  Client unlimited_client{api_listener_, dispatcher_, stats_store_, random_, StreamBufferBudget(0)};
+  ON_CALL(dispatcher_, isThreadSafe()).WillByDefault(Return(true));
+  ON_CALL(*request_decoder_, streamInfo()).WillByDefault(ReturnRef(stream_info_));
+  EXPECT_CALL(api_listener_, newStream(_, _))
+      .WillOnce(Invoke([&](ResponseEncoder& encoder, bool) -> RequestDecoder& {
+        response_encoder_ = &encoder;
+        return *request_decoder_;
+      }));
+  unlimited_client.startStream(stream_, bridge_callbacks_, explicit_flow_control_);
+  unlimited_client.sendHeaders(stream_, defaultRequestHeaders(), false);
+
+  EXPECT_CALL(*request_decoder_, decodeData(BufferStringEqual(body.substr(0, 64 * 1024)), false));
+  unlimited_client.sendFile(stream_, open(path.c_str(), O_RDONLY), 0, body.size(), true);
+  EXPECT_TRUE(file_upload_notifier->enabled_);
+  EXPECT_CALL(*request_decoder_, decodeData(BufferStringEqual(body.substr(64 * 1024)), true));
+  file_upload_notifier->invokeCallback();
+  EXPECT_FALSE(file_upload_notifier->enabled_);
+}
+
+TEST_P(ClientTest, SendFileFollowedByData) {
+  Event::MockDispatcher dispatcher;
+  ON_CALL(dispatcher_, drain).WillByDefault([&](Event::Dispatcher& event_dispatcher) {
+    dispatcher_.Event::ProvisionalDispatcher::drain(event_dispatcher);
+  });
+  dispatcher_.drain(dispatcher);
+  ON_CALL(dispatcher_, createSchedulableCallback).WillByDefault([&](std::function<void()> cb) {
+    return dispatcher_.Event::ProvisionalDispatcher::createSchedulableCallback(cb);
+  });
+  auto* file_upload_notifier = new NiceMock<Event::MockSchedulableCallback>(&dispatcher);
+  const std::string path = TestEnvironment::writeStringToFileForTest("request_body", "file");
+  cc_.end_stream_with_headers_ = false;
+  createStream();
+  http_client_.sendHeaders(stream_, defaultRequestHeaders(), false);
+
+  // The file waits for upstream buffers to drain, and data sent meanwhile follows it.
+  Stream& stream = response_encoder_->getStream();
+  stream.readDisable(true);
+  EXPECT_CALL(*request_decoder_, decodeData(_, _)).Times(0);
+  http_client_.sendFile(stream_, open(path.c_str(), O_RDONLY), 0, 4, false);
+  http_client_.sendData(stream_, Data::Utility::copyToBridgeData(" and data"), true);
+
+  stream.readDisable(false);
+  testing::InSequence s;
+  EXPECT_CALL(*request_decoder_, decodeData(BufferStringEqual("file"), false));
+  EXPECT_CALL(*request_decoder_, decodeData(BufferStringEqual(" and data"), true));
+  file_upload_notifier->invokeCallback();
+  EXPECT_EQ(cc_.on_send_window_available_calls, 0);
+}
+
+TEST_P(ClientTest, SendFilesBackToBack) {
+  Event::MockDispatcher dispatcher;
+  ON_CALL(dispatcher_, drain).WillByDefault([&](Event::Dispatcher& event_dispatcher) {
+    dispatcher_.Event::ProvisionalDispatcher::drain(event_dispatcher);
+  });
+  dispatcher_.drain(dispatcher);
+  ON_CALL(dispatcher_, createSchedulableCallback).WillByDefault([&](std::function<void()> cb) {
+    return dispatcher_.Event::ProvisionalDispatcher::createSchedulableCallback(cb);
+  });
+  auto* file_upload_notifier = new NiceMock<Event::MockSchedulableCallback>(&dispatcher);
+  const std::string first_path = TestEnvironment::writeStringToFileForTest("first_body", "first");
+  const std::string second_path =
+      TestEnvironment::writeStringToFileForTest("second_body", "second");
+  cc_.end_stream_with_headers_ = false;
+  createStream();
+  http_client_.sendHeaders(stream_, defaultRequestHeaders(), false);
+
+  // A file sent while another is being sent is queued behind it and the data sent after it.
+  Stream& stream = response_encoder_->getStream();
+  stream.readDisable(true);
+  EXPECT_CALL(*request_decoder_, decodeData(_, _)).Times(0);
+  EXPECT_CALL(dispatcher_, deferredDelete_(_)).Times(0);
+  http_client_.sendFile(stream_, open(first_path.c_str(), O_RDONLY), 0, 5, false);
+  http_client_.sendData(stream_, Data::Utility::copyToBridgeData(" and "), false);
+  http_client_.sendFile(stream_, open(second_path.c_str(), O_RDONLY), 0, 6, false);
+  TestRequestTrailerMapImpl trailers{{"x-trailer", "1"}};
+  http_client_.sendTrailers(stream_, Utility::toBridgeHeaders(trailers));
+
+  stream.readDisable(false);
+  testing::InSequence s;
+  EXPECT_CALL(*request_decoder_, decodeData(BufferStringEqual("first"), false));
+  EXPECT_CALL(*request_decoder_, decodeData(BufferStringEqual(" and "), false));
+  file_upload_notifier->invokeCallback();
+  EXPECT_TRUE(file_upload_notifier->enabled_);
+  EXPECT_CALL(*request_decoder_, decodeData(BufferStringEqual("second"), false));
+  EXPECT_CALL(*request_decoder_, decodeTrailers_(_));
+  file_upload_notifier->invokeCallback();
+  EXPECT_FALSE(file_upload_notifier->enabled_);
+  EXPECT_EQ(cc_.on_error_calls, 0);
+  EXPECT_EQ(cc_.on_send_window_available_calls, 0);
+}
+
+TEST_P(ClientTest, SendFileReadFailureResetsStream) {
+  const std::string path = TestEnvironment::writeStringToFileForTest("request_body", "short");
+  cc_.end_stream_with_headers_ = false;
+  createStream();
+  http_client_.sendHeaders(stream_, defaultRequestHeaders(), false);
+
+  // The file ends before the range does.
+  EXPECT_CALL(*request_decoder_, decodeData(_, _)).Times(0);
+  EXPECT_CALL(dispatcher_, deferredDelete_(_));
+  http_client_.sendFile(stream_, open(path.c_str(), O_RDONLY), 0, 100, true);
+  EXPECT_EQ(cc_.on_error_calls, 1);
+}
+
+TEST_P(ClientTest, WriteResponseBodyToFile) {
+  const std::string path = TestEnvironment::temporaryPath("response_body");
+  const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  ASSERT_GE(fd, 0);
+  cc_.end_stream_with_headers_ = false;
+  createFileStream(fd);
+  MockStreamCallbacks stream_callbacks;
+  response_encoder_->getStream().addCallbacks(stream_callbacks);
+  http_client_.sendHeaders(stream_, defaultRequestHeaders(), true);
+
+  TestResponseHeaderMapImpl response_headers{{":status", "200"}};
+  response_encoder_->encodeHeaders(response_headers, false);
+  EXPECT_EQ(cc_.on_headers_calls, 1);
+
+  // The body is written without being asked for, and upstream is read disabled while more than
+  // the buffer limit is unwritten.
+  EXPECT_CALL(stream_callbacks, onAboveWriteBufferHighWatermark());
+  Buffer::OwnedImpl response_data("response body");
+  response_encoder_->encodeData(response_data, false);
+  resumeDataIfExplicitFlowControl(20);
+  EXPECT_CALL(stream_callbacks, onBelowWriteBufferLowWatermark());
+  runPosts(1);
+  EXPECT_EQ(13, cc_.response_body_written);
+
+  // The stream completes once the whole body has been written, and trailers follow it.
+  Buffer::OwnedImpl last_data("!");
+  response_encoder_->encodeData(last_data, false);
+  TestResponseTrailerMapImpl response_trailers{{"x-trailer", "1"}};
+  response_encoder_->encodeTrailers(response_trailers);
+  EXPECT_EQ(cc_.on_trailers_calls, 0);
+  EXPECT_CALL(dispatcher_, deferredDelete_(_));
+  runPosts(2);
+  EXPECT_EQ(14, cc_.response_body_written);
+  EXPECT_EQ(cc_.on_trailers_calls, 1);
+  EXPECT_EQ(cc_.on_complete_calls, 1);
+  EXPECT_EQ(cc_.on_data_calls, 0);
+  close(fd);
+  EXPECT_EQ("response body!", TestEnvironment::readFileToStringForTest(path));
+}
+
+TEST_P(ClientTest, WriteResponseBodyToFileFailureFailsStream) {
+  TestEnvironment::writeStringToFileForTest("response_body", "");
+  const int fd = open(TestEnvironment::temporaryPath("response_body").c_str(), O_RDONLY);
+  ASSERT_GE(fd, 0);
+  cc_.end_stream_with_headers_ = false;
+  createFileStream(fd);
+  http_client_.sendHeaders(stream_, defaultRequestHeaders(), true);
+  TestResponseHeaderMapImpl response_headers{{":status", "200"}};
+  response_encoder_->encodeHeaders(response_headers, false);
+
+  Buffer::OwnedImpl response_data("response body");
+  response_encoder_->encodeData(response_data, true);
+  EXPECT_CALL(dispatcher_, deferredDelete_(_));
+  runPosts(1);
+  EXPECT_EQ(cc_.on_error_calls, 1);
+  EXPECT_EQ(cc_.on_complete_calls, 0);
+  close(fd);
+}
+
 TEST_P(ClientTest, EmptyDataWithEndStream) {
   cc_.end_stream_with_headers_ = false;
 
@@ -465,7 +1187,7 @@ TEST_P(ClientTest, MultipleStreams) {
   NiceMock<MockRequestDecoder> request_decoder2;
   ON_CALL(request_decoder2, streamInfo()).WillByDefault(ReturnRef(stream_info_));
   ResponseEncoder* response_encoder2{};
-  envoy_http_callbacks bridge_callbacks_2;
+  envoy_http_callbacks bridge_callbacks_2{};
   callbacks_called cc2 = {0, 0, 0, 0, 0, 0, 0, "200", true, ""};
   bridge_callbacks_2.context = &cc2;
   bridge_callbacks_2.on_headers = [](envoy_headers c_headers, bool end_stream, envoy_stream_intel,
@@ -525,6 +1247,43 @@ TEST_P(ClientTest, MultipleStreams) {
   ASSERT_EQ(cc_.on_complete_calls, 1);
 }
 
+TEST_P(ClientTest, CallbackLatencySampledPerCallback) {
+  cc_.end_stream_with_headers_ = false;
+  NiceMock<Stats::MockIsolatedStatsStore> stats_store;
+  Client sampled_client{api_listener_, dispatcher_, stats_store, random_, StreamBufferBudget(),
+                        CallbackLatencySampler(3)};
+
+  // Each stream invokes on_headers, on_data and on_complete in turn. Sampling one in three of
+  // each callback records one latency in each histogram, rather than every third callback.
+  EXPECT_CALL(stats_store, deliverHistogramToSinks(_, _)).Times(0);
+  for (const std::string callback : {"on_headers", "on_data", "on_complete"}) {
+    EXPECT_CALL(stats_store,
+                deliverHistogramToSinks(Property(&Stats::Metric::name,
+                                                 "http.client." + callback + "_callback_latency"),
+                                        _));
+  }
+
+  ON_CALL(dispatcher_, isThreadSafe()).WillByDefault(Return(true));
+  ON_CALL(*request_decoder_, streamInfo()).WillByDefault(ReturnRef(stream_info_));
+  EXPECT_CALL(dispatcher_, deferredDelete_(_)).Times(3);
+  for (envoy_stream_t stream = 1; stream <= 3; stream++) {
+    EXPECT_CALL(api_listener_, newStream(_, _))
+        .WillOnce(Invoke([&](ResponseEncoder& encoder, bool) -> RequestDecoder& {
+          response_encoder_ = &encoder;
+          return *request_decoder_;
+        }));
+    sampled_client.startStream(stream, bridge_callbacks_, explicit_flow_control_);
+
+    TestResponseHeaderMapImpl response_headers{{":status", "200"}};
+    response_encoder_->encodeHeaders(response_headers, false);
+    Buffer::OwnedImpl response_data("response body");
+    response_encoder_->encodeData(response_data, true);
+    resumeDataIfExplicitFlowControl(20);
+  }
+  EXPECT_EQ(3, cc_.on_data_calls);
+  EXPECT_EQ(3, cc_.on_complete_calls);
+}
+
 TEST_P(ClientTest, EnvoyLocalError) {
   // Override the on_error default with some custom checks.
   bridge_callbacks_.on_error = [](envoy_error error, envoy_stream_intel, envoy_final_stream_intel,
@@ -598,6 +1357,40 @@ TEST_P(ClientTest, DoubleResetStreamLocal) {
   ASSERT_EQ(cc_.on_complete_calls, 0);
 }
 
+TEST_P(ClientTest, CancelDetachesStreamWithSharedResponse) {
+  cc_.end_stream_with_headers_ = false;
+  createStream();
+  MockStreamCallbacks stream_callbacks;
+  response_encoder_->getStream().addCallbacks(stream_callbacks);
+  http_client_.sendHeaders(stream_, defaultRequestHeaders(), true);
+  auto shared_response = std::make_shared<TestSharedResponse>();
+  stream_info_.filterState()->setData(StreamInfo::SharedResponse::key(), shared_response,
+                                      StreamInfo::FilterState::StateType::Mutable,
+                                      StreamInfo::FilterState::LifeSpan::Request);
+
+  // The platform is told the stream is cancelled, but the request is not reset.
+  EXPECT_CALL(stream_callbacks, onResetStream(_, _)).Times(0);
+  EXPECT_CALL(dispatcher_, deferredDelete_(_)).Times(0);
+  http_client_.cancelStream(stream_);
+  EXPECT_EQ(cc_.on_cancel_calls, 1);
+  EXPECT_TRUE(shared_response->detached_);
+  http_client_.cancelStream(stream_);
+  EXPECT_EQ(cc_.on_cancel_calls, 1);
+  testing::Mock::VerifyAndClearExpectations(&dispatcher_);
+
+  // The response no longer reaches the platform, and the stream is removed once it ends.
+  TestResponseHeaderMapImpl response_headers{{":status", "200"}};
+  response_encoder_->encodeHeaders(response_headers, false);
+  EXPECT_CALL(dispatcher_, deferredDelete_(_));
+  Buffer::OwnedImpl response_data("response body");
+  response_encoder_->encodeData(response_data, true);
+  EXPECT_EQ(response_data.length(), 0);
+  EXPECT_EQ(cc_.on_headers_calls, 0);
+  EXPECT_EQ(cc_.on_data_calls, 0);
+  EXPECT_EQ(cc_.on_complete_calls, 0);
+  EXPECT_EQ(cc_.on_cancel_calls, 1);
+}
+
 TEST_P(ClientTest, RemoteResetAfterStreamStart) {
   cc_.end_stream_with_headers_ = false;
 
@@ -739,7 +1532,7 @@ TEST_P(ClientTest, EncodeMetadata) {
 
 TEST_P(ClientTest, NullAccessors) {
   envoy_stream_t stream = 1;
-  envoy_http_callbacks bridge_callbacks;
+  envoy_http_callbacks bridge_callbacks{};
 
   // Create a stream.
   ON_CALL(dispatcher_, isThreadSafe()).WillByDefault(Return(true));
@@ -949,5 +1742,96 @@ TEST_P(ExplicitFlowControlTest, CancelWithStreamComplete) {
   ASSERT_EQ(cc_.on_complete_calls, 0);
 }
 
+TEST_P(ExplicitFlowControlTest, StreamBufferLimit) {
+  createStream();
+  EXPECT_EQ(StreamBufferBudget::DefaultStreamLimit, response_encoder_->getStream().bufferLimit());
+
+  // Streams may override the default limit when they are started.
+  envoy_stream_options options{};
+  options.explicit_flow_control = true;
+  options.buffer_limit_bytes = 4096;
+  ResponseEncoder* response_encoder2{};
+  EXPECT_CALL(api_listener_, newStream(_, _))
+      .WillOnce(Invoke([&](ResponseEncoder& encoder, bool) -> RequestDecoder& {
+        response_encoder2 = &encoder;
+        return *request_decoder_;
+      }));
+  http_client_.startStream(stream_ + 1, bridge_callbacks_, options);
+  EXPECT_EQ(4096, response_encoder2->getStream().bufferLimit());
+}
+
+TEST_P(ExplicitFlowControlTest, BufferBudgetLowersWatermark) {
+  cc_.end_stream_with_headers_ = false;
+  constexpr uint32_t stream_limit = 64 * 1024;
+  Client budgeted_client{api_listener_, dispatcher_, stats_store_, random_,
+                         StreamBufferBudget(stream_limit, 2 * stream_limit)};
+
+  ON_CALL(dispatcher_, isThreadSafe()).WillByDefault(Return(true));
+  ON_CALL(*request_decoder_, streamInfo()).WillByDefault(ReturnRef(stream_info_));
+  EXPECT_CALL(api_listener_, newStream(_, _))
+      .WillOnce(Invoke([&](ResponseEncoder& encoder, bool) -> RequestDecoder& {
+        response_encoder_ = &encoder;
+        return *request_decoder_;
+      }));
+  budgeted_client.startStream(stream_, bridge_callbacks_, true);
+  EXPECT_EQ(stream_limit, response_encoder_->getStream().bufferLimit());
+
+  MockStreamCallbacks stream_callbacks;
+  response_encoder_->getStream().addCallbacks(stream_callbacks);
+  TestResponseHeaderMapImpl response_headers{{":status", "200"}};
+  response_encoder_->encodeHeaders(response_headers, false);
+
+  // Buffering a full stream limit uses half of the budget, which halves the stream's watermark
+  // and so pushes back on the upstream.
+  EXPECT_CALL(stream_callbacks, onAboveWriteBufferHighWatermark());
+  Buffer::OwnedImpl response_data(std::string(stream_limit, 'a'));
+  response_encoder_->encodeData(response_data, false);
+
+  // Once the data is drained, the watermark is restored.
+  EXPECT_CALL(stream_callbacks, onBelowWriteBufferLowWatermark());
+  resumeDataIfExplicitFlowControl(stream_limit);
+  EXPECT_EQ(stream_limit, cc_.body_data_.size());
+}
+
+TEST_P(ExplicitFlowControlTest, AutoTunedReadWindow) {
+  cc_.end_stream_with_headers_ = false;
+  ON_CALL(dispatcher_, isThreadSafe()).WillByDefault(Return(true));
+  ON_CALL(*request_decoder_, streamInfo()).WillByDefault(ReturnRef(stream_info_));
+  EXPECT_CALL(api_listener_, newStream(_, _))
+      .WillOnce(Invoke([&](ResponseEncoder& encoder, bool) -> RequestDecoder& {
+        response_encoder_ = &encoder;
+        return *request_decoder_;
+      }));
+  envoy_stream_options options{};
+  options.explicit_flow_control = true;
+  options.auto_tune_read_window = true;
+  http_client_.startStream(stream_, bridge_callbacks_, options);
+  EXPECT_CALL(*request_decoder_, decodeHeaders_(_, true));
+  http_client_.sendHeaders(stream_, defaultRequestHeaders(), true);
+
+  TestResponseHeaderMapImpl response_headers{{":status", "200"}};
+  response_encoder_->encodeHeaders(response_headers, false);
+
+  // A single grant permits data to be delivered as it arrives, until its credit is used.
+  resumeDataIfExplicitFlowControl(8);
+  Buffer::OwnedImpl response_data("1234");
+  response_encoder_->encodeData(response_data, false);
+  Buffer::OwnedImpl response_data2("5678");
+  response_encoder_->encodeData(response_data2, false);
+  EXPECT_EQ(2, cc_.on_data_calls);
+  EXPECT_EQ("12345678", cc_.body_data_);
+
+  // Once the credit is used, data is buffered until the next grant.
+  Buffer::OwnedImpl response_data3("9");
+  response_encoder_->encodeData(response_data3, true);
+  request_decoder_.reset();
+  EXPECT_EQ(2, cc_.on_data_calls);
+  ASSERT_EQ(cc_.on_complete_calls, 0);
+
+  resumeDataIfExplicitFlowControl(8);
+  EXPECT_EQ("123456789", cc_.body_data_);
+  ASSERT_EQ(cc_.on_complete_calls, 1);
+}
+
 } // namespace Http
 } // namespace Envoy
@@ -4,6 +4,7 @@
 #include "library/common/bridge/utility.h"
 #include "library/common/data/utility.h"
 #include "library/common/http/header_utility.h"
+#include "library/common/http/well_known_headers.h"
 #include "library/common/types/c_types.h"
 
 namespace Envoy {
@@ -176,5 +177,51 @@ TEST(HeaderDataConstructorTest, FromCppToCWithAlpn) {
   release_envoy_headers(c_headers);
 }
 
+TEST(HeaderDataConstructorTest, FromCppToCPreservesCase) {
+  envoy_headers original_headers =
+      Bridge::Utility::makeEnvoyMap({{"Content-Type", "text/plain"}, {"x-lower", "value"}});
+  RequestHeaderMapPtr cpp_headers = Utility::toRequestHeaders(original_headers);
+
+  envoy_headers c_headers = Utility::toBridgeHeaders(*cpp_headers);
+
+  ASSERT_EQ(2, c_headers.length);
+  EXPECT_EQ("Content-Type", Data::Utility::copyToString(c_headers.entries[0].key));
+  EXPECT_EQ("text/plain", Data::Utility::copyToString(c_headers.entries[0].value));
+  EXPECT_EQ("x-lower", Data::Utility::copyToString(c_headers.entries[1].key));
+  EXPECT_EQ("value", Data::Utility::copyToString(c_headers.entries[1].value));
+  release_envoy_headers(c_headers);
+}
+
+TEST(RequestHeaderDataConstructorTest, FromCToCppInternsWellKnownKeys) {
+  envoy_headers c_headers = Bridge::Utility::makeEnvoyMap(
+      {{":method", "GET"}, {"content-type", "text/plain"}, {"Accept", "*/*"}, {"x-custom", "1"}});
+  RequestHeaderMapPtr cpp_headers = Utility::toRequestHeaders(c_headers);
+  ASSERT_EQ(4, cpp_headers->size());
+
+  // Lowercase well-known keys reference the interned keys rather than copies of them.
+  const LowerCaseString* content_type = WellKnownHeaders::get().find("content-type");
+  ASSERT_NE(nullptr, content_type);
+  auto entries = cpp_headers->get(*content_type);
+  ASSERT_EQ(1, entries.size());
+  EXPECT_EQ(content_type->get().data(), entries[0]->key().getStringView().data());
+  EXPECT_EQ("text/plain", entries[0]->value().getStringView());
+  EXPECT_EQ("GET", cpp_headers->getMethodValue());
+  EXPECT_EQ("1", cpp_headers->get(LowerCaseString("x-custom"))[0]->value().getStringView());
+
+  // Only keys which are not lowercase have their original case restored.
+  envoy_headers bridge_headers = Utility::toBridgeHeaders(*cpp_headers);
+  std::map<std::string, std::string> keys;
+  for (envoy_map_size_t i = 0; i < bridge_headers.length; i++) {
+    keys.emplace(Data::Utility::copyToString(bridge_headers.entries[i].key),
+                 Data::Utility::copyToString(bridge_headers.entries[i].value));
+  }
+  EXPECT_EQ((std::map<std::string, std::string>{{":method", "GET"},
+                                                {"content-type", "text/plain"},
+                                                {"Accept", "*/*"},
+                                                {"x-custom", "1"}}),
+            keys);
+  release_envoy_headers(bridge_headers);
+}
+
 } // namespace Http
 } // namespace Envoy
@@ -0,0 +1,79 @@
+#include "gtest/gtest.h"
+#include "library/common/http/read_window.h"
+
+namespace Envoy {
+namespace Http {
+
+class ReadWindowTest : public testing::Test {
+public:
+  void advance(std::chrono::milliseconds duration) { now_ += duration; }
+
+  MonotonicTime now_;
+  ReadWindow window_{1024};
+};
+
+TEST_F(ReadWindowTest, StartsAtFirstGrant) {
+  EXPECT_EQ(64, window_.onGrant(64, now_));
+  EXPECT_EQ(64, window_.window());
+  EXPECT_EQ(40, window_.onDelivered(24, now_));
+  EXPECT_EQ(0, window_.onDelivered(40, now_));
+}
+
+TEST_F(ReadWindowTest, GrowsWhenCreditRunsOutAndConsumerKeepsUp) {
+  window_.onGrant(64, now_);
+  window_.onDelivered(64, now_);
+  advance(std::chrono::milliseconds(1));
+  EXPECT_EQ(128, window_.onGrant(64, now_));
+
+  // Grants which arrive while credit remains top it up without growing the window.
+  window_.onDelivered(64, now_);
+  EXPECT_EQ(128, window_.onGrant(64, now_));
+
+  // The window doubles up to the maximum.
+  for (int i = 0; i < 8; ++i) {
+    window_.onDelivered(window_.credit(), now_);
+    window_.onGrant(64, now_);
+  }
+  EXPECT_EQ(1024, window_.window());
+}
+
+TEST_F(ReadWindowTest, DoesNotGrowWhenConsumerIsNotPrompt) {
+  window_.onGrant(64, now_);
+  window_.onDelivered(64, now_);
+  advance(ReadWindow::FastGrantInterval + std::chrono::milliseconds(1));
+  EXPECT_EQ(64, window_.onGrant(64, now_));
+}
+
+TEST_F(ReadWindowTest, ShrinksWhenConsumerFallsBehind) {
+  window_.onGrant(256, now_);
+  window_.onDelivered(256, now_);
+  window_.onGrant(64, now_);
+  EXPECT_EQ(512, window_.window());
+
+  window_.onDelivered(100, now_);
+  advance(ReadWindow::SlowGrantInterval);
+  EXPECT_EQ(256, window_.onGrant(64, now_));
+
+  // The window does not shrink below the size of the grants.
+  for (int i = 0; i < 8; ++i) {
+    window_.onDelivered(1, now_);
+    advance(ReadWindow::SlowGrantInterval);
+    window_.onGrant(64, now_);
+  }
+  EXPECT_EQ(64, window_.window());
+
+  // A slow grant with nothing delivered since the last one does not shrink the window.
+  window_.onDelivered(64, now_);
+  window_.onGrant(128, now_);
+  EXPECT_EQ(128, window_.window());
+  advance(ReadWindow::SlowGrantInterval);
+  EXPECT_EQ(128, window_.onGrant(64, now_));
+}
+
+TEST_F(ReadWindowTest, GrantsLargerThanTheMaximum) {
+  EXPECT_EQ(4096, window_.onGrant(4096, now_));
+  EXPECT_EQ(1024, window_.window());
+}
+
+} // namespace Http
+} // namespace Envoy
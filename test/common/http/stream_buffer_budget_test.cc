@@ -0,0 +1,50 @@
+#include "gtest/gtest.h"
+#include "library/common/http/stream_buffer_budget.h"
+
+namespace Envoy {
+namespace Http {
+
+TEST(StreamBufferBudgetTest, NoBudget) {
+  StreamBufferBudget budget;
+  EXPECT_EQ(StreamBufferBudget::DefaultStreamLimit, budget.limitFor(0));
+  EXPECT_EQ(4096, budget.limitFor(4096));
+
+  // Without a budget, buffered bytes are tracked but limits are unchanged.
+  budget.update(0, 10 * StreamBufferBudget::DefaultStreamLimit);
+  EXPECT_EQ(10 * StreamBufferBudget::DefaultStreamLimit, budget.buffered());
+  EXPECT_EQ(StreamBufferBudget::DefaultStreamLimit, budget.limitFor(0));
+}
+
+TEST(StreamBufferBudgetTest, LimitsShrinkAsBudgetFills) {
+  constexpr uint32_t limit = 1024 * 1024;
+  StreamBufferBudget budget(limit, 4 * limit);
+  EXPECT_EQ(limit, budget.limitFor(0));
+
+  budget.update(0, limit);
+  EXPECT_EQ(limit * 3 / 4, budget.limitFor(0));
+  EXPECT_EQ(limit * 3 / 8, budget.limitFor(limit / 2));
+
+  budget.update(0, 2 * limit);
+  EXPECT_EQ(limit / 4, budget.limitFor(0));
+
+  // Limits are restored as buffers drain.
+  budget.update(2 * limit, 0);
+  EXPECT_EQ(limit * 3 / 4, budget.limitFor(0));
+  budget.update(limit, 0);
+  EXPECT_EQ(0, budget.buffered());
+  EXPECT_EQ(limit, budget.limitFor(0));
+}
+
+TEST(StreamBufferBudgetTest, LimitsHaveAFloor) {
+  constexpr uint32_t limit = 1024 * 1024;
+  StreamBufferBudget budget(limit, 4 * limit);
+
+  // Once the budget is exhausted, streams are still granted enough to make progress.
+  budget.update(0, 5 * limit);
+  EXPECT_EQ(StreamBufferBudget::MinStreamLimit, budget.limitFor(0));
+  // Limits which are already below the floor are not raised to it.
+  EXPECT_EQ(1024, budget.limitFor(1024));
+}
+
+} // namespace Http
+} // namespace Envoy
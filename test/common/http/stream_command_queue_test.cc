@@ -0,0 +1,183 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <thread>
+#include <vector>
+
+#include "source/common/buffer/buffer_impl.h"
+
+#include "gtest/gtest.h"
+#include "library/common/data/utility.h"
+#include "library/common/http/stream_command_queue.h"
+
+namespace Envoy {
+namespace Http {
+
+TEST(StreamCommandQueueTest, OnlyFirstEnqueueRequestsWakeup) {
+  StreamCommandQueue queue;
+  EXPECT_TRUE(queue.enqueue(StreamCommand::cancel(1)));
+  EXPECT_FALSE(queue.enqueue(StreamCommand::cancel(2)));
+  EXPECT_FALSE(queue.enqueue(StreamCommand::readData(3, 10)));
+
+  std::vector<envoy_stream_t> streams;
+  EXPECT_EQ(3, queue.drain([&](StreamCommand& command) { streams.push_back(command.stream_); }));
+  EXPECT_EQ((std::vector<envoy_stream_t>{1, 2, 3}), streams);
+
+  // Once drained, the next command requires a new wakeup.
+  EXPECT_TRUE(queue.enqueue(StreamCommand::cancel(4)));
+  EXPECT_EQ(1, queue.drain([](StreamCommand&) {}));
+}
+
+TEST(StreamCommandQueueTest, FailedWakeupIsRetried) {
+  StreamCommandQueue queue;
+  EXPECT_TRUE(queue.enqueue(StreamCommand::cancel(1)));
+  queue.onWakeupFailed();
+  EXPECT_TRUE(queue.enqueue(StreamCommand::cancel(2)));
+  EXPECT_EQ(2, queue.drain([](StreamCommand&) {}));
+}
+
+TEST(StreamCommandQueueTest, CommandsCarryPayloads) {
+  StreamCommandQueue queue;
+  Buffer::OwnedImpl buffer("request body");
+  envoy_data data = Data::Utility::toBridgeData(buffer);
+  queue.enqueue(StreamCommand::sendData(7, data, true));
+  queue.enqueue(StreamCommand::readData(7, 1024));
+
+  std::vector<StreamCommand> commands;
+  queue.drain([&](StreamCommand& command) { commands.push_back(command); });
+  ASSERT_EQ(2, commands.size());
+  EXPECT_EQ(StreamCommandType::SendData, commands[0].type_);
+  EXPECT_TRUE(commands[0].flag_);
+  EXPECT_EQ("request body", Data::Utility::copyToString(commands[0].data_));
+  EXPECT_EQ(StreamCommandType::ReadData, commands[1].type_);
+  EXPECT_EQ(1024, commands[1].bytes_to_read_);
+  commands[0].releasePayload();
+}
+
+TEST(StreamCommandQueueTest, OverflowPreservesOrder) {
+  StreamCommandQueue queue(4);
+  EXPECT_EQ(4, queue.capacity());
+  for (envoy_stream_t i = 0; i < 10; ++i) {
+    queue.enqueue(StreamCommand::cancel(i));
+  }
+
+  std::vector<envoy_stream_t> streams;
+  EXPECT_EQ(10, queue.drain([&](StreamCommand& command) { streams.push_back(command.stream_); }));
+  for (envoy_stream_t i = 0; i < 10; ++i) {
+    EXPECT_EQ(i, streams[i]);
+  }
+
+  // The ring is used again once the overflow has been drained.
+  queue.enqueue(StreamCommand::cancel(10));
+  streams.clear();
+  queue.drain([&](StreamCommand& command) { streams.push_back(command.stream_); });
+  EXPECT_EQ(std::vector<envoy_stream_t>{10}, streams);
+}
+
+TEST(StreamCommandQueueTest, OverflowWaitsForDelayedPublisher) {
+  StreamCommandQueue queue(4);
+  queue.synchronizer().enable();
+  queue.synchronizer().waitOn("publish");
+
+  // The first producer claims the first cell, but doesn't publish to it yet. Only the first
+  // publish waits.
+  std::thread delayed([&queue]() { queue.enqueue(StreamCommand::cancel(1)); });
+  queue.synchronizer().barrierOn("publish");
+
+  // The second producer fills the rest of the ring, then spills into the overflow.
+  std::thread producer([&queue]() {
+    for (size_t i = 0; i < 4; ++i) {
+      queue.enqueue(StreamCommand::readData(2, i));
+    }
+  });
+  producer.join();
+
+  // The second producer's overflow command isn't run ahead of its commands in the ring, which are
+  // behind the unpublished cell.
+  std::vector<StreamCommand> commands;
+  auto record = [&](StreamCommand& command) { commands.push_back(command); };
+  EXPECT_EQ(0, queue.drain(record));
+
+  queue.synchronizer().signal("publish");
+  delayed.join();
+  EXPECT_EQ(5, queue.drain(record));
+  ASSERT_EQ(5, commands.size());
+  EXPECT_EQ(1, commands[0].stream_);
+  for (size_t i = 0; i < 4; ++i) {
+    EXPECT_EQ(2, commands[i + 1].stream_);
+    EXPECT_EQ(i, commands[i + 1].bytes_to_read_);
+  }
+}
+
+TEST(StreamCommandQueueTest, DrainIsBounded) {
+  StreamCommandQueue queue(64);
+  const uint64_t total = StreamCommandQueue::MaxCommandsPerDrain + 10;
+  EXPECT_TRUE(queue.enqueue(StreamCommand::readData(1, 0)));
+  for (uint64_t i = 1; i < total; ++i) {
+    EXPECT_FALSE(queue.enqueue(StreamCommand::readData(1, i)));
+  }
+
+  uint64_t next = 0;
+  auto check = [&](StreamCommand& command) { EXPECT_EQ(next++, command.bytes_to_read_); };
+  EXPECT_EQ(StreamCommandQueue::MaxCommandsPerDrain, queue.drain(check));
+  // Nothing else scheduled a drain, so the consumer must.
+  EXPECT_TRUE(queue.rescheduleDrain());
+  EXPECT_FALSE(queue.enqueue(StreamCommand::readData(1, total)));
+  EXPECT_EQ(11, queue.drain(check));
+  EXPECT_EQ(total + 1, next);
+}
+
+TEST(StreamCommandQueueTest, UndrainedPayloadsAreReleased) {
+  bool released = false;
+  envoy_data data{0, nullptr, [](void* context) { *static_cast<bool*>(context) = true; },
+                  &released};
+  {
+    StreamCommandQueue queue;
+    queue.enqueue(StreamCommand::sendData(1, data, false));
+  }
+  EXPECT_TRUE(released);
+}
+
+TEST(StreamCommandQueueTest, UndrainedFilesAreClosed) {
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  {
+    StreamCommandQueue queue;
+    queue.enqueue(StreamCommand::sendFile(1, fds[0], 0, 10, true));
+  }
+  EXPECT_EQ(-1, fcntl(fds[0], F_GETFD));
+  close(fds[1]);
+}
+
+TEST(StreamCommandQueueTest, ConcurrentProducersPreservePerProducerOrder) {
+  constexpr int producers = 8;
+  constexpr int commands_per_producer = 10000;
+  StreamCommandQueue queue(64);
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p) {
+    threads.emplace_back([&queue, p]() {
+      for (int i = 0; i < commands_per_producer; ++i) {
+        queue.enqueue(StreamCommand::readData(p, i));
+      }
+    });
+  }
+
+  std::vector<size_t> next(producers, 0);
+  uint64_t total = 0;
+  auto check = [&](StreamCommand& command) {
+    EXPECT_EQ(next[command.stream_]++, command.bytes_to_read_);
+    ++total;
+  };
+  while (total < producers * commands_per_producer) {
+    queue.drain(check);
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  queue.drain(check);
+  EXPECT_EQ(producers * commands_per_producer, total);
+}
+
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,69 @@
+#include "gtest/gtest.h"
+#include "library/common/http/stream_priority_scheduler.h"
+
+namespace Envoy {
+namespace Http {
+
+TEST(StreamPrioritySchedulerTest, HoldsLowPriorityWhileHighPriorityPending) {
+  StreamPriorityScheduler scheduler;
+  EXPECT_FALSE(scheduler.shouldHold(ENVOY_STREAM_PRIORITY_LOW));
+
+  scheduler.onHighPriorityPending();
+  EXPECT_TRUE(scheduler.shouldHold(ENVOY_STREAM_PRIORITY_LOW));
+  EXPECT_FALSE(scheduler.shouldHold(ENVOY_STREAM_PRIORITY_NORMAL));
+  EXPECT_FALSE(scheduler.shouldHold(ENVOY_STREAM_PRIORITY_HIGH));
+
+  scheduler.hold(3, MonotonicTime{});
+  scheduler.hold(1, MonotonicTime{});
+  EXPECT_EQ(2, scheduler.held());
+  EXPECT_TRUE(scheduler.release().empty());
+
+  EXPECT_TRUE(scheduler.onHighPriorityResolved());
+  EXPECT_FALSE(scheduler.shouldHold(ENVOY_STREAM_PRIORITY_LOW));
+  // Streams are released in the order they were held.
+  EXPECT_EQ((std::vector<envoy_stream_t>{3, 1}), scheduler.release());
+  EXPECT_EQ(0, scheduler.held());
+}
+
+TEST(StreamPrioritySchedulerTest, ReleasesOnceNoHighPriorityPending) {
+  StreamPriorityScheduler scheduler;
+  scheduler.onHighPriorityPending();
+  scheduler.onHighPriorityPending();
+  scheduler.hold(1, MonotonicTime{});
+
+  EXPECT_FALSE(scheduler.onHighPriorityResolved());
+  EXPECT_TRUE(scheduler.shouldHold(ENVOY_STREAM_PRIORITY_LOW));
+  EXPECT_TRUE(scheduler.onHighPriorityResolved());
+  EXPECT_EQ(1, scheduler.release().size());
+}
+
+TEST(StreamPrioritySchedulerTest, NothingToReleaseWithoutHeldStreams) {
+  StreamPriorityScheduler scheduler;
+  scheduler.onHighPriorityPending();
+  EXPECT_FALSE(scheduler.onHighPriorityResolved());
+  EXPECT_TRUE(scheduler.release().empty());
+}
+
+TEST(StreamPrioritySchedulerTest, ReleasesStreamsHeldForMaxHoldTime) {
+  StreamPriorityScheduler scheduler(std::chrono::milliseconds(100));
+  EXPECT_FALSE(scheduler.nextExpiry().has_value());
+
+  const MonotonicTime start{};
+  scheduler.onHighPriorityPending();
+  scheduler.hold(1, start);
+  scheduler.hold(2, start + std::chrono::milliseconds(50));
+  EXPECT_EQ(start + std::chrono::milliseconds(100), scheduler.nextExpiry());
+
+  EXPECT_TRUE(scheduler.releaseExpired(start + std::chrono::milliseconds(99)).empty());
+  // Streams are released as they expire, although the high priority stream is still pending.
+  EXPECT_EQ(std::vector<envoy_stream_t>{1},
+            scheduler.releaseExpired(start + std::chrono::milliseconds(100)));
+  EXPECT_EQ(start + std::chrono::milliseconds(150), scheduler.nextExpiry());
+  EXPECT_EQ(std::vector<envoy_stream_t>{2},
+            scheduler.releaseExpired(start + std::chrono::milliseconds(200)));
+  EXPECT_FALSE(scheduler.nextExpiry().has_value());
+  EXPECT_EQ(0, scheduler.held());
+}
+
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,84 @@
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "library/common/http/stream_slot_table.h"
+
+namespace Envoy {
+namespace Http {
+
+using Table = StreamSlotTable<int>;
+
+TEST(StreamSlotTableTest, InsertFindCloseErase) {
+  Table table;
+  int a = 1;
+  table.insert(7, &a);
+  EXPECT_EQ(1, table.size());
+  EXPECT_EQ(&a, table.find(7, false));
+  EXPECT_EQ(&a, table.find(7, true));
+  EXPECT_EQ(nullptr, table.find(8, true));
+
+  EXPECT_TRUE(table.close(7));
+  EXPECT_FALSE(table.close(7));
+  EXPECT_EQ(nullptr, table.find(7, false));
+  EXPECT_EQ(&a, table.find(7, true));
+
+  EXPECT_EQ(&a, table.erase(7));
+  EXPECT_EQ(nullptr, table.erase(7));
+  EXPECT_EQ(nullptr, table.find(7, true));
+  EXPECT_EQ(0, table.size());
+}
+
+TEST(StreamSlotTableTest, StaleHandleDoesNotMatchReusedSlot) {
+  Table table;
+  int a = 1;
+  int b = 2;
+  table.insert(3, &a);
+  table.erase(3);
+  // Maps to the same slot as the erased handle.
+  const envoy_stream_t next = 3 + Table::InitialSlots;
+  table.insert(next, &b);
+  EXPECT_EQ(Table::InitialSlots, table.slots());
+  EXPECT_EQ(nullptr, table.find(3, true));
+  EXPECT_EQ(&b, table.find(next, false));
+}
+
+TEST(StreamSlotTableTest, CollisionWithLiveStreamGrowsTable) {
+  Table table;
+  int a = 1;
+  int b = 2;
+  table.insert(5, &a);
+  table.insert(5 + Table::InitialSlots, &b);
+  EXPECT_EQ(Table::InitialSlots * 2, table.slots());
+  EXPECT_EQ(&a, table.find(5, false));
+  EXPECT_EQ(&b, table.find(5 + Table::InitialSlots, false));
+}
+
+TEST(StreamSlotTableTest, LongLivedStreamSpillsToOverflow) {
+  Table table;
+  int long_lived = 0;
+  table.insert(0, &long_lived);
+  table.close(0);
+
+  std::vector<int> values(4);
+  for (size_t i = 0; i < values.size(); ++i) {
+    table.insert(Table::MaxSlots * (i + 1), &values[i]);
+  }
+  EXPECT_EQ(Table::MaxSlots, table.slots());
+  EXPECT_EQ(5, table.size());
+  EXPECT_EQ(nullptr, table.find(0, false));
+  EXPECT_EQ(&long_lived, table.find(0, true));
+  for (size_t i = 0; i < values.size(); ++i) {
+    EXPECT_EQ(&values[i], table.find(Table::MaxSlots * (i + 1), false));
+  }
+
+  int count = 0;
+  table.forEach([&count](int*) { ++count; });
+  EXPECT_EQ(5, count);
+
+  EXPECT_EQ(&values[1], table.erase(Table::MaxSlots * 2));
+  EXPECT_EQ(nullptr, table.find(Table::MaxSlots * 2, true));
+  EXPECT_EQ(4, table.size());
+}
+
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,28 @@
+#include "gtest/gtest.h"
+#include "library/common/http/well_known_headers.h"
+
+namespace Envoy {
+namespace Http {
+
+TEST(WellKnownHeadersTest, FindsEveryKey) {
+  const WellKnownHeaderValues& headers = WellKnownHeaders::get();
+  ASSERT_FALSE(headers.keys().empty());
+  for (const LowerCaseString& key : headers.keys()) {
+    // Lookups by an equal key held elsewhere return the interned key.
+    const std::string copy = key.get();
+    EXPECT_EQ(&key, headers.find(copy)) << copy;
+  }
+}
+
+TEST(WellKnownHeadersTest, MatchesExactly) {
+  const WellKnownHeaderValues& headers = WellKnownHeaders::get();
+  EXPECT_EQ(":path", headers.find(":path")->get());
+  EXPECT_EQ(nullptr, headers.find(""));
+  EXPECT_EQ(nullptr, headers.find("Content-Type"));
+  EXPECT_EQ(nullptr, headers.find(":pat"));
+  EXPECT_EQ(nullptr, headers.find(":pxth"));
+  EXPECT_EQ(nullptr, headers.find("x-unknown-header"));
+}
+
+} // namespace Http
+} // namespace Envoy
@@ -8,6 +8,7 @@
 #include "library/common/api/external.h"
 #include "library/common/bridge/utility.h"
 #include "library/common/data/utility.h"
+#include "library/common/engine_handle.h"
 #include "library/common/http/header_utility.h"
 #include "library/common/main_interface.h"
 
@@ -161,7 +162,9 @@ TEST(MainInterfaceTest, BasicStream) {
       } /* on_complete */,
       nullptr /* on_cancel */,
       nullptr /* on_send_window_available*/,
-      &on_complete_notification /* context */};
+      &on_complete_notification /* context */,
+      nullptr /* on_data_vectored */,
+      nullptr /* on_aggregated_response */};
   Http::TestRequestHeaderMapImpl headers;
   HttpTestUtility::addDefaultHeaders(headers);
   envoy_headers c_headers = Http::Utility::toBridgeHeaders(headers);
@@ -213,7 +216,8 @@ TEST(MainInterfaceTest, SendMetadata) {
       nullptr /* on_metadata */, nullptr /* on_trailers */,
       nullptr /* on_error */,    nullptr /* on_complete */,
       nullptr /* on_cancel */,   nullptr /* on_send_window_available */,
-      nullptr /* context */,
+      nullptr /* context */,     nullptr /* on_data_vectored */,
+      nullptr /* on_aggregated_response */,
   };
 
   envoy_stream_t stream = init_stream(engine_handle);
@@ -262,7 +266,9 @@ TEST(MainInterfaceTest, ResetStream) {
         return nullptr;
       } /* on_cancel */,
       nullptr /* on_send_window_available */,
-      &on_cancel_notification /* context */};
+      &on_cancel_notification /* context */,
+      nullptr /* on_data_vectored */,
+      nullptr /* on_aggregated_response */};
 
   envoy_stream_t stream = init_stream(engine_handle);
 
@@ -673,4 +679,36 @@ TEST(MainInterfaceTest, ResetConnectivityState) {
   ASSERT_TRUE(test_context.on_exit.WaitForNotificationWithTimeout(absl::Seconds(3)));
 }
 
+TEST(MainInterfaceTest, SuspendAndResumeEngine) {
+  engine_test_context test_context{};
+  envoy_engine_callbacks engine_cbs{[](void* context) -> void {
+                                      auto* engine_running =
+                                          static_cast<engine_test_context*>(context);
+                                      engine_running->on_engine_running.Notify();
+                                    } /*on_engine_running*/,
+                                    [](void* context) -> void {
+                                      auto* exit = static_cast<engine_test_context*>(context);
+                                      exit->on_exit.Notify();
+                                    } /*on_exit*/,
+                                    &test_context /*context*/};
+  envoy_engine_t engine_handle = init_engine(engine_cbs, {}, {});
+  run_engine(engine_handle, MINIMAL_TEST_CONFIG.c_str(), LEVEL_DEBUG.c_str(), "");
+  ASSERT_TRUE(test_context.on_engine_running.WaitForNotificationWithTimeout(absl::Seconds(3)));
+
+  // Suspending again drains and trims again, while resuming more than once has no further effect.
+  ASSERT_EQ(ENVOY_SUCCESS, suspend_engine(engine_handle));
+  ASSERT_EQ(ENVOY_SUCCESS, suspend_engine(engine_handle));
+  ASSERT_EQ(ENVOY_SUCCESS, resume_engine(engine_handle));
+  ASSERT_EQ(ENVOY_SUCCESS, resume_engine(engine_handle));
+
+  // The engine's dispatcher keeps running throughout.
+  absl::Notification dispatched;
+  ASSERT_EQ(ENVOY_SUCCESS, EngineHandle::runOnEngineDispatcher(
+                               engine_handle, [&dispatched](auto&) { dispatched.Notify(); }));
+  ASSERT_TRUE(dispatched.WaitForNotificationWithTimeout(absl::Seconds(3)));
+
+  terminate_engine(engine_handle, /* release */ true);
+  ASSERT_TRUE(test_context.on_exit.WaitForNotificationWithTimeout(absl::Seconds(3)));
+}
+
 } // namespace Envoy
@@ -7,6 +7,8 @@
 #include "library/common/network/connectivity_manager.h"
 
 using testing::_;
+using testing::Eq;
+using testing::Invoke;
 using testing::Ref;
 using testing::Return;
 
@@ -33,6 +35,9 @@ public:
   ConnectivityManagerSharedPtr connectivity_manager_;
 };
 
+using Extensions::Common::DynamicForwardProxy::DnsCache;
+using Extensions::Common::DynamicForwardProxy::MockDnsCache;
+
 TEST_F(ConnectivityManagerTest, SetPreferredNetworkWithNewNetworkChangesConfigurationKey) {
   envoy_netconf_t original_key = connectivity_manager_->getConfigurationKey();
   envoy_netconf_t new_key = ConnectivityManagerImpl::setPreferredNetwork(ENVOY_NET_WWAN);
@@ -105,6 +110,118 @@ TEST_F(ConnectivityManagerTest, WhenDrainPostDnsNotEnabledDoesntDrainPostDnsRefr
       Network::DnsResolver::ResolutionStatus::Success);
 }
 
+TEST_F(ConnectivityManagerTest, PreconnectEstablishesConnectionsToCachedHost) {
+  EXPECT_CALL(*dns_cache_, loadDnsCacheEntry_(Eq("example.com:443"), 443, false, _))
+      .WillOnce(Return(MockDnsCache::MockLoadDnsCacheEntryResult{
+          DnsCache::LoadDnsCacheEntryStatus::InCache, nullptr, absl::nullopt}));
+  EXPECT_CALL(cm_, getThreadLocalCluster(Eq("base_h2")));
+  EXPECT_CALL(cm_.thread_local_cluster_.conn_pool_, maybePreconnect(2))
+      .Times(2)
+      .WillRepeatedly(Return(true));
+  connectivity_manager_->preconnect("example.com", ENVOY_PRECONNECT_HTTP2, 2);
+}
+
+TEST_F(ConnectivityManagerTest, PreconnectStopsOnceConnectionsSuffice) {
+  EXPECT_CALL(*dns_cache_, loadDnsCacheEntry_(Eq("example.com:8443"), 443, false, _))
+      .WillOnce(Return(MockDnsCache::MockLoadDnsCacheEntryResult{
+          DnsCache::LoadDnsCacheEntryStatus::InCache, nullptr, absl::nullopt}));
+  EXPECT_CALL(cm_, getThreadLocalCluster(Eq("base")));
+  EXPECT_CALL(cm_.thread_local_cluster_.conn_pool_, maybePreconnect(4)).WillOnce(Return(false));
+  connectivity_manager_->preconnect("example.com:8443", ENVOY_PRECONNECT_ALPN, 4);
+}
+
+TEST_F(ConnectivityManagerTest, PreconnectWaitsForDnsResolution) {
+  auto* handle =
+      new NiceMock<Extensions::Common::DynamicForwardProxy::MockLoadDnsCacheEntryHandle>();
+  DnsCache::LoadDnsCacheEntryCallbacks* load_callbacks = nullptr;
+  EXPECT_CALL(*dns_cache_, loadDnsCacheEntry_(Eq("example.com:443"), 443, false, _))
+      .WillOnce(Invoke([&](absl::string_view, uint16_t, bool,
+                           DnsCache::LoadDnsCacheEntryCallbacks& callbacks) {
+        load_callbacks = &callbacks;
+        return MockDnsCache::MockLoadDnsCacheEntryResult{
+            DnsCache::LoadDnsCacheEntryStatus::Loading, handle, absl::nullopt};
+      }));
+  EXPECT_CALL(cm_.thread_local_cluster_.conn_pool_, maybePreconnect(_)).Times(0);
+  connectivity_manager_->preconnect("example.com", ENVOY_PRECONNECT_HTTP3, 1);
+  ASSERT_NE(nullptr, load_callbacks);
+  auto& connectivity_manager = static_cast<ConnectivityManagerImpl&>(*connectivity_manager_);
+  EXPECT_EQ(1, connectivity_manager.pendingPreconnects());
+
+  EXPECT_CALL(cm_, getThreadLocalCluster(Eq("base_h3")));
+  EXPECT_CALL(cm_.thread_local_cluster_.conn_pool_, maybePreconnect(1)).WillOnce(Return(true));
+  load_callbacks->onLoadDnsCacheComplete(
+      std::make_shared<Extensions::Common::DynamicForwardProxy::MockDnsHostInfo>());
+  EXPECT_EQ(0, connectivity_manager.pendingPreconnects());
+}
+
+TEST_F(ConnectivityManagerTest, PreconnectAgainReplacesPendingResolution) {
+  std::vector<DnsCache::LoadDnsCacheEntryCallbacks*> load_callbacks;
+  EXPECT_CALL(*dns_cache_, loadDnsCacheEntry_(Eq("example.com:443"), 443, false, _))
+      .Times(2)
+      .WillRepeatedly(Invoke([&](absl::string_view, uint16_t, bool,
+                                 DnsCache::LoadDnsCacheEntryCallbacks& callbacks) {
+        load_callbacks.push_back(&callbacks);
+        return MockDnsCache::MockLoadDnsCacheEntryResult{
+            DnsCache::LoadDnsCacheEntryStatus::Loading,
+            new NiceMock<Extensions::Common::DynamicForwardProxy::MockLoadDnsCacheEntryHandle>(),
+            absl::nullopt};
+      }));
+  connectivity_manager_->preconnect("example.com", ENVOY_PRECONNECT_ALPN, 1);
+  connectivity_manager_->preconnect("example.com", ENVOY_PRECONNECT_HTTP3, 1);
+  ASSERT_EQ(2, load_callbacks.size());
+  auto& connectivity_manager = static_cast<ConnectivityManagerImpl&>(*connectivity_manager_);
+  EXPECT_EQ(1, connectivity_manager.pendingPreconnects());
+
+  // Only the latest resolution is awaited, and connections to both are established once it
+  // completes.
+  EXPECT_CALL(cm_.thread_local_cluster_.conn_pool_, maybePreconnect(1))
+      .Times(2)
+      .WillRepeatedly(Return(true));
+  load_callbacks.back()->onLoadDnsCacheComplete(
+      std::make_shared<Extensions::Common::DynamicForwardProxy::MockDnsHostInfo>());
+  EXPECT_EQ(0, connectivity_manager.pendingPreconnects());
+}
+
+TEST_F(ConnectivityManagerTest, RefreshDnsPreconnectsAgain) {
+  EXPECT_CALL(*dns_cache_, loadDnsCacheEntry_(Eq("example.com:443"), 443, false, _))
+      .Times(2)
+      .WillRepeatedly(Return(MockDnsCache::MockLoadDnsCacheEntryResult{
+          DnsCache::LoadDnsCacheEntryStatus::InCache, nullptr, absl::nullopt}));
+  EXPECT_CALL(cm_.thread_local_cluster_.conn_pool_, maybePreconnect(1))
+      .Times(2)
+      .WillRepeatedly(Return(true));
+  connectivity_manager_->preconnect("example.com", ENVOY_PRECONNECT_ALPN, 1);
+
+  envoy_netconf_t configuration_key =
+      ConnectivityManagerImpl::setPreferredNetwork(ENVOY_NET_WWAN);
+  connectivity_manager_->refreshDns(configuration_key, false);
+}
+
+TEST_F(ConnectivityManagerTest, DrainPostDnsRefreshPreconnectsAfterDrain) {
+  connectivity_manager_->setDrainPostDnsRefreshEnabled(true);
+  EXPECT_CALL(*dns_cache_, loadDnsCacheEntry_(Eq("example.com:443"), 443, false, _))
+      .WillOnce(Return(MockDnsCache::MockLoadDnsCacheEntryResult{
+          DnsCache::LoadDnsCacheEntryStatus::InCache, nullptr, absl::nullopt}));
+  EXPECT_CALL(cm_.thread_local_cluster_.conn_pool_, maybePreconnect(1)).WillOnce(Return(true));
+  connectivity_manager_->preconnect("example.com", ENVOY_PRECONNECT_ALPN, 1);
+
+  auto host_info = std::make_shared<Extensions::Common::DynamicForwardProxy::MockDnsHostInfo>();
+  EXPECT_CALL(*dns_cache_, iterateHostMap(_))
+      .WillOnce(Invoke([&](DnsCache::IterateHostMapCb callback) {
+        callback("example.com:443", host_info);
+      }));
+  // Connections are established once they've been drained, not before.
+  EXPECT_CALL(cm_.thread_local_cluster_.conn_pool_, maybePreconnect(_)).Times(0);
+  envoy_netconf_t configuration_key = connectivity_manager_->getConfigurationKey();
+  connectivity_manager_->refreshDns(configuration_key, true);
+
+  testing::InSequence s;
+  EXPECT_CALL(cm_, drainConnections(_));
+  EXPECT_CALL(cm_.thread_local_cluster_.conn_pool_, maybePreconnect(1)).WillOnce(Return(true));
+  connectivity_manager_->onDnsResolutionComplete("example.com:443", host_info,
+                                                 Network::DnsResolver::ResolutionStatus::Success);
+}
+
 TEST_F(ConnectivityManagerTest,
        ReportNetworkUsageDoesntAlterNetworkConfigurationWhenBoundInterfacesAreDisabled) {
   envoy_netconf_t configuration_key = connectivity_manager_->getConfigurationKey();
@@ -0,0 +1,162 @@
+#include <map>
+#include <string>
+#include <vector>
+
+#include "test/common/stats/stat_test_utility.h"
+#include "test/extensions/common/dynamic_forward_proxy/mocks.h"
+#include "test/test_common/simulated_time_system.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "library/common/data/utility.h"
+#include "library/common/startup_trace.h"
+
+using testing::Contains;
+using testing::NiceMock;
+using testing::Pair;
+using testing::Ref;
+using testing::UnorderedElementsAre;
+
+namespace Envoy {
+
+using Extensions::Common::DynamicForwardProxy::MockDnsCache;
+
+class StartupTraceTest : public testing::Test {
+public:
+  // Runs the phase for the given duration.
+  void runPhase(StartupPhase phase, std::chrono::microseconds duration) {
+    trace_.begin(phase);
+    time_system_.advanceTimeWait(duration);
+    trace_.end(phase);
+  }
+
+  envoy_event_tracker eventTracker() {
+    return {[](envoy_map map, const void* context) -> void {
+              auto* events = static_cast<std::vector<std::map<std::string, std::string>>*>(
+                  const_cast<void*>(context));
+              std::map<std::string, std::string> event;
+              for (envoy_map_size_t i = 0; i < map.length; i++) {
+                event.emplace(Data::Utility::copyToString(map.entries[i].key),
+                              Data::Utility::copyToString(map.entries[i].value));
+              }
+              release_envoy_map(map);
+              events->push_back(std::move(event));
+            } /*track*/,
+            &events_ /*context*/};
+  }
+
+  uint64_t gaugeValue(const std::string& name) {
+    return TestUtility::findGauge(store_, name)->value();
+  }
+
+  Event::SimulatedTimeSystem time_system_;
+  StartupTrace trace_{time_system_};
+  Stats::TestUtil::TestStore store_;
+  std::vector<std::map<std::string, std::string>> events_;
+};
+
+TEST_F(StartupTraceTest, RecordsPhases) {
+  time_system_.advanceTimeWait(std::chrono::microseconds(5));
+  runPhase(StartupPhase::LogDelegate, std::chrono::microseconds(10));
+  runPhase(StartupPhase::EngineCommon, std::chrono::microseconds(200));
+
+  // Phases which haven't ended, or haven't begun, are left out.
+  trace_.begin(StartupPhase::ServerInit);
+  trace_.end(StartupPhase::PostInit);
+  EXPECT_THAT(trace_.event(),
+              UnorderedElementsAre(Pair("name", "startup"), Pair("log_delegate_start_us", "5"),
+                                   Pair("log_delegate_us", "10"),
+                                   Pair("engine_common_start_us", "15"),
+                                   Pair("engine_common_us", "200")));
+
+  // A phase's end is only recorded once.
+  time_system_.advanceTimeWait(std::chrono::microseconds(50));
+  trace_.end(StartupPhase::ServerInit);
+  trace_.end(StartupPhase::ServerInit);
+  time_system_.advanceTimeWait(std::chrono::microseconds(50));
+  trace_.end(StartupPhase::ServerInit);
+  EXPECT_THAT(trace_.event(), Contains(Pair("server_init_us", "50")));
+}
+
+TEST_F(StartupTraceTest, ReportsOnEngineRunning) {
+  runPhase(StartupPhase::LogDelegate, std::chrono::microseconds(10));
+  runPhase(StartupPhase::EngineCommon, std::chrono::microseconds(200));
+  runPhase(StartupPhase::ServerInit, std::chrono::microseconds(3000));
+  runPhase(StartupPhase::PostInit, std::chrono::microseconds(40));
+  runPhase(StartupPhase::Drain, std::chrono::microseconds(7));
+  trace_.onEngineRunning(store_, eventTracker());
+
+  ASSERT_EQ(1, events_.size());
+  EXPECT_EQ("startup", events_[0].at("name"));
+  EXPECT_EQ("3000", events_[0].at("server_init_us"));
+  EXPECT_EQ("3210", events_[0].at("post_init_start_us"));
+  EXPECT_EQ("3257", events_[0].at("total_us"));
+  EXPECT_EQ(0, events_[0].count("first_dns_resolution_us"));
+
+  EXPECT_EQ(10, gaugeValue("startup.log_delegate_us"));
+  EXPECT_EQ(200, gaugeValue("startup.engine_common_us"));
+  EXPECT_EQ(3000, gaugeValue("startup.server_init_us"));
+  EXPECT_EQ(40, gaugeValue("startup.post_init_us"));
+  EXPECT_EQ(7, gaugeValue("startup.drain_us"));
+  EXPECT_EQ(3257, gaugeValue("startup.total_us"));
+  EXPECT_EQ(0, gaugeValue("startup.first_dns_resolution_us"));
+}
+
+TEST_F(StartupTraceTest, ReportsFirstDnsResolutionSeparately) {
+  NiceMock<MockDnsCache> dns_cache;
+  EXPECT_CALL(dns_cache, addUpdateCallbacks_(Ref(trace_)));
+  trace_.traceDnsResolution(dns_cache);
+
+  // The startup is reported without waiting for the first resolution.
+  time_system_.advanceTimeWait(std::chrono::microseconds(100));
+  trace_.onEngineRunning(store_, eventTracker());
+  ASSERT_EQ(1, events_.size());
+  EXPECT_EQ("startup", events_[0].at("name"));
+  EXPECT_EQ("100", events_[0].at("total_us"));
+  EXPECT_EQ(0, events_[0].count("first_dns_resolution_us"));
+  EXPECT_EQ(100, gaugeValue("startup.total_us"));
+  EXPECT_EQ(0, gaugeValue("startup.first_dns_resolution_us"));
+
+  time_system_.advanceTimeWait(std::chrono::microseconds(400));
+  trace_.onDnsResolutionComplete("www.example.com", nullptr,
+                                 Network::DnsResolver::ResolutionStatus::Success);
+  ASSERT_EQ(2, events_.size());
+  EXPECT_THAT(events_[1], UnorderedElementsAre(Pair("name", "startup_first_dns_resolution"),
+                                               Pair("first_dns_resolution_start_us", "0"),
+                                               Pair("first_dns_resolution_us", "500")));
+  EXPECT_EQ(500, gaugeValue("startup.first_dns_resolution_us"));
+
+  // Only the first resolution is reported.
+  trace_.onDnsResolutionComplete("www.example.org", nullptr,
+                                 Network::DnsResolver::ResolutionStatus::Failure);
+  EXPECT_EQ(2, events_.size());
+}
+
+TEST_F(StartupTraceTest, ReportsEarlyDnsResolutionWithStartup) {
+  NiceMock<MockDnsCache> dns_cache;
+  trace_.traceDnsResolution(dns_cache);
+  time_system_.advanceTimeWait(std::chrono::microseconds(20));
+  trace_.onDnsResolutionComplete("www.example.com", nullptr,
+                                 Network::DnsResolver::ResolutionStatus::Success);
+
+  time_system_.advanceTimeWait(std::chrono::microseconds(80));
+  trace_.onEngineRunning(store_, eventTracker());
+  ASSERT_EQ(1, events_.size());
+  EXPECT_EQ("20", events_[0].at("first_dns_resolution_us"));
+  EXPECT_EQ("100", events_[0].at("total_us"));
+  EXPECT_EQ(20, gaugeValue("startup.first_dns_resolution_us"));
+
+  trace_.onDnsResolutionComplete("www.example.org", nullptr,
+                                 Network::DnsResolver::ResolutionStatus::Success);
+  EXPECT_EQ(1, events_.size());
+}
+
+TEST_F(StartupTraceTest, ReportsWithoutEventTracker) {
+  runPhase(StartupPhase::ServerInit, std::chrono::microseconds(30));
+  trace_.onEngineRunning(store_, {});
+  EXPECT_EQ(30, gaugeValue("startup.server_init_us"));
+  EXPECT_EQ(30, gaugeValue("startup.total_us"));
+}
+
+} // namespace Envoy
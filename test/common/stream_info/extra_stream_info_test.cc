@@ -44,9 +44,10 @@ public:
     EXPECT_EQ(a.received_byte_count, b.received_byte_count);
   }
   StalledTimeSource start_time_source_{SYSTEM_TIME_START_MS, MONOTONIC_TIME_START_MS};
-  envoy_final_stream_intel final_intel_{-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, -1};
+  envoy_final_stream_intel final_intel_{-1, -1, -1, -1, -1, -1, -1, -1,
+                                        -1, -1, -1, 0,  0,  0,  0,  -1, 0};
   envoy_final_stream_intel expected_intel_{-1, -1, -1, -1, -1, -1, -1, -1,
-                                           -1, -1, -1, 0,  0,  0,  0,  -1};
+                                           -1, -1, -1, 0,  0,  0,  0,  -1, 0};
 };
 
 TEST_F(FinalIntelTest, Unset) {
@@ -0,0 +1,208 @@
+// Compares the heap held by a running engine after a burst of requests against that held by the
+// same engine once suspended.
+
+#include <malloc.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "source/common/common/assert.h"
+#include "source/common/http/header_map_impl.h"
+
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/notification.h"
+#include "benchmark/benchmark.h"
+#include "library/cc/engine_builder.h"
+#include "library/common/engine.h"
+#include "library/common/engine_handle.h"
+#include "library/common/http/header_utility.h"
+#include "library/common/main_interface.h"
+
+namespace Envoy {
+namespace {
+
+constexpr int Requests = 32;
+
+// An HTTP/1.1 server on the loopback address which answers every request with an empty 200, and
+// keeps its connections open until the client closes them.
+class LocalServer {
+public:
+  LocalServer() {
+    fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    RELEASE_ASSERT(bind(fd_, reinterpret_cast<sockaddr*>(&address), length) == 0, "bind failed");
+    RELEASE_ASSERT(listen(fd_, Requests) == 0, "listen failed");
+    RELEASE_ASSERT(getsockname(fd_, reinterpret_cast<sockaddr*>(&address), &length) == 0,
+                   "getsockname failed");
+    port_ = ntohs(address.sin_port);
+    acceptor_ = std::thread([this]() { accept(); });
+  }
+
+  ~LocalServer() {
+    shutdown(fd_, SHUT_RDWR);
+    close(fd_);
+    acceptor_.join();
+    for (std::thread& connection : connections_) {
+      connection.join();
+    }
+  }
+
+  uint16_t port() const { return port_; }
+
+private:
+  void accept() {
+    while (true) {
+      const int connection = ::accept(fd_, nullptr, nullptr);
+      if (connection < 0) {
+        return;
+      }
+      connections_.emplace_back([connection]() { serve(connection); });
+    }
+  }
+
+  static void serve(int connection) {
+    static constexpr absl::string_view Response = "HTTP/1.1 200 OK\r\ncontent-length: 0\r\n\r\n";
+    std::string received;
+    char buffer[4096];
+    ssize_t rc;
+    while ((rc = read(connection, buffer, sizeof(buffer))) > 0) {
+      received.append(buffer, rc);
+      // Requests have no bodies, so each ends with its headers.
+      size_t end;
+      while ((end = received.find("\r\n\r\n")) != std::string::npos) {
+        received.erase(0, end + 4);
+        if (write(connection, Response.data(), Response.size()) < 0) {
+          break;
+        }
+      }
+    }
+    close(connection);
+  }
+
+  int fd_;
+  uint16_t port_;
+  std::thread acceptor_;
+  // Only touched by the acceptor thread until it's joined.
+  std::vector<std::thread> connections_;
+};
+
+size_t heapInUse() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+  return mallinfo2().uordblks;
+#else
+  return 0;
+#endif
+}
+
+struct EngineContext {
+  absl::Notification on_engine_running;
+  absl::Notification on_exit;
+};
+
+envoy_engine_callbacks engineCallbacks(EngineContext& context) {
+  return {[](void* context) -> void {
+            static_cast<EngineContext*>(context)->on_engine_running.Notify();
+          } /*on_engine_running*/,
+          [](void* context) -> void { static_cast<EngineContext*>(context)->on_exit.Notify(); }
+          /*on_exit*/,
+          &context /*context*/};
+}
+
+// Waits for the operations already dispatched to the engine, and for the deferred deletions they
+// caused, to have run.
+void waitForEngine(envoy_engine_t engine) {
+  for (int i = 0; i < 2; i++) {
+    absl::Notification done;
+    EngineHandle::runOnEngineDispatcher(engine, [&done](Engine&) { done.Notify(); });
+    done.WaitForNotification();
+  }
+}
+
+envoy_http_callbacks streamCallbacks(absl::BlockingCounter& complete) {
+  return {[](envoy_headers headers, bool, envoy_stream_intel, void*) -> void* {
+            release_envoy_headers(headers);
+            return nullptr;
+          } /* on_headers */,
+          nullptr /* on_data */,
+          nullptr /* on_metadata */,
+          nullptr /* on_trailers */,
+          [](envoy_error error, envoy_stream_intel, envoy_final_stream_intel,
+             void* context) -> void* {
+            release_envoy_error(error);
+            static_cast<absl::BlockingCounter*>(context)->DecrementCount();
+            return nullptr;
+          } /* on_error */,
+          [](envoy_stream_intel, envoy_final_stream_intel, void* context) -> void* {
+            static_cast<absl::BlockingCounter*>(context)->DecrementCount();
+            return nullptr;
+          } /* on_complete */,
+          [](envoy_stream_intel, envoy_final_stream_intel, void* context) -> void* {
+            static_cast<absl::BlockingCounter*>(context)->DecrementCount();
+            return nullptr;
+          } /* on_cancel */,
+          nullptr /* on_send_window_available*/,
+          &complete /* context */,
+          nullptr /* on_data_vectored */,
+          nullptr /* on_aggregated_response */,
+          nullptr /* on_response_body_progress */};
+}
+
+// Runs an engine, sends a burst of concurrent requests over their own connections, and measures
+// the heap the engine holds once they complete: while running, or once suspended, per the arg.
+void bmEngineMemory(benchmark::State& state) {
+  if (heapInUse() == 0) {
+    state.SkipWithError("the heap in use can't be measured on this platform");
+    return;
+  }
+  const bool suspend = state.range(0) != 0;
+  LocalServer server;
+  const std::string authority = absl::StrCat("127.0.0.1:", server.port());
+
+  double total_bytes = 0;
+  for (auto _ : state) { // NOLINT(clang-analyzer-deadcode.DeadStores)
+    const size_t before = heapInUse();
+    EngineContext context;
+    envoy_engine_t engine = init_engine(engineCallbacks(context), {}, {});
+    run_engine(engine,
+               Platform::EngineBuilder().addMaxConnectionsPerHost(Requests).generateBootstrap(),
+               "error", "");
+    context.on_engine_running.WaitForNotification();
+
+    absl::BlockingCounter complete(Requests);
+    for (int i = 0; i < Requests; i++) {
+      envoy_stream_t stream = init_stream(engine);
+      start_stream(engine, stream, streamCallbacks(complete), false);
+      auto headers = Http::RequestHeaderMapImpl::create();
+      headers->setMethod("GET");
+      headers->setScheme("http");
+      headers->setHost(authority);
+      headers->setPath("/");
+      send_headers(engine, stream, Http::Utility::toBridgeHeaders(*headers), true);
+    }
+    complete.Wait();
+
+    if (suspend) {
+      suspend_engine(engine);
+    }
+    waitForEngine(engine);
+    total_bytes += static_cast<double>(heapInUse()) - static_cast<double>(before);
+
+    terminate_engine(engine, /* release */ true);
+    context.on_exit.WaitForNotification();
+  }
+
+  state.counters["engine_heap_bytes"] =
+      benchmark::Counter(total_bytes, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(bmEngineMemory)->ArgName("suspended")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+} // namespace
+} // namespace Envoy
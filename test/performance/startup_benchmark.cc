@@ -0,0 +1,86 @@
+// Starts and stops the engine, reporting the duration of each phase of its startup from the
+// "startup" event it emits to the event tracker.
+
+#include <map>
+#include <string>
+
+#include "absl/strings/numbers.h"
+#include "absl/synchronization/notification.h"
+#include "benchmark/benchmark.h"
+#include "library/cc/engine_builder.h"
+#include "library/common/data/utility.h"
+#include "library/common/main_interface.h"
+
+namespace Envoy {
+namespace {
+
+struct StartupContext {
+  absl::Notification on_engine_running;
+  absl::Notification on_exit;
+  absl::Notification on_startup;
+  std::map<std::string, std::string> startup;
+};
+
+envoy_engine_callbacks engineCallbacks(StartupContext& context) {
+  return {[](void* context) -> void {
+            static_cast<StartupContext*>(context)->on_engine_running.Notify();
+          } /*on_engine_running*/,
+          [](void* context) -> void {
+            static_cast<StartupContext*>(context)->on_exit.Notify();
+          } /*on_exit*/,
+          &context /*context*/};
+}
+
+envoy_event_tracker eventTracker(StartupContext& context) {
+  return {[](envoy_map map, const void* context) -> void {
+            auto* startup_context = static_cast<StartupContext*>(const_cast<void*>(context));
+            std::map<std::string, std::string> event;
+            for (envoy_map_size_t i = 0; i < map.length; i++) {
+              event.emplace(Data::Utility::copyToString(map.entries[i].key),
+                            Data::Utility::copyToString(map.entries[i].value));
+            }
+            release_envoy_map(map);
+            if (event["name"] == "startup") {
+              startup_context->startup = std::move(event);
+              startup_context->on_startup.Notify();
+            }
+          } /*track*/,
+          &context /*context*/};
+}
+
+// Runs the engine with the builder's bootstrap, preresolving a host so that the first DNS
+// resolution is part of the startup.
+void bmStartup(benchmark::State& state) {
+  std::map<std::string, double> totals;
+  for (auto _ : state) { // NOLINT(clang-analyzer-deadcode.DeadStores)
+    state.PauseTiming();
+    StartupContext context;
+    envoy_engine_t engine = init_engine(engineCallbacks(context), {}, eventTracker(context));
+    auto bootstrap = Platform::EngineBuilder()
+                         .addDnsPreresolveHostnames("[{address: localhost, port_value: 443}]")
+                         .generateBootstrap();
+    state.ResumeTiming();
+
+    run_engine(engine, std::move(bootstrap), "error", "");
+    context.on_startup.WaitForNotification();
+
+    state.PauseTiming();
+    for (const auto& [key, value] : context.startup) {
+      double duration;
+      if (key != "name" && absl::SimpleAtod(value, &duration)) {
+        totals[key] += duration;
+      }
+    }
+    terminate_engine(engine, /* release */ true);
+    context.on_exit.WaitForNotification();
+    state.ResumeTiming();
+  }
+
+  for (const auto& [key, total] : totals) {
+    state.counters[key] = benchmark::Counter(total, benchmark::Counter::kAvgIterations);
+  }
+}
+BENCHMARK(bmStartup)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+} // namespace
+} // namespace Envoy
@@ -494,8 +494,8 @@ final class EngineBuilderTests: XCTestCase {
     XCTAssertTrue(resolvedYAML.contains("&trust_chain_verification ACCEPT_UNTRUSTED"))
     XCTAssertTrue(resolvedYAML.contains("""
 &validation_context
-  trusted_ca:
-    inline_string: *tls_root_certs
+  custom_validator_config:
+    name: "envoy_mobile.cert_validator.root_certificates_cert_validator"
 """
         ))
     XCTAssertTrue(resolvedYAML.contains("&enable_drain_post_dns_refresh false"))